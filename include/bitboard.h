@@ -0,0 +1,127 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [Bitboard]
+ * 萬子, 筒子, 索子, 字牌ごとに牌の枚数を1枚4bitで64bitのwordに詰めたもの.
+ * bit[4n+3:4n] が n番目(数牌の場合 n+1)の牌の枚数(0..4).
+ * 枚数は4以下なので bit[4n+3] は常に0で, 各ランクの判定を1つのwordでまとめて(SWARで)行える.
+ * 判定結果は各ランクの最下位bit(bit[4n])に置かれる.
+ */
+
+#define BB_MAN 0
+#define BB_PIN 1
+#define BB_SOU 2
+#define BB_HONORS 3
+#define BB_LEN 4
+
+#define BB_RANK_BITS 4
+#define BB_RANK_LSB 0x111111111ull      // bit[4n] of 9 ranks
+#define BB_SEQ_LSB 0x001111111ull       // 順子の始まりになり得るランク(1..7)
+#define BB_ADJ_LSB 0x011111111ull       // 両面/辺張の始まりになり得るランク(1..8)
+#define BB_HONORS_LSB 0x1111111ull      // 字牌7種
+#define BB_TERMINAL_LSB 0x100000001ull  // 数牌の1と9
+
+typedef struct {
+  uint64_t suit[BB_LEN];
+} Bitboard;
+
+void gen_bitboard_from_tiles(Bitboard *bb, const Tiles *tiles);
+
+static inline uint32_t get_bb_suit(MJTileId tile_id) { return (uint32_t)tile_id / TILE_NUM_LEN; }
+
+static inline uint32_t get_bb_rank(MJTileId tile_id) { return (uint32_t)tile_id % TILE_NUM_LEN; }
+
+static inline MJTileId get_bb_tile_id(uint32_t suit, uint32_t rank) { return suit * TILE_NUM_LEN + rank; }
+
+static inline uint64_t get_bb_rank_bit(uint32_t rank) { return 1ull << (rank * BB_RANK_BITS); }
+
+/* 結果のmaskの最下位ランク */
+static inline uint32_t get_bb_lowest_rank(uint64_t mask) { return (uint32_t)__builtin_ctzll(mask) / BB_RANK_BITS; }
+
+static inline uint32_t get_bb_count(uint64_t word, uint32_t rank) {
+  return (uint32_t)(word >> (rank * BB_RANK_BITS)) & 0xf;
+}
+
+/* 1枚以上 */
+static inline uint64_t find_bb_tiles(uint64_t word) { return (word | (word >> 1) | (word >> 2)) & BB_RANK_LSB; }
+
+/* 2枚以上(雀頭, 対子候補) */
+static inline uint64_t find_bb_pairs(uint64_t word) { return ((word >> 1) | (word >> 2)) & BB_RANK_LSB; }
+
+/* 3枚以上(刻子候補). 3 = 0b011, 4 = 0b100 */
+static inline uint64_t find_bb_triplets(uint64_t word) { return ((word >> 2) | (word & (word >> 1))) & BB_RANK_LSB; }
+
+/* 4枚(槓子候補). 4 = 0b100 */
+static inline uint64_t find_bb_fours(uint64_t word) { return (word >> 2) & BB_RANK_LSB; }
+
+/* n, n+1, n+2 がそろうn(順子の始まり). 字牌には使わない */
+static inline uint64_t find_bb_sequences(uint64_t word) {
+  uint64_t tiles = find_bb_tiles(word);
+  return tiles & (tiles >> BB_RANK_BITS) & (tiles >> (2 * BB_RANK_BITS)) & BB_SEQ_LSB;
+}
+
+/* n, n+1 がそろうn(両面, 辺張). 字牌には使わない */
+static inline uint64_t find_bb_adjacents(uint64_t word) {
+  uint64_t tiles = find_bb_tiles(word);
+  return tiles & (tiles >> BB_RANK_BITS) & BB_ADJ_LSB;
+}
+
+/* n, n+2 がそろうn(嵌張). 字牌には使わない */
+static inline uint64_t find_bb_gaps(uint64_t word) {
+  uint64_t tiles = find_bb_tiles(word);
+  return tiles & (tiles >> (2 * BB_RANK_BITS)) & BB_SEQ_LSB;
+}
+
+/* rank から始まるブロックを取り除く/戻す. block は各ランクの枚数を4bitで詰めたもの */
+#define BB_BLOCK_SEQUENCE 0x111ull
+#define BB_BLOCK_TRIPLETS 0x3ull
+#define BB_BLOCK_PAIR 0x2ull
+#define BB_BLOCK_ADJACENT 0x11ull
+#define BB_BLOCK_GAP 0x101ull
+
+static inline uint64_t remove_bb_block(uint64_t word, uint32_t rank, uint64_t block) {
+  return word - (block << (rank * BB_RANK_BITS));
+}
+
+static inline uint64_t add_bb_block(uint64_t word, uint32_t rank, uint64_t block) {
+  return word + (block << (rank * BB_RANK_BITS));
+}
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
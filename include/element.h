@@ -44,11 +44,41 @@ typedef enum {
   ELEM_TYPE_PARTIAL_SEQUENCE, // ターツ
 } ElementType;
 
+/*
+ * 面子の内部表現. Element(MJMeld)は入力形式のまま残し, 比較やハッシュにはこちらを使う.
+ *  bit 0-5: 先頭の牌(MJTileId)
+ *  bit 6-7: ElementType
+ *  bit 8:   concealed
+ *  bit 15:  valid (0は空き)
+ */
+typedef uint16_t ElementCode;
+/* 面子(最大4つ)のElementCodeを昇順に詰めたもの. 並びによらず同じ面子の組は同じ値になる. */
+typedef uint64_t ElementsCode;
+
+#define ELEM_CODE_BITS 16
+#define ELEM_CODE_TILE_MASK 0x3fu
+#define ELEM_CODE_TYPE_SHIFT 6
+#define ELEM_CODE_TYPE_MASK (0x3u << ELEM_CODE_TYPE_SHIFT)
+#define ELEM_CODE_CONCEALED (1u << 8)
+#define ELEM_CODE_VALID (1u << 15)
+
+static inline MJTileId get_element_code_tile_id(ElementCode code) { return (MJTileId)(code & ELEM_CODE_TILE_MASK); }
+
+static inline ElementType get_element_code_type(ElementCode code) {
+  return (ElementType)((code & ELEM_CODE_TYPE_MASK) >> ELEM_CODE_TYPE_SHIFT);
+}
+
+static inline bool is_element_code_concealed(ElementCode code) { return (code & ELEM_CODE_CONCEALED) != 0; }
+
 /*
  * melds should be checked with is_valid_melds befor hands.
  */
 bool gen_elements_from_melds(Elements *elems, const MJMelds *melds);
 
+/* elem, elemsはgen_elements_from_meldsで生成されていること */
+ElementCode gen_element_code(const Element *elem);
+ElementsCode gen_elements_code(const Elements *elems);
+
 /*
  * Elements or Element arguments of the following functions are assumed to be generated with gen_elements_from_melds.
  */
@@ -92,6 +122,28 @@ bool is_kanchan_machi(const Elements *elems, MJTileId win_tile);
 bool is_penchan_machi(const Elements *elems, MJTileId win_tile);
 bool is_shanpon_machi(const Elements *elems, MJTileId win_tile);
 bool is_tanki_machi(MJTileId pair_tile, MJTileId win_tile);
+
+/*
+ * アガリ牌から見た待ちの形. アガリ牌が複数の面子に当てはまる場合は当てはまる待ちすべてがtrueになる.
+ * e.g. 123 345 で3がアガリ牌の場合 ryanmen と penchan の両方がtrue.
+ */
+typedef struct {
+  bool ryanmen;
+  bool kanchan;
+  bool penchan;
+  bool shanpon;
+  bool tanki;
+} Machi;
+
+/* 分解(concealed, pair_tile)に対して待ちの形を1度の走査で求める */
+void gen_machi(Machi *machi, const Elements *concealed, MJTileId pair_tile, MJTileId win_tile);
+/*
+ * ロンでアガリ牌を含む刻子を明刻として扱う場合 true. シャンポン待ちとしか解釈できない場合だけ明刻とする(高点法).
+ * 符計算と三暗刻, 四暗刻で同じ判定を使う.
+ */
+static inline bool is_machi_ron_triplets(const Machi *machi, bool ron) {
+  return ron && machi->shanpon && !machi->ryanmen && !machi->kanchan && !machi->penchan && !machi->tanki;
+}
 /*
  * counts same sequence element in elements
  * 123, 123, 123, 123 => 6
@@ -0,0 +1,87 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [アガリ形の列挙]
+ * 数牌1色ごとに, 面子と雀頭に分解できる枚数の組 (1色の完成形) を全て作っておき, 萬子, 筒子, 索子, 字牌の完成形を
+ * 面子4つと雀頭1つになるように組み合わせて通常形を列挙する. 七対子は通常形と重ならないものだけ, 国士無双は13通り.
+ * symmetry の場合は萬子 <= 筒子 <= 索子 (完成形の code の順) の手牌だけを, 色を入れ替えた手牌の数を重みとして列挙する.
+ * 緑一色は索子だけの役なので, 緑一色になりうる1色の手牌は索子の手牌と萬子の手牌(重み2)に分けて列挙する.
+ */
+
+#define ENUM_SUIT_HANDS_LEN 21743  // 数牌1色の完成形の数(面子0-4, 雀頭0-1)
+#define ENUM_HONOR_HANDS_LEN 498   // 字牌の完成形の数
+#define ENUM_HONORS_LEN (MJ_DR - MJ_WT + 1)
+#define ENUM_MAX_CONFIGS (MJ_MAX_HAND_LEN * 2)  // アガリ牌ごとのツモ, ロン
+
+typedef enum {
+  ENUM_FORM_NORMAL = 0,
+  ENUM_FORM_CHIITOITSU,  // 通常形に分解できない七対子
+  ENUM_FORM_KOKUSHI,
+} EnumForm;
+
+/* 1色の完成形 */
+typedef struct {
+  uint32_t code;                 // 枚数の5進数表現. 1の枚数が最下位
+  uint8_t counts[TILE_NUM_LEN];  // 字牌は ENUM_HONORS_LEN 種類
+  uint8_t elements;              // 面子の数
+  uint8_t pairs;                 // 雀頭の数
+} EnumSuit;
+
+/* 列挙したアガリ形. weight は色を入れ替えて同じになる手牌の数 (symmetry でなければ1) */
+typedef void (*EnumHandFunc)(void *arg, uint32_t worker, const Tiles *tiles, uint64_t weight, EnumForm form);
+
+/*
+ * 数牌1色の完成形 (ENUM_SUIT_HANDS_LEN 個) と字牌の完成形 (ENUM_HONOR_HANDS_LEN 個).
+ * (面子の数, 雀頭の数, code) の順に並ぶ
+ */
+const EnumSuit *get_enum_suit_hands();
+const EnumSuit *get_enum_honor_hands();
+
+/* 全てのアガリ形を threads 個のスレッドで列挙し, func を呼ぶ. func は複数のスレッドから同時に呼ばれる */
+int32_t enumerate_complete_hands(EnumHandFunc func, void *arg, uint32_t threads, bool symmetry);
+
+/* MJBaseScore.yaku_name の役の集合. bit i は mj_enum_yaku_name(i) の役 */
+uint64_t get_enum_yaku_mask(const char *yaku_name);
+
+/* tiles (14枚) を手牌に含まれる牌ごとにアガリ牌とし, ツモとロンで点数計算して weight 回分 stats に加える */
+void score_enum_hand(MJEnumStats *stats, const Tiles *tiles, uint64_t weight, EnumForm form, MJTileId player_wind,
+                     MJTileId round_wind);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -0,0 +1,77 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "element.h"
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+#define EV_YAKUMAN_HAN 13  // これ以上はドラ, リーチを加えない
+
+/* アガリ形の点数を求める条件 */
+typedef struct {
+  Elements melded;  // 副露
+  MJTileId player_wind;
+  MJTileId round_wind;
+  bool dealer;
+  bool riichi;  // 門前ならリーチの1翻を加える
+  Tiles dora;   // 牌1枚あたりのドラの翻数
+} EvScorer;
+
+/*
+ * アガリ形ごとの点数のキャッシュ. 同じアガリ形に打牌候補やツモの順番を変えて何度も到達するので,
+ * 面子の分解と点数計算を共有する. (手牌の zobrist hash, アガリ牌) で引き, 衝突したエントリは上書きする.
+ */
+#define EV_SCORE_CACHE_LEN 1024  // 2のべき乗
+
+typedef struct {
+  uint64_t key;
+  uint32_t tsumo;  // ツモアガリの3人の支払いの合計. 役がなければ0
+  uint32_t ron;    // ロンアガリの点数. 役がなければ0
+  bool valid;
+} EvScoreEntry;
+
+typedef struct {
+  EvScoreEntry entries[EV_SCORE_CACHE_LEN];
+} EvScoreCache;
+
+/*
+ * アガリ牌 win_tile を含む tiles (副露を除く3n+2枚, hashはそのzobrist hash) の点数.
+ * キャッシュになければ計算して登録する. アガリ形でなければ0点.
+ */
+const EvScoreEntry *lookup_ev_score(EvScoreCache *cache, const EvScorer *scorer, const Tiles *tiles, uint64_t hash,
+                                    MJTileId win_tile);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -68,6 +68,9 @@ extern "C" {
 
 #define FU_CHIITOITSU 25
 uint32_t calc_fu(const Elements *concealed, const Elements *melded, MJTileId pair, const ScoreConfig *cfg, bool pinfu);
+/* machi: gen_machi で求めた待ち. 複数の待ちに解釈できる場合は符が高くなる待ちを採用する(高点法) */
+uint32_t calc_fu_with_machi(const Elements *concealed, const Elements *melded, MJTileId pair, const ScoreConfig *cfg,
+                            const Machi *machi, bool pinfu);
 #if defined(__cplusplus)
 }
 #endif  // defined(__cplusplus)
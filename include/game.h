@@ -0,0 +1,81 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "rng.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [山]
+ * wall[0, wall_end) がツモ山で wall_pos から順にツモる. wall[GAME_DEAD_WALL_POS, MJ_GAME_WALL_LEN) が王牌.
+ * ドラ表示牌は wall[GAME_DEAD_WALL_POS + 2i], 裏ドラ表示牌はその次, 嶺上牌は末尾から取る.
+ * 槓のたびに wall_end を1つ減らし, 王牌を14枚に保つ.
+ */
+#define GAME_DEAD_WALL_LEN 14
+#define GAME_DEAD_WALL_POS (MJ_GAME_WALL_LEN - GAME_DEAD_WALL_LEN)
+#define GAME_MAX_KANS 4
+#define GAME_NO_TILE (MJ_DR + 1)  // MJGame.drawn: ツモっていない
+
+#define GAME_YAKUMAN_HAN 13
+#define GAME_RIICHI_STICK 1000
+#define GAME_HONBA_RON 300
+#define GAME_HONBA_TSUMO 100
+#define GAME_TENPAI_PAYMENT 3000  // 流局時の不聴罰符
+
+/* ドラ表示牌の次の牌 */
+MJTileId get_dora_tile(MJTileId indicator);
+
+/* 山を積んで配牌する. 局の状態(手牌, 捨て牌, リーチなど)を初期化する. 持ち点, 局, 親, 本場, 供託はそのまま */
+void deal_game(MJGame *game, Rng *rng);
+
+/* hand のドラ(ura: 裏ドラ)の枚数 */
+uint32_t count_game_dora(const MJGame *game, const MJPreparedHand *hand, bool ura);
+
+/*
+ * player が tile でアガれるなら翻と符を求める. 役がない場合は false.
+ * リーチ, 一発, 海底, 河底, ドラ, 裏ドラは mj_score_prepared の翻に加える. 役満ならドラなどは加えない.
+ * ron の場合 tile は手牌に含まない. tsumo の場合はツモった後の手牌で, rinshan は嶺上牌でツモった場合.
+ */
+bool score_game_win(const MJGame *game, uint32_t player, MJTileId tile, bool ron, bool rinshan, uint32_t *han,
+                    uint32_t *fu);
+
+/* アガリの精算. ツモは loser == winner. 本場と供託も精算する */
+void settle_game_win(MJGame *game, uint32_t winner, uint32_t loser, uint32_t han, uint32_t fu);
+
+/* 流局の不聴罰符の精算 */
+void settle_game_exhaustive_draw(MJGame *game, const bool tenpai[MJ_GAME_PLAYERS]);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -29,12 +29,20 @@
 #include <string.h>
 
 #include "mahjong.h"
+#include "tile.h"
 
 #if defined(__cplusplus)
 extern "C" {
 #endif  // defined(__cplusplus)
 
 bool is_valid_hands(const MJHands *hands);
+
+/*
+ * 副露を含む手牌の枚数 tiles (1種類4枚まで) から mj_prepare_hand と同じ prepared を作る.
+ * 枚数で持っている手牌を MJHands に並べて数え直さずに済む. 枚数の合計は呼び出し側で検査する
+ */
+int32_t prepare_hand_tiles(MJPreparedHand *prepared, const Tiles *tiles, const MJMelds *melds);
+
 #if defined(__cplusplus)
 }
 #endif  // defined(__cplusplus)
@@ -52,11 +52,20 @@
 extern "C" {
 #endif  // defined(__cplusplus)
 
+/* ライブラリは -fvisibility=hidden でビルドするので, ここで宣言する mj_ の関数だけを公開する */
+#if defined(__GNUC__)
+#pragma GCC visibility push(default)
+#endif  // defined(__GNUC__)
+
 #define MJ_OK 0
 #define MJ_ERR_ILLEGAL_PARAM -1
 #define MJ_ERR_NUM_TILES_SHORT -2
 #define MJ_ERR_NUM_TILES_LARGE -3
 #define MJ_ERR_AGARI_NOT_FOUND -4
+#define MJ_ERR_ILLEGAL_LOG -5  // 牌譜の形式が正しくない, または牌譜どおりに再生できない
+#define MJ_ERR_IO -6           // ファイルを読めない
+#define MJ_ERR_BUSY -7         // リングに空いているスロットがない
+#define MJ_ERR_NOT_SUPPORTED -8  // この機能なしでビルドされた
 
 #define MJ_ELEMENTS_LEN 4              // length of elements
 #define MJ_PAIR_LEN 2                  // length of pairs
@@ -67,6 +76,41 @@ extern "C" {
 
 #define MJ_MAX_YAKU_NAME_LEN 2048
 
+#define MJ_BATCH_MAX_THREADS 64                  // max number of threads in batch APIs (mj_parallel_for, ...)
+#define MJ_SIM_MAX_THREADS MJ_BATCH_MAX_THREADS  // max number of threads in mj_simulate_discards
+
+#define MJ_WIN_PROB_TABLE_LEN (1u << 14)  // entries of MJWinProbTable, power of 2
+
+#define MJ_GAME_PLAYERS 4       // players in mj_play_game
+#define MJ_GAME_WALL_LEN 136    // all tiles
+#define MJ_GAME_MAX_DORA 5      // dora indicators (1 + kans)
+#define MJ_GAME_MAX_RIVER 64    // discards kept in MJGamePlayer.river
+#define MJ_GAME_MAX_ACTIONS 40  // max number of actions passed to MJDecideFunc
+
+#define MJ_ENUM_YAKU_LEN 39  // yaku counted in MJEnumScoreStats. name: mj_enum_yaku_name
+#define MJ_ENUM_HAN_LEN 14   // han 0-12, 13+ (役満)
+#define MJ_ENUM_FU_LEN 23    // fu / 5: 0-21, 110+
+#define MJ_ENUM_LIMIT_LEN 6  // 満貫未満, 満貫, 跳満, 倍満, 三倍満, 役満
+
+#define MJ_LOG_SHANTEN_LEN 8          // shanten -1 から 6 (6以上) まで
+#define MJ_LOG_BUFFER_LEN (1u << 16)  // mj_replay_mjlog_files の1ファイルの読み込みバッファ. タグの長さの上限
+
+#define MJ_RECORD_COUNTS_LEN 13  // MJHandRecord.counts. 34種類 * 3 bit
+#define MJ_RECORD_NO_SHANTEN 127  // MJShantenRecord: 副露した手牌の七対子, 国士無双
+
+#define MJ_NOTATION_MAX_LEN 64  // mj_format_notation の出力の最大の長さ (終端の '\0' を含む)
+
+#define MJ_SERVER_MAX_CLIENTS 64     // mj_run_server に同時に接続できるクライアント数
+#define MJ_SERVER_BATCH_LEN 1024     // 1度にまとめて計算する問い合わせの最大数
+#define MJ_SERVER_CLIENT_QUERIES 64  // クライアントごとの受信バッファ (MJQuery の数)
+#define MJ_SERVER_LATENCY_LEN 1024   // MJServerStats.latency. 1us ごと, 最後は 1023us 以上
+#define MJ_SERVER_PATH_LEN 108       // UNIX domain socket の path の最大の長さ (終端の '\0' を含む)
+
+#define MJ_RING_MIN_LEN 4           // mj_create_ring のスロット数の下限. 計算済み (ticket + 2) と次の周の空きを区別する
+#define MJ_RING_MAX_LEN (1u << 20)  // mj_create_ring のスロット数の上限
+
+#define MJ_TILE_COUNTS_LEN 48  // MJ_DR + 1 padded to multiple of 16 bytes for vector loads
+
 typedef enum {
   MJ_M1 = 0,
   MJ_M2, // 1
@@ -128,6 +172,13 @@ typedef struct {
   char yaku_name[MJ_MAX_YAKU_NAME_LEN];
 } MJBaseScore;
 
+typedef struct {
+  MJTileId win_tile;
+  bool ron;
+  MJTileId player_wind;
+  MJTileId round_wind;
+} MJScoreConfig;
+
 typedef struct {
   // -1: 和了, 0: テンパイ, 1: 1向聴, 2: 2向聴...
   int32_t normal;
@@ -139,6 +190,426 @@ typedef struct {
   MJTileId tiles[MJ_DR + 1];
 } MJTiles;
 
+/*
+ * mj_simulate_discards の設定.
+ */
+typedef struct {
+  uint64_t seed;     // 同じseedなら threads によらず同じ結果になる
+  uint32_t samples;  // 打牌候補ごとの試行回数
+  uint32_t draws;    // 1試行のツモ回数
+  uint32_t threads;  // 0, 1: 呼び出したスレッドのみ. MJ_SIM_MAX_THREADS まで
+} MJSimConfig;
+
+typedef struct {
+  MJTileId discard;  // 打牌候補
+  int32_t shanten;   // 打牌後のシャンテン数
+  uint32_t samples;  // 試行回数
+  uint32_t tenpai;   // draws回のツモ以内にテンパイした試行数
+  uint32_t win;      // draws回のツモ以内にツモアガリ(和了形)した試行数
+  double tenpai_rate;
+  double win_rate;
+} MJSimResult;
+
+/*
+ * mj_win_probability の置換表. 固定サイズで, 衝突したエントリは上書きする.
+ * 内容は手牌と山の状態だけで決まるので, mj_init_win_prob_table で初期化した後は呼び出しをまたいで使い回せる.
+ * members are internal use.
+ */
+typedef struct {
+  uint64_t key;
+  double prob;
+} MJWinProbEntry;
+
+typedef struct {
+  MJWinProbEntry entries[MJ_WIN_PROB_TABLE_LEN];
+} MJWinProbTable;
+
+typedef struct {
+  MJTileId discard;  // 打牌候補
+  int32_t shanten;   // 打牌後のシャンテン数
+  bool evaluated;    // false: 2向聴以上で draws 回以内のアガリがありうるため計算していない
+  double win_rate;   // draws回のツモ以内にツモアガリ(和了形)する確率
+} MJWinProbResult;
+
+/*
+ * mj_evaluate_discards の設定.
+ */
+typedef struct {
+  MJTileId player_wind;  // MJ_WT なら親
+  MJTileId round_wind;
+  bool riichi;           // 門前ならリーチしてアガるものとして1翻を加える
+  MJTiles dora;          // 牌1枚あたりのドラの翻数
+  double ron_rate;       // アガリのうちロンの割合. 0: 全てツモ
+  uint32_t draws;        // 残りツモ回数
+  uint64_t seed;         // 以下は2向聴以上の打牌候補のシミュレーションの設定. MJSimConfig と同じ
+  uint32_t samples;
+  uint32_t threads;
+} MJEvConfig;
+
+typedef struct {
+  MJTileId discard;  // 打牌候補
+  int32_t shanten;   // 打牌後のシャンテン数
+  bool exact;        // true: win_rate を厳密に求めた(テンパイ, 1向聴). false: シミュレーションで求めた
+  double win_rate;   // draws回のツモ以内にアガる確率
+  double win_score;  // アガった場合の点数の期待値. ツモは3人の支払いの合計
+  double ev;         // win_rate * win_score
+} MJEvResult;
+
+/*
+ * 牌の種類ごとの枚数(0..4). MJTiles と同じ内容を1枚1byteで詰めたもの.
+ * tiles[MJ_DR + 1] 以降は常に0.
+ */
+typedef struct {
+  uint8_t tiles[MJ_TILE_COUNTS_LEN];
+} MJTileCounts;
+
+/*
+ * mj_prepare_hand で検証済みの手牌. 同じ手牌を異なるアガリ牌, ロン/ツモ, 風で繰り返し計算する場合に使う.
+ * members are internal use.
+ */
+typedef struct {
+  MJTileCounts concealed;  // hands - melds
+  MJMelds melded;          // melds converted to elements
+  uint64_t hash;           // zobrist hash of concealed and melded. mj_hand_draw, mj_hand_discard, mj_hand_call で更新される
+} MJPreparedHand;
+
+/*
+ * mj_play_game の対局の状態と行動.
+ */
+typedef enum {
+  MJ_ACTION_DISCARD = 0,  // tile を打牌
+  MJ_ACTION_RIICHI,       // tile を打牌してリーチ
+  MJ_ACTION_TSUMO,        // tile でツモアガリ
+  MJ_ACTION_RON,          // tile でロン
+  MJ_ACTION_CHI,          // tile を first から始まる順子でチー
+  MJ_ACTION_PON,          // tile をポン
+  MJ_ACTION_MINKAN,       // tile を明槓
+  MJ_ACTION_ANKAN,        // tile を暗槓
+  MJ_ACTION_KAKAN,        // tile を加槓
+  MJ_ACTION_PASS,         // 他家の打牌に対して何もしない
+} MJActionType;
+
+typedef struct {
+  MJActionType type;
+  MJTileId tile;
+  MJTileId first;  // MJ_ACTION_CHI only
+} MJAction;
+
+typedef struct {
+  MJPreparedHand hand;                // 手牌と副露. ツモ後は3n+2枚
+  MJTileId river[MJ_GAME_MAX_RIVER];  // 捨て牌(鳴かれた牌を含む). MJ_GAME_MAX_RIVER枚まで
+  uint32_t river_len;
+  int32_t points;
+  bool riichi;
+  int32_t shanten;        // 打牌後(3n+1枚)の手牌のシャンテン数. ツモ後も打牌するまで更新しない
+  uint64_t waits;         // shanten == 0 の待ち牌. bit[tile_id]
+  int32_t drawn_shanten;  // MJGame.drawn をツモった後(3n+2枚)の手牌のシャンテン数. 鳴いた後は更新しない
+  // members below are internal use
+  uint64_t state_hash;   // shanten, waits を求めた手牌の hash
+  uint64_t acceptables;  // bit[tile_id]: ツモるとシャンテン数が減る牌. checked の牌だけ有効
+  uint64_t checked;      // bit[tile_id]: acceptables を求めた牌. ツモった牌だけ求める
+  uint64_t discarded;    // 捨てた牌. bit[tile_id]
+  bool furiten;          // 同巡内, リーチ後の見逃し
+  bool ippatsu;
+} MJGamePlayer;
+
+typedef struct {
+  MJGamePlayer players[MJ_GAME_PLAYERS];
+  uint32_t round;   // 0: 東1局, 4: 南1局
+  uint32_t dealer;  // 親のプレイヤー
+  uint32_t honba;
+  uint32_t riichi_sticks;  // 供託の本数
+  uint32_t turn;           // 手番のプレイヤー
+  MJTileId drawn;          // 手番のプレイヤーがツモった牌. 鳴いた後は MJ_DR + 1
+  MJTileId dora_indicators[MJ_GAME_MAX_DORA];
+  uint32_t dora_len;
+  uint32_t wall_left;  // 残りツモ数(王牌を除く)
+  // members below are internal use
+  uint8_t wall[MJ_GAME_WALL_LEN];
+  uint32_t wall_pos;
+  uint32_t wall_end;
+  uint32_t kans;
+} MJGame;
+
+/*
+ * 行動の選択. actions から1つ選び, その位置を返す. game は読み取り専用.
+ * 手番のプレイヤー(打牌, リーチ, ツモ, 暗槓, 加槓)と, 打牌に対する他家(ロン, ポン, 明槓, チー, パス)で呼ばれる.
+ */
+typedef uint32_t (*MJDecideFunc)(void *arg, const MJGame *game, uint32_t player, const MJAction *actions,
+                                 uint32_t len);
+
+typedef struct {
+  MJDecideFunc decide;
+  void *arg;
+} MJPlayer;
+
+typedef struct {
+  uint64_t seed;         // 同じseedと同じ行動なら同じ対局になる
+  uint32_t rounds;       // 4: 東風戦, 8: 半荘戦
+  int32_t start_points;  // 持ち点
+  MJPlayer players[MJ_GAME_PLAYERS];
+} MJGameConfig;
+
+typedef struct {
+  int32_t points[MJ_GAME_PLAYERS];
+  uint32_t ranks[MJ_GAME_PLAYERS];  // 0: 1位. 同点は起家に近い順
+  uint32_t hands;                   // 局数(連荘を含む)
+  uint32_t wins;                    // アガリの数
+  uint32_t exhaustive_draws;        // 流局の数
+} MJGameResult;
+
+/* mj_play_games の集計. 全対局の合計 */
+typedef struct {
+  uint64_t games;
+  uint64_t hands;
+  uint64_t wins;
+  uint64_t exhaustive_draws;
+  int64_t points[MJ_GAME_PLAYERS];                   // 最終持ち点の合計
+  uint64_t ranks[MJ_GAME_PLAYERS][MJ_GAME_PLAYERS];  // [席][順位] の回数
+} MJGameStats;
+
+/* mj_enumerate_complete_hands のツモ, ロンごとの集計. 手牌とアガリ牌の組ごとに数える */
+typedef struct {
+  uint64_t scored;                     // 計算した組の数
+  uint64_t no_yaku;                    // 役なし (han 0)
+  uint64_t yaku[MJ_ENUM_YAKU_LEN];     // 役ごとの出現数
+  uint64_t han[MJ_ENUM_HAN_LEN];       // 翻数の分布. 役なしを除く
+  uint64_t fu[MJ_ENUM_FU_LEN];         // 符 / 5 の分布. 役なしを除く
+  uint64_t limits[MJ_ENUM_LIMIT_LEN];  // 子のロンの点数で分けた分布. 役なしを除く
+  uint64_t points;                     // 点数の合計. ツモは3人の支払いの合計
+} MJEnumScoreStats;
+
+/* mj_enumerate_complete_hands の集計 */
+typedef struct {
+  uint64_t hands;       // 門前14枚のアガリ形の数
+  uint64_t normal;      // 通常形
+  uint64_t chiitoitsu;  // 通常形に分解できない七対子
+  uint64_t kokushi;     // 国士無双
+  MJEnumScoreStats tsumo;
+  MJEnumScoreStats ron;
+} MJEnumStats;
+
+typedef struct {
+  MJTileId player_wind;
+  MJTileId round_wind;
+  uint32_t threads;  // 0, 1: 呼び出したスレッドのみ. MJ_BATCH_MAX_THREADS まで
+  bool symmetry;     // 萬子, 筒子, 索子を入れ替えた手牌をまとめて1回だけ計算する. 集計は同じ
+} MJEnumConfig;
+
+/* mj_replay_mjlog の集計 */
+typedef struct {
+  uint64_t files;
+  uint64_t bytes;
+  uint64_t games;                        // TAIKYOKU
+  uint64_t hands;                        // INIT
+  uint64_t draws;                        // ツモ
+  uint64_t discards;                     // 打牌
+  uint64_t calls;                        // 副露 (暗槓, 加槓を含む)
+  uint64_t riichi;                       // リーチ宣言
+  uint64_t wins;                         // AGARI. ダブロンは2回
+  uint64_t exhaustive_draws;             // 荒牌流局
+  uint64_t abortive_draws;               // 途中流局
+  uint64_t shanten[MJ_LOG_SHANTEN_LEN];  // ツモ後のシャンテン数 (通常形, 七対子, 国士無双の最小) + 1 の分布
+  uint64_t ukeire_kinds;                 // 打牌後の受け入れの種類の合計
+  uint64_t ukeire_tiles;                 // 打牌後の受け入れの枚数 (自分の手牌を除く) の合計
+  uint64_t scored;                       // mj_get_score に成功したアガリ
+  uint64_t score_errors;                 // mj_get_score に失敗したアガリ
+  uint64_t hand_mismatches;              // 再生した手牌が AGARI の hai と異なる
+  uint64_t han_mismatches;               // 偶然役とドラを除く牌譜の翻数と異なる
+  uint64_t fu_mismatches;                // 牌譜の符と異なる (役満を除く)
+} MJLogStats;
+
+typedef enum {
+  MJ_LOG_EVENT_INIT = 0,  // 配牌. player は親
+  MJ_LOG_EVENT_DRAW,
+  MJ_LOG_EVENT_DISCARD,
+  MJ_LOG_EVENT_CALL,
+  MJ_LOG_EVENT_WIN,
+  MJ_LOG_EVENT_RYUUKYOKU,
+} MJLogEventType;
+
+typedef struct {
+  MJLogEventType type;
+  uint64_t file;               // mj_replay_mjlog_files の paths の添字
+  uint32_t player;             // 0-3: 起家からの席
+  MJTileId tile;               // ツモ, 打牌, 鳴いた牌, アガリ牌
+  MJTileId player_wind;
+  MJTileId round_wind;
+  const MJPreparedHand *hand;  // イベント後の手牌. ロンはアガリ牌を加えた手牌
+  MJShanten shanten;           // DRAW: ツモ後, DISCARD: 打牌後. 副露があれば chiitoitsu, kokushi は INT32_MAX
+  MJTiles ukeire;              // DISCARD: 打牌後の受け入れ (シャンテン数が最小の形の和)
+  uint32_t ukeire_kinds;       // DISCARD
+  uint32_t ukeire_tiles;       // DISCARD: 自分の手牌と副露を除いた枚数
+  const MJBaseScore *score;    // WIN: 偶然役とドラを除く点数
+  int32_t score_ret;           // WIN: mj_get_score の戻り値
+} MJLogEvent;
+
+/* 牌譜のイベントごとに呼ばれる. worker は mj_parallel_for と同じ */
+typedef void (*MJLogEventFunc)(void *arg, uint32_t worker, const MJLogEvent *event);
+
+typedef struct {
+  uint32_t threads;     // 0, 1: 呼び出したスレッドのみ. MJ_BATCH_MAX_THREADS まで
+  MJLogEventFunc func;  // NULL: 集計のみ
+  void *arg;
+} MJLogConfig;
+
+/*
+ * 固定長 (24 bytes) の手牌レコード. 1つの手牌の mj_get_score の引数を全て持つ.
+ * mj_encode_hand_record で作り, mj_decode_hand_record で戻す. members are internal use, except tag.
+ */
+typedef struct {
+  uint32_t tag;                          // 呼び出し元が自由に使う値 (元データの行番号など). 結果にコピーされる
+  uint8_t counts[MJ_RECORD_COUNTS_LEN];  // 牌の種類ごとの枚数 (副露を含む) を 3 bit ずつ
+  uint8_t melds[MJ_ELEMENTS_LEN];        // bit 0-5: 最小の牌, bit 6-7: 種類 (チー, ポン, 明槓, 暗槓)
+  uint8_t meld_len;
+  uint8_t win_tile;  // bit 0-5: win tile, bit 7: ron
+  uint8_t winds;     // bit 0-1: player wind - MJ_WT, bit 2-3: round wind - MJ_WT
+} MJHandRecord;
+
+/* mj_score_records の結果のレコード (16 bytes) */
+typedef struct {
+  uint32_t tag;   // MJHandRecord.tag
+  int8_t ret;     // mj_get_score の戻り値
+  uint8_t han;    // 役満は 13 の倍数
+  uint8_t fu;
+  uint8_t reserved;
+  uint64_t yaku;  // bit i: mj_enum_yaku_name(i) の役
+} MJScoreRecord;
+
+/* mj_calc_shanten_records の結果のレコード (8 bytes) */
+typedef struct {
+  uint32_t tag;  // MJHandRecord.tag
+  int8_t ret;    // mj_calc_shanten の戻り値
+  int8_t normal;
+  int8_t chiitoitsu;  // 副露があれば MJ_RECORD_NO_SHANTEN
+  int8_t kokushi;     // 副露があれば MJ_RECORD_NO_SHANTEN
+} MJShantenRecord;
+
+typedef enum {
+  MJ_RECORD_HANDS = 1,  // MJHandRecord
+  MJ_RECORD_SCORES,     // MJScoreRecord
+  MJ_RECORD_SHANTENS,   // MJShantenRecord
+} MJRecordType;
+
+/* レコードファイルの先頭. 続けて record_size の大きさのレコードが len 個並ぶ */
+typedef struct {
+  char magic[4];  // "MJRC"
+  uint32_t version;
+  uint32_t type;  // MJRecordType
+  uint32_t record_size;
+  uint64_t len;
+} MJRecordHeader;
+
+/*
+ * "123m456p789s11z" 形式の手牌. m, p, s は萬子, 筒子, 索子の 1-9, z は字牌の 1-7 (東南西北白發中).
+ * "(123m)" は副露 (チー, ポン, 明槓), "[1111z]" は暗槓, 最後の "+5p" はアガリ牌.
+ */
+typedef struct {
+  MJTileCounts tiles;  // 副露とアガリ牌を含む全ての牌の枚数
+  MJMelds melds;
+  MJTileId win_tile;  // has_win_tile のときだけ有効. tiles にも含む
+  bool has_win_tile;
+} MJNotation;
+
+/*
+ * mj_run_server の問い合わせ. MJ_QUERY_SHANTEN, MJ_QUERY_UKEIRE, MJ_QUERY_WAIT は副露を除いた手牌で計算し,
+ * hand の win_tile, winds は使わない.
+ */
+typedef enum {
+  MJ_QUERY_SCORE = 1,  // mj_get_score
+  MJ_QUERY_SHANTEN,    // mj_calc_shanten
+  MJ_QUERY_UKEIRE,     // シャンテン数が最小になる形の受け入れ
+  MJ_QUERY_WAIT,       // テンパイ (3n+1枚) の待ち. テンパイでなければ tiles は 0
+} MJQueryKind;
+
+/* 問い合わせ (32 bytes). そのまま socket に書く */
+typedef struct {
+  MJHandRecord hand;  // hand.tag は結果にコピーされる
+  uint32_t kind;      // MJQueryKind
+  uint32_t reserved;
+} MJQuery;
+
+/* 問い合わせの結果 (24 bytes) */
+typedef struct {
+  uint32_t tag;  // MJQuery.hand.tag
+  int8_t ret;
+  uint8_t kind;   // MJQuery.kind
+  uint8_t han;    // SCORE
+  uint8_t fu;     // SCORE
+  int8_t normal;  // SHANTEN, UKEIRE, WAIT: MJShantenRecord と同じ
+  int8_t chiitoitsu;
+  int8_t kokushi;
+  uint8_t count;   // UKEIRE, WAIT: 自分の手牌と副露を除いた残り枚数
+  uint64_t value;  // SCORE: MJScoreRecord.yaku と同じ. UKEIRE, WAIT: bit i が MJTileId i の牌
+} MJQueryResult;
+
+typedef struct {
+  uint64_t connections;
+  uint64_t queries;
+  uint64_t batches;
+  uint64_t max_batch;                        // 1度にまとめた問い合わせの最大数
+  uint64_t latency[MJ_SERVER_LATENCY_LEN];  // 受信してから結果を送るまでの時間 (us) ごとの問い合わせ数
+} MJServerStats;
+
+/*
+ * スレッドごとの計算量. MJ_ENABLE_STATS を定義してビルド (make STATS=1) した場合だけ数える.
+ * 定義しなければ数える処理はコンパイルされない.
+ */
+typedef struct {
+  uint64_t shanten_calls;          // 通常手のシャンテン数の計算 (mj_ukeire_* の中も含む)
+  uint64_t shanten_nodes;          // シャンテン数の探索で訪れた面子の組み合わせ
+  uint64_t agari_calls;            // アガリ形の分解 (mj_get_score など)
+  uint64_t agari_decompositions;   // 見つかったアガリ形の分解
+  uint64_t scored_decompositions;  // 役と符を求めた分解. 点数計算の条件ごとに数える
+  uint64_t yaku_checks;            // 役の判定関数の呼び出し
+  uint64_t early_exits;            // 途中で打ち切った探索と判定: 面子が多すぎる, 役満で残りの役を判定しない
+} MJStats;
+
+/* UNIX domain socket の計算サーバー. 大きいので static などに置く. members are internal use, except stats */
+typedef struct {
+  int32_t listen_fd;
+  int32_t wake_fds[2];  // mj_stop_server が書き込む pipe
+  int32_t client_fds[MJ_SERVER_MAX_CLIENTS];
+  uint32_t client_lens[MJ_SERVER_MAX_CLIENTS];
+  // client_buffers の問い合わせごとの受信し終えた時刻 (ns)
+  uint64_t client_times[MJ_SERVER_MAX_CLIENTS][MJ_SERVER_CLIENT_QUERIES];
+  uint8_t client_buffers[MJ_SERVER_MAX_CLIENTS][MJ_SERVER_CLIENT_QUERIES * sizeof(MJQuery)];
+  uint32_t client_output_lens[MJ_SERVER_MAX_CLIENTS];
+  // 送り切れていない結果. POLLOUT で送る
+  uint8_t client_outputs[MJ_SERVER_MAX_CLIENTS][MJ_SERVER_CLIENT_QUERIES * sizeof(MJQueryResult)];
+  MJQuery queries[MJ_SERVER_BATCH_LEN];
+  uint64_t query_times[MJ_SERVER_BATCH_LEN];  // queries を受信し終えた時刻 (ns)
+  MJQueryResult results[MJ_SERVER_BATCH_LEN];
+  uint32_t query_clients[MJ_SERVER_BATCH_LEN];
+  uint32_t next_client;  // 次のバッチを詰め始めるクライアント
+  uint32_t threads;
+  char path[MJ_SERVER_PATH_LEN];
+  MJServerStats stats;  // mj_run_server が返った後に読む
+} MJServer;
+
+/* 共有メモリのリング. fd を fork や SCM_RIGHTS で他のプロセスに渡し, mj_open_ring で同じリングを使う */
+typedef struct {
+  void *map;         // internal use
+  uint64_t map_len;  // internal use
+  int32_t fd;        // memfd
+  uint32_t len;      // number of slots
+} MJRing;
+
+/* mmap したレコードファイル */
+typedef struct {
+  void *records;  // 先頭のレコード. MJHandRecord などの配列として読み書きする
+  uint64_t len;
+  MJRecordType type;
+  void *map;         // internal use
+  uint64_t map_len;  // internal use
+  bool writable;     // internal use
+} MJRecordFile;
+
+/*
+ * mj_parallel_for のタスク. index ごとに1回呼ばれる.
+ * worker は [0, threads) で, 同時に同じ worker で呼ばれることはないので, ワーカーごとの出力先の添字に使える.
+ */
+typedef void (*MJTaskFunc)(void *arg, uint32_t worker, uint64_t index);
 
 /*
  * return
@@ -154,6 +625,483 @@ typedef struct {
 int32_t mj_get_score(MJBaseScore *score, const MJHands *hands, const MJMelds *melds, MJTileId win_tile, bool ron,
                      MJTileId player_wind, MJTileId round_wind);
 
+/*
+ * return
+ *   MJ_OK: success
+ *   others: error
+ * params
+ *   [out]
+ *     prepared: validated hands and melds
+ *   [in]
+ *     hands: all tiles include melds and win_tile
+ *     melds: list of meld
+ */
+int32_t mj_prepare_hand(MJPreparedHand *prepared, const MJHands *hands, const MJMelds *melds);
+
+/*
+ * mj_get_score と同じ. ただし手牌と副露の検証は mj_prepare_hand で済んでいるものとする.
+ * return
+ *   MJ_OK: success
+ * params
+ *   [out]
+ *     score: calculated Score
+ *   [in]
+ *     prepared: generated with mj_prepare_hand
+ *     win_tile: win_tile
+ */
+int32_t mj_score_prepared(MJBaseScore *score, const MJPreparedHand *prepared, MJTileId win_tile, bool ron,
+                          MJTileId player_wind, MJTileId round_wind);
+
+/*
+ * 1つの手牌を複数の条件(アガリ牌, ロン/ツモ, 自風, 場風)で計算する. アガリ形の分解は1度だけ行う.
+ * return
+ *   MJ_OK: success
+ *   others: error (any of configs is illegal, or agari is not found)
+ * params
+ *   [out]
+ *     scores: calculated Score for each config. scores[i] corresponds to configs[i]
+ *   [in]
+ *     hands: all tiles include melds and win_tile
+ *     melds: list of meld
+ *     prepared: generated with mj_prepare_hand
+ *     configs: list of config. win_tile of each config must be in concealed tiles
+ *     len: length of configs and scores
+ */
+int32_t mj_get_scores(MJBaseScore *scores, const MJHands *hands, const MJMelds *melds, const MJScoreConfig *configs,
+                      uint32_t len);
+int32_t mj_score_prepared_multi(MJBaseScore *scores, const MJPreparedHand *prepared, const MJScoreConfig *configs,
+                                uint32_t len);
+
+/*
+ * 対局中の手牌の状態として MJPreparedHand を初期化する. mj_prepare_hand と異なり枚数(13枚など)は検証しない.
+ * return
+ *   MJ_OK: success
+ *   others: error
+ * params
+ *   [out]
+ *     hand: hand state
+ *   [in]
+ *     hands: all tiles include melds
+ *     melds: list of meld
+ */
+int32_t mj_init_hand(MJPreparedHand *hand, const MJHands *hands, const MJMelds *melds);
+
+/*
+ * 手牌の状態を1枚ツモ, 1枚打牌, 副露で更新する. hashはO(1)で更新される.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: tile_id is invalid, tile_id is already 4 (draw) or not in concealed tiles (discard),
+ *                         or meld tiles are not in concealed tiles (call)
+ * params
+ *   [in/out]
+ *     hand: generated with mj_prepare_hand or mj_init_hand
+ *   [in]
+ *     tile_id: drawn or discarded tile
+ *     meld: チー, ポン, 明槓 は called_tile 以外を, 暗槓 (concealed) は4枚とも手牌から除く.
+ *           ポンと同じ牌の明槓は加槓として扱い, 手牌から1枚除いてポンを置き換える.
+ *     called_tile: 他家から鳴いた牌. 暗槓と加槓では使わない
+ */
+int32_t mj_hand_draw(MJPreparedHand *hand, MJTileId tile_id);
+int32_t mj_hand_discard(MJPreparedHand *hand, MJTileId tile_id);
+int32_t mj_hand_call(MJPreparedHand *hand, const MJMeld *meld, MJTileId called_tile);
+
+/*
+ * 手牌の64bit zobrist hash. mj_prepare_hand, mj_init_hand で求まる MJPreparedHand.hash と同じ値になる.
+ * return
+ *   MJ_OK: success
+ *   others: error
+ * params
+ *   [out]
+ *     hash: zobrist hash
+ *   [in]
+ *     hands: all tiles include melds
+ *     melds: list of meld
+ */
+int32_t mj_hash_tiles(uint64_t *hash, const MJHands *hands, const MJMelds *melds);
+
+/*
+ * 打牌候補ごとに, 見えていない牌からツモを draws 回引く試行を samples 回行い, テンパイ率とツモアガリ率を求める.
+ * 2巡目以降の打牌はシャンテン数を減らす(減らなければツモ切りする)貪欲法で選ぶ. 役の有無, ロン, 副露は考慮しない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: hands are not after draw (3n+2 concealed tiles), visible tiles exceed 4, or config is invalid
+ *   others: error
+ * params
+ *   [out]
+ *     results: result for each discard candidate. must have MJ_DR + 1 entries
+ *     len: number of results
+ *   [in]
+ *     hands: all tiles include melds (after draw)
+ *     melds: list of meld
+ *     visible: 手牌以外で見えている牌(捨て牌, 他家の副露, ドラ表示牌)の枚数. NULLの場合は0枚
+ *     config: simulation config
+ */
+int32_t mj_simulate_discards(MJSimResult *results, uint32_t *len, const MJHands *hands, const MJMelds *melds,
+                             const MJTiles *visible, const MJSimConfig *config);
+
+void mj_init_win_prob_table(MJWinProbTable *table);
+
+/*
+ * テンパイまたは1向聴の手牌が, 見えていない牌 unseen から draws 回ツモる間にツモアガリ(和了形)する確率を厳密に求める.
+ * 山は unseen の牌が一様な順番で積まれているものとする.
+ * 有効牌をツモった場合はその後のアガリ確率が最大になる牌を切り, それ以外はツモ切りする. 役の有無, ロン, 副露は考慮しない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: hands are not 3n+1 concealed tiles, unseen tiles exceed 4 with hands,
+ *                         or hands is 2-shanten or more and may win within draws
+ *   others: error
+ * params
+ *   [out]
+ *     prob: win probability
+ *   [in]
+ *     hands: all tiles include melds (after discard)
+ *     melds: list of meld
+ *     unseen: 見えていない牌(山, 他家の手牌)の枚数
+ *     draws: 残りツモ回数
+ *     table: 置換表. mj_init_win_prob_table で初期化しておくこと
+ */
+int32_t mj_win_probability(double *prob, const MJHands *hands, const MJMelds *melds, const MJTiles *unseen,
+                           uint32_t draws, MJWinProbTable *table);
+
+/*
+ * ツモ後の手牌(3n+2枚)の打牌候補ごとに mj_win_probability を求める.
+ * params
+ *   [out]
+ *     results: result for each discard candidate. must have MJ_DR + 1 entries
+ *     len: number of results
+ */
+int32_t mj_win_probability_discards(MJWinProbResult *results, uint32_t *len, const MJHands *hands,
+                                    const MJMelds *melds, const MJTiles *unseen, uint32_t draws,
+                                    MJWinProbTable *table);
+
+/*
+ * ツモ後の手牌(3n+2枚)の打牌候補ごとに, アガリ率とアガった場合の点数の期待値の積を求め, 大きい順に並べる.
+ * テンパイと1向聴のアガリ率は mj_win_probability_discards で厳密に, 2向聴以上は mj_simulate_discards と同様の
+ * シミュレーションで求める. 点数は待ち牌ごとに残り枚数で重み付けし, ツモとロンを ron_rate で混ぜる.
+ * 1向聴はツモごとに点数と待ちの広さの積が最大になる牌を切るものとし,
+ * 2向聴以上はシミュレーションでアガった手牌の平均とする.
+ * 同じアガリ形は打牌候補をまたいで1回だけ面子に分解し, ツモとロンの点数を同時に求める.
+ * 場況役(一発, 海底など), 裏ドラ, 赤ドラ, 本場は考慮しない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: hands are not after draw (3n+2 concealed tiles), visible tiles exceed 4, or config is invalid
+ *   others: error
+ * params
+ *   [out]
+ *     results: result for each discard candidate, sorted by ev (descending). must have MJ_DR + 1 entries
+ *     len: number of results
+ *   [in]
+ *     hands: all tiles include melds (after draw)
+ *     melds: list of meld
+ *     visible: 手牌以外で見えている牌(捨て牌, 他家の副露, ドラ表示牌)の枚数. NULLの場合は0枚
+ *     config: evaluation config
+ *     table: mj_win_probability の置換表. mj_init_win_prob_table で初期化しておくこと
+ */
+int32_t mj_evaluate_discards(MJEvResult *results, uint32_t *len, const MJHands *hands, const MJMelds *melds,
+                             const MJTiles *visible, const MJEvConfig *config, MJWinProbTable *table);
+
+/*
+ * 4人の対局を1回行う. 配牌, ツモ, 打牌, 鳴き, リーチ, アガリ, 流局, 精算を繰り返し, config->rounds 局で終了する.
+ * ルールはMリーグに準じる(赤ドラなし, 頭ハネ, 途中流局なし, 飛びなし). 対局中にヒープは確保しない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: config is invalid, or decide returns an index out of actions
+ * params
+ *   [out]
+ *     result: final points and ranks
+ *   [in]
+ *     config: game config
+ */
+int32_t mj_play_game(MJGameResult *result, const MJGameConfig *config);
+
+/*
+ * 組み込みの行動選択. アガれるならアガり, 鳴かず, シャンテン数を減らす(減らなければツモ切りする)牌を切り,
+ * テンパイしたらリーチする.
+ * arg は使わない.
+ */
+uint32_t mj_decide_greedy(void *arg, const MJGame *game, uint32_t player, const MJAction *actions, uint32_t len);
+
+/*
+ * func(arg, worker, index) を index = [0, len) について threads 個のスレッドで並列に実行する.
+ * ワーカーごとの deque から区間を取り出して実行し, 空になったら他のワーカーから盗む(work-stealing).
+ * 実行順序とワーカーの割り当ては決まらないので, 結果を threads によらず同じにするには index だけから計算すること.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: threads exceeds MJ_BATCH_MAX_THREADS, or func is NULL
+ * params
+ *   [in]
+ *     len: number of tasks
+ *     threads: 0, 1: 呼び出したスレッドのみ. MJ_BATCH_MAX_THREADS まで
+ *     grain: 1回に取り出すタスク数の上限. 0: len と threads から決める
+ *     func: task
+ *     arg: argument of func
+ */
+int32_t mj_parallel_for(uint64_t len, uint32_t threads, uint64_t grain, MJTaskFunc func, void *arg);
+
+/*
+ * 独立した len 個の手牌を threads 個のスレッドで並列に計算する. i 番目は
+ * mj_get_score(&scores[i], &hands[i], &melds[i], configs[i].win_tile, ...) と同じ.
+ * return
+ *   MJ_OK: success. 手牌ごとの結果は rets
+ *   MJ_ERR_ILLEGAL_PARAM: threads exceeds MJ_BATCH_MAX_THREADS
+ * params
+ *   [out]
+ *     scores: calculated Score for each hand
+ *     rets: return value of mj_get_score for each hand
+ *   [in]
+ *     hands: all tiles include melds and win_tile for each hand
+ *     melds: list of meld for each hand
+ *     configs: config for each hand
+ *     len: length of scores, rets, hands, melds and configs
+ *     threads: 0, 1: 呼び出したスレッドのみ. MJ_BATCH_MAX_THREADS まで
+ */
+int32_t mj_get_scores_batch(MJBaseScore *scores, int32_t *rets, const MJHands *hands, const MJMelds *melds,
+                            const MJScoreConfig *configs, uint64_t len, uint32_t threads);
+
+/* mj_play_games の index 番目の対局の seed. この seed で mj_play_game を呼ぶと同じ対局を再現できる */
+uint64_t mj_batch_game_seed(uint64_t seed, uint64_t index);
+
+/*
+ * mj_play_game を len 回, threads 個のスレッドで並列に行う. index 番目の対局は seed を
+ * mj_batch_game_seed(config->seed, index) に置き換えた config で行うので, 結果は threads によらず同じになる.
+ * 集計はワーカーごとに行い, 最後に足し合わせる. decide は複数のスレッドから同時に呼ばれる.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: threads exceeds MJ_BATCH_MAX_THREADS
+ *   others: 最初に失敗した対局の mj_play_game のエラー
+ * params
+ *   [out]
+ *     results: result for each game. NULL: 集計のみ
+ *     stats: sum of all games. NULL: 集計しない
+ *   [in]
+ *     len: number of games
+ *     config: game config
+ *     threads: 0, 1: 呼び出したスレッドのみ. MJ_BATCH_MAX_THREADS まで
+ */
+int32_t mj_play_games(MJGameResult *results, MJGameStats *stats, uint64_t len, const MJGameConfig *config,
+                      uint32_t threads);
+
+/*
+ * 門前14枚の全てのアガリ形 (通常形, 七対子, 国士無双) を列挙し, 手牌に含まれる牌ごとにアガリ牌として
+ * ツモとロンで mj_get_score と同じ点数計算を行い, 役, 翻数, 符, 点数を集計する.
+ * 集計はワーカーごとに行い, 最後に足し合わせる.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: illegal wind, or threads exceeds MJ_BATCH_MAX_THREADS
+ * params
+ *   [out]
+ *     stats: sum of all hands
+ *   [in]
+ *     config: enumeration config
+ */
+int32_t mj_enumerate_complete_hands(MJEnumStats *stats, const MJEnumConfig *config);
+
+/* MJEnumScoreStats.yaku[index] の役の名前 (MJBaseScore.yaku_name と同じ表記). index が範囲外なら NULL */
+const char *mj_enum_yaku_name(uint32_t index);
+
+/*
+ * 天鳳の牌譜 (mjlog の XML) を1度だけ読みながら再生し, ツモごとに mj_calc_shanten, 打牌ごとに mj_ukeire_*,
+ * アガリごとに mj_get_score を計算して集計する. 解析は config->func でイベントごとに行えるので,
+ * 牌譜を読み直す必要はない.
+ * mj_replay_mjlog_files はファイルごとに MJ_LOG_BUFFER_LEN の固定長のバッファで読むので, メモリ使用量はファイルの
+ * 大きさによらない. ファイルは threads 個のスレッドで並列に再生し, 集計はワーカーごとに行って最後に足し合わせる.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: threads exceeds MJ_BATCH_MAX_THREADS
+ *   MJ_ERR_ILLEGAL_LOG, MJ_ERR_IO: 最初に失敗したファイルのエラー. 他のファイルは全て, 失敗したファイルは
+ *                                   失敗した位置まで stats に含まれる
+ * params
+ *   [out]
+ *     stats: sum of all logs
+ *   [in]
+ *     data, len: mjlog の XML (gzip は展開しておく)
+ *     paths, len: mjlog の XML のファイル
+ *     config: replay config
+ */
+int32_t mj_replay_mjlog(MJLogStats *stats, const char *data, uint64_t len, const MJLogConfig *config);
+int32_t mj_replay_mjlog_files(MJLogStats *stats, const char *const *paths, uint64_t len, const MJLogConfig *config);
+
+/*
+ * mj_get_score の引数を固定長のレコードにする / レコードから戻す.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: 同じ牌が5枚以上, 手牌が多すぎる, 副露, アガリ牌, 風が正しくない
+ * params
+ *   [out]
+ *     record: encoded record. tag は 0
+ *   [in]
+ *     hands: all tiles include melds and win_tile
+ *     melds: list of meld
+ *     config: win_tile, ron, player_wind, round_wind
+ */
+int32_t mj_encode_hand_record(MJHandRecord *record, const MJHands *hands, const MJMelds *melds,
+                              const MJScoreConfig *config);
+int32_t mj_decode_hand_record(MJHands *hands, MJMelds *melds, MJScoreConfig *config, const MJHandRecord *record);
+
+/*
+ * レコードファイルを mmap する. mj_open_record_file は読み込み専用, mj_create_record_file は len 個のレコードを
+ * 書き込むファイルを作る. file->records をそのまま mj_score_records などに渡せるので, コピーも変換もしない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: ヘッダが正しくない, または type が異なる
+ *   MJ_ERR_IO: ファイルを開けない, または mmap できない
+ * params
+ *   [out]
+ *     file: mapped file. mj_close_record_file で閉じる
+ *   [in]
+ *     path: file path
+ *     type: record type
+ *     len: number of records
+ */
+int32_t mj_open_record_file(MJRecordFile *file, const char *path, MJRecordType type);
+int32_t mj_create_record_file(MJRecordFile *file, const char *path, MJRecordType type, uint64_t len);
+int32_t mj_close_record_file(MJRecordFile *file);
+
+/*
+ * 手牌レコードを threads 個のスレッドで並列に計算する. i 番目は records[i] を戻して mj_get_score または
+ * mj_calc_shanten (副露を除いた手牌) を呼んだ結果と同じ.
+ * return
+ *   MJ_OK: success. 手牌ごとの結果は results の ret
+ *   MJ_ERR_ILLEGAL_PARAM: threads exceeds MJ_BATCH_MAX_THREADS
+ * params
+ *   [out]
+ *     results: result for each record
+ *   [in]
+ *     records: hand records
+ *     len: length of results and records
+ *     threads: 0, 1: 呼び出したスレッドのみ. MJ_BATCH_MAX_THREADS まで
+ */
+int32_t mj_score_records(MJScoreRecord *results, const MJHandRecord *records, uint64_t len, uint32_t threads);
+int32_t mj_calc_shanten_records(MJShantenRecord *results, const MJHandRecord *records, uint64_t len,
+                                uint32_t threads);
+
+/*
+ * 手牌の表記を解析する. 呼び出し元のバッファだけを使い, 1文字ずつ1回読むだけ.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: 表記が正しくない, 同じ牌が5枚以上, または副露が順子, 刻子, 槓子でない
+ *   MJ_ERR_NUM_TILES_LARGE: 牌が MJ_MAX_HAND_LEN 枚より多い
+ * params
+ *   [out]
+ *     notation: parsed hand
+ *   [in]
+ *     str: notation. '\0' で終わる必要はない
+ *     len: length of str
+ */
+int32_t mj_parse_notation(MJNotation *notation, const char *str, uint64_t len);
+
+/*
+ * 手牌を表記に戻す. 門前の牌は萬子, 筒子, 索子, 字牌の順に並べ, 副露は notation->melds の順.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: notation の牌と副露, アガリ牌が矛盾する, または buf が足りない
+ * params
+ *   [out]
+ *     buf: '\0' terminated notation. MJ_NOTATION_MAX_LEN あれば足りる
+ *     written: length of buf without '\0'. NULL 可
+ *   [in]
+ *     buf_len: size of buf
+ *     notation: hand
+ */
+int32_t mj_format_notation(char *buf, uint64_t buf_len, uint64_t *written, const MJNotation *notation);
+
+/*
+ * notation->tiles を牌の順に並べ, mj_get_score などの hands にする.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_NUM_TILES_LARGE: 牌が MJ_MAX_HAND_LEN 枚より多い
+ */
+int32_t mj_notation_to_hands(MJHands *hands, const MJNotation *notation);
+
+/*
+ * UNIX domain socket で MJQuery を受け取り, MJQueryResult を同じ順に返すサーバー.
+ * mj_run_server は poll で受信できた全てのクライアントの問い合わせを1つのバッチにまとめて threads 個のスレッドで
+ * 計算するので, プロセスごとにスレッドやテーブルを持たずに済む. mj_stop_server (シグナルハンドラからも呼べる)
+ * が呼ばれるまで返らない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: path が長すぎる, または threads exceeds MJ_BATCH_MAX_THREADS
+ *   MJ_ERR_IO: socket を作れない, または poll が失敗した
+ * params
+ *   [out]
+ *     server: server
+ *   [in]
+ *     path: socket path. 既にあれば削除して作り直す
+ *     threads: 0, 1: mj_run_server を呼んだスレッドのみ. MJ_BATCH_MAX_THREADS まで
+ */
+int32_t mj_open_server(MJServer *server, const char *path, uint32_t threads);
+int32_t mj_run_server(MJServer *server);
+void mj_stop_server(MJServer *server);
+void mj_close_server(MJServer *server);
+
+/* latency のうち percentile (0-100) % の問い合わせが収まる時間 (us) */
+uint32_t mj_server_latency_percentile(const MJServerStats *stats, double percentile);
+
+/*
+ * mj_run_server に問い合わせる. queries を順に送り, 同じ順の結果を results に受け取る.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: path が長すぎる
+ *   MJ_ERR_IO: 接続できない, または送受信が失敗した
+ * params
+ *   [out]
+ *     fd: connected socket. close で閉じる
+ *     results: result for each query
+ *   [in]
+ *     path: socket path
+ *     queries: queries
+ *     len: length of results and queries
+ */
+int32_t mj_connect_server(int32_t *fd, const char *path);
+int32_t mj_query_server(int32_t fd, MJQueryResult *results, const MJQuery *queries, uint64_t len);
+
+/*
+ * 共有メモリ (memfd) の MJQuery のリング. 問い合わせるプロセスは mj_submit_ring でスロットに書き込み,
+ * mj_wait_ring で同じスロットに書かれた結果を読む. 計算するプロセスは mj_run_ring のワーカーがスロットを取り出して
+ * 結果をその場に書く. 待つ側が眠っているときだけ futex で起こすので, 混んでいる間は問い合わせごとの syscall はない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: len が2のべき乗でない, または MJ_RING_MIN_LEN-MJ_RING_MAX_LEN の外. fd がリングでない
+ *   MJ_ERR_IO: memfd を作れない, または mmap できない
+ * params
+ *   [out]
+ *     ring: mapped ring. mj_close_ring で閉じる
+ *   [in]
+ *     len: number of slots (MJ_RING_MIN_LEN 以上の2のべき乗). 同時に処理中にできる問い合わせの数
+ *     fd: mj_create_ring で作った ring->fd
+ */
+int32_t mj_create_ring(MJRing *ring, uint32_t len);
+int32_t mj_open_ring(MJRing *ring, int32_t fd);
+void mj_close_ring(MJRing *ring);
+
+/*
+ * 問い合わせを書き込み, 結果を読むための ticket を返す. 次のスロットの前の周の結果がまだ読まれていなければ
+ * MJ_ERR_BUSY を返すので, 書き込み済みの結果を mj_wait_ring で読んでからやり直す. 待たないので, 書き込む側が
+ * 互いの結果を待って止まることはない.
+ * mj_wait_ring は ticket の結果を待って result にコピーし, スロットを空ける. ticket ごとに1回だけ呼ぶ.
+ */
+int32_t mj_submit_ring(MJRing *ring, uint32_t *ticket, const MJQuery *query);
+int32_t mj_wait_ring(MJRing *ring, MJQueryResult *result, uint32_t ticket);
+
+/*
+ * threads 個のワーカーで問い合わせを計算する. mj_stop_ring が呼ばれ, 書き込まれた問い合わせがなくなるまで返らない.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_ILLEGAL_PARAM: threads exceeds MJ_BATCH_MAX_THREADS
+ */
+int32_t mj_run_ring(MJRing *ring, uint32_t threads);
+void mj_stop_ring(MJRing *ring);
+
+/*
+ * 呼び出したスレッドの MJStats を読む, または0にする. mj_parallel_for などのワーカーの分はそのワーカーのスレッドで
+ * (タスクの中で) 読む.
+ * return
+ *   MJ_OK: success
+ *   MJ_ERR_NOT_SUPPORTED: MJ_ENABLE_STATS なしでビルドされた. stats は0
+ */
+int32_t mj_get_stats(MJStats *stats);
+void mj_reset_stats();
+
 /*
  * return
  *   MJ_OK: success
@@ -181,6 +1129,10 @@ int32_t mj_ukeire_kokushi(const MJHands *hands, MJTiles *acceptables);
 int32_t mj_ukeire_chiitoitsu(const MJHands *hands, MJTiles *acceptables);
 int32_t mj_ukeire_normal(const MJHands *hands, MJTiles *acceptables);
 
+#if defined(__GNUC__)
+#pragma GCC visibility pop
+#endif  // defined(__GNUC__)
+
 #if defined(__cplusplus)
 }
 #endif  // defined(__cplusplus)
@@ -0,0 +1,119 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [天鳳の牌譜 (mjlog) の再生]
+ * mjlog は <INIT .../><T52/><D52/><N who="1" m="..."/> ... のタグの列. 固定長のバッファに読み込みながらタグを1つずつ
+ * 取り出し, 全体を読み込んだりタグを保存したりしないので, メモリ使用量はファイルの大きさによらない.
+ * 牌は 136 種類の番号 (34種類 * 4 + 何枚目か) で, 副露は m にビット列で表される.
+ */
+
+#define MJLOG_MAX_ATTRS 16  // 1つのタグの属性の数の上限. AGARI が最も多い
+#define MJLOG_MAX_VALUES 64  // 1つの属性の数値の数の上限 (sc, yaku など)
+#define MJLOG_TILES_LEN 136
+
+typedef struct {
+  const char *name;
+  uint32_t name_len;
+  const char *value;
+  uint32_t value_len;
+} MjlogAttr;
+
+/* name, value は読み込みバッファを指し, 次に next_mjlog_tag を呼ぶまで有効 */
+typedef struct {
+  const char *name;
+  uint32_t name_len;
+  MjlogAttr attrs[MJLOG_MAX_ATTRS];
+  uint32_t attrs_len;
+} MjlogTag;
+
+typedef struct {
+  int fd;  // -1: data だけを読む
+  char *buffer;
+  uint64_t buffer_len;
+  const char *data;  // fd があれば buffer, なければ呼び出し元のデータ
+  uint64_t len;      // data の有効な長さ
+  uint64_t pos;      // data の次に読む位置
+  uint64_t bytes;    // 読み込んだバイト数
+  bool eof;
+  int32_t error;  // MJ_ERR_ILLEGAL_LOG: 形式が正しくない, タグが buffer_len より長い. MJ_ERR_IO: 読み込みに失敗した
+} MjlogReader;
+
+/* 牌譜を再生している状態 */
+typedef struct {
+  MJPreparedHand hands[MJ_GAME_PLAYERS];
+  bool active;  // INIT の後
+  uint32_t oya;
+  MJTileId round_wind;
+  MJTileId last_discard;  // 直前の打牌. 鳴きとロンの対象
+  uint32_t last_discarder;
+  uint64_t file;
+  uint32_t worker;
+  MJLogStats *stats;
+  const MJLogConfig *config;
+} MjlogReplay;
+
+/* fd から buffer に読み込みながらタグを取り出す. buffer_len はタグの長さの上限になる */
+void init_mjlog_reader_fd(MjlogReader *reader, int fd, char *buffer, uint64_t buffer_len);
+
+/* メモリ上の data からコピーせずにタグを取り出す */
+void init_mjlog_reader_data(MjlogReader *reader, const char *data, uint64_t len);
+
+/* 次の開始タグか空要素タグ. 終了タグ, 宣言, コメントは読み飛ばす. false: 終わり, または reader->error */
+bool next_mjlog_tag(MjlogReader *reader, MjlogTag *tag);
+
+bool is_mjlog_tag(const MjlogTag *tag, const char *name);
+const MjlogAttr *find_mjlog_attr(const MjlogTag *tag, const char *name);
+
+/* "1,2,3" の形の属性を values に読む. 属性がなければ len = 0 */
+bool parse_mjlog_values(const MjlogTag *tag, const char *name, int32_t *values, uint32_t *len, uint32_t max_len);
+
+/* 副露 m を手牌の副露 meld と鳴いた牌 called に変換する. called は暗槓と加槓では使わない */
+bool decode_mjlog_meld(uint32_t m, MJMeld *meld, MJTileId *called);
+
+void init_mjlog_replay(MjlogReplay *replay, MJLogStats *stats, const MJLogConfig *config, uint64_t file,
+                       uint32_t worker);
+
+/* タグ1つ分の状態を進め, stats に加え, config->func を呼ぶ */
+int32_t replay_mjlog_tag(MjlogReplay *replay, const MjlogTag *tag);
+
+/* reader の全てのタグを再生する */
+int32_t replay_mjlog(MjlogReplay *replay, MjlogReader *reader);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
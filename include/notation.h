@@ -0,0 +1,54 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+#define NOTATION_SUITS "mpsz"
+#define NOTATION_HONORS_SUIT 3  // 'z'
+
+/* 数字 number ('1'-'9') と種類 suit ('m', 'p', 's', 'z') の牌. 字牌は '1'-'7' */
+bool parse_notation_tile(MJTileId *tile_id, char number, char suit);
+
+static inline uint32_t get_notation_suit(MJTileId tile_id) {
+  return tile_id < MJ_WT ? (uint32_t)tile_id / TILE_NUM_LEN : NOTATION_HONORS_SUIT;
+}
+
+static inline char get_notation_number(MJTileId tile_id) {
+  return (char)('1' + (tile_id < MJ_WT ? (uint32_t)tile_id % TILE_NUM_LEN : (uint32_t)(tile_id - MJ_WT)));
+}
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
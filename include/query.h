@@ -0,0 +1,94 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mahjong.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [1行の JSON の問い合わせ] (mjscore.elf)
+ * 入力: {"id": 1, "kind": "score", "hand": "234m2234455p234s+3p", "ron": true, "player_wind": "1z"}
+ *   hand: mj_parse_notation の表記. 副露とアガリ牌を含む
+ *   kind: "score" (default), "shanten", "ukeire"
+ *   win_tile: hand に "+" がないときのアガリ牌. hand に含まれる牌
+ *   ron: default false
+ *   player_wind, round_wind: "1z"-"4z". default "1z"
+ *   id: そのまま出力にコピーする
+ * 出力:
+ *   score: {"id": 1, "ret": 0, "han": 4, "fu": 40, "yaku": ["sanshoku", "tanyao", "iipeiko"]}
+ *   shanten: {"ret": 0, "shanten": 0, "normal": 0, "chiitoitsu": 4, "kokushi": 11}
+ *   ukeire: {"ret": 0, "shanten": 0, "tiles": "14m", "count": 8}
+ *   エラー: {"ret": -1, "error": "..."}
+ */
+
+#define QUERY_LINE_LEN 1024  // これ以上の長さの行は "line too long"
+#define QUERY_OUTPUT_LEN (MJ_MAX_YAKU_NAME_LEN + 256)
+
+typedef enum {
+  QUERY_SCORE = 0,
+  QUERY_SHANTEN,
+  QUERY_UKEIRE,
+} QueryKind;
+
+/* JSON の値. 文字列は引用符の内側, それ以外は値そのもの. 入力の行を指すだけでコピーしない */
+typedef struct {
+  const char *str;
+  uint32_t len;
+  bool string;
+} JsonValue;
+
+typedef struct {
+  JsonValue id;
+  JsonValue hand;
+  JsonValue win_tile;
+  JsonValue player_wind;
+  JsonValue round_wind;
+  QueryKind kind;
+  bool ron;
+} Query;
+
+typedef struct {
+  char buf[QUERY_OUTPUT_LEN];
+  uint32_t len;
+} QueryOutput;
+
+/* p から始まる値を value にし, 値の次を返す. 配列とオブジェクトは読み飛ばすだけ. 失敗なら NULL */
+const char *parse_json_value(JsonValue *value, const char *p, const char *end);
+
+/* line の JSON オブジェクトを query にする. 失敗ならエラーの文言, 成功なら NULL */
+const char *parse_query(Query *query, const char *line, uint32_t len);
+
+/* 1行の問い合わせを計算し, 改行で終わる JSON を output に書く. len が QUERY_LINE_LEN 以上なら長すぎる行 */
+void process_query(QueryOutput *output, const char *line, uint32_t len);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -0,0 +1,78 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [固定長の手牌レコード]
+ * MJHandRecord は牌の種類ごとの枚数を 3 bit ずつ詰めて持つ. 副露は最小の牌と種類の 1 byte.
+ * レコードファイルは MJRecordHeader の後にレコードが並ぶだけなので, mmap してそのまま配列として読み書きできる.
+ */
+
+#define RECORD_MAGIC "MJRC"
+#define RECORD_VERSION 1
+#define RECORD_COUNT_BITS 3
+#define RECORD_TILE_MASK 0x3f
+#define RECORD_MELD_TYPE_SHIFT 6
+#define RECORD_RON 0x80
+#define RECORD_WIND_BITS 2
+
+typedef enum {
+  RECORD_MELD_CHI = 0,
+  RECORD_MELD_PON,
+  RECORD_MELD_MINKAN,  // 大明槓, 加槓
+  RECORD_MELD_ANKAN,
+} RecordMeldType;
+
+/* tiles の枚数 (0-4) を counts (MJ_RECORD_COUNTS_LEN bytes) に詰める. 5枚以上なら false */
+bool encode_record_counts(uint8_t *counts, const Tiles *tiles);
+void decode_record_counts(Tiles *tiles, const uint8_t *counts);
+
+bool encode_record_meld(uint8_t *code, const MJMeld *meld);
+bool decode_record_meld(MJMeld *meld, uint8_t code);
+
+/* 副露を除いた手牌を牌の順に並べる. レコードが正しくなければ false */
+bool decode_record_concealed(MJHands *hands, const MJHandRecord *record);
+
+/* mj_score_records, mj_calc_shanten_records の1レコード分 */
+void score_hand_record(MJScoreRecord *result, const MJHandRecord *record);
+void calc_hand_record_shanten(MJShantenRecord *result, const MJHandRecord *record);
+
+/* レコードの種類ごとの大きさ. 不明な種類なら 0 */
+uint32_t get_record_size(MJRecordType type);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -0,0 +1,85 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [共有メモリのリング]
+ * Vyukov の bounded MPMC queue (https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue)
+ * に結果を書き戻す段階を足したもの. ticket t のスロット t & mask の seq は
+ *   t: 空き -> t + 1: 問い合わせ済み -> t + 2: 計算済み -> t + len: 次の周の空き
+ * と進む. 書き込む側は head, ワーカーは tail から ticket を取る. どちらもスロットが次の状態になってから取るので,
+ * ticket を取ったまま待つことはない. seq, submitted は futex の待ち合わせにも使う.
+ */
+
+#define RING_MAGIC "MJRG"
+#define RING_VERSION 1
+#define RING_SPINS 256  // futex で眠る前に seq を読み直す回数
+#define RING_CACHE_LINE 64
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t len;
+  uint32_t mask;
+  alignas(RING_CACHE_LINE) atomic_uint head;  // 次に書き込む ticket
+  alignas(RING_CACHE_LINE) atomic_uint tail;  // 次にワーカーが取り出す ticket
+  alignas(RING_CACHE_LINE) atomic_uint submitted;  // 書き込むたびに増える. 眠っているワーカーの futex
+  atomic_uint sleepers;                            // 眠っているワーカーの数
+  atomic_uint stop;
+} RingHeader;
+
+/* 1スロットはちょうど1キャッシュライン */
+typedef struct {
+  alignas(RING_CACHE_LINE) atomic_uint seq;
+  atomic_uint waiters;  // seq を futex で待っている数
+  MJQuery query;
+  MJQueryResult result;
+} RingSlot;
+
+static inline RingHeader *get_ring_header(const MJRing *ring) { return (RingHeader *)ring->map; }
+
+/* 共有メモリの mask は別のプロセスが書き換えられるので, mj_open_ring で検査した ring->len を使う */
+static inline RingSlot *get_ring_slot(const MJRing *ring, uint32_t ticket) {
+  return &((RingSlot *)((char *)ring->map + sizeof(RingHeader)))[ticket & (ring->len - 1)];
+}
+
+/* ワーカー1つ分. ring が空で mj_stop_ring が呼ばれていれば返る */
+void run_ring_worker(MJRing *ring);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -0,0 +1,88 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * 乱数. xoshiro256** を splitmix64 で初期化する.
+ * https://prng.di.unimi.it/
+ * 同じseedからは環境によらず同じ乱数列になる. スレッドごと(タスクごと)に別のseedで初期化して使う.
+ */
+
+typedef struct {
+  uint64_t s[4];
+} Rng;
+
+static inline uint64_t next_splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static inline void seed_rng(Rng *rng, uint64_t seed) {
+  for (uint32_t i = 0; i < 4; i++) {
+    rng->s[i] = next_splitmix64(&seed);
+  }
+}
+
+static inline uint64_t rotl_rng(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+static inline uint64_t next_rng(Rng *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = rotl_rng(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl_rng(s[3], 45);
+  return result;
+}
+
+/* [0, bound) の一様乱数. bound > 0 */
+static inline uint32_t next_rng_bounded(Rng *rng, uint32_t bound) {
+  // Lemire's nearly divisionless method
+  uint64_t m = (next_rng(rng) >> 32) * bound;
+  if ((uint32_t)m < bound) {
+    uint32_t threshold = -bound % bound;
+    while ((uint32_t)m < threshold) {
+      m = (next_rng(rng) >> 32) * bound;
+    }
+  }
+  return (uint32_t)(m >> 32);
+}
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -0,0 +1,97 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [Work-stealing scheduler]
+ * タスク [0, len) をワーカー数で等分した区間として各ワーカーの deque に積み, 各ワーカーは自分の deque の底から区間を取り出す.
+ * 区間が grain より大きければ半分を底に積み直して残りを実行する. deque が空になったら他のワーカーの deque の先頭
+ * (積まれた中で最も大きい区間) を盗む. deque は Chase-Lev (固定長) で, 盗む側も含めてロックを取らない.
+ * https://fzn.fr/readings/ppopp13.pdf
+ * 区間は半分ずつ分割するので, deque に同時に積まれる区間は log2(len) 個を超えない.
+ */
+
+#define SCHED_MAX_WORKERS MJ_BATCH_MAX_THREADS
+#define SCHED_DEQUE_LEN 128  // 2のべき乗. 64bitのタスク数を分割しても溢れない
+#define SCHED_CACHE_LINE 64
+
+typedef struct {
+  atomic_uint_fast64_t begin;  // 盗む側が書き込み中の値を読んでも未定義動作にならないようにatomicにする
+  atomic_uint_fast64_t end;
+} SchedRange;
+
+typedef struct {
+  alignas(SCHED_CACHE_LINE) atomic_int_fast64_t top;     // 盗む側が進める
+  alignas(SCHED_CACHE_LINE) atomic_int_fast64_t bottom;  // 持ち主だけが書き込む
+  alignas(SCHED_CACHE_LINE) SchedRange ranges[SCHED_DEQUE_LEN];
+  alignas(SCHED_CACHE_LINE) uint64_t victim_seed;        // 盗む相手を選ぶ乱数. 持ち主だけが使う
+} SchedDeque;
+
+typedef struct {
+  SchedDeque deques[SCHED_MAX_WORKERS];
+  uint32_t workers;
+  uint64_t grain;
+  alignas(SCHED_CACHE_LINE) atomic_uint_fast64_t remaining;  // 実行が終わっていないタスク数
+} Scheduler;
+
+/* ワーカーの処理. 呼び出したスレッドが worker 0 として動く */
+typedef void (*SchedWorkerFunc)(void *arg, Scheduler *sched, uint32_t worker);
+
+/* deque の操作. push, pop は持ち主のワーカーだけが呼ぶ. steal はどのワーカーから呼んでもよい */
+void push_sched_deque(SchedDeque *deque, uint64_t begin, uint64_t end);
+bool pop_sched_deque(SchedDeque *deque, uint64_t *begin, uint64_t *end);
+bool steal_sched_deque(SchedDeque *deque, uint64_t *begin, uint64_t *end);
+
+/* タスク [0, len) を workers 個の deque に等分して積む. workers は 1 から SCHED_MAX_WORKERS まで, grain は 1 以上 */
+void init_scheduler(Scheduler *sched, uint64_t len, uint32_t workers, uint64_t grain);
+
+/*
+ * worker が次に実行するタスク区間 [begin, end) (grain 個以下) を返す. 全タスクが終わっていれば false.
+ * 実行し終えたら finish_scheduler_range を呼ぶこと.
+ */
+bool next_scheduler_range(Scheduler *sched, uint32_t worker, uint64_t *begin, uint64_t *end);
+void finish_scheduler_range(Scheduler *sched, uint64_t begin, uint64_t end);
+
+/*
+ * sched->workers - 1 個のスレッドを作り, 呼び出したスレッドと合わせて func を並列に実行し, 全て終わるまで待つ.
+ * スレッドが作れなかった場合は, そのワーカーの deque を他のワーカーが盗んで続ける.
+ */
+void run_scheduler(Scheduler *sched, SchedWorkerFunc func, void *arg);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -35,12 +35,7 @@
 extern "C" {
 #endif  // defined(__cplusplus)
 
-typedef struct {
-  MJTileId win_tile;
-  bool ron;
-  MJTileId player_wind;
-  MJTileId round_wind;
-} ScoreConfig;
+typedef MJScoreConfig ScoreConfig;
 
 bool calc_score(MJBaseScore *score, const Elements *concealed, const Elements *melded, MJTileId pair,
                 const ScoreConfig *cfg);
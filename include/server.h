@@ -0,0 +1,54 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "record.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [計算サーバー]
+ * 1つのスレッドが poll でクライアントの socket を待ち, 受信できた問い合わせを全てのクライアントから集めて
+ * MJServer.queries に詰める. 集めたバッチを mj_parallel_for で計算し, クライアントごとに続けて並んだ結果を
+ * 1回の send で返す. 同時に届いた問い合わせほど1つのバッチにまとまる.
+ * クライアントの socket は non-blocking で, 送り切れなかった結果は client_outputs に残して POLLOUT で送る.
+ * 結果を読まないクライアントは client_outputs が空くまで新しい問い合わせを計算しないので, 他のクライアントを待たせない.
+ */
+
+#define SERVER_NO_FD (-1)
+
+/* 1つの問い合わせを計算する */
+void process_server_query(MJQueryResult *result, const MJQuery *query);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
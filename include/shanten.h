@@ -28,32 +28,65 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "bitboard.h"
 #include "tile.h"
 
 #if defined(__cplusplus)
 extern "C" {
 #endif  // defined(__cplusplus)
 
+/* 萬子, 筒子, 索子, 字牌のうち1種類の通常手の探索結果 */
+typedef struct {
+  int8_t partials[MJ_PAIR_LEN][MJ_ELEMENTS_LEN + 1];  // [雀頭数][面子数] = 塔子数の最大値
+} SuitShanten;
+
 typedef struct {
   int32_t shanten_normal;
   int32_t shanten_chiitoitsu;
   int32_t shanten_kokushi;
-  int32_t shanten_normal_min;
   int32_t shanten_normal_max;
   Tiles tiles;
+  Bitboard bb;  // calc_shanten_normal の探索中の牌. tiles から作成する
   int32_t total_len;
-  int32_t elem_len;
-  int32_t pair_len;
-  int32_t partial_len;
-  int32_t stat_dig;
-  int32_t stat_dig_element;
-  int32_t stat_dig_partial;
 } ShantenCtx;
 
 void calc_shanten_kokushi(ShantenCtx *ctx);
 void calc_shanten_chiitoitsu(ShantenCtx *ctx);
 void calc_shanten_normal(ShantenCtx *ctx);
 
+/*
+ * tiles(副露を除いた手牌total_len枚)の通常手, 七対子, 国士無双のうち最小のシャンテン数.
+ * limit以下のシャンテン数が見つかった時点で探索を打ち切るので, 戻り値がlimit以下の場合は正確な最小値とは限らない.
+ * 正確な値が必要な場合は limit に -1 を指定する.
+ */
+int32_t calc_shanten_tiles(const Tiles *tiles, int32_t total_len, int32_t limit);
+
+/*
+ * [種類ごとの探索結果を保持したシャンテン数]
+ * 手牌の種類ごとの探索結果を保持し, 1枚加えた, 除いた手牌のシャンテン数を, その牌の種類だけ探索し直して求める.
+ * 手牌を更新する場合も, 前の手牌から変わった種類だけ探索し直す. 対局のように1枚ずつ変わる手牌を追うのに使う.
+ */
+typedef struct {
+  Bitboard bb;  // suits を求めた手牌
+  SuitShanten suits[BB_LEN];
+  SuitShanten halves[2];       // 萬子と筒子, 索子と字牌を足し合わせたもの
+  SuitShanten others[BB_LEN];  // suit 以外の種類を足し合わせたもの. others_valid の種類だけ有効
+  uint32_t others_valid;       // bit[suit]
+  int32_t total_len;
+  int32_t kinds;         // 七対子: 牌の種類数
+  int32_t pairs;         // 七対子: 2枚以上の牌の種類数
+  int32_t yaochu_kinds;  // 国士無双: 么九牌の種類数
+  int32_t yaochu_pairs;  // 国士無双: 2枚以上の么九牌の種類数
+  int32_t shanten;       // 手牌の通常手, 七対子, 国士無双の最小シャンテン数
+  bool valid;            // false なら全ての種類を探索する
+} SplitShanten;
+
+/* split を tiles(副露を除いた手牌total_len枚)に更新する. split は最初に valid = false にしておく */
+void update_split_shanten(SplitShanten *split, const Tiles *tiles, int32_t total_len);
+
+/* split の手牌に tile_id を1枚加えた(diff = 1), 除いた(diff = -1)手牌の最小シャンテン数. split の others を更新する */
+int32_t calc_split_shanten(SplitShanten *split, MJTileId tile_id, int32_t diff);
+
 #if defined(__cplusplus)
 }
 #endif  // defined(__cplusplus)
@@ -0,0 +1,90 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ev.h"
+#include "mahjong.h"
+#include "rng.h"
+#include "tile.h"
+#include "ukeire.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+#define SIM_WALL_LEN ((MJ_DR + 1) * MJ_MAX_TILES_LEN_IN_ELEMENT)
+#define SIM_BLOCK_SAMPLES 64  // 1タスクの試行回数. 乱数はタスクごとに (seed, 打牌候補, ブロック番号) から初期化する
+
+
+/* 打牌候補1つ分の試行の開始状態 */
+typedef struct {
+  Tiles concealed;              // 打牌後の手牌(副露を除く)
+  uint64_t hash;                // concealed の zobrist hash
+  int32_t total_len;            // concealed の枚数 (3n+1)
+  int32_t shanten;              // concealed のシャンテン数
+  uint8_t wall[SIM_WALL_LEN];   // 見えていない牌
+  uint32_t wall_len;
+} SimStart;
+
+/* 1試行の結果 */
+typedef struct {
+  bool tenpai;        // draws回のツモ以内にテンパイした
+  bool win;           // draws回のツモ以内にツモアガリ(和了形)した
+  MJTileId win_tile;  // 以下は win の場合のみ. アガリ牌
+  Tiles tiles;        // アガリ牌を含む手牌
+  uint64_t hash;      // tiles の zobrist hash
+} SimSample;
+
+/* 打牌候補ごとの, アガった試行の点数の合計 */
+typedef struct {
+  uint64_t tsumo;
+  uint64_t ron;
+} SimPoints;
+
+
+/*
+ * 貪欲法の打牌. ツモ後の tiles (total_len 枚) から, シャンテン数を shanten 以下に保つ牌のうち
+ * 孤立している牌を優先して1枚除き, 除いた牌を返す. シャンテン数を shanten 以下に保てる牌がない場合は MJ_DR + 1 を返す.
+ */
+MJTileId select_sim_discard(Tiles *tiles, int32_t total_len, int32_t shanten);
+
+/* 1試行. wallからdraws回ツモし, テンパイ, ツモアガリしたかを返す */
+void run_sim_sample(const SimStart *start, uint32_t draws, Rng *rng, ShantenCache *cache, SimSample *sample);
+
+/*
+ * mj_simulate_discards と同じ. ただし打牌候補を discards (bit[tile_id]) に含まれる牌に限り,
+ * scorer が NULL でなければアガった試行のアガリ形の点数を合計して points に返す. points は results と同じ順.
+ */
+int32_t simulate_discards(MJSimResult *results, SimPoints *points, uint32_t *len, const MJHands *hands,
+                          const MJMelds *melds, const MJTiles *visible, const MJSimConfig *config, uint64_t discards,
+                          const EvScorer *scorer);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -52,25 +52,140 @@ extern "C" {
 #define TILE_NUM_9 (9u - 1)
 #define TILE_NUM_INVALID (-1u)
 
-typedef MJTiles Tiles;
+#define TILE_NUM_LEN 9  // number of tiles in man, pin or sou
 
-bool is_tile_id_valid(MJTileId tile_id);
+/* 内部の牌の枚数表現. 公開APIの MJTiles とは gen_mj_tiles_from_tiles で変換する */
+typedef MJTileCounts Tiles;
 
-bool is_tile_id_honors(MJTileId tile_id);
-bool is_tile_id_wind(MJTileId tile_id);
-bool is_tile_id_dragon(MJTileId tile_id);
-bool is_tile_id_man(MJTileId tile_id);
-bool is_tile_id_pin(MJTileId tile_id);
-bool is_tile_id_sou(MJTileId tile_id);
+#define TILE_FLAG_HONORS (1u << 0)
+#define TILE_FLAG_WIND (1u << 1)
+#define TILE_FLAG_DRAGON (1u << 2)
+#define TILE_FLAG_YAOCHU (1u << 3)  // 1,9字牌
+#define TILE_FLAG_ROUTOU (1u << 4)  // 1,9牌
+#define TILE_FLAG_GREEN (1u << 5)   // 緑一色に使える牌. 索子の23468と發
+
+typedef struct {
+  uint8_t type;   // TILE_TYPE_*
+  int8_t number;  // TILE_NUM_*. 字牌は -1
+  uint8_t flags;  // TILE_FLAG_*
+} TileProperty;
+
+#define TILE_FLAG_TERMINAL (TILE_FLAG_YAOCHU | TILE_FLAG_ROUTOU)
+#define TILE_FLAG_WIND_HONORS (TILE_FLAG_HONORS | TILE_FLAG_WIND | TILE_FLAG_YAOCHU)
+#define TILE_FLAG_DRAGON_HONORS (TILE_FLAG_HONORS | TILE_FLAG_DRAGON | TILE_FLAG_YAOCHU)
+
+/*
+ * 牌の種類ごとの性質. 末尾の1つは範囲外の牌のための番兵.
+ * 定数として各翻訳単位に埋め込むので, 役や符の判定から関数呼び出しなしの表引き1回で引ける.
+ */
+static const TileProperty tile_properties[MJ_DR + 2] = {
+    {TILE_TYPE_MAN, 0, TILE_FLAG_TERMINAL},
+    {TILE_TYPE_MAN, 1, 0},
+    {TILE_TYPE_MAN, 2, 0},
+    {TILE_TYPE_MAN, 3, 0},
+    {TILE_TYPE_MAN, 4, 0},
+    {TILE_TYPE_MAN, 5, 0},
+    {TILE_TYPE_MAN, 6, 0},
+    {TILE_TYPE_MAN, 7, 0},
+    {TILE_TYPE_MAN, 8, TILE_FLAG_TERMINAL},
+    {TILE_TYPE_PIN, 0, TILE_FLAG_TERMINAL},
+    {TILE_TYPE_PIN, 1, 0},
+    {TILE_TYPE_PIN, 2, 0},
+    {TILE_TYPE_PIN, 3, 0},
+    {TILE_TYPE_PIN, 4, 0},
+    {TILE_TYPE_PIN, 5, 0},
+    {TILE_TYPE_PIN, 6, 0},
+    {TILE_TYPE_PIN, 7, 0},
+    {TILE_TYPE_PIN, 8, TILE_FLAG_TERMINAL},
+    {TILE_TYPE_SOU, 0, TILE_FLAG_TERMINAL},
+    {TILE_TYPE_SOU, 1, TILE_FLAG_GREEN},
+    {TILE_TYPE_SOU, 2, TILE_FLAG_GREEN},
+    {TILE_TYPE_SOU, 3, TILE_FLAG_GREEN},
+    {TILE_TYPE_SOU, 4, 0},
+    {TILE_TYPE_SOU, 5, TILE_FLAG_GREEN},
+    {TILE_TYPE_SOU, 6, 0},
+    {TILE_TYPE_SOU, 7, TILE_FLAG_GREEN},
+    {TILE_TYPE_SOU, 8, TILE_FLAG_TERMINAL},
+    {TILE_TYPE_WIND, -1, TILE_FLAG_WIND_HONORS},
+    {TILE_TYPE_WIND, -1, TILE_FLAG_WIND_HONORS},
+    {TILE_TYPE_WIND, -1, TILE_FLAG_WIND_HONORS},
+    {TILE_TYPE_WIND, -1, TILE_FLAG_WIND_HONORS},
+    {TILE_TYPE_DRAGON, -1, TILE_FLAG_DRAGON_HONORS},
+    {TILE_TYPE_DRAGON, -1, TILE_FLAG_DRAGON_HONORS | TILE_FLAG_GREEN},
+    {TILE_TYPE_DRAGON, -1, TILE_FLAG_DRAGON_HONORS},
+    {TILE_TYPE_INVALID, -1, 0},
+};
+
+static inline bool is_tile_id_valid(MJTileId tile_id) { return (uint32_t)tile_id <= MJ_DR; }
+
+static inline const TileProperty *get_tile_property(MJTileId tile_id) {
+  return &tile_properties[is_tile_id_valid(tile_id) ? tile_id : MJ_DR + 1];
+}
+
+static inline bool is_tile_id_honors(MJTileId tile_id) {
+  return (get_tile_property(tile_id)->flags & TILE_FLAG_HONORS) != 0;
+}
+static inline bool is_tile_id_wind(MJTileId tile_id) {
+  return (get_tile_property(tile_id)->flags & TILE_FLAG_WIND) != 0;
+}
+static inline bool is_tile_id_dragon(MJTileId tile_id) {
+  return (get_tile_property(tile_id)->flags & TILE_FLAG_DRAGON) != 0;
+}
+static inline bool is_tile_id_man(MJTileId tile_id) { return get_tile_property(tile_id)->type == TILE_TYPE_MAN; }
+static inline bool is_tile_id_pin(MJTileId tile_id) { return get_tile_property(tile_id)->type == TILE_TYPE_PIN; }
+static inline bool is_tile_id_sou(MJTileId tile_id) { return get_tile_property(tile_id)->type == TILE_TYPE_SOU; }
 /* 1,9字牌 */
-bool is_tile_id_yaochu(MJTileId tile_id);
+static inline bool is_tile_id_yaochu(MJTileId tile_id) {
+  return (get_tile_property(tile_id)->flags & TILE_FLAG_YAOCHU) != 0;
+}
 /* 1,9牌 */
-bool is_tile_id_routou(MJTileId tile_id);
+static inline bool is_tile_id_routou(MJTileId tile_id) {
+  return (get_tile_property(tile_id)->flags & TILE_FLAG_ROUTOU) != 0;
+}
+/* 索子の23468と發 */
+static inline bool is_tile_id_green(MJTileId tile_id) {
+  return (get_tile_property(tile_id)->flags & TILE_FLAG_GREEN) != 0;
+}
 
-uint32_t get_tile_type(MJTileId tile_id);
-uint32_t get_tile_number(MJTileId tile_id);  // for man, pin and sou
+static inline uint32_t get_tile_type(MJTileId tile_id) { return get_tile_property(tile_id)->type; }
+/* for man, pin and sou. 字牌は TILE_NUM_INVALID */
+static inline uint32_t get_tile_number(MJTileId tile_id) {
+  return (uint32_t)(int32_t)get_tile_property(tile_id)->number;
+}
 
 bool gen_tiles_from_hands(Tiles *tiles, const MJHands *hands);
+void gen_mj_tiles_from_tiles(MJTiles *mj_tiles, const Tiles *tiles);
+void gen_tiles_from_mj_tiles(Tiles *tiles, const MJTiles *mj_tiles);
+
+static inline void add_tile(Tiles *tiles, MJTileId tile_id) { tiles->tiles[tile_id]++; }
+
+static inline void remove_tile(Tiles *tiles, MJTileId tile_id) { tiles->tiles[tile_id]--; }
+
+/* 牌の総数. 8牌分の枚数を1度に足し合わせる */
+static inline uint32_t count_tiles(const Tiles *tiles) {
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < MJ_TILE_COUNTS_LEN; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, &tiles->tiles[i], sizeof(word));
+    sum += word;  // 各byteは高々4 * 6なので桁あふれしない
+  }
+  sum += sum >> 32;
+  sum += sum >> 16;
+  sum += sum >> 8;
+  return (uint32_t)(sum & 0xff);
+}
+
+/*
+ * first(MJ_M1, MJ_P1 or MJ_S1)から始まる数牌9枚分の枚数を1枚4bitで詰めて返す.
+ * bit[4n+3:4n] が n+1 の牌の枚数.
+ */
+static inline uint64_t get_suit_tiles(const Tiles *tiles, MJTileId first) {
+  uint64_t suit = 0;
+  for (uint32_t i = 0; i < TILE_NUM_LEN; i++) {
+    suit |= (uint64_t)tiles->tiles[first + i] << (4 * i);
+  }
+  return suit;
+}
 
 const char *tile_id_str(MJTileId tile_id);
 #if defined(__cplusplus)
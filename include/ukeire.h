@@ -39,6 +39,36 @@ void gen_acceptable_kokushi(ShantenCtx *ctx, Tiles *acceptables);
 void gen_acceptable_chiitoitsu(ShantenCtx *ctx, Tiles *acceptables);
 void gen_acceptable_normal(ShantenCtx *ctx, Tiles *acceptables);
 
+/*
+ * tiles(副露を除いた手牌total_len枚)に1枚加えると, 通常手, 七対子, 国士無双の最小シャンテン数が shanten より減る牌.
+ * bit[tile_id] が1の牌が有効牌. shanten は calc_shanten_tiles で求めた値であること.
+ */
+uint64_t gen_acceptable_mask(Tiles *tiles, int32_t total_len, int32_t shanten);
+
+/*
+ * 手牌(3n+1枚)ごとのシャンテン数と有効牌のキャッシュ. 同じ手牌を何度も評価する探索やシミュレーションで使う.
+ * zobrist hash (hash_tiles) で引き, 衝突したエントリは上書きする.
+ */
+#define SHANTEN_CACHE_LEN 4096  // 2のべき乗
+
+typedef struct {
+  uint64_t hash;
+  uint64_t acceptables;  // bit[tile_id]: シャンテン数が減る牌. checked の牌だけ有効
+  uint64_t checked;      // bit[tile_id]: acceptables を求めた牌. ツモった牌だけ求める
+  int32_t shanten;
+  bool valid;
+} ShantenCacheEntry;
+
+typedef struct {
+  ShantenCacheEntry entries[SHANTEN_CACHE_LEN];
+} ShantenCache;
+
+/* tiles (total_len 枚, hashはそのzobrist hash) のシャンテン数. キャッシュになければ計算して登録する */
+ShantenCacheEntry *lookup_shanten_cache(ShantenCache *cache, const Tiles *tiles, uint64_t hash, int32_t total_len);
+
+/* entry の手牌 tiles に tile_id を加えるとシャンテン数が減るか. 初めて聞かれた牌だけ計算して entry に記録する */
+bool is_shanten_cache_acceptable(ShantenCacheEntry *entry, Tiles *tiles, int32_t total_len, MJTileId tile_id);
+
 #if defined(__cplusplus)
 }
 #endif  // defined(__cplusplus)
@@ -0,0 +1,53 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * 山の状態. 以降の確率に関わる牌(有効牌と, 有効牌で聴牌した後の待ち牌)だけ種類ごとの枚数を持ち,
+ * それ以外の牌はどれをツモっても同じなので total にだけ含める.
+ */
+typedef struct {
+  Tiles tiles;     // 関わる牌の枚数. それ以外は0
+  uint32_t total;  // 山の残り枚数(関わらない牌を含む)
+  uint64_t hash;   // tiles の zobrist hash (get_zobrist_pool_key)
+} WinProbPool;
+
+/* waits(bit[tile_id]) で聴牌している手牌が, poolから draws 回ツモる間に待ち牌を引く確率(超幾何分布) */
+double calc_tenpai_win_rate(const WinProbPool *pool, uint64_t waits, uint32_t draws);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -35,6 +35,9 @@ extern "C" {
 /*** 1翻 ***/
 /* 平和: 門前: 必須, 説明: 役牌以外で構成, 面子を順子のみで構成し両面待ちで上がる. ロンで30符, ツモで20符 */
 int is_pinfu(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile, const ScoreConfig *cfg);
+/* 平和: machi は gen_machi で求めた待ち */
+int is_pinfu_with_machi(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
+                        const ScoreConfig *cfg, const Machi *machi);
 /* 断么九: 門前: 不要, 説明: 么九牌以外で構成 */
 int is_tanyao(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
               const ScoreConfig *cfg);
@@ -67,6 +70,9 @@ int is_toitoi(const Elements *concealed_elems, const Elements *melded_elems, MJT
 /* 三暗刻: 門前: 不要, 説明: 暗刻を3つ構成 */
 int is_sanankou(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
                 const ScoreConfig *cfg);
+/* 三暗刻: machi は gen_machi で求めた待ち */
+int is_sanankou_with_machi(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
+                           const ScoreConfig *cfg, const Machi *machi);
 /* 三色同刻: 門前: 不要, 説明: 同数異種の刻子を3つ構成 */
 int is_sanshoku_douko(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
                       const ScoreConfig *cfg);
@@ -135,6 +141,9 @@ int is_kokushi(const Tiles *tiles);
 /* 四暗刻: 門前: 必要, 説明: 面子を暗刻(暗槓含む)で構成. 注意: ロンアガリで面子が揃う場合は明刻扱い. */
 int is_suuankou(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
                 const ScoreConfig *cfg);
+/* 四暗刻: machi は gen_machi で求めた待ち */
+int is_suuankou_with_machi(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
+                           const ScoreConfig *cfg, const Machi *machi);
 /* 大三元: 門前: 不要, 説明: 三元牌をすべて刻子で構成 */
 int is_daisangen(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
                  const ScoreConfig *cfg);
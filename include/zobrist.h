@@ -0,0 +1,98 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "element.h"
+#include "mahjong.h"
+#include "tile.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+/*
+ * [Zobrist hash]
+ * 手牌の状態を (牌, 何枚目か) と (副露面子, 何個目か) ごとの64bitの鍵のxorで表す.
+ * 牌を1枚足す/引くと鍵1つのxorで更新できる.
+ * 鍵はテーブルを持たず, 添字を splitmix64 で混ぜて求める(初期化が不要で, ビルドやプロセスによらず同じ値になる).
+ */
+
+#define ZOBRIST_SEED 0x6a09e667f3bcc909ull
+#define ZOBRIST_COPIES MJ_MAX_TILES_LEN_IN_ELEMENT
+#define ZOBRIST_ELEMENT_BASE ((MJ_DR + 1) * ZOBRIST_COPIES)  // 副露面子の鍵の添字は牌の鍵の後ろに置く
+#define ZOBRIST_ELEMENT_CODE_MASK 0x1ffu                     // tile, type, concealed
+#define ZOBRIST_POOL_BASE (ZOBRIST_ELEMENT_BASE + (ZOBRIST_ELEMENT_CODE_MASK + 1) * ZOBRIST_COPIES)
+#define ZOBRIST_COUNTER_BASE (ZOBRIST_POOL_BASE + (MJ_DR + 1) * ZOBRIST_COPIES)
+
+static inline uint64_t mix_zobrist_key(uint64_t index) {
+  uint64_t z = ZOBRIST_SEED + (index + 1) * 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/* tile_idの copy 枚目(0始まり)の鍵 */
+static inline uint64_t get_zobrist_tile_key(MJTileId tile_id, uint32_t copy) {
+  return mix_zobrist_key((uint64_t)tile_id * ZOBRIST_COPIES + copy);
+}
+
+/* 同じ副露面子の copy 個目(0始まり)の鍵. 順子は同じものを複数鳴けるので個数も鍵に含める */
+static inline uint64_t get_zobrist_element_key(ElementCode code, uint32_t copy) {
+  return mix_zobrist_key(ZOBRIST_ELEMENT_BASE + (uint64_t)(code & ZOBRIST_ELEMENT_CODE_MASK) * ZOBRIST_COPIES + copy);
+}
+
+/* 山(見えていない牌)に残っている tile_id の copy 枚目の鍵. 手牌の鍵とは別に持つ */
+static inline uint64_t get_zobrist_pool_key(MJTileId tile_id, uint32_t copy) {
+  return mix_zobrist_key(ZOBRIST_POOL_BASE + (uint64_t)tile_id * ZOBRIST_COPIES + copy);
+}
+
+/* 残りツモ回数などの数値の鍵 */
+static inline uint64_t get_zobrist_counter_key(uint64_t counter) { return mix_zobrist_key(ZOBRIST_COUNTER_BASE + counter); }
+
+/* 牌を1枚加えた後のhash. tilesは加える前の枚数 */
+static inline uint64_t add_zobrist_tile(uint64_t hash, const Tiles *tiles, MJTileId tile_id) {
+  return hash ^ get_zobrist_tile_key(tile_id, tiles->tiles[tile_id]);
+}
+
+/* 牌を1枚除いた後のhash. tilesは除く前の枚数 */
+static inline uint64_t remove_zobrist_tile(uint64_t hash, const Tiles *tiles, MJTileId tile_id) {
+  return hash ^ get_zobrist_tile_key(tile_id, tiles->tiles[tile_id] - 1u);
+}
+
+uint64_t hash_tiles(const Tiles *tiles);
+uint64_t hash_elements(const Elements *elems);
+
+/* elemsに面子を1つ加えた後のhash. elemsは加える前の面子 */
+uint64_t add_zobrist_element(uint64_t hash, const Elements *elems, const Element *elem);
+/* elemsから面子を1つ除いた後のhash. elemsは除く前の面子 */
+uint64_t remove_zobrist_element(uint64_t hash, const Elements *elems, const Element *elem);
+
+#if defined(__cplusplus)
+}
+#endif  // defined(__cplusplus)
@@ -0,0 +1,324 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mahjong.h"
+
+/*
+ * (N, 34) の uint8 の牌の枚数の配列をまとめて計算する CPython 拡張.
+ * 入力と出力はバッファプロトコルで受け取り, 手牌ごとに Python のオブジェクトを作らない. 計算中は GIL を解放して
+ * mj_parallel_for で threads 個のスレッドに分ける.
+ *
+ * counts: C-contiguous で要素が1byte, 長さが 34 の倍数 (numpy.uint8 の (N, 34), bytes, bytearray など).
+ *   counts[i][tile_id] が牌の枚数. 副露は扱わないので全て門前の牌.
+ * out: 省略すると bytearray を作って返す. 渡す場合は書き込めて C-contiguous で, 要素が1byte か出力の型と同じ大きさ.
+ *
+ *   shanten(counts, out=None, threads=1)  -> int8 (N, 3): normal, chiitoitsu, kokushi.
+ *     13枚未満の七対子, 国士無双と不正な行は NO_SHANTEN
+ *   ukeire(counts, out=None, threads=1)   -> uint64 (N,): bit[tile_id] がシャンテン数が最小の形の受け入れ.
+ *     3n+1 枚でない行, 不正な行は 0
+ *   is_agari(counts, out=None, threads=1) -> uint8 (N,): 3n+2 枚で和了形なら 1
+ *   score(counts, win_tiles, out=None, ron=False, player_wind=27, round_wind=27, threads=1)
+ *                                         -> uint32 (N, 2): han, fu. アガリでない行, 役がない行, 不正な行は 0, 0
+ *     win_tiles: 要素が1byteの (N,) のアガリ牌. counts はアガリ牌を含む
+ */
+
+#define PY_COUNTS_LEN (MJ_DR + 1)
+#define PY_GRAIN 256  // mj_parallel_for で1回に取り出す行数. 1行は数us なので細かく分けすぎない
+
+typedef struct {
+  const uint8_t *counts;
+  const uint8_t *win_tiles;
+  uint8_t *out;
+  bool ron;
+  MJTileId player_wind;
+  MJTileId round_wind;
+} PyBatch;
+
+static bool gen_hands_from_counts(MJHands *hands, const uint8_t *counts) {
+  hands->len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (counts[i] > MJ_MAX_TILES_LEN_IN_ELEMENT || hands->len + counts[i] > MJ_MAX_HAND_LEN) {
+      return false;
+    }
+    for (uint32_t j = 0; j < counts[i]; j++) {
+      hands->tile_id[hands->len++] = (MJTileId)i;
+    }
+  }
+  return hands->len > 0;
+}
+
+/* 13枚未満では七対子, 国士無双を計算しないので NO_SHANTEN のまま */
+static bool calc_py_shanten(MJShanten *shanten, const MJHands *hands) {
+  shanten->normal = MJ_RECORD_NO_SHANTEN;
+  shanten->chiitoitsu = MJ_RECORD_NO_SHANTEN;
+  shanten->kokushi = MJ_RECORD_NO_SHANTEN;
+  return mj_calc_shanten(hands, shanten) == MJ_OK;
+}
+
+static int32_t get_min_shanten(const MJShanten *shanten) {
+  int32_t min = shanten->normal;
+  min = shanten->chiitoitsu < min ? shanten->chiitoitsu : min;
+  return shanten->kokushi < min ? shanten->kokushi : min;
+}
+
+static void calc_shanten_task(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  const PyBatch *batch = (const PyBatch *)arg;
+  int8_t *out = (int8_t *)&batch->out[index * 3];
+  MJHands hands;
+  MJShanten shanten;
+  if (!gen_hands_from_counts(&hands, &batch->counts[index * PY_COUNTS_LEN]) || !calc_py_shanten(&shanten, &hands)) {
+    out[0] = out[1] = out[2] = MJ_RECORD_NO_SHANTEN;
+    return;
+  }
+  out[0] = (int8_t)shanten.normal;
+  out[1] = (int8_t)shanten.chiitoitsu;
+  out[2] = (int8_t)shanten.kokushi;
+}
+
+static void calc_ukeire_task(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  const PyBatch *batch = (const PyBatch *)arg;
+  uint64_t mask = 0;
+  MJHands hands;
+  MJShanten shanten;
+  if (gen_hands_from_counts(&hands, &batch->counts[index * PY_COUNTS_LEN]) &&
+      hands.len % MJ_MIN_TILES_LEN_IN_ELEMENT == 1 && calc_py_shanten(&shanten, &hands)) {
+    typedef int32_t (*UkeireFunc)(const MJHands *hands, MJTiles *acceptables);
+    const UkeireFunc funcs[] = {mj_ukeire_normal, mj_ukeire_chiitoitsu, mj_ukeire_kokushi};
+    const int32_t values[] = {shanten.normal, shanten.chiitoitsu, shanten.kokushi};
+    int32_t min = get_min_shanten(&shanten);
+    for (uint32_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++) {
+      MJTiles acceptables;
+      if (values[i] != min || funcs[i](&hands, &acceptables) != MJ_OK) {
+        continue;
+      }
+      for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+        mask |= acceptables.tiles[j] ? 1ull << j : 0;
+      }
+    }
+  }
+  memcpy(&batch->out[index * sizeof(uint64_t)], &mask, sizeof(uint64_t));
+}
+
+static void calc_agari_task(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  const PyBatch *batch = (const PyBatch *)arg;
+  MJHands hands;
+  MJShanten shanten;
+  batch->out[index] = gen_hands_from_counts(&hands, &batch->counts[index * PY_COUNTS_LEN]) &&
+                      hands.len % MJ_MIN_TILES_LEN_IN_ELEMENT == 2 && calc_py_shanten(&shanten, &hands) &&
+                      get_min_shanten(&shanten) == -1;
+}
+
+static void calc_score_task(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  const PyBatch *batch = (const PyBatch *)arg;
+  uint32_t out[2] = {0, 0};
+  MJHands hands;
+  MJMelds melds = {.len = 0};
+  MJBaseScore score;
+  MJTileId win_tile = (MJTileId)batch->win_tiles[index];
+  if (win_tile <= MJ_DR && gen_hands_from_counts(&hands, &batch->counts[index * PY_COUNTS_LEN]) &&
+      mj_get_score(&score, &hands, &melds, win_tile, batch->ron, batch->player_wind, batch->round_wind) == MJ_OK) {
+    out[0] = score.han;
+    out[1] = score.fu;
+  }
+  memcpy(&batch->out[index * sizeof(out)], out, sizeof(out));
+}
+
+static bool get_counts_buffer(Py_buffer *view, PyObject *obj, const char *name, Py_ssize_t *len) {
+  if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS) < 0) {
+    return false;
+  }
+  if (view->itemsize != 1 || view->len % PY_COUNTS_LEN != 0 ||
+      (view->ndim >= 2 && view->shape[view->ndim - 1] != PY_COUNTS_LEN)) {
+    PyErr_Format(PyExc_ValueError, "%s must be a contiguous (N, %d) array of 1-byte items", name, PY_COUNTS_LEN);
+    PyBuffer_Release(view);
+    return false;
+  }
+  *len = view->len / PY_COUNTS_LEN;
+  return true;
+}
+
+/* out が None なら size bytes の bytearray を作る. 作ったか, 借りたオブジェクトの新しい参照を *result に返す */
+static bool get_out_buffer(Py_buffer *view, PyObject **result, PyObject *out, Py_ssize_t itemsize,
+                           Py_ssize_t size) {
+  *result = out == Py_None ? PyByteArray_FromStringAndSize(NULL, size) : (Py_INCREF(out), out);
+  if (*result == NULL) {
+    return false;
+  }
+  if (PyObject_GetBuffer(*result, view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) < 0) {
+    Py_CLEAR(*result);
+    return false;
+  }
+  if (view->len != size || (view->itemsize != 1 && view->itemsize != itemsize)) {
+    PyErr_Format(PyExc_ValueError, "out must be a writable contiguous buffer of %zd bytes", size);
+    PyBuffer_Release(view);
+    Py_CLEAR(*result);
+    return false;
+  }
+  return true;
+}
+
+static bool get_py_threads(uint32_t *threads, long value) {
+  if (value < 0 || value > MJ_BATCH_MAX_THREADS) {
+    PyErr_Format(PyExc_ValueError, "threads must be in [0, %d]", MJ_BATCH_MAX_THREADS);
+    return false;
+  }
+  *threads = (uint32_t)value;
+  return true;
+}
+
+static bool get_py_wind(MJTileId *wind, long value, const char *name) {
+  if (value < MJ_WT || value > MJ_WP) {
+    PyErr_Format(PyExc_ValueError, "%s must be in [%d, %d]", name, MJ_WT, MJ_WP);
+    return false;
+  }
+  *wind = (MJTileId)value;
+  return true;
+}
+
+static bool get_win_tiles_buffer(Py_buffer *view, PyObject *obj, Py_ssize_t len) {
+  if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS) < 0) {
+    return false;
+  }
+  if (view->itemsize != 1 || view->len != len) {
+    PyErr_Format(PyExc_ValueError, "win_tiles must be a contiguous (%zd,) array of 1-byte items", len);
+    PyBuffer_Release(view);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * counts の行ごとに func を並列に呼び, 結果 (1行 itemsize * items bytes) を out に書く.
+ * win_tiles_obj は score だけが使う. それ以外は NULL
+ */
+static PyObject *run_py_batch(PyObject *counts_obj, PyObject *win_tiles_obj, PyObject *out_obj, long threads_value,
+                              MJTaskFunc func, PyBatch *batch, Py_ssize_t itemsize, Py_ssize_t items) {
+  uint32_t threads;
+  if (!get_py_threads(&threads, threads_value)) {
+    return NULL;
+  }
+  Py_buffer counts, win_tiles, out;
+  Py_ssize_t len;
+  if (!get_counts_buffer(&counts, counts_obj, "counts", &len)) {
+    return NULL;
+  }
+  if (win_tiles_obj != NULL && !get_win_tiles_buffer(&win_tiles, win_tiles_obj, len)) {
+    PyBuffer_Release(&counts);
+    return NULL;
+  }
+  PyObject *result;
+  if (get_out_buffer(&out, &result, out_obj, itemsize, len * itemsize * items)) {
+    batch->counts = (const uint8_t *)counts.buf;
+    batch->win_tiles = win_tiles_obj != NULL ? (const uint8_t *)win_tiles.buf : NULL;
+    batch->out = (uint8_t *)out.buf;
+    int32_t ret;
+    Py_BEGIN_ALLOW_THREADS;
+    ret = mj_parallel_for((uint64_t)len, threads, PY_GRAIN, func, batch);
+    Py_END_ALLOW_THREADS;
+    PyBuffer_Release(&out);
+    if (ret != MJ_OK) {
+      PyErr_Format(PyExc_RuntimeError, "mj_parallel_for failed: %d", ret);
+      Py_CLEAR(result);
+    }
+  }
+  if (win_tiles_obj != NULL) {
+    PyBuffer_Release(&win_tiles);
+  }
+  PyBuffer_Release(&counts);
+  return result;
+}
+
+static PyObject *py_shanten(PyObject *self, PyObject *args, PyObject *kwargs) {
+  (void)self;
+  static char *keywords[] = {"counts", "out", "threads", NULL};
+  PyObject *counts, *out = Py_None;
+  long threads = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O$l", keywords, &counts, &out, &threads)) {
+    return NULL;
+  }
+  PyBatch batch = {0};
+  return run_py_batch(counts, NULL, out, threads, calc_shanten_task, &batch, sizeof(int8_t), 3);
+}
+
+static PyObject *py_ukeire(PyObject *self, PyObject *args, PyObject *kwargs) {
+  (void)self;
+  static char *keywords[] = {"counts", "out", "threads", NULL};
+  PyObject *counts, *out = Py_None;
+  long threads = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O$l", keywords, &counts, &out, &threads)) {
+    return NULL;
+  }
+  PyBatch batch = {0};
+  return run_py_batch(counts, NULL, out, threads, calc_ukeire_task, &batch, sizeof(uint64_t), 1);
+}
+
+static PyObject *py_is_agari(PyObject *self, PyObject *args, PyObject *kwargs) {
+  (void)self;
+  static char *keywords[] = {"counts", "out", "threads", NULL};
+  PyObject *counts, *out = Py_None;
+  long threads = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O$l", keywords, &counts, &out, &threads)) {
+    return NULL;
+  }
+  PyBatch batch = {0};
+  return run_py_batch(counts, NULL, out, threads, calc_agari_task, &batch, sizeof(uint8_t), 1);
+}
+
+static PyObject *py_score(PyObject *self, PyObject *args, PyObject *kwargs) {
+  (void)self;
+  static char *keywords[] = {"counts", "win_tiles", "out", "ron", "player_wind", "round_wind", "threads", NULL};
+  PyObject *counts, *win_tiles, *out = Py_None;
+  int ron = 0;
+  long player_wind = MJ_WT, round_wind = MJ_WT, threads = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|O$plll", keywords, &counts, &win_tiles, &out, &ron,
+                                   &player_wind, &round_wind, &threads)) {
+    return NULL;
+  }
+  PyBatch batch = {.ron = ron != 0};
+  if (!get_py_wind(&batch.player_wind, player_wind, "player_wind") ||
+      !get_py_wind(&batch.round_wind, round_wind, "round_wind")) {
+    return NULL;
+  }
+  return run_py_batch(counts, win_tiles, out, threads, calc_score_task, &batch, sizeof(uint32_t), 2);
+}
+
+static PyMethodDef py_methods[] = {
+    {"shanten", (PyCFunction)(void (*)(void))py_shanten, METH_VARARGS | METH_KEYWORDS,
+     "shanten(counts, out=None, *, threads=1) -> int8 (N, 3): normal, chiitoitsu, kokushi"},
+    {"ukeire", (PyCFunction)(void (*)(void))py_ukeire, METH_VARARGS | METH_KEYWORDS,
+     "ukeire(counts, out=None, *, threads=1) -> uint64 (N,): bit[tile_id] of acceptable tiles"},
+    {"is_agari", (PyCFunction)(void (*)(void))py_is_agari, METH_VARARGS | METH_KEYWORDS,
+     "is_agari(counts, out=None, *, threads=1) -> uint8 (N,): 1 if complete"},
+    {"score", (PyCFunction)(void (*)(void))py_score, METH_VARARGS | METH_KEYWORDS,
+     "score(counts, win_tiles, out=None, *, ron=False, player_wind=27, round_wind=27, threads=1)"
+     " -> uint32 (N, 2): han, fu"},
+    {NULL, NULL, 0, NULL},
+};
+
+static struct PyModuleDef py_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "mahjong",
+    .m_doc = "Batch shanten, ukeire, agari and score over (N, 34) tile counts.",
+    .m_size = -1,
+    .m_methods = py_methods,
+};
+
+PyMODINIT_FUNC PyInit_mahjong(void) {
+  PyObject *module = PyModule_Create(&py_module);
+  if (module == NULL) {
+    return NULL;
+  }
+  if (PyModule_AddIntConstant(module, "NO_SHANTEN", MJ_RECORD_NO_SHANTEN) < 0 ||
+      PyModule_AddIntConstant(module, "MAX_THREADS", MJ_BATCH_MAX_THREADS) < 0) {
+    Py_DECREF(module);
+    return NULL;
+  }
+  return module;
+}
@@ -0,0 +1,73 @@
+import array
+import struct
+import unittest
+
+import mahjong
+
+SUITS = "mpsz"
+
+
+def counts(notation):
+    """ "123m55z" のような門前の牌だけの表記を34種類の枚数にする """
+    row = bytearray(34)
+    numbers = []
+    for c in notation:
+        if c.isdigit():
+            numbers.append(int(c))
+            continue
+        for n in numbers:
+            row[SUITS.index(c) * 9 + n - 1] += 1
+        numbers = []
+    return bytes(row)
+
+
+def tile(notation):
+    return counts(notation).index(1)
+
+
+class TestMahjong(unittest.TestCase):
+    def test_shanten(self):
+        rows = counts("123m456p789s1122z") + counts("19m19p19s1234567z") + counts("1234m")
+        out = mahjong.shanten(rows)
+        self.assertEqual(struct.unpack("9b", out), (0, 4, 8, 8, 6, 0, 0, mahjong.NO_SHANTEN, mahjong.NO_SHANTEN))
+
+    def test_shanten_illegal(self):
+        out = mahjong.shanten(counts("11111m") + bytes(34))
+        self.assertEqual(set(out), {mahjong.NO_SHANTEN})
+        with self.assertRaises(ValueError):
+            mahjong.shanten(bytes(33))
+        with self.assertRaises(ValueError):
+            mahjong.shanten(bytes(34), out=bytearray(2))
+        with self.assertRaises(ValueError):
+            mahjong.shanten(bytes(34), threads=mahjong.MAX_THREADS + 1)
+
+    def test_ukeire(self):
+        rows = counts("123m456p789s1122z") + counts("19m19p19s1234567z") + counts("123m456p789s11223z")
+        out = array.array("Q", bytes(8 * 3))
+        self.assertIs(mahjong.ukeire(rows, out), out)
+        self.assertEqual(out[0], (1 << tile("1z")) | (1 << tile("2z")))
+        self.assertEqual(out[1], sum(1 << tile(t) for t in ["1m", "9m", "1p", "9p", "1s", "9s"]) | (0x7F << 27))
+        self.assertEqual(out[2], 0)
+
+    def test_is_agari(self):
+        rows = counts("123m456p789s11222z") + counts("1122m3344p5566s77z") + counts("123m456p789s1122z")
+        self.assertEqual(bytes(mahjong.is_agari(rows)), bytes([1, 1, 0]))
+
+    def test_score(self):
+        rows = counts("234m22334455p234s") + counts("123m456p789s11222z") + counts("123m456p789s1122z")
+        win_tiles = bytes([tile("3p"), tile("2z"), tile("1z")])
+        out = mahjong.score(rows, win_tiles, ron=True)
+        self.assertEqual(struct.unpack("6I", out)[0:2], (4, 40))
+        self.assertEqual(struct.unpack("6I", out)[4:6], (0, 0))
+        with self.assertRaises(ValueError):
+            mahjong.score(rows, win_tiles[0:2])
+
+    def test_threads(self):
+        hands = ["123m456p789s1122z", "19m19p19s1234567z", "1122m3344p5566s7z", "2345678m234p567s"]
+        rows = b"".join(counts(hands[i % len(hands)]) for i in range(10000))
+        self.assertEqual(mahjong.shanten(rows, threads=4), mahjong.shanten(rows))
+        self.assertEqual(mahjong.ukeire(rows, threads=4), mahjong.ukeire(rows))
+
+
+if __name__ == "__main__":
+    unittest.main()
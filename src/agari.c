@@ -29,10 +29,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bitboard.h"
 #include "element.h"
 #include "mahjong.h"
+#include "stats.h"
 #include "tile.h"
 
+#define ENABLE_DEBUG (0)
+
 /*
  * [アガリ判定について]
  * 手牌(自摸を含み、副露牌、暗槓子を含まない)を以下の順で処理をする
@@ -100,11 +104,15 @@
 
 void gen_triplets_candidates(_Triplets *triplets, const Tiles *tiles) {
   memset(triplets, 0, sizeof(_Triplets));
-  for (uint32_t i = 0; i <= MJ_DR; i++) {
-    uint8_t tile_num = tiles->tiles[i];
-    if (tile_num >= 3) {  // pickup triplets candidate from tiles
+  Bitboard bb;
+  gen_bitboard_from_tiles(&bb, tiles);
+  for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+    uint64_t candidates = find_bb_triplets(bb.suit[suit]);  // pickup triplets candidate from tiles
+    while (candidates) {
+      uint32_t rank = get_bb_lowest_rank(candidates);
+      candidates &= candidates - 1;
       assert(triplets->len < MJ_ELEMENTS_LEN);
-      triplets->tile_id[triplets->len] = i;
+      triplets->tile_id[triplets->len] = get_bb_tile_id(suit, rank);
       triplets->len++;
     }
   }
@@ -113,45 +121,32 @@ void gen_triplets_candidates(_Triplets *triplets, const Tiles *tiles) {
 /*
  * tilesがすべて順子で成立するか確認する.
  * 成立した面子はelemsに追加される.
+ * 各色の最も小さい牌は必ず順子の始まりになるので, 色ごとに小さい牌から順子を抜いていけばよい.
  */
 static uint32_t find_elements_as_sequence(const Tiles *tiles, Elements *elems) {
-  Tiles _tiles;
-  memcpy(&_tiles, tiles, sizeof(Tiles));
-  for (int i = 0; i <= MJ_DR; i++) {
-    uint8_t tile_num = _tiles.tiles[i];
-    if (tile_num) {
-      if (is_tile_id_honors(i)) {
-        return false;
-      }
-      uint32_t number = get_tile_number(i);
-      if (number == 7 || number == 8) { /* in case of M8, M9, P8, P9, S8, S9 */
-        return false;
-      }
-
-      /* next and next of next do not exist */
-      if (_tiles.tiles[i + 1] == 0 || _tiles.tiles[i + 2] == 0) {
+  Bitboard bb;
+  gen_bitboard_from_tiles(&bb, tiles);
+  if (bb.suit[BB_HONORS]) {
+    return false;
+  }
+  for (uint32_t suit = BB_MAN; suit <= BB_SOU; suit++) {
+    uint64_t word = bb.suit[suit];
+    while (word) {
+      uint32_t rank = get_bb_lowest_rank(find_bb_tiles(word));
+      /* next and next of next do not exist, or in case of 8, 9 */
+      if ((find_bb_sequences(word) & get_bb_rank_bit(rank)) == 0) {
         return false;
       }
-      _tiles.tiles[i]--;
-      _tiles.tiles[i + 1]--;
-      _tiles.tiles[i + 2]--;
+      word = remove_bb_block(word, rank, BB_BLOCK_SEQUENCE);
+      MJTileId tile_id = get_bb_tile_id(suit, rank);
       assert(elems->len < MJ_ELEMENTS_LEN);
-      elems->meld[elems->len].tile_id[0] = i;
-      elems->meld[elems->len].tile_id[1] = i + 1;
-      elems->meld[elems->len].tile_id[2] = i + 2;
+      elems->meld[elems->len].tile_id[0] = tile_id;
+      elems->meld[elems->len].tile_id[1] = tile_id + 1;
+      elems->meld[elems->len].tile_id[2] = tile_id + 2;
       elems->meld[elems->len].len = 3;
       elems->meld[elems->len].concealed = true;
       elems->meld[elems->len].type = ELEM_TYPE_SEQUENCE;
       elems->len++;
-
-      uint32_t found = find_elements_as_sequence(&_tiles, elems);
-      if (found) {
-        return true;
-      }
-      elems->len--;
-      _tiles.tiles[i]++;
-      _tiles.tiles[i + 1]++;
-      _tiles.tiles[i + 2]++;
     }
   }
   return true;
@@ -263,6 +258,7 @@ static uint32_t find_agari_with_triplets_candidates(const _Triplets *triplets, c
  */
 uint32_t find_agari(const Tiles *concealed_tiles, const Elements *melded_elems, AgariCallbackTiles *cb_tiles,
                     AgariCallbackElements *cb_elements, void *cbarg) {
+  INC_STATS(agari_calls);
   uint32_t found;
   uint32_t agari = 0;
   if (melded_elems->len == 0) {
@@ -282,11 +278,14 @@ uint32_t find_agari(const Tiles *concealed_tiles, const Elements *melded_elems,
       gen_triplets_candidates(&triplets, &_concealed_tiles);
       found = find_agari_with_triplets_candidates(&triplets, &_concealed_tiles, melded_elems, i, cb_elements, cbarg);
       agari += found;
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
       if (found) {
         fprintf(stderr, "agari %d: pair: %s\n", agari, tile_id_str(i));
       }
+#endif
       _concealed_tiles.tiles[i] += 2;  // revert: remove pair from tiles
     }
   }
+  ADD_STATS(agari_decompositions, agari);
   return agari;
 }
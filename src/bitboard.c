@@ -0,0 +1,44 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "bitboard.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "tile.h"
+
+void gen_bitboard_from_tiles(Bitboard *bb, const Tiles *tiles) {
+  bb->suit[BB_MAN] = get_suit_tiles(tiles, MJ_M1);
+  bb->suit[BB_PIN] = get_suit_tiles(tiles, MJ_P1);
+  bb->suit[BB_SOU] = get_suit_tiles(tiles, MJ_S1);
+  uint64_t honors = 0;
+  for (uint32_t i = 0; i <= MJ_DR - MJ_WT; i++) {
+    honors |= (uint64_t)tiles->tiles[MJ_WT + i] << (i * BB_RANK_BITS);
+  }
+  bb->suit[BB_HONORS] = honors;
+}
@@ -42,35 +42,24 @@
   }                                             \
   return true
 
-static int tile_cmp(const void *p1, const void *p2) {
-  return (signed)*(const MJTileId *)p1 - (signed)*(const MJTileId *)p2;
+/* 面子の牌は高々4枚なのでqsortを使わず挿入ソートする */
+static void sort_tile(Element *elem) {
+  for (uint32_t i = 1; i < elem->len && i < MJ_MAX_TILES_LEN_IN_ELEMENT; i++) {
+    MJTileId tile_id = elem->tile_id[i];
+    uint32_t j = i;
+    for (; j > 0 && elem->tile_id[j - 1] > tile_id; j--) {
+      elem->tile_id[j] = elem->tile_id[j - 1];
+    }
+    elem->tile_id[j] = tile_id;
+  }
 }
 
-static void sort_tile(Element *elem) { qsort(&elem->tile_id[0], elem->len, sizeof(elem->tile_id[0]), tile_cmp); }
-
 static void sort_tile_elements(Elements *elems) {
   for (uint32_t i = 0; i < elems->len; i++) {
     sort_tile(&elems->meld[i]);
   }
 }
 
-static int element_cmp(const void *p1, const void *p2) {
-  const Element *e1;
-  const Element *e2;
-  e1 = (const Element *)p1;
-  e2 = (const Element *)p2;
-  if (e1->tile_id[0] == e2->tile_id[0]) {
-    return (signed)e1->type - (signed)e2->type;
-  } else {
-    return (signed)e1->tile_id[0] - (signed)e2->tile_id[0];
-  }
-}
-
-static void sort_elements(Elements *elems) {
-  qsort(&elems->meld[0], elems->len, sizeof(MJMeld), element_cmp);
-  util_dump_melds(elems);
-}
-
 /*
  * before calling the following functions, elem should be sorted.
  */
@@ -140,80 +129,81 @@ bool gen_elements_from_melds(Elements *elems, const MJMelds *melds) {
   return true;
 }
 
-/* single element */
-/* 2..8 */
-bool is_element_chunchan(const Element *elem) {
-  for (uint32_t i = 0; i < elem->len; i++) {
-    MJTileId tile_id = elem->tile_id[i];
-    if (is_tile_id_yaochu(tile_id)) {
-      return false;
-    }
+ElementCode gen_element_code(const Element *elem) {
+  assert(elem->tile_id[0] <= MJ_DR && elem->type <= ELEM_TYPE_PARTIAL_SEQUENCE);
+  uint32_t code = ELEM_CODE_VALID | (elem->type << ELEM_CODE_TYPE_SHIFT) | (uint32_t)elem->tile_id[0];
+  if (elem->concealed) {
+    code |= ELEM_CODE_CONCEALED;
   }
-  return true;
+  return (ElementCode)code;
 }
 
-/* 1 or 9 */
-bool is_element_routou(const Element *elem) {
-  for (uint32_t i = 0; i < elem->len; i++) {
-    MJTileId tile_id = elem->tile_id[i];
-    if (!is_tile_id_routou(tile_id)) {
-      return false;
+/* maskを掛けたElementCodeを昇順に並べて詰める. 空きは0 */
+static ElementsCode pack_element_codes(const Elements *elems, uint32_t mask) {
+  ElementCode codes[MJ_ELEMENTS_LEN] = {0};
+  assert(elems->len <= MJ_ELEMENTS_LEN);
+  for (uint32_t i = 0; i < elems->len; i++) {
+    ElementCode code = (ElementCode)(gen_element_code(&elems->meld[i]) & mask);
+    uint32_t j = i;
+    for (; j > 0 && codes[j - 1] > code; j--) {
+      codes[j] = codes[j - 1];
     }
+    codes[j] = code;
   }
-  return true;
+  ElementsCode packed = 0;
+  for (uint32_t i = 0; i < MJ_ELEMENTS_LEN; i++) {
+    packed |= (ElementsCode)codes[i] << (i * ELEM_CODE_BITS);
+  }
+  return packed;
 }
 
-bool has_element_routou(const Element *elem) {
-  for (uint32_t i = 0; i < elem->len; i++) {
-    MJTileId tile_id = elem->tile_id[i];
-    if (is_tile_id_honors(tile_id)) {
-      return false;
-    }
-    uint32_t number = get_tile_number(tile_id);
-    if (elem->type == ELEM_TYPE_SEQUENCE) {
-      if (number != (TILE_NUM_1 + i) && number != (TILE_NUM_7 + i)) {  // 1,2,3 or 7,8,9
-        return false;
-      }
-    } else {
-      if (number != TILE_NUM_1 && number != TILE_NUM_9) {  // 1 or 9
-        return false;
-      }
-    }
-  }
-  return true;
+ElementsCode gen_elements_code(const Elements *elems) { return pack_element_codes(elems, 0xffffu); }
+
+/*
+ * 面子の性質を(ElementType, 先頭の牌)で引くテーブル.
+ * 順子は先頭の牌が1..7, 刻子, 槓子は全ての牌について定義する.
+ */
+#define ELEM_PROP_CHUNCHAN (1u << 0)    /* 2..8 */
+#define ELEM_PROP_ROUTOU (1u << 1)      /* 111, 999 */
+#define ELEM_PROP_HAS_ROUTOU (1u << 2)  /* 123, 789, 111, 999 */
+#define ELEM_PROP_YAOCHU (1u << 3)      /* 1,9,字牌 */
+#define ELEM_PROP_HAS_YAOCHU (1u << 4)  /* 123, 789, 111, 999 or 字牌 */
+
+#define P_C ELEM_PROP_CHUNCHAN
+#define P_S19 (ELEM_PROP_HAS_ROUTOU | ELEM_PROP_HAS_YAOCHU)
+#define P_T19 (ELEM_PROP_ROUTOU | ELEM_PROP_HAS_ROUTOU | ELEM_PROP_YAOCHU | ELEM_PROP_HAS_YAOCHU)
+#define P_TH (ELEM_PROP_YAOCHU | ELEM_PROP_HAS_YAOCHU)
+
+#define SEQUENCE_SUIT_PROPS P_S19, P_C, P_C, P_C, P_C, P_C, P_S19, 0, 0
+#define SEQUENCE_HONORS_PROPS 0, 0, 0, 0, 0, 0, 0
+#define TRIPLETS_SUIT_PROPS P_T19, P_C, P_C, P_C, P_C, P_C, P_C, P_C, P_T19
+#define TRIPLETS_HONORS_PROPS P_TH, P_TH, P_TH, P_TH, P_TH, P_TH, P_TH
+
+static const uint8_t element_props[ELEM_TYPE_PARTIAL_SEQUENCE + 1][MJ_DR + 1] = {
+    [ELEM_TYPE_SEQUENCE] = {SEQUENCE_SUIT_PROPS, SEQUENCE_SUIT_PROPS, SEQUENCE_SUIT_PROPS, SEQUENCE_HONORS_PROPS},
+    [ELEM_TYPE_TRIPLETS] = {TRIPLETS_SUIT_PROPS, TRIPLETS_SUIT_PROPS, TRIPLETS_SUIT_PROPS, TRIPLETS_HONORS_PROPS},
+    [ELEM_TYPE_FOURS] = {TRIPLETS_SUIT_PROPS, TRIPLETS_SUIT_PROPS, TRIPLETS_SUIT_PROPS, TRIPLETS_HONORS_PROPS},
+};
+
+static inline bool has_element_prop(const Element *elem, uint32_t prop) {
+  assert(elem->tile_id[0] <= MJ_DR && elem->type <= ELEM_TYPE_PARTIAL_SEQUENCE);
+  return (element_props[elem->type][elem->tile_id[0]] & prop) != 0;
 }
 
+/* single element */
+/* 2..8 */
+bool is_element_chunchan(const Element *elem) { return has_element_prop(elem, ELEM_PROP_CHUNCHAN); }
+
+/* 1 or 9 */
+bool is_element_routou(const Element *elem) { return has_element_prop(elem, ELEM_PROP_ROUTOU); }
+
+bool has_element_routou(const Element *elem) { return has_element_prop(elem, ELEM_PROP_HAS_ROUTOU); }
+
 /* 1,9,字牌 */
-bool is_element_yaochu(const Element *elem) {
-  for (uint32_t i = 0; i < elem->len; i++) {
-    MJTileId tile_id = elem->tile_id[i];
-    if (!is_tile_id_yaochu(tile_id)) {
-      return false;
-    }
-  }
-  return true;
-}
+bool is_element_yaochu(const Element *elem) { return has_element_prop(elem, ELEM_PROP_YAOCHU); }
 
 /* 123, 789, 111, 999 or 字牌 */
-bool has_element_yaochu(const Element *elem) {
-  for (uint32_t i = 0; i < elem->len; i++) {
-    MJTileId tile_id = elem->tile_id[i];
-    if (is_tile_id_honors(tile_id)) {
-      continue;
-    }
-    uint32_t number = get_tile_number(tile_id);
-    if (elem->type == ELEM_TYPE_SEQUENCE) {
-      if (number != (TILE_NUM_1 + i) && number != (TILE_NUM_7 + i)) {  // 1,2,3 or 7,8,9
-        return false;
-      }
-    } else {
-      if (number != TILE_NUM_1 && number != TILE_NUM_9) {  // 1 or 9
-        return false;
-      }
-    }
-  }
-  return true;
-}
+bool has_element_yaochu(const Element *elem) { return has_element_prop(elem, ELEM_PROP_HAS_YAOCHU); }
 
 bool is_element_sequence(const Element *elem) { return elem->type == ELEM_TYPE_SEQUENCE; }
 
@@ -372,35 +362,38 @@ bool is_shanpon_machi(const Elements *elems, MJTileId win_tile) {
 
 bool is_tanki_machi(MJTileId pair_tile, MJTileId win_tile) { return pair_tile == win_tile; }
 
-static bool is_element_same_sequence(const Element *e1, const Element *e2) {
-  if (e1->len != e2->len) {
-    return false;
-  }
-  if (e1->type != e2->type || e1->type != ELEM_TYPE_SEQUENCE) {
-    return false;
-  }
-  if (e1->concealed != e2->concealed) {
-    return false;
-  }
-  for (uint32_t i = 0; i < e1->len; i++) {
-    if (e1->tile_id[i] != e2->tile_id[i]) {
-      return false;
+void gen_machi(Machi *machi, const Elements *concealed, MJTileId pair_tile, MJTileId win_tile) {
+  memset(machi, 0, sizeof(Machi));
+  for (uint32_t i = 0; i < concealed->len; i++) {
+    const Element *elem = &concealed->meld[i];
+    if (is_element_triplets(elem)) {
+      if (elem->tile_id[0] == win_tile) {
+        machi->shanpon = true;
+      }
+    } else if (is_element_sequence(elem)) {
+      uint32_t number = get_tile_number(elem->tile_id[0]);  // n,n+1,n+2の順子
+      if (elem->tile_id[0] == win_tile) {
+        if (number == TILE_NUM_7) {  // 789で7がアガリ牌
+          machi->penchan = true;
+        } else {
+          machi->ryanmen = true;
+        }
+      }
+      if (elem->tile_id[1] == win_tile) {
+        machi->kanchan = true;
+      }
+      if (elem->tile_id[2] == win_tile) {
+        if (number == TILE_NUM_1) {  // 123で3がアガリ牌
+          machi->penchan = true;
+        } else {
+          machi->ryanmen = true;
+        }
+      }
     }
   }
-  return true;
+  machi->tanki = is_tanki_machi(pair_tile, win_tile);
 }
 
-static uint32_t count_elements_same_sequence_from(uint32_t start, const Elements *elems) {
-  uint32_t count = 0;
-  assert(start < elems->len);
-  const Element *elem = &elems->meld[start];
-  for (uint32_t i = start + 1; i < elems->len; i++) {
-    if (is_element_same_sequence(elem, &elems->meld[i])) {
-      count++;
-    }
-  }
-  return count;
-}
 /*
  * counts same sequence element in elements
  * 123, 123, 123, 123 => 6
@@ -411,12 +404,21 @@ static uint32_t count_elements_same_sequence_from(uint32_t start, const Elements
  */
 
 uint32_t count_elements_same_sequence(const Elements *elems) {
-  if (elems->len <= 1) {
-    return 0;
+  ElementCode codes[MJ_ELEMENTS_LEN];
+  assert(elems->len <= MJ_ELEMENTS_LEN);
+  for (uint32_t i = 0; i < elems->len; i++) {
+    codes[i] = gen_element_code(&elems->meld[i]);
   }
   uint32_t count = 0;
-  for (uint32_t i = 0; i < elems->len - 1; i++) {
-    count += count_elements_same_sequence_from(i, elems);
+  for (uint32_t i = 0; i < elems->len; i++) {
+    if (get_element_code_type(codes[i]) != ELEM_TYPE_SEQUENCE) {
+      continue;
+    }
+    for (uint32_t j = i + 1; j < elems->len; j++) {
+      if (codes[i] == codes[j]) {
+        count++;
+      }
+    }
   }
   return count;
 }
@@ -430,37 +432,17 @@ static int has_element_tile_id(const Element *elem, MJTileId tile_id) {
   return false;
 }
 
+/* 暗/明は区別しない */
 bool is_same_element(const Element *e1, const Element *e2) {
-  if (e1->len != e2->len) {
-    return false;
-  }
-  if (e1->type != e2->type) {
-    return false;
-  }
-  for (uint32_t i = 0; i < e1->len; i++) {
-    if (e1->tile_id[i] != e2->tile_id[i]) {
-      return false;
-    }
-  }
-  return true;
+  return ((gen_element_code(e1) ^ gen_element_code(e2)) & ~ELEM_CODE_CONCEALED) == 0;
 }
 
 bool is_same_elements(const Elements *e1, const Elements *e2) {
   if (e1->len != e2->len) {
     return false;
   }
-  Elements _e1;
-  Elements _e2;
-  memcpy(&_e1, e1, sizeof(Elements));
-  memcpy(&_e2, e2, sizeof(Elements));
-  sort_elements(&_e1);
-  sort_elements(&_e2);
-  for (uint32_t i = 0; i < _e1.len; i++) {
-    if (!is_same_element(&_e1.meld[i], &_e2.meld[i])) {
-      return false;
-    }
-  }
-  return true;
+  uint32_t mask = 0xffffu & ~ELEM_CODE_CONCEALED;
+  return pack_element_codes(e1, mask) == pack_element_codes(e2, mask);
 }
 
 bool has_elements_tile_id(const Elements *elems, MJTileId tile_id) {
@@ -0,0 +1,609 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "enumerate.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mahjong.h"
+#include "scheduler.h"
+#include "score.h"
+#include "tile.h"
+
+#define ENUM_GROUPS_LEN ((MJ_ELEMENTS_LEN + 1) * MJ_PAIR_LEN)  // (面子の数, 雀頭の数) の組
+#define ENUM_SUIT_KEYS_LEN 65536                               // 重複を含めて生成する数牌1色の完成形の数の上限
+#define ENUM_CHIITOITSU_MASKS (1u << TILE_NUM_LEN)             // 数牌1色の対子の組
+#define ENUM_CHIITOITSU_PAIRS 7
+#define ENUM_KOKUSHI_LEN 13
+#define ENUM_GREEN_RANKS 0xaeu  // 2, 3, 4, 6, 8
+#define ENUM_NO_ELEMENT (-1)
+#define ENUM_SUIT_ELEMENTS ((TILE_NUM_LEN) + (TILE_NUM_LEN - 2))  // 刻子9種類, 順子7種類
+
+typedef struct {
+  // group (面子の数 * 2 + 雀頭の数) の完成形は suits[suit_groups[group], suit_groups[group + 1])
+  EnumSuit suits[ENUM_SUIT_HANDS_LEN];
+  uint32_t suit_groups[ENUM_GROUPS_LEN + 1];
+  EnumSuit honors[ENUM_HONOR_HANDS_LEN];
+  uint32_t honor_groups[ENUM_GROUPS_LEN + 1];
+  // 対子の組が数牌1色の完成形なら雀頭の数. 完成形でなければ ENUM_NO_ELEMENT
+  int8_t chiitoitsu_pairs[ENUM_CHIITOITSU_MASKS];
+  uint16_t chiitoitsu_masks[ENUM_CHIITOITSU_MASKS];  // 対子の数の順に並べた対子の組
+  uint32_t chiitoitsu_begin[TILE_NUM_LEN + 2];       // 対子の数ごとの chiitoitsu_masks の開始位置
+} EnumTables;
+
+typedef struct {
+  EnumHandFunc func;
+  void *arg;
+  bool symmetry;
+} EnumCtx;
+
+typedef struct {
+  alignas(SCHED_CACHE_LINE) MJEnumStats stats;
+} EnumShard;
+
+typedef struct {
+  const MJEnumConfig *config;
+  EnumShard shards[SCHED_MAX_WORKERS];
+} EnumScore;
+
+static EnumTables tables;
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+/* score.c が出力する役の名前 */
+static const char *const yaku_names[MJ_ENUM_YAKU_LEN] = {
+    "kokushi",        "tsuisou",    "chiitoitsu", "chinitsu",   "honitsu",
+    "honroto",        "tanyao",     "tsumo",      "suuankou",   "daisangen",
+    "ryuisou",        "shosuushi",  "daisuushi",  "chinroto",   "suukantsu",
+    "chuuren_poutou", "ryanpeiko",  "junchan",    "toitoi",     "sanankou",
+    "sanshoku_douko", "sankantsu",  "shosangen",  "double_ton", "double_nan",
+    "double_sha",     "double_pei", "sanshoku",   "ittsu",      "chanta",
+    "pinfu",          "iipeiko",    "haku",       "hatsu",      "chun",
+    "ton",            "nan",        "sha",        "pei",
+};
+
+static uint32_t get_enum_group(uint32_t tiles_len) {
+  return tiles_len / MJ_MIN_TILES_LEN_IN_ELEMENT * MJ_PAIR_LEN + (tiles_len % MJ_MIN_TILES_LEN_IN_ELEMENT != 0);
+}
+
+static uint32_t encode_enum_counts(const uint8_t *counts, uint32_t len) {
+  uint32_t code = 0;
+  for (uint32_t i = len; i > 0; i--) {
+    code = code * (MJ_MAX_TILES_LEN_IN_ELEMENT + 1) + counts[i - 1];
+  }
+  return code;
+}
+
+/* key は group << 24 | code */
+static void decode_enum_key(EnumSuit *suit, uint32_t key, uint32_t len) {
+  memset(suit, 0, sizeof(EnumSuit));
+  suit->code = key & 0xffffffu;
+  uint32_t code = suit->code;
+  uint32_t tiles_len = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    suit->counts[i] = (uint8_t)(code % (MJ_MAX_TILES_LEN_IN_ELEMENT + 1));
+    code /= MJ_MAX_TILES_LEN_IN_ELEMENT + 1;
+    tiles_len += suit->counts[i];
+  }
+  suit->elements = (uint8_t)(tiles_len / MJ_MIN_TILES_LEN_IN_ELEMENT);
+  suit->pairs = (uint8_t)(tiles_len % MJ_MIN_TILES_LEN_IN_ELEMENT != 0);
+}
+
+static uint32_t gen_enum_key(const uint8_t *counts, uint32_t len) {
+  uint32_t tiles_len = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    tiles_len += counts[i];
+  }
+  return get_enum_group(tiles_len) << 24 | encode_enum_counts(counts, len);
+}
+
+/* 数牌1色の完成形を, first 番目以降の面子を加えて重複を含めて作る */
+static void gen_enum_suit_keys(uint32_t *keys, uint32_t *len, uint8_t *counts, uint32_t elements, uint32_t first) {
+  assert(*len + TILE_NUM_LEN + 1 <= ENUM_SUIT_KEYS_LEN);
+  keys[(*len)++] = gen_enum_key(counts, TILE_NUM_LEN);
+  for (uint32_t i = 0; i < TILE_NUM_LEN; i++) {
+    if (counts[i] + MJ_PAIR_LEN <= MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      counts[i] += MJ_PAIR_LEN;
+      keys[(*len)++] = gen_enum_key(counts, TILE_NUM_LEN);
+      counts[i] -= MJ_PAIR_LEN;
+    }
+  }
+  if (elements == MJ_ELEMENTS_LEN) {
+    return;
+  }
+  for (uint32_t i = first; i < ENUM_SUIT_ELEMENTS; i++) {
+    if (i < TILE_NUM_LEN) {  // 刻子
+      if (counts[i] + MJ_MIN_TILES_LEN_IN_ELEMENT > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+        continue;
+      }
+      counts[i] += MJ_MIN_TILES_LEN_IN_ELEMENT;
+      gen_enum_suit_keys(keys, len, counts, elements + 1, i);
+      counts[i] -= MJ_MIN_TILES_LEN_IN_ELEMENT;
+    } else {  // 順子
+      uint32_t rank = i - TILE_NUM_LEN;
+      if (counts[rank] == MJ_MAX_TILES_LEN_IN_ELEMENT || counts[rank + 1] == MJ_MAX_TILES_LEN_IN_ELEMENT ||
+          counts[rank + 2] == MJ_MAX_TILES_LEN_IN_ELEMENT) {
+        continue;
+      }
+      counts[rank]++;
+      counts[rank + 1]++;
+      counts[rank + 2]++;
+      gen_enum_suit_keys(keys, len, counts, elements + 1, i);
+      counts[rank]--;
+      counts[rank + 1]--;
+      counts[rank + 2]--;
+    }
+  }
+}
+
+static int compare_enum_keys(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+/* 重複を除いて並べ, suits と groups を作る. 作った数を返す */
+static uint32_t gen_enum_suits(EnumSuit *suits, uint32_t *groups, uint32_t *keys, uint32_t len, uint32_t tiles_len) {
+  qsort(keys, len, sizeof(uint32_t), compare_enum_keys);
+  uint32_t unique_len = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    if (unique_len > 0 && keys[unique_len - 1] == keys[i]) {
+      continue;
+    }
+    keys[unique_len++] = keys[i];
+  }
+  uint32_t group = 0;
+  for (uint32_t i = 0; i < unique_len; i++) {
+    decode_enum_key(&suits[i], keys[i], tiles_len);
+    for (; group <= keys[i] >> 24; group++) {
+      groups[group] = i;
+    }
+  }
+  for (; group <= ENUM_GROUPS_LEN; group++) {
+    groups[group] = unique_len;
+  }
+  return unique_len;
+}
+
+static const EnumSuit *find_enum_suit(uint32_t code, uint32_t group) {
+  uint32_t lo = tables.suit_groups[group];
+  uint32_t hi = tables.suit_groups[group + 1];
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (tables.suits[mid].code < code) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < tables.suit_groups[group + 1] && tables.suits[lo].code == code ? &tables.suits[lo] : NULL;
+}
+
+static void gen_enum_chiitoitsu_tables() {
+  uint32_t len = 0;
+  for (uint32_t pairs = 0; pairs <= TILE_NUM_LEN; pairs++) {
+    tables.chiitoitsu_begin[pairs] = len;
+    for (uint32_t mask = 0; mask < ENUM_CHIITOITSU_MASKS; mask++) {
+      if ((uint32_t)__builtin_popcount(mask) == pairs) {
+        tables.chiitoitsu_masks[len++] = (uint16_t)mask;
+      }
+    }
+  }
+  tables.chiitoitsu_begin[TILE_NUM_LEN + 1] = len;
+  for (uint32_t mask = 0; mask < ENUM_CHIITOITSU_MASKS; mask++) {
+    uint8_t counts[TILE_NUM_LEN] = {0};
+    for (uint32_t i = 0; i < TILE_NUM_LEN; i++) {
+      counts[i] = (mask >> i) & 1 ? MJ_PAIR_LEN : 0;
+    }
+    uint32_t key = gen_enum_key(counts, TILE_NUM_LEN);
+    const EnumSuit *suit = find_enum_suit(key & 0xffffffu, key >> 24);
+    tables.chiitoitsu_pairs[mask] = suit ? (int8_t)suit->pairs : ENUM_NO_ELEMENT;
+  }
+}
+
+static void init_enum_tables() {
+  static uint32_t keys[ENUM_SUIT_KEYS_LEN];
+  uint32_t len = 0;
+  uint8_t counts[TILE_NUM_LEN] = {0};
+  gen_enum_suit_keys(keys, &len, counts, 0, 0);
+  uint32_t suits_len = gen_enum_suits(tables.suits, tables.suit_groups, keys, len, TILE_NUM_LEN);
+  assert(suits_len == ENUM_SUIT_HANDS_LEN);
+  (void)suits_len;
+
+  // 字牌は各牌 0, 2, 3 枚
+  len = 0;
+  uint32_t combinations = 1;
+  for (uint32_t i = 0; i < ENUM_HONORS_LEN; i++) {
+    combinations *= 3;
+  }
+  for (uint32_t i = 0; i < combinations; i++) {
+    uint32_t pairs = 0;
+    uint32_t elements = 0;
+    for (uint32_t j = 0, c = i; j < ENUM_HONORS_LEN; j++, c /= 3) {
+      counts[j] = (uint8_t)(c % 3 == 0 ? 0 : c % 3 == 1 ? MJ_PAIR_LEN : MJ_MIN_TILES_LEN_IN_ELEMENT);
+      pairs += c % 3 == 1;
+      elements += c % 3 == 2;
+    }
+    if (pairs <= 1 && elements <= MJ_ELEMENTS_LEN) {
+      keys[len++] = gen_enum_key(counts, ENUM_HONORS_LEN);
+    }
+  }
+  uint32_t honors_len = gen_enum_suits(tables.honors, tables.honor_groups, keys, len, ENUM_HONORS_LEN);
+  assert(honors_len == ENUM_HONOR_HANDS_LEN);
+  (void)honors_len;
+
+  gen_enum_chiitoitsu_tables();
+}
+
+const EnumSuit *get_enum_suit_hands() {
+  pthread_once(&tables_once, init_enum_tables);
+  return tables.suits;
+}
+
+const EnumSuit *get_enum_honor_hands() {
+  pthread_once(&tables_once, init_enum_tables);
+  return tables.honors;
+}
+
+/* group の中で code 以上の最初の位置 */
+static uint32_t lower_bound_enum_suit(uint32_t group, uint32_t code) {
+  uint32_t lo = tables.suit_groups[group];
+  uint32_t hi = tables.suit_groups[group + 1];
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (tables.suits[mid].code < code) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* 萬子 <= 筒子 <= 索子 の手牌の色を入れ替えた手牌の数 */
+static uint64_t get_enum_weight(uint32_t m, uint32_t p, uint32_t s) {
+  if (m == p && p == s) {
+    return 1;
+  }
+  if (m == p || p == s) {
+    return 3;
+  }
+  return 6;
+}
+
+static void fill_enum_tiles(Tiles *tiles, const uint8_t *m, const uint8_t *p, const uint8_t *s, const uint8_t *h) {
+  memset(tiles, 0, sizeof(Tiles));
+  memcpy(&tiles->tiles[MJ_M1], m, TILE_NUM_LEN);
+  memcpy(&tiles->tiles[MJ_P1], p, TILE_NUM_LEN);
+  memcpy(&tiles->tiles[MJ_S1], s, TILE_NUM_LEN);
+  memcpy(&tiles->tiles[MJ_WT], h, ENUM_HONORS_LEN);
+}
+
+/* 緑一色になりうる数牌1色と字牌 */
+static bool is_enum_green(const EnumSuit *suit, const uint8_t *honors) {
+  for (uint32_t i = 0; i < TILE_NUM_LEN; i++) {
+    if (suit->counts[i] && ((ENUM_GREEN_RANKS >> i) & 1) == 0) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < ENUM_HONORS_LEN; i++) {
+    if (honors[i] && MJ_WT + i != MJ_DG) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void emit_enum_hand(const EnumCtx *ctx, uint32_t worker, const EnumSuit *m, const EnumSuit *p,
+                           const EnumSuit *s, const uint8_t *h, EnumForm form) {
+  Tiles tiles;
+  fill_enum_tiles(&tiles, m->counts, p->counts, s->counts, h);
+  if (!ctx->symmetry) {
+    ctx->func(ctx->arg, worker, &tiles, 1, form);
+    return;
+  }
+  if (m->code == 0 && p->code == 0 && s->code != 0 && is_enum_green(s, h)) {
+    // 索子なら緑一色, 萬子と筒子は同じ
+    ctx->func(ctx->arg, worker, &tiles, 1, form);
+    fill_enum_tiles(&tiles, s->counts, p->counts, m->counts, h);
+    ctx->func(ctx->arg, worker, &tiles, 2, form);
+    return;
+  }
+  ctx->func(ctx->arg, worker, &tiles, get_enum_weight(m->code, p->code, s->code), form);
+}
+
+/* 萬子が m の通常形 */
+static void enumerate_normal(const EnumCtx *ctx, uint32_t worker, const EnumSuit *m) {
+  for (uint32_t pg = 0; pg < ENUM_GROUPS_LEN; pg++) {
+    uint32_t p_elements = m->elements + pg / MJ_PAIR_LEN;
+    uint32_t p_pairs = m->pairs + pg % MJ_PAIR_LEN;
+    if (p_elements > MJ_ELEMENTS_LEN || p_pairs > 1) {
+      continue;
+    }
+    uint32_t p_begin = ctx->symmetry ? lower_bound_enum_suit(pg, m->code) : tables.suit_groups[pg];
+    for (uint32_t pi = p_begin; pi < tables.suit_groups[pg + 1]; pi++) {
+      const EnumSuit *p = &tables.suits[pi];
+      for (uint32_t sg = 0; sg < ENUM_GROUPS_LEN; sg++) {
+        uint32_t s_elements = p_elements + sg / MJ_PAIR_LEN;
+        uint32_t s_pairs = p_pairs + sg % MJ_PAIR_LEN;
+        if (s_elements > MJ_ELEMENTS_LEN || s_pairs > 1) {
+          continue;
+        }
+        uint32_t hg = (MJ_ELEMENTS_LEN - s_elements) * MJ_PAIR_LEN + (1 - s_pairs);
+        uint32_t s_begin = ctx->symmetry ? lower_bound_enum_suit(sg, p->code) : tables.suit_groups[sg];
+        for (uint32_t si = s_begin; si < tables.suit_groups[sg + 1]; si++) {
+          for (uint32_t hi = tables.honor_groups[hg]; hi < tables.honor_groups[hg + 1]; hi++) {
+            emit_enum_hand(ctx, worker, m, p, &tables.suits[si], tables.honors[hi].counts, ENUM_FORM_NORMAL);
+          }
+        }
+      }
+    }
+  }
+}
+
+static void fill_enum_chiitoitsu(EnumSuit *suit, uint32_t mask, uint32_t len) {
+  memset(suit, 0, sizeof(EnumSuit));
+  for (uint32_t i = 0; i < len; i++) {
+    suit->counts[i] = (mask >> i) & 1 ? MJ_PAIR_LEN : 0;
+  }
+  suit->code = encode_enum_counts(suit->counts, len);
+}
+
+/* 通常形にも分解できる七対子 (二盃口など) */
+static bool is_enum_chiitoitsu_normal(uint32_t m, uint32_t p, uint32_t s, uint32_t h) {
+  if (tables.chiitoitsu_pairs[m] == ENUM_NO_ELEMENT || tables.chiitoitsu_pairs[p] == ENUM_NO_ELEMENT ||
+      tables.chiitoitsu_pairs[s] == ENUM_NO_ELEMENT) {
+    return false;
+  }
+  uint32_t pairs = (uint32_t)(tables.chiitoitsu_pairs[m] + tables.chiitoitsu_pairs[p] + tables.chiitoitsu_pairs[s]);
+  return pairs + (uint32_t)__builtin_popcount(h) == 1;
+}
+
+/* 萬子の対子が m_mask の七対子 */
+static void enumerate_chiitoitsu(const EnumCtx *ctx, uint32_t worker, uint32_t m_mask) {
+  uint32_t m_pairs = (uint32_t)__builtin_popcount(m_mask);
+  if (m_pairs > ENUM_CHIITOITSU_PAIRS) {
+    return;
+  }
+  EnumSuit m;
+  EnumSuit p;
+  EnumSuit s;
+  EnumSuit h;
+  fill_enum_chiitoitsu(&m, m_mask, TILE_NUM_LEN);
+  for (uint32_t pi = 0; pi < tables.chiitoitsu_begin[ENUM_CHIITOITSU_PAIRS - m_pairs + 1]; pi++) {
+    uint32_t p_mask = tables.chiitoitsu_masks[pi];
+    fill_enum_chiitoitsu(&p, p_mask, TILE_NUM_LEN);
+    if (ctx->symmetry && p.code < m.code) {
+      continue;
+    }
+    uint32_t p_pairs = m_pairs + (uint32_t)__builtin_popcount(p_mask);
+    for (uint32_t si = 0; si < tables.chiitoitsu_begin[ENUM_CHIITOITSU_PAIRS - p_pairs + 1]; si++) {
+      uint32_t s_mask = tables.chiitoitsu_masks[si];
+      fill_enum_chiitoitsu(&s, s_mask, TILE_NUM_LEN);
+      if (ctx->symmetry && s.code < p.code) {
+        continue;
+      }
+      uint32_t h_pairs = ENUM_CHIITOITSU_PAIRS - p_pairs - (uint32_t)__builtin_popcount(s_mask);
+      if (h_pairs > ENUM_HONORS_LEN) {
+        continue;
+      }
+      for (uint32_t hi = tables.chiitoitsu_begin[h_pairs]; hi < tables.chiitoitsu_begin[h_pairs + 1]; hi++) {
+        uint32_t h_mask = tables.chiitoitsu_masks[hi];
+        if (h_mask >= (1u << ENUM_HONORS_LEN)) {
+          continue;
+        }
+        if (is_enum_chiitoitsu_normal(m_mask, p_mask, s_mask, h_mask)) {
+          continue;  // 通常形で数えた
+        }
+        fill_enum_chiitoitsu(&h, h_mask, ENUM_HONORS_LEN);
+        emit_enum_hand(ctx, worker, &m, &p, &s, h.counts, ENUM_FORM_CHIITOITSU);
+      }
+    }
+  }
+}
+
+static void enumerate_kokushi(const EnumCtx *ctx, uint32_t worker) {
+  const MJTileId yaochu[ENUM_KOKUSHI_LEN] = {MJ_M1, MJ_M9, MJ_P1, MJ_P9, MJ_S1, MJ_S9, MJ_WT,
+                                             MJ_WN, MJ_WS, MJ_WP, MJ_DW, MJ_DG, MJ_DR};
+  for (uint32_t i = 0; i < ENUM_KOKUSHI_LEN; i++) {
+    Tiles tiles;
+    memset(&tiles, 0, sizeof(Tiles));
+    for (uint32_t j = 0; j < ENUM_KOKUSHI_LEN; j++) {
+      tiles.tiles[yaochu[j]] = 1;
+    }
+    tiles.tiles[yaochu[i]]++;
+    ctx->func(ctx->arg, worker, &tiles, 1, ENUM_FORM_KOKUSHI);  // 13通りなので色の入れ替えはしない
+  }
+}
+
+/* task: [0, ENUM_SUIT_HANDS_LEN) は通常形, 続く ENUM_CHIITOITSU_MASKS 個は七対子, 最後は国士無双 */
+static void enumerate_task(void *arg, uint32_t worker, uint64_t task) {
+  const EnumCtx *ctx = (const EnumCtx *)arg;
+  if (task < ENUM_SUIT_HANDS_LEN) {
+    enumerate_normal(ctx, worker, &tables.suits[task]);
+  } else if (task < ENUM_SUIT_HANDS_LEN + ENUM_CHIITOITSU_MASKS) {
+    enumerate_chiitoitsu(ctx, worker, (uint32_t)(task - ENUM_SUIT_HANDS_LEN));
+  } else {
+    enumerate_kokushi(ctx, worker);
+  }
+}
+
+int32_t enumerate_complete_hands(EnumHandFunc func, void *arg, uint32_t threads, bool symmetry) {
+  pthread_once(&tables_once, init_enum_tables);
+  EnumCtx ctx = {func, arg, symmetry};
+  // タスクごとの手牌の数は大きく異なるので1つずつ取り出す
+  return mj_parallel_for(ENUM_SUIT_HANDS_LEN + ENUM_CHIITOITSU_MASKS + 1, threads, 1, enumerate_task, &ctx);
+}
+
+uint64_t get_enum_yaku_mask(const char *yaku_name) {
+  // yaku_name は "name name " の形
+  uint64_t mask = 0;
+  while (*yaku_name) {
+    const char *end = strchr(yaku_name, ' ');
+    size_t len = end ? (size_t)(end - yaku_name) : strlen(yaku_name);
+    uint32_t i = 0;
+    for (; i < MJ_ENUM_YAKU_LEN; i++) {
+      if (strncmp(yaku_names[i], yaku_name, len) == 0 && yaku_names[i][len] == '\0') {
+        mask |= 1ull << i;
+        break;
+      }
+    }
+    assert(i < MJ_ENUM_YAKU_LEN);
+    yaku_name += end ? len + 1 : len;
+  }
+  return mask;
+}
+
+static void add_enum_yaku(MJEnumScoreStats *stats, const char *yaku_name, uint64_t weight) {
+  for (uint64_t mask = get_enum_yaku_mask(yaku_name); mask; mask &= mask - 1) {
+    stats->yaku[__builtin_ctzll(mask)] += weight;
+  }
+}
+
+/* 子のロンの点数で満貫未満, 満貫, 跳満, 倍満, 三倍満, 役満に分ける */
+static uint32_t get_enum_limit(uint32_t fu, uint32_t han) {
+  const uint32_t limits[MJ_ENUM_LIMIT_LEN - 1] = {8000, 12000, 16000, 24000, 32000};
+  uint32_t score = 0;
+  uint32_t score_dealer = 0;
+  get_score(fu, han, false, false, &score, &score_dealer);
+  uint32_t i = 0;
+  for (; i < MJ_ENUM_LIMIT_LEN - 1 && score >= limits[i]; i++) {
+  }
+  return i;
+}
+
+static void add_enum_score(MJEnumScoreStats *stats, const MJBaseScore *score, bool ron, bool dealer,
+                           uint64_t weight) {
+  stats->scored += weight;
+  if (score->han == 0) {
+    stats->no_yaku += weight;
+    return;
+  }
+  add_enum_yaku(stats, score->yaku_name, weight);
+  stats->han[score->han < MJ_ENUM_HAN_LEN ? score->han : MJ_ENUM_HAN_LEN - 1] += weight;
+  stats->fu[score->fu / 5 < MJ_ENUM_FU_LEN ? score->fu / 5 : MJ_ENUM_FU_LEN - 1] += weight;
+  stats->limits[get_enum_limit(score->fu, score->han)] += weight;
+  uint32_t points = 0;
+  uint32_t points_dealer = 0;
+  get_score(score->fu, score->han, !ron, dealer, &points, &points_dealer);
+  if (!ron) {  // 3人の支払いの合計
+    points = dealer ? points * (MJ_GAME_PLAYERS - 1) : points * (MJ_GAME_PLAYERS - 2) + points_dealer;
+  }
+  stats->points += points * weight;
+}
+
+void score_enum_hand(MJEnumStats *stats, const Tiles *tiles, uint64_t weight, EnumForm form, MJTileId player_wind,
+                     MJTileId round_wind) {
+  MJHands hands;
+  MJScoreConfig configs[ENUM_MAX_CONFIGS];
+  uint32_t configs_len = 0;
+  hands.len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    for (uint32_t j = 0; j < tiles->tiles[i]; j++) {
+      hands.tile_id[hands.len++] = (MJTileId)i;
+    }
+    if (tiles->tiles[i]) {
+      configs[configs_len++] = (MJScoreConfig){(MJTileId)i, false, player_wind, round_wind};
+      configs[configs_len++] = (MJScoreConfig){(MJTileId)i, true, player_wind, round_wind};
+    }
+  }
+  // 全てのアガリ牌とツモ, ロンを1回の面子の分解で計算する
+  MJMelds melds = {{}, 0};
+  MJBaseScore scores[ENUM_MAX_CONFIGS];
+  int32_t ret = mj_get_scores(scores, &hands, &melds, configs, configs_len);
+  assert(ret == MJ_OK);
+  if (ret != MJ_OK) {
+    return;
+  }
+  stats->hands += weight;
+  if (form == ENUM_FORM_NORMAL) {
+    stats->normal += weight;
+  } else if (form == ENUM_FORM_CHIITOITSU) {
+    stats->chiitoitsu += weight;
+  } else {
+    stats->kokushi += weight;
+  }
+  bool dealer = player_wind == MJ_WT;
+  for (uint32_t i = 0; i < configs_len; i++) {
+    add_enum_score(configs[i].ron ? &stats->ron : &stats->tsumo, &scores[i], configs[i].ron, dealer, weight);
+  }
+}
+
+static void merge_enum_score_stats(MJEnumScoreStats *stats, const MJEnumScoreStats *shard) {
+  stats->scored += shard->scored;
+  stats->no_yaku += shard->no_yaku;
+  for (uint32_t i = 0; i < MJ_ENUM_YAKU_LEN; i++) {
+    stats->yaku[i] += shard->yaku[i];
+  }
+  for (uint32_t i = 0; i < MJ_ENUM_HAN_LEN; i++) {
+    stats->han[i] += shard->han[i];
+  }
+  for (uint32_t i = 0; i < MJ_ENUM_FU_LEN; i++) {
+    stats->fu[i] += shard->fu[i];
+  }
+  for (uint32_t i = 0; i < MJ_ENUM_LIMIT_LEN; i++) {
+    stats->limits[i] += shard->limits[i];
+  }
+  stats->points += shard->points;
+}
+
+static void score_enum_task(void *arg, uint32_t worker, const Tiles *tiles, uint64_t weight, EnumForm form) {
+  EnumScore *score = (EnumScore *)arg;
+  score_enum_hand(&score->shards[worker].stats, tiles, weight, form, score->config->player_wind,
+                  score->config->round_wind);
+}
+
+const char *mj_enum_yaku_name(uint32_t index) { return index < MJ_ENUM_YAKU_LEN ? yaku_names[index] : NULL; }
+
+int32_t mj_enumerate_complete_hands(MJEnumStats *stats, const MJEnumConfig *config) {
+  if (config->player_wind < MJ_WT || config->player_wind > MJ_WP || config->round_wind < MJ_WT ||
+      config->round_wind > MJ_WP) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  EnumScore score;
+  score.config = config;
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    memset(&score.shards[i].stats, 0, sizeof(MJEnumStats));
+  }
+  int32_t ret = enumerate_complete_hands(score_enum_task, &score, config->threads, config->symmetry);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+
+  memset(stats, 0, sizeof(MJEnumStats));
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    const MJEnumStats *shard = &score.shards[i].stats;
+    stats->hands += shard->hands;
+    stats->normal += shard->normal;
+    stats->chiitoitsu += shard->chiitoitsu;
+    stats->kokushi += shard->kokushi;
+    merge_enum_score_stats(&stats->tsumo, &shard->tsumo);
+    merge_enum_score_stats(&stats->ron, &shard->ron);
+  }
+  return MJ_OK;
+}
@@ -0,0 +1,335 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "ev.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "element.h"
+#include "mahjong.h"
+#include "score.h"
+#include "shanten.h"
+#include "simulate.h"
+#include "tile.h"
+#include "ukeire.h"
+#include "zobrist.h"
+
+#define ENABLE_DEBUG (0)
+
+#define EV_TENPAI_CACHE_LEN 1024  // 2のべき乗
+
+/* テンパイ形ごとの, 待ち牌の点数を残り枚数で重み付けした和 */
+typedef struct {
+  uint64_t hash;
+  double points;  // sum(残り枚数 * 点数)
+  double weight;  // sum(残り枚数)
+  bool valid;
+} EvTenpaiEntry;
+
+typedef struct {
+  EvScorer scorer;
+  Tiles unseen;  // 見えていない牌. ツモによる変化は無視する
+  double ron_rate;
+  EvScoreCache score_cache;
+  EvTenpaiEntry tenpai_cache[EV_TENPAI_CACHE_LEN];
+} EvCtx;
+
+static uint32_t count_ev_dora(const EvScorer *scorer, const Tiles *tiles) {
+  uint32_t dora = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    dora += (uint32_t)tiles->tiles[i] * scorer->dora.tiles[i];
+  }
+  for (uint32_t i = 0; i < scorer->melded.len; i++) {
+    const Element *elem = &scorer->melded.meld[i];
+    for (uint32_t j = 0; j < elem->len; j++) {
+      dora += scorer->dora.tiles[elem->tile_id[j]];
+    }
+  }
+  return dora;
+}
+
+/* 役がなければ0点. ツモは3人の支払いの合計 */
+static uint32_t calc_ev_points(const EvScorer *scorer, const MJBaseScore *score, bool tsumo, uint32_t dora) {
+  uint32_t han = score->han;
+  if (han < EV_YAKUMAN_HAN) {
+    han += scorer->riichi ? 1 : 0;
+    if (han == 0) {
+      return 0;
+    }
+    han += dora;
+  }
+  uint32_t points = 0;
+  uint32_t points_dealer = 0;
+  get_score(score->fu, han, tsumo, scorer->dealer, &points, &points_dealer);
+  if (!tsumo) {
+    return points;
+  }
+  return scorer->dealer ? points * (MJ_GAME_PLAYERS - 1) : points * (MJ_GAME_PLAYERS - 2) + points_dealer;
+}
+
+const EvScoreEntry *lookup_ev_score(EvScoreCache *cache, const EvScorer *scorer, const Tiles *tiles, uint64_t hash,
+                                    MJTileId win_tile) {
+  uint64_t key = hash ^ ((uint64_t)(win_tile + 1) * 0x9e3779b97f4a7c15ull);
+  EvScoreEntry *entry = &cache->entries[key & (EV_SCORE_CACHE_LEN - 1)];
+  if (entry->valid && entry->key == key) {
+    return entry;
+  }
+  entry->key = key;
+  entry->valid = true;
+  entry->tsumo = 0;
+  entry->ron = 0;
+
+  // ツモとロンを1回の面子の分解で計算する
+  MJPreparedHand hand;
+  memcpy(&hand.concealed, tiles, sizeof(Tiles));
+  memcpy(&hand.melded, &scorer->melded, sizeof(Elements));
+  hand.hash = 0;
+  MJScoreConfig configs[2] = {
+      {win_tile, false, scorer->player_wind, scorer->round_wind},
+      {win_tile, true, scorer->player_wind, scorer->round_wind},
+  };
+  MJBaseScore scores[2];
+  if (mj_score_prepared_multi(scores, &hand, configs, 2) != MJ_OK) {
+    return entry;
+  }
+  uint32_t dora = count_ev_dora(scorer, tiles);
+  entry->tsumo = calc_ev_points(scorer, &scores[0], true, dora);
+  entry->ron = calc_ev_points(scorer, &scores[1], false, dora);
+  return entry;
+}
+
+static double mix_ev_points(const EvCtx *ctx, double tsumo, double ron) {
+  return tsumo * (1.0 - ctx->ron_rate) + ron * ctx->ron_rate;
+}
+
+/* テンパイの tiles (total_len 枚) の待ち牌の点数 */
+static const EvTenpaiEntry *lookup_ev_tenpai(EvCtx *ctx, Tiles *tiles, uint64_t hash, int32_t total_len) {
+  EvTenpaiEntry *entry = &ctx->tenpai_cache[hash & (EV_TENPAI_CACHE_LEN - 1)];
+  if (entry->valid && entry->hash == hash) {
+    return entry;
+  }
+  entry->hash = hash;
+  entry->valid = true;
+  entry->points = 0.0;
+  entry->weight = 0.0;
+  uint64_t waits = gen_acceptable_mask(tiles, total_len, 0);
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if ((waits & (1ull << i)) == 0 || ctx->unseen.tiles[i] == 0) {
+      continue;
+    }
+    uint64_t win_hash = add_zobrist_tile(hash, tiles, (MJTileId)i);
+    add_tile(tiles, (MJTileId)i);
+    const EvScoreEntry *score = lookup_ev_score(&ctx->score_cache, &ctx->scorer, tiles, win_hash, (MJTileId)i);
+    remove_tile(tiles, (MJTileId)i);
+    entry->points += ctx->unseen.tiles[i] * mix_ev_points(ctx, score->tsumo, score->ron);
+    entry->weight += ctx->unseen.tiles[i];
+  }
+  return entry;
+}
+
+/*
+ * 1向聴の tiles (total_len 枚) がテンパイしてアガった場合の点数の期待値.
+ * 有効牌ごとに, 待ち牌の点数と残り枚数の積の和が最大になるテンパイ形に取り, 有効牌の残り枚数で平均する.
+ */
+static double calc_ev_iishanten(EvCtx *ctx, Tiles *tiles, uint64_t hash, int32_t total_len) {
+  uint64_t acceptables = gen_acceptable_mask(tiles, total_len, 1);
+  double points = 0.0;
+  double weight = 0.0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if ((acceptables & (1ull << i)) == 0 || ctx->unseen.tiles[i] == 0) {
+      continue;
+    }
+    uint64_t draw_hash = add_zobrist_tile(hash, tiles, (MJTileId)i);
+    add_tile(tiles, (MJTileId)i);
+    const EvTenpaiEntry *best = NULL;
+    for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+      if (tiles->tiles[j] == 0 || j == i) {
+        continue;
+      }
+      uint64_t discard_hash = remove_zobrist_tile(draw_hash, tiles, (MJTileId)j);
+      remove_tile(tiles, (MJTileId)j);
+      if (calc_shanten_tiles(tiles, total_len, 0) <= 0) {
+        const EvTenpaiEntry *entry = lookup_ev_tenpai(ctx, tiles, discard_hash, total_len);
+        if (best == NULL || entry->points > best->points) {
+          best = entry;
+        }
+      }
+      add_tile(tiles, (MJTileId)j);
+    }
+    remove_tile(tiles, (MJTileId)i);
+    if (best != NULL && best->weight > 0.0) {
+      points += ctx->unseen.tiles[i] * best->points / best->weight;
+      weight += ctx->unseen.tiles[i];
+    }
+  }
+  return weight > 0.0 ? points / weight : 0.0;
+}
+
+static int32_t init_ev_ctx(EvCtx *ctx, MJTiles *unseen, const MJPreparedHand *hand, const MJTiles *visible,
+                           const MJEvConfig *config) {
+  memset(ctx, 0, sizeof(EvCtx));
+  memcpy(&ctx->scorer.melded, &hand->melded, sizeof(Elements));
+  ctx->scorer.player_wind = config->player_wind;
+  ctx->scorer.round_wind = config->round_wind;
+  ctx->scorer.dealer = config->player_wind == MJ_WT;
+  ctx->scorer.riichi = config->riichi && !has_elements_melded(&hand->melded);
+  gen_tiles_from_mj_tiles(&ctx->scorer.dora, &config->dora);
+  ctx->ron_rate = config->ron_rate;
+
+  // 見えていない牌 = 4 - 手牌 - 副露 - visible
+  Tiles seen;
+  memcpy(&seen, &hand->concealed, sizeof(Tiles));
+  for (uint32_t i = 0; i < hand->melded.len; i++) {
+    const Element *elem = &hand->melded.meld[i];
+    for (uint32_t j = 0; j < elem->len; j++) {
+      add_tile(&seen, elem->tile_id[j]);
+    }
+  }
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    uint32_t count = seen.tiles[i] + (visible ? (uint32_t)visible->tiles[i] : 0);
+    if (count > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    ctx->unseen.tiles[i] = (uint8_t)(MJ_MAX_TILES_LEN_IN_ELEMENT - count);
+  }
+  gen_mj_tiles_from_tiles(unseen, &ctx->unseen);
+  return MJ_OK;
+}
+
+/* 期待値の大きい順. 同じならアガリ率の高い順, 牌の順 */
+static bool is_ev_result_before(const MJEvResult *a, const MJEvResult *b) {
+  if (a->ev != b->ev) {
+    return a->ev > b->ev;
+  }
+  if (a->win_rate != b->win_rate) {
+    return a->win_rate > b->win_rate;
+  }
+  return a->discard < b->discard;
+}
+
+static void sort_ev_results(MJEvResult *results, uint32_t len) {
+  for (uint32_t i = 1; i < len; i++) {
+    MJEvResult result = results[i];
+    uint32_t j = i;
+    for (; j > 0 && is_ev_result_before(&result, &results[j - 1]); j--) {
+      results[j] = results[j - 1];
+    }
+    results[j] = result;
+  }
+}
+
+int32_t mj_evaluate_discards(MJEvResult *results, uint32_t *len, const MJHands *hands, const MJMelds *melds,
+                             const MJTiles *visible, const MJEvConfig *config, MJWinProbTable *table) {
+  if (config->ron_rate < 0.0 || config->ron_rate > 1.0) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  MJPreparedHand hand;
+  int32_t ret = mj_init_hand(&hand, hands, melds);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  int32_t total_len = (int32_t)count_tiles(&hand.concealed);
+  if (total_len % MJ_MIN_TILES_LEN_IN_ELEMENT != 2) {  // ツモ後の手牌
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  EvCtx ctx;
+  MJTiles unseen;
+  ret = init_ev_ctx(&ctx, &unseen, &hand, visible, config);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+
+  // テンパイと1向聴はアガリ率を厳密に求める
+  MJWinProbResult probs[MJ_DR + 1];
+  uint32_t probs_len;
+  ret = mj_win_probability_discards(probs, &probs_len, hands, melds, &unseen, config->draws, table);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  uint64_t sim_discards = 0;
+  int32_t result_index[MJ_DR + 1];  // 打牌 -> results の添字
+  for (uint32_t i = 0; i <= MJ_DR; i++) {
+    result_index[i] = -1;
+  }
+  for (uint32_t i = 0; i < probs_len; i++) {
+    MJEvResult *result = &results[i];
+    result_index[probs[i].discard] = (int32_t)i;
+    result->discard = probs[i].discard;
+    result->shanten = probs[i].shanten;
+    result->exact = probs[i].evaluated;
+    result->win_rate = probs[i].win_rate;
+    result->win_score = 0.0;
+    if (!result->exact) {
+      sim_discards |= 1ull << result->discard;
+      continue;
+    }
+    if (result->win_rate == 0.0) {
+      continue;
+    }
+    remove_tile(&hand.concealed, result->discard);
+    uint64_t hash = hash_tiles(&hand.concealed);
+    if (result->shanten == 0) {
+      const EvTenpaiEntry *entry = lookup_ev_tenpai(&ctx, &hand.concealed, hash, total_len - 1);
+      result->win_score = entry->weight > 0.0 ? entry->points / entry->weight : 0.0;
+    } else {
+      result->win_score = calc_ev_iishanten(&ctx, &hand.concealed, hash, total_len - 1);
+    }
+    add_tile(&hand.concealed, result->discard);
+  }
+
+  // 2向聴以上はシミュレーションでアガった手牌の点数を平均する
+  if (sim_discards != 0) {
+    MJSimConfig sim_config = {config->seed, config->samples, config->draws, config->threads};
+    MJSimResult sims[MJ_DR + 1];
+    SimPoints points[MJ_DR + 1];
+    uint32_t sims_len;
+    ret = simulate_discards(sims, points, &sims_len, hands, melds, visible, &sim_config, sim_discards, &ctx.scorer);
+    if (ret != MJ_OK) {
+      return ret;
+    }
+    for (uint32_t i = 0; i < sims_len; i++) {
+      if (sims[i].discard > MJ_DR || result_index[sims[i].discard] < 0) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      MJEvResult *result = &results[result_index[sims[i].discard]];
+      result->win_rate = sims[i].win_rate;
+      if (sims[i].win > 0) {
+        result->win_score = mix_ev_points(&ctx, (double)points[i].tsumo, (double)points[i].ron) / sims[i].win;
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < probs_len; i++) {
+    results[i].ev = results[i].win_rate * results[i].win_score;
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+    fprintf(stderr, "%s: shanten %d, win %f, score %f, ev %f\n", tile_id_str(results[i].discard),
+            results[i].shanten, results[i].win_rate, results[i].win_score, results[i].ev);
+#endif
+  }
+  sort_ev_results(results, probs_len);
+  *len = probs_len;
+  return MJ_OK;
+}
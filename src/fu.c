@@ -29,6 +29,13 @@
 static uint32_t round_up(uint32_t fu, uint32_t n) { return ((fu + (n - 1)) / n) * n; }
 
 uint32_t calc_fu(const Elements *concealed, const Elements *melded, MJTileId pair, const ScoreConfig *cfg, bool pinfu) {
+  Machi machi;
+  gen_machi(&machi, concealed, pair, cfg->win_tile);
+  return calc_fu_with_machi(concealed, melded, pair, cfg, &machi, pinfu);
+}
+
+uint32_t calc_fu_with_machi(const Elements *concealed, const Elements *melded, MJTileId pair, const ScoreConfig *cfg,
+                            const Machi *machi, bool pinfu) {
   if (pinfu) {
     if (cfg->ron) {
       return 30;
@@ -50,24 +57,25 @@ uint32_t calc_fu(const Elements *concealed, const Elements *melded, MJTileId pai
   if (cfg->player_wind == pair || cfg->round_wind == pair) {  // 連風牌は2符
     fu += 2;
   }
-  if (is_kanchan_machi(concealed, cfg->win_tile) || is_penchan_machi(concealed, cfg->win_tile) ||
-      is_tanki_machi(pair, cfg->win_tile)) {
+  if (machi->kanchan || machi->penchan || machi->tanki) {  // 両面とも解釈できる場合も符のつく待ちを採用する(高点法)
     fu += 2;
   }
+  /* アガリ牌がシャンポン待ちとしか解釈できない場合のみ, ロンで作成された刻子を明刻として扱う(高点法) */
+  bool ron_triplets = is_machi_ron_triplets(machi, cfg->ron);
   // concealed
   for (uint32_t i = 0; i < concealed->len; i++) {
     const Element *elem = &concealed->meld[i];
     if (is_element_triplets(elem)) {
       MJTileId tile_id = elem->tile_id[0];
       if (is_element_chunchan(elem)) {
-        if (tile_id == cfg->win_tile && cfg->ron) {  // この刻子はロンで作成された刻子なので明刻扱い
-          fu += 2;                                   // 明刻(中張牌)
+        if (tile_id == cfg->win_tile && ron_triplets) {  // この刻子はロンで作成された刻子なので明刻扱い
+          fu += 2;                                      // 明刻(中張牌)
         } else {
           fu += 4;  // 暗刻(中張牌)
         }
       } else {
-        if (tile_id == cfg->win_tile && cfg->ron) {  // この刻子はロンで作成された刻子なので明刻扱い
-          fu += 4;                                   // 明刻(么九牌)
+        if (tile_id == cfg->win_tile && ron_triplets) {  // この刻子はロンで作成された刻子なので明刻扱い
+          fu += 4;                                      // 明刻(么九牌)
         } else {
           fu += 8;  // 暗刻(么九牌)
         }
@@ -0,0 +1,831 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "game.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bitboard.h"
+#include "element.h"
+#include "mahjong.h"
+#include "rng.h"
+#include "scheduler.h"
+#include "score.h"
+#include "shanten.h"
+#include "simulate.h"
+#include "tile.h"
+#include "ukeire.h"
+#include "zobrist.h"
+
+#define ENABLE_DEBUG (0)
+
+/* 1局の結果 */
+typedef struct {
+  bool win;
+  uint32_t winner;
+  bool renchan;  // 親のアガリ, または親のテンパイでの流局
+} HandResult;
+
+/* 行動の候補 */
+typedef struct {
+  MJAction actions[MJ_GAME_MAX_ACTIONS];
+  uint32_t len;
+} Actions;
+
+/* mj_play_games のワーカーごとの集計. 他のワーカーの集計とキャッシュラインを共有しない */
+typedef struct {
+  alignas(SCHED_CACHE_LINE) MJGameStats stats;
+  uint64_t error_index;  // 失敗した対局の最小の index. 失敗がなければ UINT64_MAX
+  int32_t error;
+} GameShard;
+
+typedef struct {
+  MJGameResult *results;
+  const MJGameConfig *config;
+  GameShard shards[SCHED_MAX_WORKERS];
+} GameBatch;
+
+static inline uint64_t get_tile_bit(MJTileId tile_id) { return 1ull << tile_id; }
+
+static void add_action(Actions *actions, MJActionType type, MJTileId tile_id, MJTileId first) {
+  assert(actions->len < MJ_GAME_MAX_ACTIONS);
+  MJAction *action = &actions->actions[actions->len++];
+  action->type = type;
+  action->tile = tile_id;
+  action->first = first;
+}
+
+static MJTileId get_player_wind(const MJGame *game, uint32_t player) {
+  return MJ_WT + (player + MJ_GAME_PLAYERS - game->dealer) % MJ_GAME_PLAYERS;
+}
+
+static MJTileId get_round_wind(const MJGame *game) { return MJ_WT + game->round / MJ_GAME_PLAYERS; }
+
+static void update_wall_left(MJGame *game) { game->wall_left = game->wall_end - game->wall_pos; }
+
+MJTileId get_dora_tile(MJTileId indicator) {
+  if (indicator <= MJ_S9) {
+    return get_tile_number(indicator) == TILE_NUM_9 ? indicator - TILE_NUM_9 : indicator + 1;
+  }
+  if (indicator <= MJ_WP) {
+    return indicator == MJ_WP ? MJ_WT : indicator + 1;
+  }
+  return indicator == MJ_DR ? MJ_DW : indicator + 1;
+}
+
+/*
+ * 手牌(3n+1枚)のシャンテン数と待ち牌. 手牌が変わっていなければ計算しない.
+ * split は player の手牌の種類ごとの探索結果で, 打牌とツモで変わった種類だけ探索し直す.
+ */
+static void update_player_state(MJGamePlayer *player, SplitShanten *split) {
+  if (player->hand.hash == player->state_hash) {
+    return;
+  }
+  const Tiles *concealed = &player->hand.concealed;
+  update_split_shanten(split, concealed, (int32_t)count_tiles(concealed));
+  player->shanten = split->shanten;
+  player->waits = 0;
+  if (player->shanten == 0) {
+    for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+      if (concealed->tiles[i] < MJ_MAX_TILES_LEN_IN_ELEMENT && calc_split_shanten(split, (MJTileId)i, 1) < 0) {
+        player->waits |= get_tile_bit(i);
+      }
+    }
+  }
+  player->state_hash = player->hand.hash;
+  // テンパイなら有効牌は待ち牌. それ以外はツモった牌の分だけ後で求める
+  player->acceptables = player->waits;
+  player->checked = player->shanten == 0 ? ~0ull : 0;
+}
+
+/* 打牌後の手牌に tile_id をツモるとシャンテン数が減るか. 同じ手牌で初めてツモった牌だけ計算する */
+static bool is_player_acceptable(MJGamePlayer *player, SplitShanten *split, MJTileId tile_id) {
+  uint64_t bit = get_tile_bit(tile_id);
+  if ((player->checked & bit) == 0) {
+    player->checked |= bit;
+    if (calc_split_shanten(split, tile_id, 1) < player->shanten) {
+      player->acceptables |= bit;
+    }
+  }
+  return (player->acceptables & bit) != 0;
+}
+
+void deal_game(MJGame *game, Rng *rng) {
+  for (uint32_t i = 0; i < MJ_GAME_WALL_LEN; i++) {
+    game->wall[i] = (uint8_t)(i / MJ_MAX_TILES_LEN_IN_ELEMENT);
+  }
+  for (uint32_t i = 0; i + 1 < MJ_GAME_WALL_LEN; i++) {  // Fisher-Yates
+    uint32_t j = i + next_rng_bounded(rng, MJ_GAME_WALL_LEN - i);
+    uint8_t tile_id = game->wall[j];
+    game->wall[j] = game->wall[i];
+    game->wall[i] = tile_id;
+  }
+  game->wall_pos = 0;
+  game->wall_end = GAME_DEAD_WALL_POS;
+  game->kans = 0;
+  game->dora_indicators[0] = game->wall[GAME_DEAD_WALL_POS];
+  game->dora_len = 1;
+  game->turn = game->dealer;
+  game->drawn = GAME_NO_TILE;
+
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    MJGamePlayer *player = &game->players[(game->dealer + i) % MJ_GAME_PLAYERS];
+    memset(&player->hand, 0, sizeof(MJPreparedHand));
+    for (uint32_t j = 0; j < MJ_MIN_HAND_LEN - 1; j++) {
+      add_tile(&player->hand.concealed, game->wall[game->wall_pos++]);
+    }
+    player->hand.hash = hash_tiles(&player->hand.concealed) ^ hash_elements(&player->hand.melded);
+    player->state_hash = ~player->hand.hash;  // play_hand が求める
+    player->river_len = 0;
+    player->riichi = false;
+    player->discarded = 0;
+    player->furiten = false;
+    player->ippatsu = false;
+  }
+  update_wall_left(game);
+}
+
+static uint32_t count_hand_tile(const MJPreparedHand *hand, MJTileId tile_id) {
+  uint32_t count = hand->concealed.tiles[tile_id];
+  for (uint32_t i = 0; i < hand->melded.len; i++) {
+    const Element *elem = &hand->melded.meld[i];
+    for (uint32_t j = 0; j < elem->len; j++) {
+      count += elem->tile_id[j] == tile_id;
+    }
+  }
+  return count;
+}
+
+uint32_t count_game_dora(const MJGame *game, const MJPreparedHand *hand, bool ura) {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < game->dora_len; i++) {
+    MJTileId indicator = ura ? game->wall[GAME_DEAD_WALL_POS + 2 * i + 1] : game->dora_indicators[i];
+    count += count_hand_tile(hand, get_dora_tile(indicator));
+  }
+  return count;
+}
+
+bool score_game_win(const MJGame *game, uint32_t player, MJTileId tile, bool ron, bool rinshan, uint32_t *han,
+                    uint32_t *fu) {
+  const MJGamePlayer *p = &game->players[player];
+  MJPreparedHand hand = p->hand;
+  if (ron && mj_hand_draw(&hand, tile) != MJ_OK) {
+    return false;
+  }
+  MJBaseScore score;
+  if (mj_score_prepared(&score, &hand, tile, ron, get_player_wind(game, player), get_round_wind(game)) != MJ_OK) {
+    return false;
+  }
+  // mj_score_prepared が数えない状況役
+  uint32_t extra = 0;
+  if (p->riichi) {
+    extra += p->ippatsu ? 2 : 1;
+  }
+  if (game->wall_pos == game->wall_end && !rinshan) {
+    extra++;  // 海底, 河底
+  }
+  if (score.han + extra == 0) {
+    return false;  // 役なし
+  }
+  *fu = score.fu;
+  if (score.han >= GAME_YAKUMAN_HAN) {
+    *han = score.han;
+    return true;
+  }
+  *han = score.han + extra + count_game_dora(game, &hand, false);
+  if (p->riichi) {
+    *han += count_game_dora(game, &hand, true);
+  }
+  return true;
+}
+
+void settle_game_win(MJGame *game, uint32_t winner, uint32_t loser, uint32_t han, uint32_t fu) {
+  bool dealer = winner == game->dealer;
+  uint32_t score = 0;
+  uint32_t score_dealer = 0;
+  if (loser != winner) {
+    get_score(fu, han, false, dealer, &score, &score_dealer);
+    int32_t payment = (int32_t)(score + GAME_HONBA_RON * game->honba);
+    game->players[loser].points -= payment;
+    game->players[winner].points += payment;
+  } else {
+    get_score(fu, han, true, dealer, &score, &score_dealer);
+    for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+      if (i == winner) {
+        continue;
+      }
+      int32_t payment = (int32_t)((i == game->dealer ? score_dealer : score) + GAME_HONBA_TSUMO * game->honba);
+      game->players[i].points -= payment;
+      game->players[winner].points += payment;
+    }
+  }
+  game->players[winner].points += (int32_t)(GAME_RIICHI_STICK * game->riichi_sticks);
+  game->riichi_sticks = 0;
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+  fprintf(stderr, "win: player %u, loser %u, han %u, fu %u\n", winner, loser, han, fu);
+#endif
+}
+
+void settle_game_exhaustive_draw(MJGame *game, const bool tenpai[MJ_GAME_PLAYERS]) {
+  uint32_t len = 0;
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    len += tenpai[i];
+  }
+  if (len == 0 || len == MJ_GAME_PLAYERS) {
+    return;
+  }
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    if (tenpai[i]) {
+      game->players[i].points += (int32_t)(GAME_TENPAI_PAYMENT / len);
+    } else {
+      game->players[i].points -= (int32_t)(GAME_TENPAI_PAYMENT / (MJ_GAME_PLAYERS - len));
+    }
+  }
+}
+
+static bool decide_action(const MJGameConfig *config, const MJGame *game, uint32_t player, const Actions *actions,
+                          const MJAction **action) {
+  const MJPlayer *p = &config->players[player];
+  uint32_t index = p->decide(p->arg, game, player, actions->actions, actions->len);
+  if (index >= actions->len) {
+    return false;
+  }
+  *action = &actions->actions[index];
+  return true;
+}
+
+/* 食い替え(鳴いた牌, チーの筋の牌)の打牌を禁止する牌. bit[tile_id] */
+static uint64_t get_kuikae_mask(MJActionType type, MJTileId tile_id, MJTileId first) {
+  uint64_t mask = get_tile_bit(tile_id);
+  if (type == MJ_ACTION_CHI) {
+    if (tile_id == first && get_tile_number(first) + 3 <= TILE_NUM_9) {
+      mask |= get_tile_bit(first + 3);
+    } else if (tile_id == first + 2 && get_tile_number(first) >= TILE_NUM_2) {
+      mask |= get_tile_bit(first - 1);
+    }
+  }
+  return mask;
+}
+
+/* 鳴いた後に食い替えにならない打牌が残るか */
+static bool can_discard_after_call(const MJGamePlayer *player, MJActionType type, MJTileId tile_id, MJTileId first) {
+  Tiles tiles = player->hand.concealed;
+  if (type == MJ_ACTION_CHI) {
+    for (uint32_t i = 0; i < MJ_MIN_TILES_LEN_IN_ELEMENT; i++) {
+      if (first + i != tile_id) {
+        remove_tile(&tiles, first + i);
+      }
+    }
+  } else {
+    tiles.tiles[tile_id] -= MJ_PAIR_LEN;
+  }
+  uint64_t kuikae = get_kuikae_mask(type, tile_id, first);
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (tiles.tiles[i] && (kuikae & get_tile_bit(i)) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool can_ron(const MJGame *game, uint32_t player, MJTileId tile_id, uint32_t *han, uint32_t *fu) {
+  const MJGamePlayer *p = &game->players[player];
+  if (p->shanten != 0 || (p->waits & get_tile_bit(tile_id)) == 0) {
+    return false;
+  }
+  if (p->furiten || (p->discarded & p->waits)) {  // フリテン
+    return false;
+  }
+  return score_game_win(game, player, tile_id, true, false, han, fu);
+}
+
+/* 他家の打牌 tile_id に対する player の行動の候補 */
+static void gen_call_actions(const MJGame *game, uint32_t player, uint32_t discarder, MJTileId tile_id,
+                             Actions *actions) {
+  const MJGamePlayer *p = &game->players[player];
+  actions->len = 0;
+  uint32_t han;
+  uint32_t fu;
+  if (can_ron(game, player, tile_id, &han, &fu)) {
+    add_action(actions, MJ_ACTION_RON, tile_id, tile_id);
+  }
+  // リーチ後と河底牌は鳴けない
+  if (!p->riichi && game->wall_pos < game->wall_end && p->hand.melded.len < MJ_ELEMENTS_LEN) {
+    uint32_t count = p->hand.concealed.tiles[tile_id];
+    if (count >= MJ_PAIR_LEN && can_discard_after_call(p, MJ_ACTION_PON, tile_id, tile_id)) {
+      add_action(actions, MJ_ACTION_PON, tile_id, tile_id);
+    }
+    if (count == MJ_MIN_TILES_LEN_IN_ELEMENT && game->kans < GAME_MAX_KANS) {
+      add_action(actions, MJ_ACTION_MINKAN, tile_id, tile_id);
+    }
+    if (player == (discarder + 1) % MJ_GAME_PLAYERS && !is_tile_id_honors(tile_id)) {
+      uint32_t number = get_tile_number(tile_id);
+      for (uint32_t d = 0; d < MJ_MIN_TILES_LEN_IN_ELEMENT; d++) {
+        if (number < d || number - d + 2 > TILE_NUM_9) {
+          continue;
+        }
+        MJTileId first = tile_id - d;
+        bool found = true;
+        for (uint32_t i = 0; i < MJ_MIN_TILES_LEN_IN_ELEMENT; i++) {
+          if (first + i != tile_id && p->hand.concealed.tiles[first + i] == 0) {
+            found = false;
+          }
+        }
+        if (found && can_discard_after_call(p, MJ_ACTION_CHI, tile_id, first)) {
+          add_action(actions, MJ_ACTION_CHI, tile_id, first);
+        }
+      }
+    }
+  }
+  if (actions->len) {
+    add_action(actions, MJ_ACTION_PASS, tile_id, tile_id);
+  }
+}
+
+/* ツモ後(drawn が MJ_DR 以下), または鳴いた後の手番の行動の候補. split は打牌後の手牌の探索結果 */
+static void gen_turn_actions(const MJGame *game, uint32_t player, const SplitShanten *split, bool rinshan,
+                             uint64_t kuikae, Actions *actions) {
+  const MJGamePlayer *p = &game->players[player];
+  MJTileId drawn = game->drawn;
+  actions->len = 0;
+  uint32_t han;
+  uint32_t fu;
+  if (drawn <= MJ_DR && p->shanten == 0 && (p->waits & get_tile_bit(drawn)) &&
+      score_game_win(game, player, drawn, false, rinshan, &han, &fu)) {
+    add_action(actions, MJ_ACTION_TSUMO, drawn, drawn);
+  }
+  if (p->riichi) {
+    add_action(actions, MJ_ACTION_DISCARD, drawn, drawn);  // ツモ切りのみ
+    return;
+  }
+  const Tiles *concealed = &p->hand.concealed;
+  // 手牌にある牌だけを小さい順に見る
+  Bitboard bb;
+  gen_bitboard_from_tiles(&bb, concealed);
+  if (drawn <= MJ_DR && game->kans < GAME_MAX_KANS && game->wall_pos < game->wall_end) {
+    for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+      for (uint64_t fours = find_bb_fours(bb.suit[suit]); fours; fours &= fours - 1) {
+        MJTileId tile_id = get_bb_tile_id(suit, get_bb_lowest_rank(fours));
+        add_action(actions, MJ_ACTION_ANKAN, tile_id, tile_id);
+      }
+    }
+    for (uint32_t i = 0; i < p->hand.melded.len; i++) {
+      const Element *elem = &p->hand.melded.meld[i];
+      if (is_element_triplets(elem) && concealed->tiles[elem->tile_id[0]]) {
+        add_action(actions, MJ_ACTION_KAKAN, elem->tile_id[0], elem->tile_id[0]);
+      }
+    }
+  }
+  if (drawn <= MJ_DR && p->drawn_shanten <= 0 && !has_elements_melded(&p->hand.melded) &&
+      p->points >= GAME_RIICHI_STICK && game->wall_end - game->wall_pos >= MJ_GAME_PLAYERS) {
+    // ツモった牌の種類だけ探索し直して, 1枚ずつ切った手牌のシャンテン数を求める
+    SplitShanten drawn_split = *split;
+    update_split_shanten(&drawn_split, concealed, (int32_t)count_tiles(concealed));
+    for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+      for (uint64_t tiles = find_bb_tiles(bb.suit[suit]); tiles; tiles &= tiles - 1) {
+        MJTileId tile_id = get_bb_tile_id(suit, get_bb_lowest_rank(tiles));
+        if (calc_split_shanten(&drawn_split, tile_id, -1) <= 0) {
+          add_action(actions, MJ_ACTION_RIICHI, tile_id, tile_id);
+        }
+      }
+    }
+  }
+  for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+    for (uint64_t tiles = find_bb_tiles(bb.suit[suit]); tiles; tiles &= tiles - 1) {
+      MJTileId tile_id = get_bb_tile_id(suit, get_bb_lowest_rank(tiles));
+      if ((kuikae & get_tile_bit(tile_id)) == 0) {
+        add_action(actions, MJ_ACTION_DISCARD, tile_id, tile_id);
+      }
+    }
+  }
+}
+
+static void clear_ippatsu(MJGame *game) {
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    game->players[i].ippatsu = false;
+  }
+}
+
+/* 槓の後に新しいドラをめくり, 嶺上牌をツモる */
+static MJTileId draw_rinshan(MJGame *game) {
+  game->kans++;
+  game->dora_indicators[game->dora_len] = game->wall[GAME_DEAD_WALL_POS + 2 * game->dora_len];
+  game->dora_len++;
+  game->wall_end--;
+  update_wall_left(game);
+  clear_ippatsu(game);
+  return game->wall[MJ_GAME_WALL_LEN - game->kans];
+}
+
+static void gen_call_meld(MJMeld *meld, const MJAction *action) {
+  memset(meld, 0, sizeof(MJMeld));
+  if (action->type == MJ_ACTION_CHI) {
+    meld->len = MJ_MIN_TILES_LEN_IN_ELEMENT;
+    for (uint32_t i = 0; i < meld->len; i++) {
+      meld->tile_id[i] = action->first + i;
+    }
+    return;
+  }
+  bool fours = action->type == MJ_ACTION_MINKAN || action->type == MJ_ACTION_ANKAN || action->type == MJ_ACTION_KAKAN;
+  meld->len = fours ? MJ_MAX_TILES_LEN_IN_ELEMENT : MJ_MIN_TILES_LEN_IN_ELEMENT;
+  for (uint32_t i = 0; i < meld->len; i++) {
+    meld->tile_id[i] = action->tile;
+  }
+  meld->concealed = action->type == MJ_ACTION_ANKAN;
+}
+
+/* 打牌に対する他家の行動. ロンは頭ハネ. 鳴いた場合は caller と行動を返す */
+static int32_t respond_discard(MJGame *game, const MJGameConfig *config, uint32_t discarder, MJTileId tile_id,
+                               HandResult *hand_result, bool *called, uint32_t *caller, MJAction *call) {
+  MJAction chosen[MJ_GAME_PLAYERS];
+  bool ron_offered[MJ_GAME_PLAYERS] = {false};
+  *called = false;
+  for (uint32_t i = 1; i < MJ_GAME_PLAYERS; i++) {
+    uint32_t player = (discarder + i) % MJ_GAME_PLAYERS;
+    Actions actions;
+    gen_call_actions(game, player, discarder, tile_id, &actions);
+    chosen[player].type = MJ_ACTION_PASS;
+    if (actions.len == 0) {
+      continue;
+    }
+    ron_offered[player] = actions.actions[0].type == MJ_ACTION_RON;
+    const MJAction *action;
+    if (!decide_action(config, game, player, &actions, &action)) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    chosen[player] = *action;
+  }
+
+  for (uint32_t i = 1; i < MJ_GAME_PLAYERS; i++) {
+    uint32_t player = (discarder + i) % MJ_GAME_PLAYERS;
+    if (chosen[player].type == MJ_ACTION_RON) {
+      uint32_t han;
+      uint32_t fu;
+      bool ron = score_game_win(game, player, tile_id, true, false, &han, &fu);
+      assert(ron);
+      (void)ron;
+      settle_game_win(game, player, discarder, han, fu);
+      hand_result->win = true;
+      hand_result->winner = player;
+      return MJ_OK;
+    }
+  }
+  for (uint32_t i = 1; i < MJ_GAME_PLAYERS; i++) {
+    uint32_t player = (discarder + i) % MJ_GAME_PLAYERS;
+    if (ron_offered[player]) {
+      game->players[player].furiten = true;  // 見逃し. リーチしていなければ次の打牌で解除する
+    }
+  }
+  // ポン, 明槓はチーより優先する
+  for (uint32_t priority = 0; priority < 2 && !*called; priority++) {
+    for (uint32_t i = 1; i < MJ_GAME_PLAYERS; i++) {
+      uint32_t player = (discarder + i) % MJ_GAME_PLAYERS;
+      MJActionType type = chosen[player].type;
+      bool match = priority == 0 ? (type == MJ_ACTION_PON || type == MJ_ACTION_MINKAN) : type == MJ_ACTION_CHI;
+      if (match) {
+        *called = true;
+        *caller = player;
+        *call = chosen[player];
+        break;
+      }
+    }
+  }
+  return MJ_OK;
+}
+
+static void add_river(MJGamePlayer *player, MJTileId tile_id) {
+  if (player->river_len < MJ_GAME_MAX_RIVER) {
+    player->river[player->river_len++] = tile_id;
+  }
+  player->discarded |= get_tile_bit(tile_id);
+}
+
+/* 1局. 配牌済みの game から流局かアガリまで進める */
+static int32_t play_hand(MJGame *game, const MJGameConfig *config, HandResult *hand_result) {
+  memset(hand_result, 0, sizeof(HandResult));
+  uint32_t player = game->dealer;
+  bool draw = true;
+  bool rinshan = false;  // 槓の後の嶺上牌のツモ
+  MJTileId rinshan_tile = GAME_NO_TILE;
+  uint64_t kuikae = 0;
+  SplitShanten splits[MJ_GAME_PLAYERS];
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    splits[i].valid = false;
+    update_player_state(&game->players[i], &splits[i]);
+  }
+  for (;;) {
+    game->turn = player;
+    MJGamePlayer *p = &game->players[player];
+    game->drawn = GAME_NO_TILE;
+    if (rinshan) {
+      game->drawn = rinshan_tile;
+    } else if (draw) {
+      if (game->wall_pos == game->wall_end) {
+        bool tenpai[MJ_GAME_PLAYERS];
+        for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+          tenpai[i] = game->players[i].shanten == 0 && game->players[i].waits != 0;
+        }
+        settle_game_exhaustive_draw(game, tenpai);
+        hand_result->renchan = tenpai[game->dealer];
+        return MJ_OK;
+      }
+      game->drawn = game->wall[game->wall_pos++];
+      update_wall_left(game);
+    }
+    if (game->drawn <= MJ_DR) {
+      p->drawn_shanten = p->shanten - (is_player_acceptable(p, &splits[player], game->drawn) ? 1 : 0);
+      mj_hand_draw(&p->hand, game->drawn);
+    }
+
+    Actions actions;
+    gen_turn_actions(game, player, &splits[player], rinshan, kuikae, &actions);
+    const MJAction *action;
+    if (!decide_action(config, game, player, &actions, &action)) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    if (action->type == MJ_ACTION_TSUMO) {
+      uint32_t han;
+      uint32_t fu;
+      bool tsumo = score_game_win(game, player, action->tile, false, rinshan, &han, &fu);
+      assert(tsumo);
+      (void)tsumo;
+      settle_game_win(game, player, player, han, fu);
+      hand_result->win = true;
+      hand_result->winner = player;
+      hand_result->renchan = player == game->dealer;
+      return MJ_OK;
+    }
+    if (action->type == MJ_ACTION_ANKAN || action->type == MJ_ACTION_KAKAN) {
+      MJMeld meld;
+      gen_call_meld(&meld, action);
+      int32_t ret = mj_hand_call(&p->hand, &meld, action->tile);
+      assert(ret == MJ_OK);
+      (void)ret;
+      update_player_state(p, &splits[player]);
+      rinshan_tile = draw_rinshan(game);
+      rinshan = true;
+      continue;
+    }
+    rinshan = false;
+    kuikae = 0;
+
+    // 打牌
+    MJTileId tile_id = action->tile;
+    mj_hand_discard(&p->hand, tile_id);
+    add_river(p, tile_id);
+    if (!p->riichi) {
+      p->furiten = false;
+    }
+    p->ippatsu = false;
+    bool riichi = action->type == MJ_ACTION_RIICHI;
+    if (riichi) {
+      p->riichi = true;
+      p->ippatsu = true;
+    }
+    update_player_state(p, &splits[player]);
+
+    bool called;
+    uint32_t caller = player;
+    MJAction call = {MJ_ACTION_PASS, GAME_NO_TILE, GAME_NO_TILE};
+    int32_t ret = respond_discard(game, config, player, tile_id, hand_result, &called, &caller, &call);
+    if (ret != MJ_OK || hand_result->win) {
+      if (hand_result->win) {
+        hand_result->renchan = hand_result->winner == game->dealer;
+      }
+      return ret;
+    }
+    if (riichi) {  // ロンされなければリーチ成立
+      p->points -= GAME_RIICHI_STICK;
+      game->riichi_sticks++;
+    }
+    if (!called) {
+      player = (player + 1) % MJ_GAME_PLAYERS;
+      draw = true;
+      continue;
+    }
+
+    MJMeld meld;
+    gen_call_meld(&meld, &call);
+    MJGamePlayer *c = &game->players[caller];
+    ret = mj_hand_call(&c->hand, &meld, tile_id);
+    assert(ret == MJ_OK);
+    clear_ippatsu(game);
+    player = caller;
+    draw = false;
+    if (call.type == MJ_ACTION_MINKAN) {
+      update_player_state(c, &splits[caller]);
+      rinshan_tile = draw_rinshan(game);
+      rinshan = true;
+    } else {
+      kuikae = get_kuikae_mask(call.type, tile_id, call.first);
+    }
+  }
+}
+
+/* 持ち点の順位. 同点は起家に近い順 */
+static void gen_game_ranks(MJGameResult *result) {
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    result->ranks[i] = 0;
+    for (uint32_t j = 0; j < MJ_GAME_PLAYERS; j++) {
+      if (result->points[j] > result->points[i] || (result->points[j] == result->points[i] && j < i)) {
+        result->ranks[i]++;
+      }
+    }
+  }
+}
+
+int32_t mj_play_game(MJGameResult *result, const MJGameConfig *config) {
+  if (config->rounds == 0 || config->rounds > MJ_GAME_PLAYERS * MJ_GAME_PLAYERS) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    if (config->players[i].decide == NULL) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+  }
+  MJGame game;
+  memset(&game, 0, sizeof(MJGame));
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    game.players[i].points = config->start_points;
+  }
+  memset(result, 0, sizeof(MJGameResult));
+  Rng rng;
+  seed_rng(&rng, config->seed);
+
+  while (game.round < config->rounds) {
+    deal_game(&game, &rng);
+    HandResult hand_result;
+    int32_t ret = play_hand(&game, config, &hand_result);
+    if (ret != MJ_OK) {
+      return ret;
+    }
+    result->hands++;
+    if (hand_result.win) {
+      result->wins++;
+      game.honba = hand_result.renchan ? game.honba + 1 : 0;
+    } else {
+      result->exhaustive_draws++;
+      game.honba++;
+    }
+    if (!hand_result.renchan) {
+      game.dealer = (game.dealer + 1) % MJ_GAME_PLAYERS;
+      game.round++;
+    }
+  }
+
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    result->points[i] = game.players[i].points;
+  }
+  gen_game_ranks(result);
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    if (result->ranks[i] == 0) {  // 供託はトップ取り
+      result->points[i] += (int32_t)(GAME_RIICHI_STICK * game.riichi_sticks);
+    }
+  }
+  return MJ_OK;
+}
+
+/* ツモ後はシャンテン数が減る場合だけ孤立牌から切り, 減らなければツモ切りする. 鳴いた後はシャンテン数を保つ牌を切る */
+static MJTileId select_greedy_discard(Tiles *tiles, const MJGamePlayer *player, MJTileId drawn) {
+  int32_t total_len = (int32_t)count_tiles(tiles);
+  if (drawn <= MJ_DR) {
+    if (player->drawn_shanten >= player->shanten) {
+      return drawn;
+    }
+    return select_sim_discard(tiles, total_len, player->drawn_shanten);
+  }
+  return select_sim_discard(tiles, total_len, calc_shanten_tiles(tiles, total_len, -1));
+}
+
+uint32_t mj_decide_greedy(void *arg, const MJGame *game, uint32_t player, const MJAction *actions, uint32_t len) {
+  (void)arg;
+  uint32_t discard = len;
+  for (uint32_t i = 0; i < len; i++) {
+    MJActionType type = actions[i].type;
+    if (type == MJ_ACTION_TSUMO || type == MJ_ACTION_RON || type == MJ_ACTION_PASS) {
+      return i;  // ロン, ツモの候補はパスより先にある
+    }
+    if (type == MJ_ACTION_DISCARD && discard == len) {
+      discard = i;
+    }
+  }
+  const MJGamePlayer *p = &game->players[player];
+  if (p->riichi || discard == len) {
+    return discard == len ? 0 : discard;
+  }
+  Tiles tiles = p->hand.concealed;
+  MJTileId tile_id = select_greedy_discard(&tiles, p, game->drawn);
+  for (uint32_t i = 0; i < len; i++) {
+    if (actions[i].tile == tile_id && actions[i].type == MJ_ACTION_RIICHI) {
+      return i;
+    }
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    if (actions[i].tile == tile_id && actions[i].type == MJ_ACTION_DISCARD) {
+      return i;
+    }
+  }
+  return discard;  // 食い替えで切れない場合
+}
+
+uint64_t mj_batch_game_seed(uint64_t seed, uint64_t index) { return seed ^ next_splitmix64(&index); }
+
+static void add_game_stats(MJGameStats *stats, const MJGameResult *result) {
+  stats->games++;
+  stats->hands += result->hands;
+  stats->wins += result->wins;
+  stats->exhaustive_draws += result->exhaustive_draws;
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    stats->points[i] += result->points[i];
+    stats->ranks[i][result->ranks[i]]++;
+  }
+}
+
+static void merge_game_stats(MJGameStats *stats, const MJGameStats *shard) {
+  stats->games += shard->games;
+  stats->hands += shard->hands;
+  stats->wins += shard->wins;
+  stats->exhaustive_draws += shard->exhaustive_draws;
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    stats->points[i] += shard->points[i];
+    for (uint32_t j = 0; j < MJ_GAME_PLAYERS; j++) {
+      stats->ranks[i][j] += shard->ranks[i][j];
+    }
+  }
+}
+
+static void play_batch_game(void *arg, uint32_t worker, uint64_t index) {
+  GameBatch *batch = (GameBatch *)arg;
+  GameShard *shard = &batch->shards[worker];
+  MJGameConfig config = *batch->config;
+  config.seed = mj_batch_game_seed(config.seed, index);
+  MJGameResult result;
+  int32_t ret = mj_play_game(&result, &config);
+  if (ret != MJ_OK) {
+    if (index < shard->error_index) {
+      shard->error_index = index;
+      shard->error = ret;
+    }
+    return;
+  }
+  if (batch->results) {
+    batch->results[index] = result;
+  }
+  add_game_stats(&shard->stats, &result);
+}
+
+int32_t mj_play_games(MJGameResult *results, MJGameStats *stats, uint64_t len, const MJGameConfig *config,
+                      uint32_t threads) {
+  GameBatch batch;
+  batch.results = results;
+  batch.config = config;
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    memset(&batch.shards[i].stats, 0, sizeof(MJGameStats));
+    batch.shards[i].error_index = UINT64_MAX;
+    batch.shards[i].error = MJ_OK;
+  }
+  // 1対局は十分重いので1つずつ取り出す
+  int32_t ret = mj_parallel_for(len, threads, 1, play_batch_game, &batch);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+
+  // 集計の足し算は順序によらないので, ワーカーの割り当てが変わっても同じ値になる
+  uint64_t error_index = UINT64_MAX;
+  if (stats) {
+    memset(stats, 0, sizeof(MJGameStats));
+  }
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    if (stats) {
+      merge_game_stats(stats, &batch.shards[i].stats);
+    }
+    if (batch.shards[i].error_index < error_index) {
+      error_index = batch.shards[i].error_index;
+      ret = batch.shards[i].error;
+    }
+  }
+  return ret;
+}
@@ -35,6 +35,9 @@
 #include "meld.h"
 #include "score.h"
 #include "tile.h"
+#include "zobrist.h"
+
+#define ENABLE_DEBUG (0)
 
 static bool remove_melds_from_tiles(Tiles *tiles, const MJMelds *melds) {
   for (uint32_t i = 0; i < melds->len; i++) {
@@ -72,88 +75,264 @@ static bool remove_melds_from_tiles(Tiles *tiles, const MJMelds *melds) {
  * つまり翻を比較して同じなら符を比較して大小を比較できる.
  */
 
+/*
+ * アガリ形の分解は牌のみに依存するので, 分解ごとにすべての ScoreConfig の点数を計算する.
+ */
 typedef struct {
-  MJBaseScore score;
-  ScoreConfig score_config;
+  MJBaseScore *scores;
+  const ScoreConfig *score_configs;
+  uint32_t len;
 } _Score;
 
+static void save_greater_score(MJBaseScore *saved, const MJBaseScore *score) {
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+  if (score->han) {
+    fprintf(stderr, "%s\n", score->yaku_name);
+  }
+#endif
+  if ((score->han > saved->han) || (score->han == saved->han && score->fu > saved->fu)) {
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+    fprintf(stderr, "changed %d:%d:%s --> %d:%d:%s\n", saved->han, saved->fu, saved->yaku_name, score->han, score->fu,
+            score->yaku_name);
+#endif
+    memcpy(saved, score, sizeof(MJBaseScore));
+  }
+}
+
 /* for 国士無双, 七対子 */
 static bool score_tiles(const Tiles *tiles, void *arg) {
   _Score *_score = (_Score *)arg;
-  MJBaseScore score;
-  bool agari = calc_score_with_tiles(&score, tiles, &_score->score_config);
-  // save greater score
-  if (score.han) {
-    fprintf(stderr, "%s\n", score.yaku_name);
-  }
-  if ((score.han > _score->score.han) || (score.han == _score->score.han && score.fu > _score->score.fu)) {
-    fprintf(stderr, "changed %d:%d:%s --> %d:%d:%s\n", _score->score.han, _score->score.fu, _score->score.yaku_name,
-            score.han, score.fu, score.yaku_name);
-    memcpy(&_score->score, &score, sizeof(MJBaseScore));
+  bool agari = false;
+  for (uint32_t i = 0; i < _score->len; i++) {
+    MJBaseScore score;
+    agari = calc_score_with_tiles(&score, tiles, &_score->score_configs[i]);  // agari doesn't depend on config
+    // save greater score
+    save_greater_score(&_score->scores[i], &score);
   }
   return agari;
 }
 
 static bool score_elements(const Elements *concealed, const Elements *melded, MJTileId pair, void *arg) {
   _Score *_score = (_Score *)arg;
-  MJBaseScore score;
-  bool agari = calc_score(&score, concealed, melded, pair, &_score->score_config);
-  if (score.han) {
-    fprintf(stderr, "%s\n", score.yaku_name);
-  }
-  // save greater score
-  if ((score.han > _score->score.han) || (score.han == _score->score.han && score.fu > _score->score.fu)) {
-    fprintf(stderr, "changed %d:%d:%s --> %d:%d:%s\n", _score->score.han, _score->score.fu, _score->score.yaku_name,
-            score.han, score.fu, score.yaku_name);
-    memcpy(&_score->score, &score, sizeof(MJBaseScore));
+  bool agari = false;
+  for (uint32_t i = 0; i < _score->len; i++) {
+    MJBaseScore score;
+    agari = calc_score(&score, concealed, melded, pair, &_score->score_configs[i]);
+    // save greater score
+    save_greater_score(&_score->scores[i], &score);
   }
   return agari;
 }
 
-int32_t mj_get_score(MJBaseScore *score, const MJHands *hands, const MJMelds *melds, MJTileId win_tile, bool ron,
-                     MJTileId player_wind, MJTileId round_wind) {
+int32_t prepare_hand_tiles(MJPreparedHand *prepared, const Tiles *tiles, const MJMelds *melds) {
+  if (!is_valid_melds(melds)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  // make tiles = hands - melds
+  prepared->concealed = *tiles;
+  if (!remove_melds_from_tiles(&prepared->concealed, melds)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  if (!gen_elements_from_melds(&prepared->melded, melds)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  prepared->hash = hash_tiles(&prepared->concealed) ^ hash_elements(&prepared->melded);
+  return MJ_OK;
+}
+
+static int32_t prepare_hand(MJPreparedHand *prepared, const MJHands *hands, const MJMelds *melds) {
+  for (uint32_t i = 0; i < hands->len; i++) {
+    if (!is_tile_id_valid(hands->tile_id[i])) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+  }
+  Tiles tiles;
+  if (!gen_tiles_from_hands(&tiles, hands)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  return prepare_hand_tiles(prepared, &tiles, melds);
+}
+
+int32_t mj_prepare_hand(MJPreparedHand *prepared, const MJHands *hands, const MJMelds *melds) {
   if (hands->len > MJ_MAX_HAND_LEN) {
     return MJ_ERR_NUM_TILES_LARGE;
   }
   if (hands->len < MJ_MIN_HAND_LEN) {
     return MJ_ERR_NUM_TILES_SHORT;
   }
-  if (!is_valid_hands(hands)) {
-    return MJ_ERR_ILLEGAL_PARAM;
+  return prepare_hand(prepared, hands, melds);
+}
+
+int32_t mj_init_hand(MJPreparedHand *hand, const MJHands *hands, const MJMelds *melds) {
+  if (hands->len > MJ_MAX_HAND_LEN) {
+    return MJ_ERR_NUM_TILES_LARGE;
   }
-  if (!is_valid_melds(melds)) {
+  return prepare_hand(hand, hands, melds);
+}
+
+int32_t mj_hand_draw(MJPreparedHand *hand, MJTileId tile_id) {
+  if (!is_tile_id_valid(tile_id) || hand->concealed.tiles[tile_id] >= MJ_MAX_TILES_LEN_IN_ELEMENT) {
     return MJ_ERR_ILLEGAL_PARAM;
   }
-  if (win_tile < MJ_M1 || win_tile > MJ_DR) {
+  hand->hash = add_zobrist_tile(hand->hash, &hand->concealed, tile_id);
+  add_tile(&hand->concealed, tile_id);
+  return MJ_OK;
+}
+
+int32_t mj_hand_discard(MJPreparedHand *hand, MJTileId tile_id) {
+  if (!is_tile_id_valid(tile_id) || hand->concealed.tiles[tile_id] == 0) {
     return MJ_ERR_ILLEGAL_PARAM;
   }
+  hand->hash = remove_zobrist_tile(hand->hash, &hand->concealed, tile_id);
+  remove_tile(&hand->concealed, tile_id);
+  return MJ_OK;
+}
 
-  Tiles tiles;
-  if (!gen_tiles_from_hands(&tiles, hands)) {
-    return MJ_ERR_ILLEGAL_PARAM;
+/* 加槓の対象になるポンの位置. なければ -1 */
+static int32_t find_kakan_triplets(const Elements *melded, const Element *fours) {
+  if (!is_element_fours(fours) || is_element_concealed(fours)) {
+    return -1;
   }
-  // make tiles = hands - melds
-  if (!remove_melds_from_tiles(&tiles, melds)) {
+  for (uint32_t i = 0; i < melded->len; i++) {
+    const Element *elem = &melded->meld[i];
+    if (is_element_triplets(elem) && elem->tile_id[0] == fours->tile_id[0]) {
+      return (int32_t)i;
+    }
+  }
+  return -1;
+}
+
+int32_t mj_hand_call(MJPreparedHand *hand, const MJMeld *meld, MJTileId called_tile) {
+  MJMelds melds = {{*meld}, 1};
+  if (!is_valid_melds(&melds)) {
     return MJ_ERR_ILLEGAL_PARAM;
   }
-  if (tiles.tiles[win_tile] == 0) {  // check if win_tile is in tiles
+  Elements elems;
+  if (!gen_elements_from_melds(&elems, &melds)) {
     return MJ_ERR_ILLEGAL_PARAM;
   }
+  const Element *elem = &elems.meld[0];
 
-  Elements melded_elems;
-  if (!gen_elements_from_melds(&melded_elems, melds)) {
-    return MJ_ERR_ILLEGAL_PARAM;
+  Tiles remove;  // 手牌から除く牌
+  memset(&remove, 0, sizeof(Tiles));
+  int32_t kakan = find_kakan_triplets(&hand->melded, elem);
+  if (kakan >= 0) {
+    add_tile(&remove, elem->tile_id[0]);
+  } else {
+    if (hand->melded.len >= MJ_ELEMENTS_LEN) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    for (uint32_t i = 0; i < elem->len; i++) {
+      add_tile(&remove, elem->tile_id[i]);
+    }
+    if (!is_element_concealed(elem)) {
+      if (!is_tile_id_valid(called_tile) || remove.tiles[called_tile] == 0) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      remove_tile(&remove, called_tile);
+    }
+  }
+  for (uint32_t i = 0; i <= MJ_DR; i++) {
+    if (hand->concealed.tiles[i] < remove.tiles[i]) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
   }
 
-  _Score _score = {
-      {0, 0, ""},
-      {win_tile, ron, player_wind, round_wind},
-  };
+  for (uint32_t i = 0; i <= MJ_DR; i++) {
+    while (remove.tiles[i] > 0) {
+      hand->hash = remove_zobrist_tile(hand->hash, &hand->concealed, (MJTileId)i);
+      remove_tile(&hand->concealed, (MJTileId)i);
+      remove_tile(&remove, (MJTileId)i);
+    }
+  }
+  if (kakan >= 0) {
+    Elements others = hand->melded;  // 加槓するポン以外の副露
+    others.meld[kakan] = others.meld[--others.len];
+    hand->hash = remove_zobrist_element(hand->hash, &hand->melded, &hand->melded.meld[kakan]);
+    hand->hash = add_zobrist_element(hand->hash, &others, elem);
+    hand->melded.meld[kakan] = *elem;
+  } else {
+    hand->hash = add_zobrist_element(hand->hash, &hand->melded, elem);
+    hand->melded.meld[hand->melded.len++] = *elem;
+  }
+  return MJ_OK;
+}
 
-  uint32_t agari = find_agari(&tiles, &melded_elems, score_tiles, score_elements, &_score);
+int32_t mj_hash_tiles(uint64_t *hash, const MJHands *hands, const MJMelds *melds) {
+  MJPreparedHand prepared;
+  int32_t ret = mj_init_hand(&prepared, hands, melds);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  *hash = prepared.hash;
+  return MJ_OK;
+}
+
+int32_t mj_score_prepared_multi(MJBaseScore *scores, const MJPreparedHand *prepared, const MJScoreConfig *configs,
+                                uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    MJTileId win_tile = configs[i].win_tile;
+    if (win_tile < MJ_M1 || win_tile > MJ_DR) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    if (prepared->concealed.tiles[win_tile] == 0) {  // check if win_tile is in tiles
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    memset(&scores[i], 0, sizeof(MJBaseScore));
+  }
+
+  _Score _score = {scores, configs, len};
+  uint32_t agari = find_agari(&prepared->concealed, &prepared->melded, score_tiles, score_elements, &_score);
   if (agari == 0) {
     return MJ_ERR_AGARI_NOT_FOUND;
   }
-  memcpy(score, &_score.score, sizeof(MJBaseScore));
   return MJ_OK;
 }
+
+int32_t mj_score_prepared(MJBaseScore *score, const MJPreparedHand *prepared, MJTileId win_tile, bool ron,
+                          MJTileId player_wind, MJTileId round_wind) {
+  const MJScoreConfig config = {win_tile, ron, player_wind, round_wind};
+  return mj_score_prepared_multi(score, prepared, &config, 1);
+}
+
+int32_t mj_get_scores(MJBaseScore *scores, const MJHands *hands, const MJMelds *melds, const MJScoreConfig *configs,
+                      uint32_t len) {
+  MJPreparedHand prepared;
+  int32_t ret = mj_prepare_hand(&prepared, hands, melds);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  return mj_score_prepared_multi(scores, &prepared, configs, len);
+}
+
+int32_t mj_get_score(MJBaseScore *score, const MJHands *hands, const MJMelds *melds, MJTileId win_tile, bool ron,
+                     MJTileId player_wind, MJTileId round_wind) {
+  MJPreparedHand prepared;
+  int32_t ret = mj_prepare_hand(&prepared, hands, melds);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  return mj_score_prepared(score, &prepared, win_tile, ron, player_wind, round_wind);
+}
+
+typedef struct {
+  MJBaseScore *scores;
+  int32_t *rets;
+  const MJHands *hands;
+  const MJMelds *melds;
+  const MJScoreConfig *configs;
+} ScoreBatch;
+
+static void score_batch_hand(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  ScoreBatch *batch = (ScoreBatch *)arg;
+  const MJScoreConfig *config = &batch->configs[index];
+  batch->rets[index] = mj_get_score(&batch->scores[index], &batch->hands[index], &batch->melds[index],
+                                    config->win_tile, config->ron, config->player_wind, config->round_wind);
+}
+
+int32_t mj_get_scores_batch(MJBaseScore *scores, int32_t *rets, const MJHands *hands, const MJMelds *melds,
+                            const MJScoreConfig *configs, uint64_t len, uint32_t threads) {
+  ScoreBatch batch = {scores, rets, hands, melds, configs};
+  return mj_parallel_for(len, threads, 0, score_batch_hand, &batch);
+}
@@ -0,0 +1,760 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "mjlog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdalign.h>
+#include <unistd.h>
+
+#include "scheduler.h"
+
+#define MJLOG_CHI 0x4
+#define MJLOG_PON 0x8
+#define MJLOG_KAKAN 0x10
+#define MJLOG_NUKIDORA 0x20
+#define MJLOG_NOT_APPLICABLE INT32_MAX  // 副露した手牌の七対子, 国士無双のシャンテン数
+#define MJLOG_YAKUMAN_HAN 13
+
+/* mj_replay_mjlog_files のワーカーごとの集計. 他のワーカーの集計とキャッシュラインを共有しない */
+typedef struct {
+  alignas(SCHED_CACHE_LINE) MJLogStats stats;
+  uint64_t error_index;  // 失敗したファイルの最小の index. 失敗がなければ UINT64_MAX
+  int32_t error;
+} MjlogShard;
+
+typedef struct {
+  const char *const *paths;
+  const MJLogConfig *config;
+  MjlogShard shards[SCHED_MAX_WORKERS];
+} MjlogBatch;
+
+void init_mjlog_reader_fd(MjlogReader *reader, int fd, char *buffer, uint64_t buffer_len) {
+  memset(reader, 0, sizeof(MjlogReader));
+  reader->fd = fd;
+  reader->buffer = buffer;
+  reader->buffer_len = buffer_len;
+  reader->data = buffer;
+}
+
+void init_mjlog_reader_data(MjlogReader *reader, const char *data, uint64_t len) {
+  memset(reader, 0, sizeof(MjlogReader));
+  reader->fd = -1;
+  reader->data = data;
+  reader->len = len;
+  reader->bytes = len;
+  reader->eof = true;
+}
+
+/* 読み終えた部分を捨てて, 残りの後ろに読み足す. false: これ以上読めない */
+static bool fill_mjlog_reader(MjlogReader *reader) {
+  if (reader->eof) {
+    return false;
+  }
+  uint64_t rest = reader->len - reader->pos;
+  if (rest == reader->buffer_len) {  // タグがバッファに収まらない
+    reader->error = MJ_ERR_ILLEGAL_LOG;
+    return false;
+  }
+  memmove(reader->buffer, &reader->buffer[reader->pos], rest);
+  reader->len = rest;
+  reader->pos = 0;
+  ssize_t n;
+  do {
+    n = read(reader->fd, &reader->buffer[reader->len], reader->buffer_len - reader->len);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    reader->eof = true;
+    if (n < 0) {
+      reader->error = MJ_ERR_IO;
+    }
+    return false;
+  }
+  reader->len += (uint64_t)n;
+  reader->bytes += (uint64_t)n;
+  return true;
+}
+
+static bool is_mjlog_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+/* '<' と '>' の間 [p, end) */
+static bool parse_mjlog_tag(MjlogTag *tag, const char *p, const char *end) {
+  if (end > p && end[-1] == '/') {
+    end--;
+  }
+  tag->name = p;
+  while (p < end && !is_mjlog_space(*p)) {
+    p++;
+  }
+  tag->name_len = (uint32_t)(p - tag->name);
+  tag->attrs_len = 0;
+  if (tag->name_len == 0) {
+    return false;
+  }
+  for (;;) {
+    while (p < end && is_mjlog_space(*p)) {
+      p++;
+    }
+    if (p == end) {
+      return true;
+    }
+    if (tag->attrs_len == MJLOG_MAX_ATTRS) {
+      return false;
+    }
+    MjlogAttr *attr = &tag->attrs[tag->attrs_len++];
+    attr->name = p;
+    while (p < end && *p != '=' && !is_mjlog_space(*p)) {
+      p++;
+    }
+    attr->name_len = (uint32_t)(p - attr->name);
+    if (attr->name_len == 0 || end - p < 2 || p[0] != '=' || p[1] != '"') {
+      return false;
+    }
+    p += 2;
+    attr->value = p;
+    const char *quote = memchr(p, '"', (size_t)(end - p));
+    if (quote == NULL) {
+      return false;
+    }
+    attr->value_len = (uint32_t)(quote - p);
+    p = quote + 1;
+  }
+}
+
+bool next_mjlog_tag(MjlogReader *reader, MjlogTag *tag) {
+  for (;;) {
+    const char *begin = memchr(&reader->data[reader->pos], '<', reader->len - reader->pos);
+    if (begin == NULL) {
+      reader->pos = reader->len;
+      if (!fill_mjlog_reader(reader)) {
+        return false;
+      }
+      continue;
+    }
+    reader->pos = (uint64_t)(begin - reader->data);
+    const char *end = memchr(begin, '>', reader->len - reader->pos);
+    if (end == NULL) {
+      if (!fill_mjlog_reader(reader)) {
+        if (reader->error == MJ_OK) {  // 途中で終わったタグ
+          reader->error = MJ_ERR_ILLEGAL_LOG;
+        }
+        return false;
+      }
+      continue;
+    }
+    reader->pos = (uint64_t)(end - reader->data) + 1;
+    if (end - begin >= 2 && (begin[1] == '/' || begin[1] == '?' || begin[1] == '!')) {
+      continue;  // 終了タグ, 宣言, コメント
+    }
+    if (!parse_mjlog_tag(tag, begin + 1, end)) {
+      reader->error = MJ_ERR_ILLEGAL_LOG;
+      return false;
+    }
+    return true;
+  }
+}
+
+static bool is_mjlog_name(const char *name, uint32_t name_len, const char *expected) {
+  return strlen(expected) == name_len && memcmp(name, expected, name_len) == 0;
+}
+
+bool is_mjlog_tag(const MjlogTag *tag, const char *name) { return is_mjlog_name(tag->name, tag->name_len, name); }
+
+const MjlogAttr *find_mjlog_attr(const MjlogTag *tag, const char *name) {
+  for (uint32_t i = 0; i < tag->attrs_len; i++) {
+    if (is_mjlog_name(tag->attrs[i].name, tag->attrs[i].name_len, name)) {
+      return &tag->attrs[i];
+    }
+  }
+  return NULL;
+}
+
+bool parse_mjlog_values(const MjlogTag *tag, const char *name, int32_t *values, uint32_t *len, uint32_t max_len) {
+  *len = 0;
+  const MjlogAttr *attr = find_mjlog_attr(tag, name);
+  if (attr == NULL || attr->value_len == 0) {
+    return true;
+  }
+  const char *p = attr->value;
+  const char *end = &attr->value[attr->value_len];
+  for (;;) {
+    bool negative = p < end && *p == '-';
+    p += negative;
+    if (p == end || *p < '0' || *p > '9' || *len == max_len) {
+      return false;
+    }
+    int64_t value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+      value = value * 10 + (*p - '0');
+      if (value > INT32_MAX) {
+        return false;
+      }
+    }
+    values[(*len)++] = (int32_t)(negative ? -value : value);
+    if (p == end) {
+      return true;
+    }
+    if (*p != ',') {
+      return false;
+    }
+    p++;
+  }
+}
+
+/* 属性の1つ目の数値. なければ false */
+static bool parse_mjlog_value(const MjlogTag *tag, const char *name, int32_t *value) {
+  int32_t values[MJLOG_MAX_VALUES];
+  uint32_t len;
+  if (!parse_mjlog_values(tag, name, values, &len, MJLOG_MAX_VALUES) || len == 0) {
+    return false;
+  }
+  *value = values[0];
+  return true;
+}
+
+bool decode_mjlog_meld(uint32_t m, MJMeld *meld, MJTileId *called) {
+  memset(meld, 0, sizeof(MJMeld));
+  if (m & MJLOG_CHI) {
+    // 順子の最小の牌 (萬子, 筒子, 索子の1-7) * 3 + 鳴いた牌の位置
+    uint32_t t = (m >> 10) & 0x3f;
+    uint32_t called_pos = t % 3;
+    t /= 3;
+    if (t >= (TILE_NUM_LEN - 2) * 3) {
+      return false;
+    }
+    uint32_t base = t / (TILE_NUM_LEN - 2) * TILE_NUM_LEN + t % (TILE_NUM_LEN - 2);
+    meld->len = MJ_MIN_TILES_LEN_IN_ELEMENT;
+    for (uint32_t i = 0; i < meld->len; i++) {
+      meld->tile_id[i] = (MJTileId)(base + i);
+    }
+    *called = (MJTileId)(base + called_pos);
+  } else if (m & (MJLOG_PON | MJLOG_KAKAN)) {
+    // 牌の種類 * 3 + 鳴いた牌の位置
+    uint32_t t = ((m >> 9) & 0x7f) / 3;
+    if (t > MJ_DR) {
+      return false;
+    }
+    meld->len = m & MJLOG_PON ? MJ_MIN_TILES_LEN_IN_ELEMENT : MJ_MAX_TILES_LEN_IN_ELEMENT;
+    for (uint32_t i = 0; i < meld->len; i++) {
+      meld->tile_id[i] = (MJTileId)t;
+    }
+    *called = (MJTileId)t;
+  } else if (m & MJLOG_NUKIDORA) {
+    return false;  // 三人麻雀は扱わない
+  } else {
+    // 暗槓, 大明槓: 牌の番号. 下位2ビットが鳴いた相手 (0: 暗槓)
+    uint32_t t = (m >> 8) & 0xff;
+    if (t >= MJLOG_TILES_LEN) {
+      return false;
+    }
+    meld->len = MJ_MAX_TILES_LEN_IN_ELEMENT;
+    for (uint32_t i = 0; i < meld->len; i++) {
+      meld->tile_id[i] = (MJTileId)(t / MJ_MAX_TILES_LEN_IN_ELEMENT);
+    }
+    meld->concealed = (m & 0x3) == 0;
+    *called = (MJTileId)(t / MJ_MAX_TILES_LEN_IN_ELEMENT);
+  }
+  return true;
+}
+
+void init_mjlog_replay(MjlogReplay *replay, MJLogStats *stats, const MJLogConfig *config, uint64_t file,
+                       uint32_t worker) {
+  memset(replay, 0, sizeof(MjlogReplay));
+  replay->stats = stats;
+  replay->config = config;
+  replay->file = file;
+  replay->worker = worker;
+}
+
+static void init_mjlog_event(const MjlogReplay *replay, MJLogEvent *event, MJLogEventType type, uint32_t player,
+                             MJTileId tile) {
+  event->type = type;
+  event->file = replay->file;
+  event->player = player;
+  event->tile = tile;
+  event->player_wind = (MJTileId)(MJ_WT + (player + MJ_GAME_PLAYERS - replay->oya) % MJ_GAME_PLAYERS);
+  event->round_wind = replay->round_wind;
+  event->hand = &replay->hands[player];
+}
+
+static void emit_mjlog_event(const MjlogReplay *replay, const MJLogEvent *event) {
+  if (replay->config->func) {
+    replay->config->func(replay->config->arg, replay->worker, event);
+  }
+}
+
+static void gen_mjlog_hands(MJHands *hands, const Tiles *tiles) {
+  hands->len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    for (uint32_t j = 0; j < tiles->tiles[i]; j++) {
+      hands->tile_id[hands->len++] = (MJTileId)i;
+    }
+  }
+}
+
+static int32_t get_mjlog_min_shanten(const MJShanten *shanten) {
+  int32_t min = shanten->normal;
+  min = shanten->chiitoitsu < min ? shanten->chiitoitsu : min;
+  return shanten->kokushi < min ? shanten->kokushi : min;
+}
+
+static int32_t calc_mjlog_shanten(const MJHands *hands, MJShanten *shanten) {
+  shanten->chiitoitsu = MJLOG_NOT_APPLICABLE;
+  shanten->kokushi = MJLOG_NOT_APPLICABLE;
+  return mj_calc_shanten(hands, shanten) == MJ_OK ? MJ_OK : MJ_ERR_ILLEGAL_LOG;
+}
+
+/* シャンテン数が最小になる形の受け入れの和 */
+static int32_t calc_mjlog_ukeire(const MJPreparedHand *hand, const MJHands *hands, MJLogEvent *event) {
+  typedef int32_t (*UkeireFunc)(const MJHands *hands, MJTiles *acceptables);
+  const UkeireFunc funcs[] = {mj_ukeire_normal, mj_ukeire_chiitoitsu, mj_ukeire_kokushi};
+  const int32_t shanten[] = {event->shanten.normal, event->shanten.chiitoitsu, event->shanten.kokushi};
+  int32_t min = get_mjlog_min_shanten(&event->shanten);
+  memset(&event->ukeire, 0, sizeof(MJTiles));
+  for (uint32_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++) {
+    if (shanten[i] != min) {
+      continue;
+    }
+    MJTiles acceptables;
+    if (funcs[i](hands, &acceptables) != MJ_OK) {
+      return MJ_ERR_ILLEGAL_LOG;
+    }
+    for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+      event->ukeire.tiles[j] = event->ukeire.tiles[j] || acceptables.tiles[j] ? 1 : 0;
+    }
+  }
+
+  // 自分の手牌と副露にある牌は数えない
+  Tiles visible;
+  memcpy(&visible, &hand->concealed, sizeof(Tiles));
+  for (uint32_t i = 0; i < hand->melded.len; i++) {
+    for (uint32_t j = 0; j < hand->melded.meld[i].len; j++) {
+      visible.tiles[hand->melded.meld[i].tile_id[j]]++;
+    }
+  }
+  event->ukeire_kinds = 0;
+  event->ukeire_tiles = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (event->ukeire.tiles[i]) {
+      event->ukeire_kinds++;
+      event->ukeire_tiles += visible.tiles[i] < MJ_MAX_TILES_LEN_IN_ELEMENT
+                                 ? MJ_MAX_TILES_LEN_IN_ELEMENT - visible.tiles[i]
+                                 : 0;
+    }
+  }
+  return MJ_OK;
+}
+
+/* T, U, V, W (ツモ) や D, E, F, G (打牌) に牌の番号が続くタグ */
+static bool parse_mjlog_tile_tag(const MjlogTag *tag, const char *letters, uint32_t *player, MJTileId *tile) {
+  if (tag->name_len < 2 || tag->name_len > 4) {
+    return false;
+  }
+  const char *letter = memchr(letters, tag->name[0], MJ_GAME_PLAYERS);
+  if (letter == NULL) {
+    return false;
+  }
+  uint32_t t = 0;
+  for (uint32_t i = 1; i < tag->name_len; i++) {
+    if (tag->name[i] < '0' || tag->name[i] > '9') {
+      return false;
+    }
+    t = t * 10 + (uint32_t)(tag->name[i] - '0');
+  }
+  *player = (uint32_t)(letter - letters);
+  *tile = (MJTileId)(t / MJ_MAX_TILES_LEN_IN_ELEMENT);
+  return t < MJLOG_TILES_LEN;
+}
+
+static bool parse_mjlog_player(const MjlogTag *tag, const char *name, uint32_t *player) {
+  int32_t value;
+  if (!parse_mjlog_value(tag, name, &value) || value < 0 || value >= MJ_GAME_PLAYERS) {
+    return false;
+  }
+  *player = (uint32_t)value;
+  return true;
+}
+
+/* 牌の番号の列を枚数にする */
+static bool parse_mjlog_tiles(const MjlogTag *tag, const char *name, Tiles *tiles, uint32_t *len) {
+  int32_t values[MJLOG_MAX_VALUES];
+  if (!parse_mjlog_values(tag, name, values, len, MJ_MAX_HAND_LEN)) {
+    return false;
+  }
+  memset(tiles, 0, sizeof(Tiles));
+  for (uint32_t i = 0; i < *len; i++) {
+    if (values[i] < 0 || values[i] >= MJLOG_TILES_LEN) {
+      return false;
+    }
+    tiles->tiles[values[i] / MJ_MAX_TILES_LEN_IN_ELEMENT]++;
+  }
+  return true;
+}
+
+static int32_t replay_mjlog_init(MjlogReplay *replay, const MjlogTag *tag) {
+  int32_t seed[MJLOG_MAX_VALUES];
+  uint32_t seed_len;
+  if (!parse_mjlog_values(tag, "seed", seed, &seed_len, MJLOG_MAX_VALUES) || seed_len == 0 || seed[0] < 0 ||
+      !parse_mjlog_player(tag, "oya", &replay->oya)) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  replay->round_wind = (MJTileId)(MJ_WT + (uint32_t)seed[0] / MJ_GAME_PLAYERS % MJ_GAME_PLAYERS);
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    char name[] = "hai0";
+    name[3] = (char)('0' + i);
+    Tiles tiles;
+    uint32_t len;
+    if (!parse_mjlog_tiles(tag, name, &tiles, &len)) {
+      return MJ_ERR_ILLEGAL_LOG;
+    }
+    MJHands hands;
+    MJMelds melds = {{}, 0};
+    gen_mjlog_hands(&hands, &tiles);
+    if (mj_init_hand(&replay->hands[i], &hands, &melds) != MJ_OK) {
+      return MJ_ERR_ILLEGAL_LOG;
+    }
+  }
+  replay->active = true;
+  replay->last_discard = MJ_DR + 1;
+  replay->stats->hands++;
+  MJLogEvent event;
+  memset(&event, 0, sizeof(event));
+  init_mjlog_event(replay, &event, MJ_LOG_EVENT_INIT, replay->oya, MJ_DR + 1);
+  emit_mjlog_event(replay, &event);
+  return MJ_OK;
+}
+
+static int32_t replay_mjlog_draw(MjlogReplay *replay, uint32_t player, MJTileId tile) {
+  MJPreparedHand *hand = &replay->hands[player];
+  if (!replay->active || mj_hand_draw(hand, tile) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  MJLogEvent event;
+  memset(&event, 0, sizeof(event));
+  init_mjlog_event(replay, &event, MJ_LOG_EVENT_DRAW, player, tile);
+  MJHands hands;
+  gen_mjlog_hands(&hands, &hand->concealed);
+  if (calc_mjlog_shanten(&hands, &event.shanten) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  int32_t shanten = get_mjlog_min_shanten(&event.shanten) + 1;
+  replay->stats->draws++;
+  replay->stats->shanten[shanten < MJ_LOG_SHANTEN_LEN ? shanten : MJ_LOG_SHANTEN_LEN - 1]++;
+  emit_mjlog_event(replay, &event);
+  return MJ_OK;
+}
+
+static int32_t replay_mjlog_discard(MjlogReplay *replay, uint32_t player, MJTileId tile) {
+  MJPreparedHand *hand = &replay->hands[player];
+  if (!replay->active || mj_hand_discard(hand, tile) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  replay->last_discard = tile;
+  replay->last_discarder = player;
+  MJLogEvent event;
+  init_mjlog_event(replay, &event, MJ_LOG_EVENT_DISCARD, player, tile);
+  event.score = NULL;
+  event.score_ret = MJ_OK;
+  MJHands hands;
+  gen_mjlog_hands(&hands, &hand->concealed);
+  if (calc_mjlog_shanten(&hands, &event.shanten) != MJ_OK || calc_mjlog_ukeire(hand, &hands, &event) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  replay->stats->discards++;
+  replay->stats->ukeire_kinds += event.ukeire_kinds;
+  replay->stats->ukeire_tiles += event.ukeire_tiles;
+  emit_mjlog_event(replay, &event);
+  return MJ_OK;
+}
+
+static int32_t replay_mjlog_call(MjlogReplay *replay, const MjlogTag *tag) {
+  uint32_t player;
+  int32_t m;
+  MJMeld meld;
+  MJTileId called;
+  if (!replay->active || !parse_mjlog_player(tag, "who", &player) || !parse_mjlog_value(tag, "m", &m) || m < 0 ||
+      !decode_mjlog_meld((uint32_t)m, &meld, &called)) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  // チー, ポン, 大明槓は直前の打牌を鳴く
+  bool kakan = ((uint32_t)m & MJLOG_KAKAN) != 0;
+  if (!meld.concealed && !kakan && (called != replay->last_discard || player == replay->last_discarder)) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  if (mj_hand_call(&replay->hands[player], &meld, called) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  replay->stats->calls++;
+  MJLogEvent event;
+  memset(&event, 0, sizeof(event));
+  init_mjlog_event(replay, &event, MJ_LOG_EVENT_CALL, player, called);
+  emit_mjlog_event(replay, &event);
+  return MJ_OK;
+}
+
+/* 天鳳の役の番号のうち, ライブラリが判定する役. 偶然役とドラは判定しない */
+static bool is_mjlog_yaku_scored(int32_t yaku) {
+  switch (yaku) {
+    case 1:   // 立直
+    case 2:   // 一発
+    case 3:   // 槍槓
+    case 4:   // 嶺上開花
+    case 5:   // 海底摸月
+    case 6:   // 河底撈魚
+    case 21:  // 両立直
+    case 36:  // 人和
+    case 37:  // 天和
+    case 38:  // 地和
+    case 52:  // ドラ
+    case 53:  // 裏ドラ
+    case 54:  // 赤ドラ
+      return false;
+    default:
+      return true;
+  }
+}
+
+/* 牌譜の役のうち, ライブラリが判定する役の翻数. 比べられなければ false */
+static bool get_mjlog_expected_han(const MjlogTag *tag, uint32_t *han, bool *yakuman) {
+  int32_t values[MJLOG_MAX_VALUES];
+  uint32_t len;
+  if (!parse_mjlog_values(tag, "yakuman", values, &len, MJLOG_MAX_VALUES)) {
+    return false;
+  }
+  *han = 0;
+  *yakuman = len > 0;
+  if (*yakuman) {
+    for (uint32_t i = 0; i < len; i++) {
+      *han += is_mjlog_yaku_scored(values[i]) ? MJLOG_YAKUMAN_HAN : 0;
+    }
+    return *han > 0;  // 天和, 地和だけなら比べない
+  }
+  // 役の番号と翻数の組
+  if (!parse_mjlog_values(tag, "yaku", values, &len, MJLOG_MAX_VALUES) || len % 2 != 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < len; i += 2) {
+    *han += is_mjlog_yaku_scored(values[i]) ? (uint32_t)values[i + 1] : 0;
+  }
+  return true;
+}
+
+static int32_t replay_mjlog_win(MjlogReplay *replay, const MjlogTag *tag) {
+  uint32_t player;
+  uint32_t from;
+  int32_t machi;
+  if (!replay->active || !parse_mjlog_player(tag, "who", &player) || !parse_mjlog_player(tag, "fromWho", &from) ||
+      !parse_mjlog_value(tag, "machi", &machi) || machi < 0 || machi >= MJLOG_TILES_LEN) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  MJTileId tile = (MJTileId)(machi / MJ_MAX_TILES_LEN_IN_ELEMENT);
+  bool ron = player != from;
+  // ダブロンがあるので手牌は変えない
+  MJPreparedHand hand = replay->hands[player];
+  if (ron && mj_hand_draw(&hand, tile) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  Tiles hai;
+  uint32_t hai_len;
+  if (!parse_mjlog_tiles(tag, "hai", &hai, &hai_len)) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  if (memcmp(hai.tiles, hand.concealed.tiles, MJ_DR + 1) != 0) {
+    replay->stats->hand_mismatches++;
+  }
+
+  MJLogEvent event;
+  memset(&event, 0, sizeof(event));
+  init_mjlog_event(replay, &event, MJ_LOG_EVENT_WIN, player, tile);
+  event.hand = &hand;
+  MJBaseScore score;
+  event.score = &score;
+  event.score_ret = mj_score_prepared(&score, &hand, tile, ron, event.player_wind, event.round_wind);
+  replay->stats->wins++;
+  if (event.score_ret == MJ_OK) {
+    replay->stats->scored++;
+    uint32_t han;
+    bool yakuman;
+    int32_t ten[MJLOG_MAX_VALUES];
+    uint32_t ten_len;
+    if (get_mjlog_expected_han(tag, &han, &yakuman)) {
+      if (score.han != han) {
+        replay->stats->han_mismatches++;
+      } else if (!yakuman && han > 0 && parse_mjlog_values(tag, "ten", ten, &ten_len, MJLOG_MAX_VALUES) &&
+                 ten_len > 0 && score.fu != (uint32_t)ten[0]) {
+        replay->stats->fu_mismatches++;
+      }
+    }
+  } else {
+    replay->stats->score_errors++;
+  }
+  emit_mjlog_event(replay, &event);
+  return MJ_OK;
+}
+
+static int32_t replay_mjlog_ryuukyoku(MjlogReplay *replay, const MjlogTag *tag) {
+  if (!replay->active) {
+    return MJ_ERR_ILLEGAL_LOG;
+  }
+  if (find_mjlog_attr(tag, "type")) {
+    replay->stats->abortive_draws++;
+  } else {
+    replay->stats->exhaustive_draws++;
+  }
+  MJLogEvent event;
+  memset(&event, 0, sizeof(event));
+  init_mjlog_event(replay, &event, MJ_LOG_EVENT_RYUUKYOKU, replay->oya, MJ_DR + 1);
+  emit_mjlog_event(replay, &event);
+  return MJ_OK;
+}
+
+int32_t replay_mjlog_tag(MjlogReplay *replay, const MjlogTag *tag) {
+  uint32_t player;
+  MJTileId tile;
+  if (parse_mjlog_tile_tag(tag, "TUVW", &player, &tile)) {
+    return replay_mjlog_draw(replay, player, tile);
+  }
+  if (parse_mjlog_tile_tag(tag, "DEFG", &player, &tile)) {
+    return replay_mjlog_discard(replay, player, tile);
+  }
+  if (is_mjlog_tag(tag, "N")) {
+    return replay_mjlog_call(replay, tag);
+  }
+  if (is_mjlog_tag(tag, "REACH")) {
+    int32_t step;
+    if (parse_mjlog_value(tag, "step", &step) && step == 1) {
+      replay->stats->riichi++;
+    }
+    return MJ_OK;
+  }
+  if (is_mjlog_tag(tag, "INIT")) {
+    return replay_mjlog_init(replay, tag);
+  }
+  if (is_mjlog_tag(tag, "AGARI")) {
+    return replay_mjlog_win(replay, tag);
+  }
+  if (is_mjlog_tag(tag, "RYUUKYOKU")) {
+    return replay_mjlog_ryuukyoku(replay, tag);
+  }
+  if (is_mjlog_tag(tag, "TAIKYOKU")) {
+    replay->stats->games++;
+  }
+  return MJ_OK;  // SHUFFLE, GO, UN, DORA, BYE など
+}
+
+int32_t replay_mjlog(MjlogReplay *replay, MjlogReader *reader) {
+  MjlogTag tag;
+  int32_t ret = MJ_OK;
+  while (ret == MJ_OK && next_mjlog_tag(reader, &tag)) {
+    ret = replay_mjlog_tag(replay, &tag);
+  }
+  replay->stats->bytes += reader->bytes;
+  return ret != MJ_OK ? ret : reader->error;
+}
+
+int32_t mj_replay_mjlog(MJLogStats *stats, const char *data, uint64_t len, const MJLogConfig *config) {
+  memset(stats, 0, sizeof(MJLogStats));
+  MjlogReader reader;
+  init_mjlog_reader_data(&reader, data, len);
+  MjlogReplay replay;
+  init_mjlog_replay(&replay, stats, config, 0, 0);
+  stats->files = 1;
+  return replay_mjlog(&replay, &reader);
+}
+
+static void replay_mjlog_file(void *arg, uint32_t worker, uint64_t index) {
+  MjlogBatch *batch = (MjlogBatch *)arg;
+  MjlogShard *shard = &batch->shards[worker];
+  int32_t ret = MJ_ERR_IO;
+  int fd = open(batch->paths[index], O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);  // 先読みを増やす
+#endif
+    char buffer[MJ_LOG_BUFFER_LEN];
+    MjlogReader reader;
+    init_mjlog_reader_fd(&reader, fd, buffer, sizeof(buffer));
+    MjlogReplay replay;
+    init_mjlog_replay(&replay, &shard->stats, batch->config, index, worker);
+    ret = replay_mjlog(&replay, &reader);
+    close(fd);
+  }
+  shard->stats.files++;
+  if (ret != MJ_OK && index < shard->error_index) {
+    shard->error_index = index;
+    shard->error = ret;
+  }
+}
+
+static void merge_mjlog_stats(MJLogStats *stats, const MJLogStats *shard) {
+  stats->files += shard->files;
+  stats->bytes += shard->bytes;
+  stats->games += shard->games;
+  stats->hands += shard->hands;
+  stats->draws += shard->draws;
+  stats->discards += shard->discards;
+  stats->calls += shard->calls;
+  stats->riichi += shard->riichi;
+  stats->wins += shard->wins;
+  stats->exhaustive_draws += shard->exhaustive_draws;
+  stats->abortive_draws += shard->abortive_draws;
+  for (uint32_t i = 0; i < MJ_LOG_SHANTEN_LEN; i++) {
+    stats->shanten[i] += shard->shanten[i];
+  }
+  stats->ukeire_kinds += shard->ukeire_kinds;
+  stats->ukeire_tiles += shard->ukeire_tiles;
+  stats->scored += shard->scored;
+  stats->score_errors += shard->score_errors;
+  stats->hand_mismatches += shard->hand_mismatches;
+  stats->han_mismatches += shard->han_mismatches;
+  stats->fu_mismatches += shard->fu_mismatches;
+}
+
+int32_t mj_replay_mjlog_files(MJLogStats *stats, const char *const *paths, uint64_t len, const MJLogConfig *config) {
+  MjlogBatch batch;
+  batch.paths = paths;
+  batch.config = config;
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    memset(&batch.shards[i].stats, 0, sizeof(MJLogStats));
+    batch.shards[i].error_index = UINT64_MAX;
+    batch.shards[i].error = MJ_OK;
+  }
+  // 1ファイルは十分重いので1つずつ取り出す
+  int32_t ret = mj_parallel_for(len, config->threads, 1, replay_mjlog_file, &batch);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+
+  memset(stats, 0, sizeof(MJLogStats));
+  uint64_t error_index = UINT64_MAX;
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    merge_mjlog_stats(stats, &batch.shards[i].stats);
+    if (batch.shards[i].error_index < error_index) {
+      error_index = batch.shards[i].error_index;
+      ret = batch.shards[i].error;
+    }
+  }
+  return ret;
+}
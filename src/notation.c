@@ -0,0 +1,223 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "notation.h"
+
+bool parse_notation_tile(MJTileId *tile_id, char number, char suit) {
+  if (number < '1' || number > '9') {
+    return false;
+  }
+  uint32_t rank = (uint32_t)(number - '1');
+  switch (suit) {
+    case 'm':
+      *tile_id = (MJTileId)(MJ_M1 + rank);
+      return true;
+    case 'p':
+      *tile_id = (MJTileId)(MJ_P1 + rank);
+      return true;
+    case 's':
+      *tile_id = (MJTileId)(MJ_S1 + rank);
+      return true;
+    case 'z':
+      *tile_id = (MJTileId)(MJ_WT + rank);
+      return *tile_id <= MJ_DR;
+    default:
+      return false;
+  }
+}
+
+static int32_t add_notation_tile(MJNotation *notation, uint32_t *len, MJTileId tile_id) {
+  if (notation->tiles.tiles[tile_id] >= MJ_MAX_TILES_LEN_IN_ELEMENT) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  if (*len >= MJ_MAX_HAND_LEN) {
+    return MJ_ERR_NUM_TILES_LARGE;
+  }
+  notation->tiles.tiles[tile_id]++;
+  (*len)++;
+  return MJ_OK;
+}
+
+/* 順子 (数牌の連続する3枚), 刻子, 槓子. 暗槓は槓子のみ */
+static bool is_notation_meld_valid(const MJMeld *meld) {
+  bool same = true;
+  MJTileId min = meld->tile_id[0];
+  MJTileId max = meld->tile_id[0];
+  for (uint32_t i = 1; i < meld->len; i++) {
+    same = same && meld->tile_id[i] == meld->tile_id[0];
+    min = meld->tile_id[i] < min ? meld->tile_id[i] : min;
+    max = meld->tile_id[i] > max ? meld->tile_id[i] : max;
+  }
+  if (same) {
+    return !meld->concealed || meld->len == MJ_MAX_TILES_LEN_IN_ELEMENT;
+  }
+  // 3枚が異なり, 最小と最大の差が2なら連続している
+  return meld->len == MJ_MIN_TILES_LEN_IN_ELEMENT && !meld->concealed && max < MJ_WT && max - min == 2 &&
+         meld->tile_id[0] != meld->tile_id[1] && meld->tile_id[1] != meld->tile_id[2] &&
+         meld->tile_id[0] != meld->tile_id[2];
+}
+
+int32_t mj_parse_notation(MJNotation *notation, const char *str, uint64_t len) {
+  memset(notation, 0, sizeof(MJNotation));
+  uint32_t tiles_len = 0;
+  uint64_t i = 0;
+  while (i < len) {
+    char c = str[i];
+    if (c == '+') {
+      // アガリ牌は最後の1枚
+      if (i + 3 != len || !parse_notation_tile(&notation->win_tile, str[i + 1], str[i + 2])) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      notation->has_win_tile = true;
+      return add_notation_tile(notation, &tiles_len, notation->win_tile);
+    }
+
+    bool meld = c == '(' || c == '[';
+    uint64_t first = meld ? i + 1 : i;
+    uint64_t last = first;  // 数字の後の牌の種類の位置
+    while (last < len && str[last] >= '0' && str[last] <= '9') {
+      last++;
+    }
+    if (last == first || last >= len) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    i = last + 1;
+
+    MJMeld *m = NULL;
+    if (meld) {
+      if (notation->melds.len >= MJ_ELEMENTS_LEN || last - first < MJ_MIN_TILES_LEN_IN_ELEMENT ||
+          last - first > MJ_MAX_TILES_LEN_IN_ELEMENT || i >= len || str[i] != (c == '(' ? ')' : ']')) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      i++;
+      m = &notation->melds.meld[notation->melds.len++];
+      m->len = (uint32_t)(last - first);
+      m->concealed = c == '[';
+    }
+    for (uint64_t j = first; j < last; j++) {
+      MJTileId tile_id;
+      if (!parse_notation_tile(&tile_id, str[j], str[last])) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      int32_t ret = add_notation_tile(notation, &tiles_len, tile_id);
+      if (ret != MJ_OK) {
+        return ret;
+      }
+      if (m) {
+        m->tile_id[j - first] = tile_id;
+      }
+    }
+    if (m && !is_notation_meld_valid(m)) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+  }
+  return MJ_OK;
+}
+
+static uint32_t format_notation_meld(char *buf, const MJMeld *meld) {
+  uint32_t pos = 0;
+  buf[pos++] = meld->concealed ? '[' : '(';
+  for (uint32_t i = 0; i < meld->len; i++) {
+    buf[pos++] = get_notation_number(meld->tile_id[i]);
+  }
+  buf[pos++] = NOTATION_SUITS[get_notation_suit(meld->tile_id[0])];
+  buf[pos++] = meld->concealed ? ']' : ')';
+  return pos;
+}
+
+int32_t mj_format_notation(char *buf, uint64_t buf_len, uint64_t *written, const MJNotation *notation) {
+  // 副露とアガリ牌を除いた門前の牌
+  Tiles concealed = notation->tiles;
+  if (notation->melds.len > MJ_ELEMENTS_LEN) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  for (uint32_t i = 0; i < notation->melds.len; i++) {
+    const MJMeld *meld = &notation->melds.meld[i];
+    if (meld->len < MJ_MIN_TILES_LEN_IN_ELEMENT || meld->len > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    for (uint32_t j = 0; j < meld->len; j++) {
+      if (!is_tile_id_valid(meld->tile_id[j]) || concealed.tiles[meld->tile_id[j]] == 0 ||
+          get_notation_suit(meld->tile_id[j]) != get_notation_suit(meld->tile_id[0])) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      remove_tile(&concealed, meld->tile_id[j]);
+    }
+  }
+  if (notation->has_win_tile) {
+    if (!is_tile_id_valid(notation->win_tile) || concealed.tiles[notation->win_tile] == 0) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    remove_tile(&concealed, notation->win_tile);
+  }
+  if (count_tiles(&concealed) > MJ_MAX_HAND_LEN) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+
+  char out[MJ_NOTATION_MAX_LEN];
+  uint32_t pos = 0;
+  for (uint32_t suit = 0; suit <= NOTATION_HONORS_SUIT; suit++) {
+    uint32_t first = suit * TILE_NUM_LEN;
+    uint32_t last = suit == NOTATION_HONORS_SUIT ? MJ_DR : first + TILE_NUM_LEN - 1;
+    uint32_t start = pos;
+    for (uint32_t i = first; i <= last; i++) {
+      for (uint32_t j = 0; j < concealed.tiles[i]; j++) {
+        out[pos++] = get_notation_number((MJTileId)i);
+      }
+    }
+    if (pos > start) {
+      out[pos++] = NOTATION_SUITS[suit];
+    }
+  }
+  for (uint32_t i = 0; i < notation->melds.len; i++) {
+    pos += format_notation_meld(&out[pos], &notation->melds.meld[i]);
+  }
+  if (notation->has_win_tile) {
+    out[pos++] = '+';
+    out[pos++] = get_notation_number(notation->win_tile);
+    out[pos++] = NOTATION_SUITS[get_notation_suit(notation->win_tile)];
+  }
+  if (pos + 1 > buf_len) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  memcpy(buf, out, pos);
+  buf[pos] = '\0';
+  if (written) {
+    *written = pos;
+  }
+  return MJ_OK;
+}
+
+int32_t mj_notation_to_hands(MJHands *hands, const MJNotation *notation) {
+  hands->len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    for (uint32_t j = 0; j < notation->tiles.tiles[i]; j++) {
+      if (hands->len >= MJ_MAX_HAND_LEN) {
+        return MJ_ERR_NUM_TILES_LARGE;
+      }
+      hands->tile_id[hands->len++] = (MJTileId)i;
+    }
+  }
+  return MJ_OK;
+}
@@ -0,0 +1,299 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "query.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tile.h"
+
+#define QUERY_NO_SHANTEN 99  // 副露した手牌の七対子, 国士無双
+
+static void append_output(QueryOutput *output, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(&output->buf[output->len], sizeof(output->buf) - output->len, format, args);
+  va_end(args);
+  if (n > 0) {
+    output->len += (uint32_t)n;
+    output->len = output->len < sizeof(output->buf) ? output->len : (uint32_t)sizeof(output->buf) - 1;
+  }
+}
+
+static const char *skip_json_space(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+const char *parse_json_value(JsonValue *value, const char *p, const char *end) {
+  if (p >= end) {
+    return NULL;
+  }
+  if (*p == '"') {
+    const char *first = ++p;
+    while (p < end && *p != '"') {
+      p += *p == '\\' ? 2 : 1;
+    }
+    if (p >= end) {
+      return NULL;
+    }
+    *value = (JsonValue){first, (uint32_t)(p - first), true};
+    return p + 1;
+  }
+  const char *first = p;
+  uint32_t depth = 0;
+  while (p < end) {
+    if (*p == '"') {
+      JsonValue str;
+      p = parse_json_value(&str, p, end);
+      if (!p) {
+        return NULL;
+      }
+      continue;
+    }
+    if (*p == '[' || *p == '{') {
+      depth++;
+    } else if (*p == ']' || *p == '}') {
+      if (depth == 0) {
+        break;
+      }
+      depth--;
+    } else if (depth == 0 && (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r')) {
+      break;
+    }
+    p++;
+  }
+  if (p == first || depth != 0) {
+    return NULL;
+  }
+  *value = (JsonValue){first, (uint32_t)(p - first), false};
+  return p;
+}
+
+static bool is_json_value(const JsonValue *value, const char *str) {
+  return value->len == strlen(str) && memcmp(value->str, str, value->len) == 0;
+}
+
+const char *parse_query(Query *query, const char *line, uint32_t len) {
+  memset(query, 0, sizeof(Query));
+  const char *end = line + len;
+  const char *p = skip_json_space(line, end);
+  if (p >= end || *p++ != '{') {
+    return "invalid json";
+  }
+  p = skip_json_space(p, end);
+  while (p < end && *p != '}') {
+    JsonValue key, value;
+    p = parse_json_value(&key, p, end);
+    if (!p || !key.string) {
+      return "invalid json";
+    }
+    p = skip_json_space(p, end);
+    if (p >= end || *p++ != ':') {
+      return "invalid json";
+    }
+    p = parse_json_value(&value, skip_json_space(p, end), end);
+    if (!p) {
+      return "invalid json";
+    }
+    if (is_json_value(&key, "id")) {
+      query->id = value;
+    } else if (is_json_value(&key, "hand")) {
+      query->hand = value;
+    } else if (is_json_value(&key, "win_tile")) {
+      query->win_tile = value;
+    } else if (is_json_value(&key, "player_wind")) {
+      query->player_wind = value;
+    } else if (is_json_value(&key, "round_wind")) {
+      query->round_wind = value;
+    } else if (is_json_value(&key, "ron")) {
+      query->ron = !value.string && is_json_value(&value, "true");
+    } else if (is_json_value(&key, "kind")) {
+      if (is_json_value(&value, "score")) {
+        query->kind = QUERY_SCORE;
+      } else if (is_json_value(&value, "shanten")) {
+        query->kind = QUERY_SHANTEN;
+      } else if (is_json_value(&value, "ukeire")) {
+        query->kind = QUERY_UKEIRE;
+      } else {
+        return "unknown kind";
+      }
+    }
+    p = skip_json_space(p, end);
+    if (p < end && *p == ',') {
+      p = skip_json_space(p + 1, end);
+    }
+  }
+  if (p >= end) {
+    return "invalid json";
+  }
+  if (!query->hand.string) {
+    return "hand is required";
+  }
+  return NULL;
+}
+
+/* "5p" のような1枚の牌. value がなければ default_tile */
+static bool parse_query_tile(MJTileId *tile_id, const JsonValue *value, MJTileId default_tile) {
+  if (!value->str) {
+    *tile_id = default_tile;
+    return true;
+  }
+  MJNotation notation;
+  if (!value->string || mj_parse_notation(&notation, value->str, value->len) != MJ_OK || notation.melds.len != 0) {
+    return false;
+  }
+  MJHands hands;
+  if (mj_notation_to_hands(&hands, &notation) != MJ_OK || hands.len != 1) {
+    return false;
+  }
+  *tile_id = hands.tile_id[0];
+  return true;
+}
+
+static void score_query(QueryOutput *output, const Query *query, const MJNotation *notation) {
+  MJTileId win_tile = notation->win_tile;
+  MJTileId player_wind, round_wind;
+  if ((!notation->has_win_tile && (!query->win_tile.str || !parse_query_tile(&win_tile, &query->win_tile, MJ_WT))) ||
+      !parse_query_tile(&player_wind, &query->player_wind, MJ_WT) ||
+      !parse_query_tile(&round_wind, &query->round_wind, MJ_WT) || !is_tile_id_wind(player_wind) ||
+      !is_tile_id_wind(round_wind)) {
+    append_output(output, "\"ret\": %d, \"error\": \"invalid tile\"", MJ_ERR_ILLEGAL_PARAM);
+    return;
+  }
+  MJHands hands;
+  MJBaseScore score;
+  int32_t ret = mj_notation_to_hands(&hands, notation);
+  if (ret == MJ_OK) {
+    ret = mj_get_score(&score, &hands, &notation->melds, win_tile, query->ron, player_wind, round_wind);
+  }
+  append_output(output, "\"ret\": %d", ret);
+  if (ret != MJ_OK) {
+    return;
+  }
+  append_output(output, ", \"han\": %u, \"fu\": %u, \"yaku\": [", score.han, score.fu);
+  // yaku_name は空白区切り
+  const char *p = score.yaku_name;
+  bool first = true;
+  while (*p) {
+    const char *next = strchr(p, ' ');
+    uint32_t len = next ? (uint32_t)(next - p) : (uint32_t)strlen(p);
+    if (len > 0) {
+      append_output(output, "%s\"%.*s\"", first ? "" : ", ", (int)len, p);
+      first = false;
+    }
+    p += len + (next ? 1 : 0);
+  }
+  append_output(output, "]");
+}
+
+static int32_t get_query_min_shanten(const MJShanten *shanten) {
+  int32_t min = shanten->normal;
+  min = shanten->chiitoitsu < min ? shanten->chiitoitsu : min;
+  return shanten->kokushi < min ? shanten->kokushi : min;
+}
+
+/* 副露を除いた手牌のシャンテン数と, シャンテン数が最小になる形の受け入れ */
+static void calc_query_shanten(QueryOutput *output, const Query *query, const MJNotation *notation) {
+  MJNotation concealed = *notation;
+  concealed.melds.len = 0;
+  concealed.has_win_tile = false;
+  for (uint32_t i = 0; i < notation->melds.len; i++) {
+    for (uint32_t j = 0; j < notation->melds.meld[i].len; j++) {
+      concealed.tiles.tiles[notation->melds.meld[i].tile_id[j]]--;
+    }
+  }
+  MJHands hands;
+  MJShanten shanten = {QUERY_NO_SHANTEN, QUERY_NO_SHANTEN, QUERY_NO_SHANTEN};
+  int32_t ret = mj_notation_to_hands(&hands, &concealed);
+  if (ret == MJ_OK) {
+    ret = mj_calc_shanten(&hands, &shanten);
+  }
+  append_output(output, "\"ret\": %d", ret);
+  if (ret != MJ_OK) {
+    return;
+  }
+  int32_t min = get_query_min_shanten(&shanten);
+  append_output(output, ", \"shanten\": %d", min);
+  if (query->kind == QUERY_SHANTEN) {
+    append_output(output, ", \"normal\": %d", shanten.normal);
+    if (shanten.chiitoitsu != QUERY_NO_SHANTEN) {
+      append_output(output, ", \"chiitoitsu\": %d, \"kokushi\": %d", shanten.chiitoitsu, shanten.kokushi);
+    }
+    return;
+  }
+
+  typedef int32_t (*UkeireFunc)(const MJHands *hands, MJTiles *acceptables);
+  const UkeireFunc funcs[] = {mj_ukeire_normal, mj_ukeire_chiitoitsu, mj_ukeire_kokushi};
+  const int32_t form_shanten[] = {shanten.normal, shanten.chiitoitsu, shanten.kokushi};
+  MJNotation ukeire;
+  memset(&ukeire, 0, sizeof(ukeire));
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++) {
+    MJTiles acceptables;
+    if (form_shanten[i] != min || funcs[i](&hands, &acceptables) != MJ_OK) {
+      continue;
+    }
+    for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+      if (acceptables.tiles[j] && !ukeire.tiles.tiles[j]) {
+        ukeire.tiles.tiles[j] = 1;
+        count += MJ_MAX_TILES_LEN_IN_ELEMENT - notation->tiles.tiles[j];  // 自分の手牌と副露にある牌は数えない
+      }
+    }
+  }
+  char tiles[MJ_NOTATION_MAX_LEN];
+  if (mj_format_notation(tiles, sizeof(tiles), NULL, &ukeire) != MJ_OK) {
+    tiles[0] = '\0';
+  }
+  append_output(output, ", \"tiles\": \"%s\", \"count\": %u", tiles, count);
+}
+
+void process_query(QueryOutput *output, const char *line, uint32_t len) {
+  output->len = 0;
+  Query query;
+  const char *error = len >= QUERY_LINE_LEN ? "line too long" : parse_query(&query, line, len);
+  append_output(output, "{");
+  if (!error && query.id.str) {
+    append_output(output, query.id.string ? "\"id\": \"%.*s\", " : "\"id\": %.*s, ", (int)query.id.len, query.id.str);
+  }
+  MJNotation notation;
+  int32_t ret = error ? MJ_ERR_ILLEGAL_PARAM : mj_parse_notation(&notation, query.hand.str, query.hand.len);
+  if (!error && ret != MJ_OK) {
+    error = "invalid hand";
+  }
+  if (error) {
+    append_output(output, "\"ret\": %d, \"error\": \"%s\"}\n", ret, error);
+    return;
+  }
+  if (query.kind == QUERY_SCORE) {
+    score_query(output, &query, &notation);
+  } else {
+    calc_query_shanten(output, &query, &notation);
+  }
+  append_output(output, "}\n");
+}
@@ -0,0 +1,421 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "record.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "enumerate.h"
+#include "hand.h"
+#include "scheduler.h"
+
+_Static_assert(sizeof(MJHandRecord) == 24, "MJHandRecord must be 24 bytes");
+_Static_assert(sizeof(MJScoreRecord) == 16, "MJScoreRecord must be 16 bytes");
+_Static_assert(sizeof(MJShantenRecord) == 8, "MJShantenRecord must be 8 bytes");
+_Static_assert(sizeof(MJRecordHeader) == 24, "MJRecordHeader must be 24 bytes");
+_Static_assert((MJ_DR + 1) * RECORD_COUNT_BITS <= MJ_RECORD_COUNTS_LEN * 8, "MJ_RECORD_COUNTS_LEN is too short");
+
+bool encode_record_counts(uint8_t *counts, const Tiles *tiles) {
+  memset(counts, 0, MJ_RECORD_COUNTS_LEN);
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (tiles->tiles[i] > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      return false;
+    }
+    uint32_t bit = i * RECORD_COUNT_BITS;
+    uint32_t value = (uint32_t)tiles->tiles[i] << (bit % 8);
+    counts[bit / 8] |= (uint8_t)value;
+    if (value >> 8) {  // 次の byte にまたがる
+      counts[bit / 8 + 1] |= (uint8_t)(value >> 8);
+    }
+  }
+  return true;
+}
+
+void decode_record_counts(Tiles *tiles, const uint8_t *counts) {
+  memset(tiles, 0, sizeof(Tiles));
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    uint32_t bit = i * RECORD_COUNT_BITS;
+    uint32_t value = counts[bit / 8];
+    if (bit % 8 > 8 - RECORD_COUNT_BITS) {
+      value |= (uint32_t)counts[bit / 8 + 1] << 8;
+    }
+    tiles->tiles[i] = (uint8_t)((value >> (bit % 8)) & ((1u << RECORD_COUNT_BITS) - 1));
+  }
+}
+
+bool encode_record_meld(uint8_t *code, const MJMeld *meld) {
+  if (meld->len < MJ_MIN_TILES_LEN_IN_ELEMENT || meld->len > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+    return false;
+  }
+  Tiles tiles;
+  memset(&tiles, 0, sizeof(Tiles));
+  MJTileId min = MJ_DR;
+  for (uint32_t i = 0; i < meld->len; i++) {
+    if (!is_tile_id_valid(meld->tile_id[i])) {
+      return false;
+    }
+    add_tile(&tiles, meld->tile_id[i]);
+    min = meld->tile_id[i] < min ? meld->tile_id[i] : min;
+  }
+  RecordMeldType type;
+  if (meld->len == MJ_MAX_TILES_LEN_IN_ELEMENT) {
+    type = meld->concealed ? RECORD_MELD_ANKAN : RECORD_MELD_MINKAN;
+  } else {
+    type = tiles.tiles[min] == meld->len ? RECORD_MELD_PON : RECORD_MELD_CHI;
+  }
+  *code = (uint8_t)((uint32_t)type << RECORD_MELD_TYPE_SHIFT | (uint32_t)min);
+
+  // 戻した面子と牌が一致しなければ, 順子でも刻子でもない
+  MJMeld decoded;
+  if (!decode_record_meld(&decoded, *code)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < decoded.len; i++) {
+    if (tiles.tiles[decoded.tile_id[i]] == 0) {
+      return false;
+    }
+    remove_tile(&tiles, decoded.tile_id[i]);
+  }
+  return true;
+}
+
+bool decode_record_meld(MJMeld *meld, uint8_t code) {
+  memset(meld, 0, sizeof(MJMeld));
+  MJTileId tile_id = (MJTileId)(code & RECORD_TILE_MASK);
+  RecordMeldType type = (RecordMeldType)(code >> RECORD_MELD_TYPE_SHIFT);
+  if (!is_tile_id_valid(tile_id)) {
+    return false;
+  }
+  if (type == RECORD_MELD_CHI) {
+    if (tile_id > MJ_S9 || tile_id % TILE_NUM_LEN > TILE_NUM_LEN - MJ_MIN_TILES_LEN_IN_ELEMENT) {
+      return false;
+    }
+    meld->len = MJ_MIN_TILES_LEN_IN_ELEMENT;
+    for (uint32_t i = 0; i < meld->len; i++) {
+      meld->tile_id[i] = (MJTileId)(tile_id + i);
+    }
+    return true;
+  }
+  meld->len = type == RECORD_MELD_PON ? MJ_MIN_TILES_LEN_IN_ELEMENT : MJ_MAX_TILES_LEN_IN_ELEMENT;
+  for (uint32_t i = 0; i < meld->len; i++) {
+    meld->tile_id[i] = tile_id;
+  }
+  meld->concealed = type == RECORD_MELD_ANKAN;
+  return true;
+}
+
+static bool is_record_wind_valid(MJTileId wind) { return wind >= MJ_WT && wind <= MJ_WP; }
+
+int32_t mj_encode_hand_record(MJHandRecord *record, const MJHands *hands, const MJMelds *melds,
+                              const MJScoreConfig *config) {
+  memset(record, 0, sizeof(MJHandRecord));
+  if (hands->len > MJ_MAX_HAND_LEN || melds->len > MJ_ELEMENTS_LEN) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  for (uint32_t i = 0; i < hands->len; i++) {
+    if (!is_tile_id_valid(hands->tile_id[i])) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+  }
+  Tiles tiles;
+  if (!gen_tiles_from_hands(&tiles, hands) || !encode_record_counts(record->counts, &tiles)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  for (uint32_t i = 0; i < melds->len; i++) {
+    if (!encode_record_meld(&record->melds[i], &melds->meld[i])) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+  }
+  if (!is_tile_id_valid(config->win_tile) || !is_record_wind_valid(config->player_wind) ||
+      !is_record_wind_valid(config->round_wind)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  record->meld_len = (uint8_t)melds->len;
+  record->win_tile = (uint8_t)((uint32_t)config->win_tile | (config->ron ? RECORD_RON : 0));
+  record->winds = (uint8_t)((uint32_t)(config->player_wind - MJ_WT) |
+                            (uint32_t)(config->round_wind - MJ_WT) << RECORD_WIND_BITS);
+  return MJ_OK;
+}
+
+/* 副露と点数計算の条件 */
+static int32_t decode_record_melds(MJMelds *melds, MJScoreConfig *config, const MJHandRecord *record) {
+  if (record->meld_len > MJ_ELEMENTS_LEN) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  melds->len = record->meld_len;
+  for (uint32_t i = 0; i < melds->len; i++) {
+    if (!decode_record_meld(&melds->meld[i], record->melds[i])) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+  }
+  config->win_tile = (MJTileId)(record->win_tile & RECORD_TILE_MASK);
+  config->ron = (record->win_tile & RECORD_RON) != 0;
+  config->player_wind = (MJTileId)(MJ_WT + (record->winds & ((1u << RECORD_WIND_BITS) - 1)));
+  config->round_wind = (MJTileId)(MJ_WT + ((record->winds >> RECORD_WIND_BITS) & ((1u << RECORD_WIND_BITS) - 1)));
+  return is_tile_id_valid(config->win_tile) ? MJ_OK : MJ_ERR_ILLEGAL_PARAM;
+}
+
+int32_t mj_decode_hand_record(MJHands *hands, MJMelds *melds, MJScoreConfig *config, const MJHandRecord *record) {
+  Tiles tiles;
+  decode_record_counts(&tiles, record->counts);
+  hands->len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    for (uint32_t j = 0; j < tiles.tiles[i]; j++) {
+      if (hands->len == MJ_MAX_HAND_LEN) {
+        return MJ_ERR_ILLEGAL_PARAM;
+      }
+      hands->tile_id[hands->len++] = (MJTileId)i;
+    }
+  }
+  return decode_record_melds(melds, config, record);
+}
+
+/* mj_decode_hand_record, mj_prepare_hand と同じ検査で, レコードの枚数から MJHands を経ずに prepared を作る */
+static int32_t prepare_hand_record(MJPreparedHand *prepared, MJScoreConfig *config, const MJHandRecord *record) {
+  Tiles tiles;
+  decode_record_counts(&tiles, record->counts);
+  uint32_t len = 0;
+  bool too_many = false;  // 1種類5枚以上
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    len += tiles.tiles[i];
+    too_many = too_many || tiles.tiles[i] > MJ_MAX_TILES_LEN_IN_ELEMENT;
+  }
+  MJMelds melds;
+  if (len > MJ_MAX_HAND_LEN || decode_record_melds(&melds, config, record) != MJ_OK) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  if (len < MJ_MIN_HAND_LEN) {
+    return MJ_ERR_NUM_TILES_SHORT;
+  }
+  return too_many ? MJ_ERR_ILLEGAL_PARAM : prepare_hand_tiles(prepared, &tiles, &melds);
+}
+
+uint32_t get_record_size(MJRecordType type) {
+  switch (type) {
+    case MJ_RECORD_HANDS:
+      return sizeof(MJHandRecord);
+    case MJ_RECORD_SCORES:
+      return sizeof(MJScoreRecord);
+    case MJ_RECORD_SHANTENS:
+      return sizeof(MJShantenRecord);
+    default:
+      return 0;
+  }
+}
+
+static void init_record_header(MJRecordHeader *header, MJRecordType type, uint64_t len) {
+  memset(header, 0, sizeof(MJRecordHeader));
+  memcpy(header->magic, RECORD_MAGIC, sizeof(header->magic));
+  header->version = RECORD_VERSION;
+  header->type = type;
+  header->record_size = get_record_size(type);
+  header->len = len;
+}
+
+int32_t mj_open_record_file(MJRecordFile *file, const char *path, MJRecordType type) {
+  memset(file, 0, sizeof(MJRecordFile));
+  uint32_t record_size = get_record_size(type);
+  if (record_size == 0) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return MJ_ERR_IO;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return MJ_ERR_IO;
+  }
+  uint64_t map_len = (uint64_t)st.st_size;
+  if (map_len < sizeof(MJRecordHeader)) {
+    close(fd);
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  void *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // mmap した領域はファイルを閉じても有効
+  if (map == MAP_FAILED) {
+    return MJ_ERR_IO;
+  }
+  const MJRecordHeader *header = (const MJRecordHeader *)map;
+  if (memcmp(header->magic, RECORD_MAGIC, sizeof(header->magic)) != 0 || header->version != RECORD_VERSION ||
+      header->type != (uint32_t)type || header->record_size != record_size ||
+      header->len > (map_len - sizeof(MJRecordHeader)) / record_size) {
+    munmap(map, map_len);
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  madvise(map, map_len, MADV_SEQUENTIAL);  // 先読みを増やし, 読み終えたページを早く捨てる
+  file->records = (char *)map + sizeof(MJRecordHeader);
+  file->len = header->len;
+  file->type = type;
+  file->map = map;
+  file->map_len = map_len;
+  return MJ_OK;
+}
+
+int32_t mj_create_record_file(MJRecordFile *file, const char *path, MJRecordType type, uint64_t len) {
+  memset(file, 0, sizeof(MJRecordFile));
+  uint32_t record_size = get_record_size(type);
+  if (record_size == 0 || len > (UINT64_MAX - sizeof(MJRecordHeader)) / record_size) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return MJ_ERR_IO;
+  }
+  uint64_t map_len = sizeof(MJRecordHeader) + len * record_size;
+  if (ftruncate(fd, (off_t)map_len) != 0) {
+    close(fd);
+    return MJ_ERR_IO;
+  }
+  void *map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return MJ_ERR_IO;
+  }
+  init_record_header((MJRecordHeader *)map, type, len);
+  file->records = (char *)map + sizeof(MJRecordHeader);
+  file->len = len;
+  file->type = type;
+  file->map = map;
+  file->map_len = map_len;
+  file->writable = true;
+  return MJ_OK;
+}
+
+int32_t mj_close_record_file(MJRecordFile *file) {
+  int32_t ret = MJ_OK;
+  if (file->map) {
+    if (file->writable && msync(file->map, file->map_len, MS_SYNC) != 0) {
+      ret = MJ_ERR_IO;
+    }
+    if (munmap(file->map, file->map_len) != 0) {
+      ret = MJ_ERR_IO;
+    }
+  }
+  memset(file, 0, sizeof(MJRecordFile));
+  return ret;
+}
+
+void score_hand_record(MJScoreRecord *result, const MJHandRecord *record) {
+  MJPreparedHand prepared;
+  MJScoreConfig config;
+  memset(result, 0, sizeof(MJScoreRecord));
+  result->tag = record->tag;
+  int32_t ret = prepare_hand_record(&prepared, &config, record);
+  if (ret != MJ_OK) {
+    result->ret = (int8_t)ret;
+    return;
+  }
+  MJBaseScore score;
+  ret = mj_score_prepared(&score, &prepared, config.win_tile, config.ron, config.player_wind, config.round_wind);
+  result->ret = (int8_t)ret;
+  if (ret == MJ_OK) {
+    result->han = (uint8_t)(score.han < UINT8_MAX ? score.han : UINT8_MAX);
+    result->fu = (uint8_t)score.fu;
+    result->yaku = get_enum_yaku_mask(score.yaku_name);
+  }
+}
+
+bool decode_record_concealed(MJHands *hands, const MJHandRecord *record) {
+  if (record->meld_len > MJ_ELEMENTS_LEN) {
+    return false;
+  }
+  Tiles tiles;
+  decode_record_counts(&tiles, record->counts);
+  for (uint32_t i = 0; i < record->meld_len; i++) {
+    MJMeld meld;
+    if (!decode_record_meld(&meld, record->melds[i])) {
+      return false;
+    }
+    for (uint32_t j = 0; j < meld.len; j++) {
+      if (tiles.tiles[meld.tile_id[j]] == 0) {
+        return false;
+      }
+      remove_tile(&tiles, meld.tile_id[j]);
+    }
+  }
+  hands->len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    for (uint32_t j = 0; j < tiles.tiles[i]; j++) {
+      if (hands->len == MJ_MAX_HAND_LEN) {
+        return false;
+      }
+      hands->tile_id[hands->len++] = (MJTileId)i;
+    }
+  }
+  return true;
+}
+
+void calc_hand_record_shanten(MJShantenRecord *result, const MJHandRecord *record) {
+  result->tag = record->tag;
+  result->normal = MJ_RECORD_NO_SHANTEN;
+  result->chiitoitsu = MJ_RECORD_NO_SHANTEN;
+  result->kokushi = MJ_RECORD_NO_SHANTEN;
+  MJHands hands;
+  if (!decode_record_concealed(&hands, record)) {
+    result->ret = MJ_ERR_ILLEGAL_PARAM;
+    return;
+  }
+  MJShanten shanten;
+  shanten.chiitoitsu = MJ_RECORD_NO_SHANTEN;
+  shanten.kokushi = MJ_RECORD_NO_SHANTEN;
+  result->ret = (int8_t)mj_calc_shanten(&hands, &shanten);
+  if (result->ret == MJ_OK) {
+    result->normal = (int8_t)shanten.normal;
+    result->chiitoitsu = (int8_t)shanten.chiitoitsu;
+    result->kokushi = (int8_t)shanten.kokushi;
+  }
+}
+
+typedef struct {
+  void *results;
+  const MJHandRecord *records;
+} RecordBatch;
+
+static void score_record(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  RecordBatch *batch = (RecordBatch *)arg;
+  score_hand_record(&((MJScoreRecord *)batch->results)[index], &batch->records[index]);
+}
+
+static void calc_shanten_record(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  RecordBatch *batch = (RecordBatch *)arg;
+  calc_hand_record_shanten(&((MJShantenRecord *)batch->results)[index], &batch->records[index]);
+}
+
+int32_t mj_score_records(MJScoreRecord *results, const MJHandRecord *records, uint64_t len, uint32_t threads) {
+  RecordBatch batch = {results, records};
+  return mj_parallel_for(len, threads, 0, score_record, &batch);
+}
+
+int32_t mj_calc_shanten_records(MJShantenRecord *results, const MJHandRecord *records, uint64_t len,
+                                uint32_t threads) {
+  RecordBatch batch = {results, records};
+  return mj_parallel_for(len, threads, 0, calc_shanten_record, &batch);
+}
@@ -0,0 +1,260 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#define _GNU_SOURCE  // memfd_create
+
+#include "ring.h"
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "server.h"
+
+_Static_assert(sizeof(RingSlot) == RING_CACHE_LINE, "RingSlot must be one cache line");
+
+static void wait_ring_futex(atomic_uint *addr, uint32_t value) {
+  syscall(SYS_futex, addr, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+static void wake_ring_futex(atomic_uint *addr, int32_t len) {
+  syscall(SYS_futex, addr, FUTEX_WAKE, len, NULL, NULL, 0);
+}
+
+static inline void relax_ring() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+/* seq が value になるまで待つ. しばらく読み直してから futex で眠る */
+static void wait_ring_seq(RingSlot *slot, uint32_t value) {
+  for (uint32_t i = 0; i < RING_SPINS; i++) {
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) == value) {
+      return;
+    }
+    relax_ring();
+  }
+  atomic_fetch_add(&slot->waiters, 1);
+  for (;;) {
+    uint32_t seq = atomic_load(&slot->seq);
+    if (seq == value) {
+      break;
+    }
+    wait_ring_futex(&slot->seq, seq);
+  }
+  atomic_fetch_sub(&slot->waiters, 1);
+}
+
+static void set_ring_seq(RingSlot *slot, uint32_t value) {
+  atomic_store(&slot->seq, value);
+  if (atomic_load(&slot->waiters) > 0) {
+    wake_ring_futex(&slot->seq, INT_MAX);
+  }
+}
+
+static int32_t map_ring(MJRing *ring, int32_t fd, uint64_t map_len) {
+  void *map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    return MJ_ERR_IO;
+  }
+  ring->map = map;
+  ring->map_len = map_len;
+  ring->fd = fd;
+  return MJ_OK;
+}
+
+/*
+ * スロット数は MJ_RING_MIN_LEN 以上 MJ_RING_MAX_LEN 以下の2のべき乗. len == 2 では計算済みの ticket + 2 が
+ * 次の周の空き ticket + len と同じ値になり, 読まれていない結果のスロットに書き込めてしまう
+ */
+static bool is_ring_len_valid(uint32_t len) {
+  return len >= MJ_RING_MIN_LEN && len <= MJ_RING_MAX_LEN && (len & (len - 1)) == 0;
+}
+
+int32_t mj_create_ring(MJRing *ring, uint32_t len) {
+  memset(ring, 0, sizeof(MJRing));
+  ring->fd = -1;
+  if (!is_ring_len_valid(len)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  int32_t fd = memfd_create("mahjong-ring", MFD_CLOEXEC);
+  if (fd < 0) {
+    return MJ_ERR_IO;
+  }
+  uint64_t map_len = sizeof(RingHeader) + (uint64_t)len * sizeof(RingSlot);
+  if (ftruncate(fd, (off_t)map_len) != 0 || map_ring(ring, fd, map_len) != MJ_OK) {
+    close(fd);
+    return MJ_ERR_IO;
+  }
+  // ftruncate した領域は0なので, 0 でない値だけ書く
+  RingHeader *header = get_ring_header(ring);
+  memcpy(header->magic, RING_MAGIC, sizeof(header->magic));
+  header->version = RING_VERSION;
+  header->len = len;
+  header->mask = len - 1;
+  ring->len = len;
+  for (uint32_t i = 0; i < len; i++) {
+    atomic_init(&get_ring_slot(ring, i)->seq, i);
+  }
+  return MJ_OK;
+}
+
+int32_t mj_open_ring(MJRing *ring, int32_t fd) {
+  memset(ring, 0, sizeof(MJRing));
+  ring->fd = -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return MJ_ERR_IO;
+  }
+  if ((uint64_t)st.st_size < sizeof(RingHeader)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  int32_t ret = map_ring(ring, fd, (uint64_t)st.st_size);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  // fd は別のプロセスのものなので, 読んだ値だけを検査して使う
+  const RingHeader *header = get_ring_header(ring);
+  uint32_t len = header->len;
+  if (memcmp(header->magic, RING_MAGIC, sizeof(header->magic)) != 0 || header->version != RING_VERSION ||
+      !is_ring_len_valid(len) || header->mask != len - 1 ||
+      ring->map_len != sizeof(RingHeader) + (uint64_t)len * sizeof(RingSlot)) {
+    munmap(ring->map, ring->map_len);
+    memset(ring, 0, sizeof(MJRing));
+    ring->fd = -1;
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  ring->len = len;
+  return MJ_OK;
+}
+
+void mj_close_ring(MJRing *ring) {
+  if (ring->map) {
+    munmap(ring->map, ring->map_len);
+  }
+  if (ring->fd >= 0) {
+    close(ring->fd);
+  }
+  memset(ring, 0, sizeof(MJRing));
+  ring->fd = -1;
+}
+
+int32_t mj_submit_ring(MJRing *ring, uint32_t *ticket, const MJQuery *query) {
+  RingHeader *header = get_ring_header(ring);
+  uint32_t t = atomic_load(&header->head);
+  RingSlot *slot;
+  for (;;) {
+    slot = get_ring_slot(ring, t);
+    int32_t diff = (int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - t);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak(&header->head, &t, t + 1)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return MJ_ERR_BUSY;  // 前の周の結果がまだ読まれていない
+    } else {
+      t = atomic_load(&header->head);  // 他の書き込み側が取った
+    }
+  }
+  slot->query = *query;
+  set_ring_seq(slot, t + 1);
+  atomic_fetch_add(&header->submitted, 1);
+  if (atomic_load(&header->sleepers) > 0) {
+    wake_ring_futex(&header->submitted, 1);
+  }
+  *ticket = t;
+  return MJ_OK;
+}
+
+int32_t mj_wait_ring(MJRing *ring, MJQueryResult *result, uint32_t ticket) {
+  RingSlot *slot = get_ring_slot(ring, ticket);
+  wait_ring_seq(slot, ticket + 2);
+  *result = slot->result;
+  set_ring_seq(slot, ticket + ring->len);
+  return MJ_OK;
+}
+
+void run_ring_worker(MJRing *ring) {
+  RingHeader *header = get_ring_header(ring);
+  uint32_t spins = 0;
+  for (;;) {
+    uint32_t ticket = atomic_load(&header->tail);
+    RingSlot *slot = get_ring_slot(ring, ticket);
+    int32_t diff = (int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - (ticket + 1));
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak(&header->tail, &ticket, ticket + 1)) {
+        process_server_query(&slot->result, &slot->query);
+        set_ring_seq(slot, ticket + 2);
+        spins = 0;
+      }
+      continue;
+    }
+    if (diff > 0) {
+      continue;  // 他のワーカーが取り出した
+    }
+
+    // 空
+    if (atomic_load(&header->stop)) {
+      return;
+    }
+    if (++spins < RING_SPINS) {
+      relax_ring();
+      continue;
+    }
+    // submitted を読んでから空を確かめて眠るので, その間に書き込まれても futex が値の違いで返る
+    uint32_t submitted = atomic_load(&header->submitted);
+    atomic_fetch_add(&header->sleepers, 1);
+    if ((int32_t)(atomic_load(&slot->seq) - (ticket + 1)) < 0 && !atomic_load(&header->stop)) {
+      wait_ring_futex(&header->submitted, submitted);
+    }
+    atomic_fetch_sub(&header->sleepers, 1);
+    spins = 0;
+  }
+}
+
+static void run_ring_task(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  (void)index;
+  run_ring_worker((MJRing *)arg);
+}
+
+int32_t mj_run_ring(MJRing *ring, uint32_t threads) {
+  if (threads > MJ_BATCH_MAX_THREADS) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  // 1タスクが1つのワーカーのループ
+  uint32_t workers = threads > 1 ? threads : 1;
+  return mj_parallel_for(workers, workers, 1, run_ring_task, ring);
+}
+
+void mj_stop_ring(MJRing *ring) {
+  RingHeader *header = get_ring_header(ring);
+  atomic_store(&header->stop, 1);
+  atomic_fetch_add(&header->submitted, 1);
+  wake_ring_futex(&header->submitted, INT_MAX);
+}
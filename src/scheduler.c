@@ -0,0 +1,209 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "scheduler.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include "mahjong.h"
+#include "rng.h"
+
+#define ENABLE_DEBUG (0)
+
+#define SCHED_AUTO_GRAIN_SPLITS 64  // grain 自動設定時の1ワーカーあたりの最低分割数
+
+typedef struct {
+  Scheduler *sched;
+  SchedWorkerFunc func;
+  void *arg;
+  uint32_t worker;
+} SchedThread;
+
+typedef struct {
+  MJTaskFunc func;
+  void *arg;
+} ParallelFor;
+
+void push_sched_deque(SchedDeque *deque, uint64_t begin, uint64_t end) {
+  int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  SchedRange *range = &deque->ranges[(uint64_t)bottom & (SCHED_DEQUE_LEN - 1)];
+  atomic_store_explicit(&range->begin, begin, memory_order_relaxed);
+  atomic_store_explicit(&range->end, end, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+static void load_sched_range(SchedDeque *deque, int_fast64_t index, uint64_t *begin, uint64_t *end) {
+  SchedRange *range = &deque->ranges[(uint64_t)index & (SCHED_DEQUE_LEN - 1)];
+  *begin = atomic_load_explicit(&range->begin, memory_order_relaxed);
+  *end = atomic_load_explicit(&range->end, memory_order_relaxed);
+}
+
+bool pop_sched_deque(SchedDeque *deque, uint64_t *begin, uint64_t *end) {
+  int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+  if (top > bottom) {  // 空
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return false;
+  }
+  load_sched_range(deque, bottom, begin, end);
+  if (top < bottom) {
+    return true;
+  }
+  // 最後の1つは盗む側と取り合う
+  bool taken = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                                       memory_order_relaxed);
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+  return taken;
+}
+
+bool steal_sched_deque(SchedDeque *deque, uint64_t *begin, uint64_t *end) {
+  int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+  if (top >= bottom) {
+    return false;
+  }
+  load_sched_range(deque, top, begin, end);
+  return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed);
+}
+
+void init_scheduler(Scheduler *sched, uint64_t len, uint32_t workers, uint64_t grain) {
+  sched->workers = workers;
+  sched->grain = grain;
+  atomic_init(&sched->remaining, len);
+  for (uint32_t i = 0; i < workers; i++) {
+    SchedDeque *deque = &sched->deques[i];
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    deque->victim_seed = i;
+    // len * i / workers は64bitで溢れうるので商と余りに分けて計算する
+    uint64_t begin = len / workers * i + len % workers * i / workers;
+    uint64_t end = len / workers * (i + 1) + len % workers * (i + 1) / workers;
+    if (begin < end) {
+      push_sched_deque(deque, begin, end);
+    }
+  }
+}
+
+static bool steal_scheduler_range(Scheduler *sched, uint32_t worker, uint64_t *begin, uint64_t *end) {
+  // 盗む相手が偏らないように, 最初の相手を乱数で決めて一周する
+  uint32_t first = (uint32_t)(next_splitmix64(&sched->deques[worker].victim_seed) % sched->workers);
+  for (uint32_t i = 0; i < sched->workers; i++) {
+    uint32_t victim = (first + i) % sched->workers;
+    if (victim != worker && steal_sched_deque(&sched->deques[victim], begin, end)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool next_scheduler_range(Scheduler *sched, uint32_t worker, uint64_t *begin, uint64_t *end) {
+  SchedDeque *deque = &sched->deques[worker];
+  for (;;) {
+    if (pop_sched_deque(deque, begin, end) || steal_scheduler_range(sched, worker, begin, end)) {
+      // 後半を積み直して他のワーカーが盗めるようにする
+      while (*end - *begin > sched->grain) {
+        uint64_t mid = *begin + (*end - *begin) / 2;
+        push_sched_deque(deque, mid, *end);
+        *end = mid;
+      }
+      return true;
+    }
+    if (atomic_load_explicit(&sched->remaining, memory_order_acquire) == 0) {
+      return false;
+    }
+    sched_yield();  // 他のワーカーが実行中の区間を分割するのを待つ
+  }
+}
+
+void finish_scheduler_range(Scheduler *sched, uint64_t begin, uint64_t end) {
+  atomic_fetch_sub_explicit(&sched->remaining, end - begin, memory_order_acq_rel);
+}
+
+static void *run_sched_thread(void *arg) {
+  SchedThread *thread = (SchedThread *)arg;
+  thread->func(thread->arg, thread->sched, thread->worker);
+  return NULL;
+}
+
+void run_scheduler(Scheduler *sched, SchedWorkerFunc func, void *arg) {
+  pthread_t threads[SCHED_MAX_WORKERS];
+  SchedThread args[SCHED_MAX_WORKERS];
+  bool created[SCHED_MAX_WORKERS];
+  for (uint32_t i = 1; i < sched->workers; i++) {
+    args[i] = (SchedThread){sched, func, arg, i};
+    created[i] = pthread_create(&threads[i], NULL, run_sched_thread, &args[i]) == 0;
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+    if (!created[i]) {
+      fprintf(stderr, "worker %u: pthread_create failed\n", i);
+    }
+#endif
+  }
+  func(arg, sched, 0);
+  for (uint32_t i = 1; i < sched->workers; i++) {
+    if (created[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+}
+
+static void run_parallel_for(void *arg, Scheduler *sched, uint32_t worker) {
+  ParallelFor *parallel = (ParallelFor *)arg;
+  uint64_t begin;
+  uint64_t end;
+  while (next_scheduler_range(sched, worker, &begin, &end)) {
+    for (uint64_t i = begin; i < end; i++) {
+      parallel->func(parallel->arg, worker, i);
+    }
+    finish_scheduler_range(sched, begin, end);
+  }
+}
+
+int32_t mj_parallel_for(uint64_t len, uint32_t threads, uint64_t grain, MJTaskFunc func, void *arg) {
+  if (threads > MJ_BATCH_MAX_THREADS || func == NULL) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  if (len == 0) {
+    return MJ_OK;
+  }
+  uint32_t workers = threads == 0 ? 1 : threads;
+  if (workers > len) {
+    workers = (uint32_t)len;
+  }
+  if (grain == 0) {
+    grain = len / ((uint64_t)workers * SCHED_AUTO_GRAIN_SPLITS);
+    grain = grain == 0 ? 1 : grain;
+  }
+  Scheduler sched;
+  init_scheduler(&sched, len, workers, grain);
+  ParallelFor parallel = {func, arg};
+  run_scheduler(&sched, run_parallel_for, &parallel);
+  return MJ_OK;
+}
@@ -0,0 +1,449 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#define _GNU_SOURCE  // accept4
+
+#include "server.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(MJQuery) == 32, "MJQuery must be 32 bytes");
+_Static_assert(sizeof(MJQueryResult) == 24, "MJQueryResult must be 24 bytes");
+
+static uint64_t get_server_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool send_server_all(int32_t fd, const void *buf, uint64_t len) {
+  const uint8_t *p = (const uint8_t *)buf;
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= (uint64_t)n;
+  }
+  return true;
+}
+
+static bool recv_server_all(int32_t fd, void *buf, uint64_t len) {
+  uint8_t *p = (uint8_t *)buf;
+  while (len > 0) {
+    ssize_t n = recv(fd, p, len, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= (uint64_t)n;
+  }
+  return true;
+}
+
+static bool init_server_addr(struct sockaddr_un *addr, const char *path) {
+  memset(addr, 0, sizeof(struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  uint64_t len = strlen(path);
+  if (len == 0 || len >= MJ_SERVER_PATH_LEN || len >= sizeof(addr->sun_path)) {
+    return false;
+  }
+  memcpy(addr->sun_path, path, len);
+  return true;
+}
+
+/* シャンテン数が最小になる形の受け入れの和. MJ_QUERY_WAIT はテンパイのときだけ */
+static void calc_server_ukeire(MJQueryResult *result, const MJHandRecord *record) {
+  MJHands hands;
+  if (!decode_record_concealed(&hands, record)) {
+    result->ret = MJ_ERR_ILLEGAL_PARAM;
+    return;
+  }
+  int32_t min = result->normal;
+  min = result->chiitoitsu < min ? result->chiitoitsu : min;
+  min = result->kokushi < min ? result->kokushi : min;
+  if (result->kind == MJ_QUERY_WAIT && min != 0) {
+    return;
+  }
+
+  typedef int32_t (*UkeireFunc)(const MJHands *hands, MJTiles *acceptables);
+  const UkeireFunc funcs[] = {mj_ukeire_normal, mj_ukeire_chiitoitsu, mj_ukeire_kokushi};
+  const int32_t shanten[] = {result->normal, result->chiitoitsu, result->kokushi};
+  Tiles tiles;  // 自分の手牌と副露にある牌は数えない
+  decode_record_counts(&tiles, record->counts);
+  for (uint32_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++) {
+    if (shanten[i] != min) {
+      continue;
+    }
+    MJTiles acceptables;
+    int32_t ret = funcs[i](&hands, &acceptables);
+    if (ret != MJ_OK) {
+      result->ret = (int8_t)ret;
+      return;
+    }
+    for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+      if (acceptables.tiles[j] && !(result->value & (1ull << j))) {
+        result->value |= 1ull << j;
+        result->count = (uint8_t)(result->count + MJ_MAX_TILES_LEN_IN_ELEMENT - tiles.tiles[j]);
+      }
+    }
+  }
+}
+
+void process_server_query(MJQueryResult *result, const MJQuery *query) {
+  memset(result, 0, sizeof(MJQueryResult));
+  result->tag = query->hand.tag;
+  result->kind = (uint8_t)query->kind;
+  result->normal = MJ_RECORD_NO_SHANTEN;
+  result->chiitoitsu = MJ_RECORD_NO_SHANTEN;
+  result->kokushi = MJ_RECORD_NO_SHANTEN;
+  switch (query->kind) {
+    case MJ_QUERY_SCORE: {
+      MJScoreRecord score;
+      score_hand_record(&score, &query->hand);
+      result->ret = score.ret;
+      result->han = score.han;
+      result->fu = score.fu;
+      result->value = score.yaku;
+      return;
+    }
+    case MJ_QUERY_SHANTEN:
+    case MJ_QUERY_UKEIRE:
+    case MJ_QUERY_WAIT: {
+      MJShantenRecord shanten;
+      calc_hand_record_shanten(&shanten, &query->hand);
+      result->ret = shanten.ret;
+      result->normal = shanten.normal;
+      result->chiitoitsu = shanten.chiitoitsu;
+      result->kokushi = shanten.kokushi;
+      if (result->ret == MJ_OK && query->kind != MJ_QUERY_SHANTEN) {
+        calc_server_ukeire(result, &query->hand);
+      }
+      return;
+    }
+    default:
+      result->ret = MJ_ERR_ILLEGAL_PARAM;
+      return;
+  }
+}
+
+int32_t mj_open_server(MJServer *server, const char *path, uint32_t threads) {
+  memset(server, 0, sizeof(MJServer));
+  server->listen_fd = SERVER_NO_FD;
+  server->wake_fds[0] = SERVER_NO_FD;
+  server->wake_fds[1] = SERVER_NO_FD;
+  for (uint32_t i = 0; i < MJ_SERVER_MAX_CLIENTS; i++) {
+    server->client_fds[i] = SERVER_NO_FD;
+  }
+  struct sockaddr_un addr;
+  if (!init_server_addr(&addr, path) || threads > MJ_BATCH_MAX_THREADS) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  server->threads = threads;
+  if (pipe(server->wake_fds) != 0) {
+    server->wake_fds[0] = SERVER_NO_FD;
+    server->wake_fds[1] = SERVER_NO_FD;
+    return MJ_ERR_IO;
+  }
+  server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (server->listen_fd < 0) {
+    mj_close_server(server);
+    return MJ_ERR_IO;
+  }
+  unlink(path);
+  if (bind(server->listen_fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    mj_close_server(server);
+    return MJ_ERR_IO;
+  }
+  memcpy(server->path, addr.sun_path, sizeof(server->path));  // 作った socket だけを mj_close_server で消す
+  if (listen(server->listen_fd, MJ_SERVER_MAX_CLIENTS) != 0) {
+    mj_close_server(server);
+    return MJ_ERR_IO;
+  }
+  return MJ_OK;
+}
+
+static void close_server_client(MJServer *server, uint32_t client) {
+  close(server->client_fds[client]);
+  server->client_fds[client] = SERVER_NO_FD;
+  server->client_lens[client] = 0;
+  server->client_output_lens[client] = 0;
+}
+
+static void accept_server_client(MJServer *server) {
+  int32_t fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  for (uint32_t i = 0; i < MJ_SERVER_MAX_CLIENTS; i++) {
+    if (server->client_fds[i] == SERVER_NO_FD) {
+      server->client_fds[i] = fd;
+      server->client_lens[i] = 0;
+      server->client_output_lens[i] = 0;
+      server->stats.connections++;
+      return;
+    }
+  }
+  close(fd);  // 接続数が上限を超えた
+}
+
+static void recv_server_client(MJServer *server, uint32_t client, uint64_t now) {
+  uint32_t len = server->client_lens[client];
+  if (len == sizeof(server->client_buffers[client])) {
+    return;  // client_outputs が空くまで受信しない
+  }
+  ssize_t n = recv(server->client_fds[client], &server->client_buffers[client][len],
+                   sizeof(server->client_buffers[client]) - len, MSG_DONTWAIT);
+  if (n > 0) {
+    server->client_lens[client] += (uint32_t)n;
+    // この recv で受信し終えた問い合わせの時刻. 前の recv で受信し終えた問い合わせの時刻は変えない
+    for (uint32_t i = len / (uint32_t)sizeof(MJQuery); i < server->client_lens[client] / sizeof(MJQuery); i++) {
+      server->client_times[client][i] = now;
+    }
+  } else if (n == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+    close_server_client(server, client);  // 返していない問い合わせは捨てる
+  }
+}
+
+/* バッチに詰められる問い合わせの数. 結果を client_outputs に置ける分だけ */
+static uint32_t count_server_queries(const MJServer *server, uint32_t client) {
+  uint32_t queries = server->client_lens[client] / (uint32_t)sizeof(MJQuery);
+  uint32_t room =
+      (uint32_t)(sizeof(server->client_outputs[client]) - server->client_output_lens[client]) / sizeof(MJQueryResult);
+  return queries < room ? queries : room;
+}
+
+/* 全てのクライアントの受信済みの問い合わせをバッチに詰める. 1つのクライアントの問い合わせは続けて並ぶ */
+static uint32_t fill_server_batch(MJServer *server) {
+  uint32_t len = 0;
+  // 前のバッチの続きのクライアントから順に詰める. 番号の小さいクライアントだけでバッチが埋まらないように
+  uint32_t first = server->next_client;
+  for (uint32_t k = 0; k < MJ_SERVER_MAX_CLIENTS && len < MJ_SERVER_BATCH_LEN; k++) {
+    uint32_t i = (first + k) % MJ_SERVER_MAX_CLIENTS;
+    uint32_t ready = count_server_queries(server, i);
+    uint32_t queries = ready < MJ_SERVER_BATCH_LEN - len ? ready : MJ_SERVER_BATCH_LEN - len;
+    if (queries == 0) {
+      continue;
+    }
+    uint32_t bytes = queries * (uint32_t)sizeof(MJQuery);
+    memcpy(&server->queries[len], server->client_buffers[i], bytes);
+    memcpy(&server->query_times[len], server->client_times[i], queries * sizeof(uint64_t));
+    for (uint32_t j = 0; j < queries; j++) {
+      server->query_clients[len + j] = i;
+    }
+    len += queries;
+    server->client_lens[i] -= bytes;
+    memmove(server->client_buffers[i], &server->client_buffers[i][bytes], server->client_lens[i]);
+    memmove(server->client_times[i], &server->client_times[i][queries],
+            (MJ_SERVER_CLIENT_QUERIES - queries) * sizeof(uint64_t));
+    // 入り切らなかった問い合わせは次のバッチの先頭に詰める
+    server->next_client = queries < ready ? i : (i + 1) % MJ_SERVER_MAX_CLIENTS;
+  }
+  return len;
+}
+
+/* client_outputs を送れるだけ送る. 残りは POLLOUT で送る. 接続が切れていれば false */
+static bool flush_server_client(MJServer *server, uint32_t client) {
+  uint32_t len = server->client_output_lens[client];
+  if (len == 0) {
+    return true;
+  }
+  ssize_t n = send(server->client_fds[client], server->client_outputs[client], len, MSG_NOSIGNAL | MSG_DONTWAIT);
+  if (n < 0) {
+    return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+  server->client_output_lens[client] -= (uint32_t)n;
+  memmove(server->client_outputs[client], &server->client_outputs[client][n], server->client_output_lens[client]);
+  return true;
+}
+
+static void process_server_batch_query(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  MJServer *server = (MJServer *)arg;
+  process_server_query(&server->results[index], &server->queries[index]);
+}
+
+static int32_t run_server_batch(MJServer *server, uint32_t len) {
+  int32_t ret = mj_parallel_for(len, server->threads, 0, process_server_batch_query, server);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  for (uint32_t i = 0; i < len;) {
+    uint32_t client = server->query_clients[i];
+    uint32_t last = i;
+    while (last < len && server->query_clients[last] == client) {
+      last++;
+    }
+    if (server->client_fds[client] != SERVER_NO_FD) {
+      uint32_t bytes = (last - i) * (uint32_t)sizeof(MJQueryResult);  // fill_server_batch が空きを確かめている
+      memcpy(&server->client_outputs[client][server->client_output_lens[client]], &server->results[i], bytes);
+      server->client_output_lens[client] += bytes;
+      if (!flush_server_client(server, client)) {
+        close_server_client(server, client);
+      }
+    }
+    uint64_t now = get_server_time();
+    for (; i < last; i++) {
+      uint64_t latency = (now - server->query_times[i]) / 1000;
+      server->stats.latency[latency < MJ_SERVER_LATENCY_LEN ? latency : MJ_SERVER_LATENCY_LEN - 1]++;
+    }
+  }
+  server->stats.queries += len;
+  server->stats.batches++;
+  server->stats.max_batch = len > server->stats.max_batch ? len : server->stats.max_batch;
+  return MJ_OK;
+}
+
+int32_t mj_run_server(MJServer *server) {
+  struct pollfd fds[MJ_SERVER_MAX_CLIENTS + 2];
+  for (;;) {
+    // 受信済みの問い合わせが残っていれば待たない
+    bool pending = false;
+    fds[0] = (struct pollfd){server->wake_fds[0], POLLIN, 0};
+    fds[1] = (struct pollfd){server->listen_fd, POLLIN, 0};
+    for (uint32_t i = 0; i < MJ_SERVER_MAX_CLIENTS; i++) {
+      bool full = server->client_lens[i] == sizeof(server->client_buffers[i]);
+      short events = (short)((full ? 0 : POLLIN) | (server->client_output_lens[i] > 0 ? POLLOUT : 0));
+      fds[i + 2] = (struct pollfd){server->client_fds[i], events, 0};
+      pending = pending || count_server_queries(server, i) > 0;
+    }
+    if (poll(fds, MJ_SERVER_MAX_CLIENTS + 2, pending ? 0 : -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return MJ_ERR_IO;
+    }
+    if (fds[0].revents) {
+      return MJ_OK;
+    }
+    if (fds[1].revents & POLLIN) {
+      accept_server_client(server);
+    }
+    uint64_t now = get_server_time();
+    for (uint32_t i = 0; i < MJ_SERVER_MAX_CLIENTS; i++) {
+      if (fds[i + 2].fd == SERVER_NO_FD || fds[i + 2].revents == 0) {
+        continue;
+      }
+      if ((fds[i + 2].revents & POLLOUT) && !flush_server_client(server, i)) {
+        close_server_client(server, i);
+        continue;
+      }
+      if (fds[i + 2].revents & ~POLLOUT) {
+        recv_server_client(server, i, now);
+      }
+    }
+    uint32_t len = fill_server_batch(server);
+    if (len > 0) {
+      int32_t ret = run_server_batch(server, len);
+      if (ret != MJ_OK) {
+        return ret;
+      }
+    }
+  }
+}
+
+void mj_stop_server(MJServer *server) {
+  const char c = 0;
+  ssize_t n = write(server->wake_fds[1], &c, 1);  // シグナルハンドラから呼べるように write だけ
+  (void)n;
+}
+
+void mj_close_server(MJServer *server) {
+  for (uint32_t i = 0; i < MJ_SERVER_MAX_CLIENTS; i++) {
+    if (server->client_fds[i] != SERVER_NO_FD) {
+      close_server_client(server, i);
+    }
+  }
+  const int32_t fds[] = {server->listen_fd, server->wake_fds[0], server->wake_fds[1]};
+  for (uint32_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+    if (fds[i] != SERVER_NO_FD) {
+      close(fds[i]);
+    }
+  }
+  server->listen_fd = SERVER_NO_FD;
+  server->wake_fds[0] = SERVER_NO_FD;
+  server->wake_fds[1] = SERVER_NO_FD;
+  if (server->path[0]) {
+    unlink(server->path);
+    server->path[0] = '\0';
+  }
+}
+
+uint32_t mj_server_latency_percentile(const MJServerStats *stats, double percentile) {
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < MJ_SERVER_LATENCY_LEN; i++) {
+    total += stats->latency[i];
+  }
+  double target = (double)total * percentile / 100.0;
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < MJ_SERVER_LATENCY_LEN; i++) {
+    sum += stats->latency[i];
+    if (sum > 0 && (double)sum >= target) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+int32_t mj_connect_server(int32_t *fd, const char *path) {
+  *fd = SERVER_NO_FD;
+  struct sockaddr_un addr;
+  if (!init_server_addr(&addr, path)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  int32_t sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    return MJ_ERR_IO;
+  }
+  if (connect(sock, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(sock);
+    return MJ_ERR_IO;
+  }
+  *fd = sock;
+  return MJ_OK;
+}
+
+int32_t mj_query_server(int32_t fd, MJQueryResult *results, const MJQuery *queries, uint64_t len) {
+  // 結果を読まずに送り続けるとお互いの送信が詰まるので, バッチ1つ分ずつ送って受け取る
+  for (uint64_t i = 0; i < len; i += MJ_SERVER_BATCH_LEN) {
+    uint64_t n = len - i < MJ_SERVER_BATCH_LEN ? len - i : MJ_SERVER_BATCH_LEN;
+    if (!send_server_all(fd, &queries[i], n * sizeof(MJQuery)) ||
+        !recv_server_all(fd, &results[i], n * sizeof(MJQueryResult))) {
+      return MJ_ERR_IO;
+    }
+  }
+  return MJ_OK;
+}
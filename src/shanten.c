@@ -30,182 +30,160 @@
 #include <stdio.h>
 
 #include "agari.h"
+#include "bitboard.h"
 #include "mahjong.h"
+#include "stats.h"
 #include "tile.h"
 
 #define ENABLE_DEBUG (0)
 
-#define DEBUG_DEPTH(depth)                                \
-  do {                                                    \
-    fprintf(stderr, "%d", depth);                         \
-    for (int __depth = 0; __depth < (depth); __depth++) { \
-      fprintf(stderr, " ");                               \
-    }                                                     \
-  } while (0)
+/*
+ * [通常手のシャンテン数]
+ * シャンテン数 = 2 * 面子の枠数 - (2 * 面子数 + 雀頭数 + 塔子数). ただし 面子数 + 塔子数 <= 面子の枠数, 雀頭は高々1つ.
+ * 面子, 塔子, 雀頭は萬子, 筒子, 索子, 字牌をまたがないので, 種類ごとに (雀頭数, 面子数) ごとの塔子数の最大値を
+ * 求めてから組み合わせる. 手牌全体の面子, 塔子の組み合わせを探索する場合の積ではなく, 種類ごとの探索の和の手間で済む.
+ *
+ * 面子は牌の小さい順にしか取り出さない(from 以上のランクから取り出す).
+ * 取り出す順番が違うだけの同じ組み合わせを何度も探索しないため.
+ */
 
-static bool dig_partial(ShantenCtx *ctx, int depth) {
-  ctx->stat_dig_partial++;
-  for (int32_t i = MJ_M1; i <= MJ_DR; i++) {
-    if (ctx->elem_len + ctx->partial_len >= 4) {
-      break;
-    }
-    if (ctx->tiles.tiles[i] >= MJ_PAIR_LEN) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-      DEBUG_DEPTH(depth);
-      fprintf(stderr, "%s(%d):%s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i]);
-#endif
-      ctx->tiles.tiles[i] -= MJ_PAIR_LEN;
-      ctx->partial_len++;
-      bool limit = dig_partial(ctx, depth + 1);
-      ctx->partial_len--;
-      ctx->tiles.tiles[i] += MJ_PAIR_LEN;
-      if (limit) {
-        return true;
-      }
+#define SUIT_PARTIAL_NONE (-1)  // その (雀頭数, 面子数) は取れない
+
+/*
+ * 面子を取った残りの牌から取れる塔子(対子, 両面/辺張, 嵌張)の最大数.
+ * 最も小さいランクの牌は, 同じ牌, 1つ上, 2つ上の順に最も近い牌と組にしてよい(最適解の組を入れ替えても数は減らない)ので,
+ * 小さいランクから貪欲に組にすれば最大になる.
+ */
+static int count_suit_partials(uint32_t suit, uint64_t word) {
+  int partial_len = 0;
+  while (word) {
+    uint32_t rank = get_bb_lowest_rank(find_bb_tiles(word));
+    uint32_t count = get_bb_count(word, rank);
+    partial_len += (int)(count / MJ_PAIR_LEN);
+    word &= ~(0xfull << (rank * BB_RANK_BITS));
+    if (count % MJ_PAIR_LEN == 0 || suit == BB_HONORS) {
+      continue;
     }
-    uint32_t tile_number = get_tile_number(i);
-    if (tile_number != TILE_NUM_INVALID) {  // 数牌
-      if (tile_number <= TILE_NUM_8 && ctx->tiles.tiles[i] && ctx->tiles.tiles[i + 1]) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-        DEBUG_DEPTH(depth);
-        fprintf(stderr, "%s(%d):%s(%d), %s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i],
-                tile_id_str(i + 1), ctx->tiles.tiles[i + 1]);
-#endif
-        ctx->tiles.tiles[i]--;
-        ctx->tiles.tiles[i + 1]--;
-        ctx->partial_len++;
-        bool limit = dig_partial(ctx, depth + 1);
-        ctx->partial_len--;
-        ctx->tiles.tiles[i + 1]++;
-        ctx->tiles.tiles[i]++;
-        if (limit) {
-          return true;
-        }
-      }
-      if (tile_number <= TILE_NUM_7 && ctx->tiles.tiles[i] && ctx->tiles.tiles[i + 2]) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-        DEBUG_DEPTH(depth);
-        fprintf(stderr, "%s(%d):%s(%d), %s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i],
-                tile_id_str(i + 2), ctx->tiles.tiles[i + 2]);
-#endif
-        ctx->tiles.tiles[i]--;
-        ctx->tiles.tiles[i + 2]--;
-        ctx->partial_len++;
-        bool limit = dig_partial(ctx, depth + 1);
-        ctx->partial_len--;
-        ctx->tiles.tiles[i + 2]++;
-        ctx->tiles.tiles[i]++;
-        if (limit) {
-          return true;
-        }
+    for (uint32_t d = 1; d <= 2 && rank + d < TILE_NUM_LEN; d++) {
+      if (get_bb_count(word, rank + d)) {
+        word -= get_bb_rank_bit(rank + d);
+        partial_len++;
+        break;
       }
     }
   }
-  int32_t shanten = ctx->shanten_normal_max - (ctx->elem_len * 2 + ctx->pair_len + ctx->partial_len);
-  if (ctx->shanten_normal > shanten) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-    fprintf(stderr, "shanten %d (elem_len %d, partial_len %d)\n", shanten, ctx->elem_len, ctx->partial_len);
-#endif
-    ctx->shanten_normal = shanten;
-    if (ctx->shanten_normal_min >= ctx->shanten_normal) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-      fprintf(stderr, "found min: shanten %d, limit %d\n", ctx->shanten_normal, ctx->shanten_normal_min);
-#endif
-      return true;
+  return partial_len;
+}
+
+static void dig_suit_element(SuitShanten *suit_shanten, uint32_t suit, uint64_t word, uint32_t from, int pair_len,
+                             int elem_len) {
+  INC_STATS(shanten_nodes);
+  if (elem_len > MJ_ELEMENTS_LEN) {
+    INC_STATS(early_exits);
+    return;  // 手牌は高々14枚なので面子は4つまで
+  }
+  uint64_t triplets = find_bb_triplets(word);
+  uint64_t sequences = suit == BB_HONORS ? 0 : find_bb_sequences(word);  // 数牌
+  uint64_t candidates = (triplets | sequences) & ~(get_bb_rank_bit(from) - 1);
+  while (candidates) {
+    uint32_t rank = get_bb_lowest_rank(candidates);
+    uint64_t bit = get_bb_rank_bit(rank);
+    candidates &= candidates - 1;
+    if (triplets & bit) {
+      dig_suit_element(suit_shanten, suit, remove_bb_block(word, rank, BB_BLOCK_TRIPLETS), rank, pair_len,
+                       elem_len + 1);
+    }
+    if (sequences & bit) {
+      dig_suit_element(suit_shanten, suit, remove_bb_block(word, rank, BB_BLOCK_SEQUENCE), rank, pair_len,
+                       elem_len + 1);
     }
   }
-  return false;
+  int partial_len = count_suit_partials(suit, word);
+  if (suit_shanten->partials[pair_len][elem_len] < partial_len) {
+    suit_shanten->partials[pair_len][elem_len] = (int8_t)partial_len;
+  }
 }
 
-static bool dig_element(ShantenCtx *ctx, int depth) {
-  ctx->stat_dig_element++;
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 2)
-  DEBUG_DEPTH(depth);
-  fprintf(stderr, "%s(%d):depth %d\n", __func__, __LINE__, depth);
-#endif
-  for (int32_t i = MJ_M1; i <= MJ_DR; i++) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 2)
-    DEBUG_DEPTH(depth);
-    fprintf(stderr, "%s(%d):i %s\n", __func__, __LINE__, tile_id_str(i));
-#endif
-    if (ctx->tiles.tiles[i] >= MJ_MIN_TILES_LEN_IN_ELEMENT) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-      DEBUG_DEPTH(depth);
-      fprintf(stderr, "%s(%d):%s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i]);
-#endif
-      ctx->tiles.tiles[i] -= MJ_MIN_TILES_LEN_IN_ELEMENT;
-      ctx->elem_len++;
-      bool limit = dig_element(ctx, depth + 1);
-      ctx->elem_len--;
-      ctx->tiles.tiles[i] += MJ_MIN_TILES_LEN_IN_ELEMENT;
-      if (limit) {
-        return true;
+static void dig_suit(SuitShanten *suit_shanten, uint32_t suit, uint64_t word) {
+  memset(suit_shanten, SUIT_PARTIAL_NONE, sizeof(SuitShanten));
+  if (word == 0) {
+    suit_shanten->partials[0][0] = 0;
+    return;
+  }
+  dig_suit_element(suit_shanten, suit, word, 0, 0, 0);
+  uint64_t pairs = find_bb_pairs(word);
+  while (pairs) {
+    uint32_t rank = get_bb_lowest_rank(pairs);
+    pairs &= pairs - 1;
+    dig_suit_element(suit_shanten, suit, remove_bb_block(word, rank, BB_BLOCK_PAIR), 0, 1, 0);
+  }
+}
+
+/* 種類ごとの結果を足し合わせる. 面子数が枠を超える組み合わせは牌の枚数からあり得ない */
+static void merge_suit_shanten(SuitShanten *merged, const SuitShanten *suit_shanten) {
+  SuitShanten prev = *merged;
+  memset(merged, SUIT_PARTIAL_NONE, sizeof(SuitShanten));
+  for (int p1 = 0; p1 < MJ_PAIR_LEN; p1++) {
+    for (int e1 = 0; e1 <= MJ_ELEMENTS_LEN; e1++) {
+      if (prev.partials[p1][e1] == SUIT_PARTIAL_NONE) {
+        continue;
       }
-    }
-    uint32_t tile_number = get_tile_number(i);
-    if (tile_number != TILE_NUM_INVALID &&  // 数牌
-        tile_number <= TILE_NUM_7 && ctx->tiles.tiles[i] && ctx->tiles.tiles[i + 1] && ctx->tiles.tiles[i + 2]) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-      DEBUG_DEPTH(depth);
-      fprintf(stderr, "%s(%d):%s(%d), %s(%d), %s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i],
-              tile_id_str(i + 1), ctx->tiles.tiles[i + 1], tile_id_str(i + 2), ctx->tiles.tiles[i + 2]);
-#endif
-      ctx->tiles.tiles[i]--;
-      ctx->tiles.tiles[i + 1]--;
-      ctx->tiles.tiles[i + 2]--;
-      ctx->elem_len++;
-      bool limit = dig_element(ctx, depth + 1);
-      ctx->elem_len--;
-      ctx->tiles.tiles[i + 2]++;
-      ctx->tiles.tiles[i + 1]++;
-      ctx->tiles.tiles[i]++;
-      if (limit) {
-        return true;
+      for (int p2 = 0; p1 + p2 < MJ_PAIR_LEN; p2++) {
+        for (int e2 = 0; e1 + e2 <= MJ_ELEMENTS_LEN; e2++) {
+          if (suit_shanten->partials[p2][e2] == SUIT_PARTIAL_NONE) {
+            continue;
+          }
+          int partial_len = prev.partials[p1][e1] + suit_shanten->partials[p2][e2];
+          if (merged->partials[p1 + p2][e1 + e2] < partial_len) {
+            merged->partials[p1 + p2][e1 + e2] = (int8_t)partial_len;
+          }
+        }
       }
     }
   }
-  return dig_partial(ctx, depth + 1);
 }
 
-static void dig(ShantenCtx *ctx) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 2)
-  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
-    fprintf(stderr, "%s(%d): %s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i]);
-  }
-#endif
-  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
-    if (ctx->tiles.tiles[i] >= MJ_PAIR_LEN) {
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-      fprintf(stderr, "%s(%d):i %s(%d)\n", __func__, __LINE__, tile_id_str(i), ctx->tiles.tiles[i]);
-#endif
-      ctx->tiles.tiles[i] -= MJ_PAIR_LEN;
-      ctx->pair_len++;
-      ctx->stat_dig++;
-      bool limit = dig_element(ctx, 1);
-      ctx->pair_len--;
-      ctx->tiles.tiles[i] += MJ_PAIR_LEN;
-      if (limit) {
-        return;
+/*
+ * a と b を足し合わせた通常手のシャンテン数. merge_suit_shanten の結果を作らずに最小値だけ求める.
+ * 面子と塔子は(副露を除いた)面子の数までしか数えない. 13枚なら4, 1副露の10枚なら3
+ */
+static int32_t calc_merged_shanten(const SuitShanten *a, const SuitShanten *b, int32_t total_len) {
+  int32_t slots = total_len / MJ_MIN_TILES_LEN_IN_ELEMENT;
+  int32_t shanten = slots * 2 /*=2点*/;
+  for (int p1 = 0; p1 < MJ_PAIR_LEN; p1++) {
+    for (int e1 = 0; e1 <= MJ_ELEMENTS_LEN && e1 <= slots; e1++) {
+      if (a->partials[p1][e1] == SUIT_PARTIAL_NONE) {
+        continue;
+      }
+      for (int p2 = 0; p1 + p2 < MJ_PAIR_LEN; p2++) {
+        for (int e2 = 0; e1 + e2 <= MJ_ELEMENTS_LEN && e1 + e2 <= slots; e2++) {
+          if (b->partials[p2][e2] == SUIT_PARTIAL_NONE) {
+            continue;
+          }
+          int elem_len = e1 + e2;
+          int partial_len = a->partials[p1][e1] + b->partials[p2][e2];
+          if (partial_len > slots - elem_len) {
+            partial_len = slots - elem_len;
+          }
+          int32_t value = slots * 2 - (elem_len * 2 + p1 + p2 + partial_len);
+          if (shanten > value) {
+            shanten = value;
+          }
+        }
       }
     }
   }
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
-  fprintf(stderr, "%s(%d): no pair\n", __func__, __LINE__);
-#endif
-  dig_element(ctx, 0);
+  return shanten;
 }
 
+/* 分岐せずに数える. 牌の有無は手牌ごとにばらばらで分岐予測が当たらない */
 void calc_shanten_kokushi(ShantenCtx *ctx) {
   int shanten = 0;
   int pair = 0;
   const uint32_t yaochu[] = {MJ_M1, MJ_M9, MJ_P1, MJ_P9, MJ_S1, MJ_S9, MJ_WT, MJ_WN, MJ_WS, MJ_WP, MJ_DW, MJ_DG, MJ_DR};
   for (uint32_t i = 0; i < sizeof(yaochu) / sizeof(yaochu[0]); i++) {
-    if (ctx->tiles.tiles[yaochu[i]]) {
-      shanten++;
-      if (ctx->tiles.tiles[yaochu[i]] >= MJ_PAIR_LEN && pair == 0) {
-        pair = 1;
-      }
-    }
+    shanten += ctx->tiles.tiles[yaochu[i]] != 0;
+    pair |= ctx->tiles.tiles[yaochu[i]] >= MJ_PAIR_LEN;
   }
   ctx->shanten_kokushi = 13 - (shanten + pair);
 }
@@ -214,12 +192,8 @@ void calc_shanten_chiitoitsu(ShantenCtx *ctx) {
   int shanten = 0;
   int kind = 0;
   for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
-    if (ctx->tiles.tiles[i]) {
-      kind++;
-      if (ctx->tiles.tiles[i] >= MJ_PAIR_LEN) {
-        shanten++;
-      }
-    }
+    kind += ctx->tiles.tiles[i] != 0;
+    shanten += ctx->tiles.tiles[i] >= MJ_PAIR_LEN;
   }
   // 11 22 33 44 55 55 7 => 1 -> 4枚組は7が入って5を捨てても1シャンテンにならない
   ctx->shanten_chiitoitsu = 6 - shanten;
@@ -229,14 +203,26 @@ void calc_shanten_chiitoitsu(ShantenCtx *ctx) {
 }
 
 void calc_shanten_normal(ShantenCtx *ctx) {
-  dig(ctx);
+  INC_STATS(shanten_calls);
+  gen_bitboard_from_tiles(&ctx->bb, &ctx->tiles);
+  SuitShanten merged;
+  dig_suit(&merged, BB_MAN, ctx->bb.suit[BB_MAN]);
+  SuitShanten suit_shanten;
+  for (uint32_t suit = BB_PIN; suit < BB_HONORS; suit++) {
+    dig_suit(&suit_shanten, suit, ctx->bb.suit[suit]);
+    merge_suit_shanten(&merged, &suit_shanten);
+  }
+  dig_suit(&suit_shanten, BB_HONORS, ctx->bb.suit[BB_HONORS]);
+  int32_t shanten = calc_merged_shanten(&merged, &suit_shanten, ctx->total_len);
+  if (ctx->shanten_normal > shanten) {
+    ctx->shanten_normal = shanten;
+  }
 
 #if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
   fprintf(stderr, "shanten %d\n", ctx->shanten_normal);
 #endif
-#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 2)
-  fprintf(stderr, "stat dig %d, stat dig element %d, stat dig partial %d\n", ctx->stat_dig, ctx->stat_dig_element,
-          ctx->stat_dig_partial);
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 2) && defined(MJ_ENABLE_STATS)
+  fprintf(stderr, "shanten nodes %llu\n", (unsigned long long)thread_stats.shanten_nodes);
 #endif
 }
 
@@ -250,11 +236,6 @@ int32_t mj_calc_shanten(const MJHands *hands, MJShanten *shanten) {
   }
 
   ctx.total_len = (int32_t)hands->len;
-  if (ctx.total_len % MJ_MIN_TILES_LEN_IN_ELEMENT == 2) {
-    ctx.shanten_normal_min = -1;  // 和了
-  } else {
-    ctx.shanten_normal_min = 0;  // テンパイ
-  }
   ctx.shanten_normal_max = ctx.total_len / MJ_MIN_TILES_LEN_IN_ELEMENT * 2 /*=2点*/;
   ctx.shanten_normal = ctx.shanten_normal_max;
 
@@ -270,3 +251,105 @@ int32_t mj_calc_shanten(const MJHands *hands, MJShanten *shanten) {
 
   return MJ_OK;
 }
+
+int32_t calc_shanten_tiles(const Tiles *tiles, int32_t total_len, int32_t limit) {
+  ShantenCtx ctx;
+  memset(&ctx, 0, sizeof(ctx));
+  memcpy(&ctx.tiles, tiles, sizeof(Tiles));
+  ctx.total_len = total_len;
+  ctx.shanten_normal_max = total_len / MJ_MIN_TILES_LEN_IN_ELEMENT * 2 /*=2点*/;
+  ctx.shanten_normal = ctx.shanten_normal_max;
+
+  int32_t shanten = ctx.shanten_normal_max;
+  if (total_len >= MJ_MIN_TILES_LEN_IN_ELEMENT * MJ_ELEMENTS_LEN + 1) {  // 副露がなければ七対子, 国士無双も見る
+    calc_shanten_kokushi(&ctx);
+    calc_shanten_chiitoitsu(&ctx);
+    shanten = ctx.shanten_kokushi < ctx.shanten_chiitoitsu ? ctx.shanten_kokushi : ctx.shanten_chiitoitsu;
+  }
+  if (shanten <= limit) {
+    return shanten;
+  }
+  calc_shanten_normal(&ctx);
+  return ctx.shanten_normal < shanten ? ctx.shanten_normal : shanten;
+}
+
+/* 七対子, 国士無双のシャンテン数. 数え方は calc_shanten_chiitoitsu, calc_shanten_kokushi と同じ */
+static int32_t calc_split_shanten_special(int32_t kinds, int32_t pairs, int32_t yaochu_kinds, int32_t yaochu_pairs) {
+  int32_t chiitoitsu = 6 - pairs + (kinds < 7 ? 7 - kinds : 0);
+  int32_t kokushi = 13 - (yaochu_kinds + (yaochu_pairs > 0 ? 1 : 0));
+  return chiitoitsu < kokushi ? chiitoitsu : kokushi;
+}
+
+void update_split_shanten(SplitShanten *split, const Tiles *tiles, int32_t total_len) {
+  Bitboard bb;
+  gen_bitboard_from_tiles(&bb, tiles);
+  for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+    if (!split->valid || split->bb.suit[suit] != bb.suit[suit]) {
+      dig_suit(&split->suits[suit], suit, bb.suit[suit]);
+    }
+  }
+  split->bb = bb;
+  split->valid = true;
+  split->total_len = total_len;
+  // others[suit] は使う種類だけ calc_split_shanten で求める. 萬子と筒子の和, 索子と字牌の和から作る
+  split->halves[0] = split->suits[BB_MAN];
+  merge_suit_shanten(&split->halves[0], &split->suits[BB_PIN]);
+  split->halves[1] = split->suits[BB_SOU];
+  merge_suit_shanten(&split->halves[1], &split->suits[BB_HONORS]);
+  split->others_valid = 0;
+
+  split->kinds = 0;
+  split->pairs = 0;
+  split->yaochu_kinds = 0;
+  split->yaochu_pairs = 0;
+  for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+    uint64_t kinds = find_bb_tiles(bb.suit[suit]);
+    uint64_t pairs = find_bb_pairs(bb.suit[suit]);
+    uint64_t yaochu = suit == BB_HONORS ? BB_HONORS_LSB : BB_TERMINAL_LSB;
+    split->kinds += __builtin_popcountll(kinds);
+    split->pairs += __builtin_popcountll(pairs);
+    split->yaochu_kinds += __builtin_popcountll(kinds & yaochu);
+    split->yaochu_pairs += __builtin_popcountll(pairs & yaochu);
+  }
+  INC_STATS(shanten_calls);
+  split->shanten = calc_merged_shanten(&split->halves[0], &split->halves[1], total_len);
+  if (total_len >= MJ_MIN_TILES_LEN_IN_ELEMENT * MJ_ELEMENTS_LEN + 1) {  // 副露がなければ七対子, 国士無双も見る
+    int32_t special =
+        calc_split_shanten_special(split->kinds, split->pairs, split->yaochu_kinds, split->yaochu_pairs);
+    split->shanten = special < split->shanten ? special : split->shanten;
+  }
+}
+
+int32_t calc_split_shanten(SplitShanten *split, MJTileId tile_id, int32_t diff) {
+  INC_STATS(shanten_calls);
+  uint32_t suit = get_bb_suit(tile_id);
+  if ((split->others_valid & (1u << suit)) == 0) {
+    split->others_valid |= 1u << suit;
+    uint32_t half = suit / 2;
+    split->others[suit] = split->halves[1 - half];
+    merge_suit_shanten(&split->others[suit], &split->suits[suit ^ 1]);  // 同じ組のもう1つの種類
+  }
+  uint32_t rank = get_bb_rank(tile_id);
+  uint64_t word = split->bb.suit[suit];
+  uint32_t count = get_bb_count(word, rank);
+  word = diff > 0 ? word + get_bb_rank_bit(rank) : word - get_bb_rank_bit(rank);
+  SuitShanten suit_shanten;
+  dig_suit(&suit_shanten, suit, word);
+  int32_t total_len = split->total_len + diff;
+  int32_t shanten = calc_merged_shanten(&split->others[suit], &suit_shanten, total_len);
+  if (total_len >= MJ_MIN_TILES_LEN_IN_ELEMENT * MJ_ELEMENTS_LEN + 1) {
+    // tile_id の枚数だけが count から count + diff に変わる
+    uint32_t next = (uint32_t)((int32_t)count + diff);
+    int32_t kinds = split->kinds + (next >= 1) - (count >= 1);
+    int32_t pairs = split->pairs + (next >= MJ_PAIR_LEN) - (count >= MJ_PAIR_LEN);
+    int32_t yaochu_kinds = split->yaochu_kinds;
+    int32_t yaochu_pairs = split->yaochu_pairs;
+    if (is_tile_id_yaochu(tile_id)) {
+      yaochu_kinds += (next >= 1) - (count >= 1);
+      yaochu_pairs += (next >= MJ_PAIR_LEN) - (count >= MJ_PAIR_LEN);
+    }
+    int32_t special = calc_split_shanten_special(kinds, pairs, yaochu_kinds, yaochu_pairs);
+    shanten = special < shanten ? special : shanten;
+  }
+  return shanten;
+}
@@ -0,0 +1,319 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "simulate.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "element.h"
+#include "mahjong.h"
+#include "rng.h"
+#include "scheduler.h"
+#include "shanten.h"
+#include "tile.h"
+#include "zobrist.h"
+
+#define ENABLE_DEBUG (0)
+
+typedef struct {
+  const MJSimConfig *config;
+  SimStart starts[MJ_DR + 1];
+  MJTileId discards[MJ_DR + 1];
+  uint32_t starts_len;
+  uint32_t blocks;  // 打牌候補ごとのブロック数
+  uint32_t tasks;   // starts_len * blocks
+  const EvScorer *scorer;
+  atomic_uint tenpai[MJ_DR + 1];
+  atomic_uint win[MJ_DR + 1];
+  atomic_uint_fast64_t tsumo_points[MJ_DR + 1];
+  atomic_uint_fast64_t ron_points[MJ_DR + 1];
+} SimCtx;
+
+/* 小さいほど先に切る. 周りの牌とのつながりが少ない牌を優先し, 同じなら字牌, 1,9牌, 2,8牌の順 */
+static uint32_t get_discard_priority(const Tiles *tiles, MJTileId tile_id) {
+  uint32_t link = (tiles->tiles[tile_id] - 1u) * 4;  // 対子, 刻子
+  if (is_tile_id_honors(tile_id)) {
+    return link * 4;
+  }
+  uint32_t number = get_tile_number(tile_id);
+  for (uint32_t d = 1; d <= 2; d++) {
+    uint32_t weight = d == 1 ? 2 : 1;  // 隣の牌は両面, 1つ飛ばしは嵌張
+    if (number >= TILE_NUM_1 + d) {
+      link += tiles->tiles[tile_id - d] * weight;
+    }
+    if (number + d <= TILE_NUM_9) {
+      link += tiles->tiles[tile_id + d] * weight;
+    }
+  }
+  uint32_t center;
+  if (number == TILE_NUM_1 || number == TILE_NUM_9) {
+    center = 1;
+  } else if (number == TILE_NUM_2 || number == TILE_NUM_8) {
+    center = 2;
+  } else {
+    center = 3;
+  }
+  return link * 4 + center;
+}
+
+MJTileId select_sim_discard(Tiles *tiles, int32_t total_len, int32_t shanten) {
+  MJTileId candidates[MJ_DR + 1];
+  uint32_t priorities[MJ_DR + 1];
+  uint32_t len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (tiles->tiles[i] == 0) {
+      continue;
+    }
+    uint32_t priority = get_discard_priority(tiles, (MJTileId)i);
+    uint32_t j = len++;
+    for (; j > 0 && priorities[j - 1] > priority; j--) {
+      candidates[j] = candidates[j - 1];
+      priorities[j] = priorities[j - 1];
+    }
+    candidates[j] = (MJTileId)i;
+    priorities[j] = priority;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    remove_tile(tiles, candidates[i]);
+    if (calc_shanten_tiles(tiles, total_len - 1, shanten) <= shanten) {
+      return candidates[i];
+    }
+    add_tile(tiles, candidates[i]);
+  }
+  return (MJTileId)(MJ_DR + 1);
+}
+
+void run_sim_sample(const SimStart *start, uint32_t draws, Rng *rng, ShantenCache *cache, SimSample *sample) {
+  Tiles tiles;
+  uint8_t wall[SIM_WALL_LEN];
+  memcpy(&tiles, &start->concealed, sizeof(Tiles));
+  memcpy(wall, start->wall, start->wall_len);
+  uint64_t hash = start->hash;
+  int32_t total_len = start->total_len;
+  ShantenCacheEntry *entry = lookup_shanten_cache(cache, &tiles, hash, total_len);
+  sample->tenpai = entry->shanten <= 0;
+  sample->win = false;
+  if (draws > start->wall_len) {
+    draws = start->wall_len;
+  }
+  for (uint32_t i = 0; i < draws; i++) {
+    // 残りの山から1枚引く(部分的な Fisher-Yates)
+    uint32_t j = i + next_rng_bounded(rng, start->wall_len - i);
+    MJTileId tile_id = wall[j];
+    wall[j] = wall[i];
+    wall[i] = (uint8_t)tile_id;
+    if (!is_shanten_cache_acceptable(entry, &tiles, total_len, tile_id)) {
+      continue;  // ツモ切り
+    }
+    if (entry->shanten == 0) {
+      sample->win = true;
+      sample->win_tile = tile_id;
+      sample->hash = add_zobrist_tile(hash, &tiles, tile_id);
+      memcpy(&sample->tiles, &tiles, sizeof(Tiles));
+      add_tile(&sample->tiles, tile_id);
+      return;
+    }
+    int32_t shanten = entry->shanten - 1;
+    hash = add_zobrist_tile(hash, &tiles, tile_id);
+    add_tile(&tiles, tile_id);
+    MJTileId discard = select_sim_discard(&tiles, total_len + 1, shanten);
+    assert(discard <= MJ_DR);
+    add_tile(&tiles, discard);  // hashの更新には除く前の枚数が要る
+    hash = remove_zobrist_tile(hash, &tiles, discard);
+    remove_tile(&tiles, discard);
+    entry = lookup_shanten_cache(cache, &tiles, hash, total_len);
+    assert(entry->shanten == shanten);
+    if (shanten == 0) {
+      sample->tenpai = true;
+    }
+  }
+}
+
+static void run_sim_task(SimCtx *ctx, ShantenCache *cache, EvScoreCache *score_cache, uint32_t task) {
+  uint32_t index = task / ctx->blocks;
+  uint32_t block = task % ctx->blocks;
+  uint32_t first = block * SIM_BLOCK_SAMPLES;
+  uint32_t len = ctx->config->samples - first;
+  if (len > SIM_BLOCK_SAMPLES) {
+    len = SIM_BLOCK_SAMPLES;
+  }
+  // タスクごとに乱数を初期化するので, どのスレッドで実行しても同じ結果になる
+  uint64_t task_seed = ((uint64_t)ctx->discards[index] << 32) | block;
+  Rng rng;
+  seed_rng(&rng, ctx->config->seed ^ next_splitmix64(&task_seed));
+
+  uint32_t tenpai = 0;
+  uint32_t win = 0;
+  uint64_t tsumo_points = 0;
+  uint64_t ron_points = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    SimSample sample;
+    run_sim_sample(&ctx->starts[index], ctx->config->draws, &rng, cache, &sample);
+    tenpai += sample.tenpai;
+    win += sample.win;
+    if (sample.win && ctx->scorer) {
+      const EvScoreEntry *entry =
+          lookup_ev_score(score_cache, ctx->scorer, &sample.tiles, sample.hash, sample.win_tile);
+      tsumo_points += entry->tsumo;
+      ron_points += entry->ron;
+    }
+  }
+  // 整数の和なので, 足す順番によらず同じ結果になる
+  atomic_fetch_add(&ctx->tenpai[index], tenpai);
+  atomic_fetch_add(&ctx->win[index], win);
+  atomic_fetch_add(&ctx->tsumo_points[index], tsumo_points);
+  atomic_fetch_add(&ctx->ron_points[index], ron_points);
+}
+
+static void sim_worker(void *arg, Scheduler *sched, uint32_t worker) {
+  SimCtx *ctx = (SimCtx *)arg;
+  ShantenCache cache;  // キャッシュは結果に影響しないのでワーカーごとに持つ
+  memset(&cache, 0, sizeof(cache));
+  EvScoreCache score_cache;
+  if (ctx->scorer) {
+    memset(&score_cache, 0, sizeof(score_cache));
+  }
+  uint64_t begin;
+  uint64_t end;
+  while (next_scheduler_range(sched, worker, &begin, &end)) {
+    for (uint64_t task = begin; task < end; task++) {
+      run_sim_task(ctx, &cache, &score_cache, (uint32_t)task);
+    }
+    finish_scheduler_range(sched, begin, end);
+  }
+}
+
+static int32_t init_sim_ctx(SimCtx *ctx, const MJHands *hands, const MJMelds *melds, const MJTiles *visible,
+                            uint64_t discards) {
+  MJPreparedHand hand;
+  int32_t ret = mj_init_hand(&hand, hands, melds);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  int32_t total_len = (int32_t)count_tiles(&hand.concealed);
+  if (total_len % MJ_MIN_TILES_LEN_IN_ELEMENT != 2) {  // ツモ後の手牌
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+
+  // 見えていない牌 = 4 - 手牌 - 副露 - visible
+  Tiles seen;
+  memcpy(&seen, &hand.concealed, sizeof(Tiles));
+  for (uint32_t i = 0; i < hand.melded.len; i++) {
+    const Element *elem = &hand.melded.meld[i];
+    for (uint32_t j = 0; j < elem->len; j++) {
+      add_tile(&seen, elem->tile_id[j]);
+    }
+  }
+  SimStart *start = &ctx->starts[0];
+  start->wall_len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    uint32_t count = seen.tiles[i] + (visible ? (uint32_t)visible->tiles[i] : 0);
+    if (count > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    for (; count < MJ_MAX_TILES_LEN_IN_ELEMENT; count++) {
+      start->wall[start->wall_len++] = (uint8_t)i;
+    }
+  }
+
+  ctx->starts_len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (hand.concealed.tiles[i] == 0 || (discards & (1ull << i)) == 0) {
+      continue;
+    }
+    start = &ctx->starts[ctx->starts_len];
+    if (ctx->starts_len > 0) {
+      memcpy(start->wall, ctx->starts[0].wall, ctx->starts[0].wall_len);
+      start->wall_len = ctx->starts[0].wall_len;
+    }
+    memcpy(&start->concealed, &hand.concealed, sizeof(Tiles));
+    remove_tile(&start->concealed, (MJTileId)i);
+    start->total_len = total_len - 1;
+    start->hash = hash_tiles(&start->concealed);
+    start->shanten = calc_shanten_tiles(&start->concealed, start->total_len, -1);
+    ctx->discards[ctx->starts_len] = (MJTileId)i;
+    ctx->starts_len++;
+  }
+  return MJ_OK;
+}
+
+int32_t simulate_discards(MJSimResult *results, SimPoints *points, uint32_t *len, const MJHands *hands,
+                          const MJMelds *melds, const MJTiles *visible, const MJSimConfig *config, uint64_t discards,
+                          const EvScorer *scorer) {
+  if (config->threads > MJ_SIM_MAX_THREADS) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  SimCtx ctx;
+  int32_t ret = init_sim_ctx(&ctx, hands, melds, visible, discards);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  ctx.config = config;
+  ctx.scorer = scorer;
+  ctx.blocks = (config->samples + SIM_BLOCK_SAMPLES - 1) / SIM_BLOCK_SAMPLES;
+  ctx.tasks = ctx.starts_len * ctx.blocks;
+  for (uint32_t i = 0; i < ctx.starts_len; i++) {
+    atomic_init(&ctx.tenpai[i], 0);
+    atomic_init(&ctx.win[i], 0);
+    atomic_init(&ctx.tsumo_points[i], 0);
+    atomic_init(&ctx.ron_points[i], 0);
+  }
+
+  if (ctx.tasks > 0) {
+    uint32_t workers = config->threads == 0 ? 1 : config->threads;
+    Scheduler sched;
+    init_scheduler(&sched, ctx.tasks, workers < ctx.tasks ? workers : ctx.tasks, 1);
+    run_scheduler(&sched, sim_worker, &ctx);
+  }
+
+  for (uint32_t i = 0; i < ctx.starts_len; i++) {
+    MJSimResult *result = &results[i];
+    result->discard = ctx.discards[i];
+    result->shanten = ctx.starts[i].shanten;
+    result->samples = config->samples;
+    result->tenpai = atomic_load(&ctx.tenpai[i]);
+    result->win = atomic_load(&ctx.win[i]);
+    result->tenpai_rate = config->samples ? (double)result->tenpai / config->samples : 0.0;
+    result->win_rate = config->samples ? (double)result->win / config->samples : 0.0;
+    if (points) {
+      points[i].tsumo = atomic_load(&ctx.tsumo_points[i]);
+      points[i].ron = atomic_load(&ctx.ron_points[i]);
+    }
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+    fprintf(stderr, "%s: shanten %d, tenpai %f, win %f\n", tile_id_str(result->discard), result->shanten,
+            result->tenpai_rate, result->win_rate);
+#endif
+  }
+  *len = ctx.starts_len;
+  return MJ_OK;
+}
+
+int32_t mj_simulate_discards(MJSimResult *results, uint32_t *len, const MJHands *hands, const MJMelds *melds,
+                             const MJTiles *visible, const MJSimConfig *config) {
+  return simulate_discards(results, NULL, len, hands, melds, visible, config, UINT64_MAX, NULL);
+}
@@ -0,0 +1,45 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "stats.h"
+
+#if defined(MJ_ENABLE_STATS)
+_Thread_local MJStats thread_stats;
+#endif  // defined(MJ_ENABLE_STATS)
+
+int32_t mj_get_stats(MJStats *stats) {
+#if defined(MJ_ENABLE_STATS)
+  *stats = thread_stats;
+  return MJ_OK;
+#else
+  memset(stats, 0, sizeof(MJStats));
+  return MJ_ERR_NOT_SUPPORTED;
+#endif  // defined(MJ_ENABLE_STATS)
+}
+
+void mj_reset_stats() {
+#if defined(MJ_ENABLE_STATS)
+  memset(&thread_stats, 0, sizeof(MJStats));
+#endif  // defined(MJ_ENABLE_STATS)
+}
@@ -36,65 +36,6 @@ static const char tile_id_to_str[][3] = {
     "p9", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "wt", "wn", "ws", "wp", "dw", "dg", "dr",
 };
 
-bool is_tile_id_valid(MJTileId tile_id) { return (tile_id >= MJ_M1 && tile_id <= MJ_DR); }
-
-bool is_tile_id_honors(MJTileId tile_id) { return (tile_id >= MJ_WT && tile_id <= MJ_DR); }
-
-bool is_tile_id_wind(MJTileId tile_id) { return (tile_id >= MJ_WT && tile_id <= MJ_WP); }
-
-bool is_tile_id_dragon(MJTileId tile_id) { return (tile_id >= MJ_DW && tile_id <= MJ_DR); }
-
-bool is_tile_id_man(MJTileId tile_id) { return (tile_id >= MJ_M1 && tile_id <= MJ_M9); }
-
-bool is_tile_id_pin(MJTileId tile_id) { return (tile_id >= MJ_P1 && tile_id <= MJ_P9); }
-
-bool is_tile_id_sou(MJTileId tile_id) { return (tile_id >= MJ_S1 && tile_id <= MJ_S9); }
-
-bool is_tile_id_yaochu(MJTileId tile_id) {
-  if (is_tile_id_honors(tile_id)) {
-    return true;
-  }
-  uint32_t number = get_tile_number(tile_id);
-  if (number == TILE_NUM_1 || number == TILE_NUM_9) {
-    return true;
-  }
-  return false;
-}
-
-bool is_tile_id_routou(MJTileId tile_id) {
-  if (is_tile_id_honors(tile_id)) {
-    return false;
-  }
-  uint32_t number = get_tile_number(tile_id);
-  if (number == TILE_NUM_1 || number == TILE_NUM_9) {
-    return true;
-  }
-  return false;
-}
-
-uint32_t get_tile_type(MJTileId tile_id) {
-  if (0) {
-  } else if (is_tile_id_man(tile_id)) {
-    return TILE_TYPE_MAN;
-  } else if (is_tile_id_pin(tile_id)) {
-    return TILE_TYPE_PIN;
-  } else if (is_tile_id_sou(tile_id)) {
-    return TILE_TYPE_SOU;
-  } else if (is_tile_id_wind(tile_id)) {
-    return TILE_TYPE_WIND;
-  } else if (is_tile_id_dragon(tile_id)) {
-    return TILE_TYPE_DRAGON;
-  }
-  return TILE_TYPE_INVALID;
-}
-
-uint32_t get_tile_number(MJTileId tile_id) {
-  if (is_tile_id_man(tile_id) || is_tile_id_pin(tile_id) || is_tile_id_sou(tile_id)) {
-    return tile_id % 9;
-  }
-  return -1u;
-}
-
 bool gen_tiles_from_hands(Tiles *tiles, const MJHands *hands) {
   memset(tiles, 0, sizeof(Tiles));
   for (uint32_t i = 0; i < hands->len; i++) {
@@ -107,4 +48,17 @@ bool gen_tiles_from_hands(Tiles *tiles, const MJHands *hands) {
   return true;
 }
 
+void gen_mj_tiles_from_tiles(MJTiles *mj_tiles, const Tiles *tiles) {
+  for (uint32_t i = 0; i <= MJ_DR; i++) {
+    mj_tiles->tiles[i] = tiles->tiles[i];
+  }
+}
+
+void gen_tiles_from_mj_tiles(Tiles *tiles, const MJTiles *mj_tiles) {
+  memset(tiles, 0, sizeof(Tiles));
+  for (uint32_t i = 0; i <= MJ_DR; i++) {
+    tiles->tiles[i] = (uint8_t)mj_tiles->tiles[i];
+  }
+}
+
 const char *tile_id_str(MJTileId tile_id) { return tile_id_to_str[tile_id]; }
@@ -35,22 +35,17 @@
 // 3. 選択したシャンテン数を減らす牌を列挙
 
 static void reset_shanten_normal(ShantenCtx *ctx) {
-  if (ctx->total_len % MJ_MIN_TILES_LEN_IN_ELEMENT == 2) {
-    ctx->shanten_normal_min = -1;  // 和了
-  } else {
-    ctx->shanten_normal_min = 0;  // テンパイ
-  }
   ctx->shanten_normal_max = ctx->total_len / MJ_MIN_TILES_LEN_IN_ELEMENT * 2 /*=2点*/;
   ctx->shanten_normal = ctx->shanten_normal_max;
 }
 
 static void incr_tile(ShantenCtx *ctx, MJTileId tile) {
-  ctx->tiles.tiles[tile]++;
+  add_tile(&ctx->tiles, tile);
   ctx->total_len++;
 }
 
 static void decr_tile(ShantenCtx *ctx, MJTileId tile) {
-  ctx->tiles.tiles[tile]--;
+  remove_tile(&ctx->tiles, tile);
   ctx->total_len--;
 }
 
@@ -178,13 +173,96 @@ void gen_acceptable_normal(ShantenCtx *ctx, Tiles *acceptables) {
   }
 }
 
+/* 1枚加えてシャンテン数が減る可能性がある牌. 手牌のどの牌とも面子, 塔子にならない牌は通常手のシャンテン数を減らさない */
+static bool is_acceptable_candidate(const Tiles *tiles, int32_t total_len, uint32_t kind, MJTileId tile_id) {
+  if (tiles->tiles[tile_id] >= MJ_MAX_TILES_LEN_IN_ELEMENT) {
+    return false;
+  }
+  if (tiles->tiles[tile_id]) {
+    return true;
+  }
+  if (total_len >= MJ_MIN_TILES_LEN_IN_ELEMENT * MJ_ELEMENTS_LEN) {
+    // 七対子は7種類未満なら新しい牌で, 国士無双は么九牌で減る
+    if (kind < 7 || is_tile_id_yaochu(tile_id)) {
+      return true;
+    }
+  }
+  if (is_tile_id_honors(tile_id)) {
+    return false;
+  }
+  uint32_t number = get_tile_number(tile_id);
+  for (uint32_t d = 1; d <= 2; d++) {
+    if (number >= TILE_NUM_1 + d && tiles->tiles[tile_id - d]) {
+      return true;
+    }
+    if (number + d <= TILE_NUM_9 && tiles->tiles[tile_id + d]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t gen_acceptable_mask(Tiles *tiles, int32_t total_len, int32_t shanten) {
+  uint32_t kind = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    kind += tiles->tiles[i] != 0;
+  }
+  uint64_t acceptables = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (!is_acceptable_candidate(tiles, total_len, kind, (MJTileId)i)) {
+      continue;
+    }
+    add_tile(tiles, (MJTileId)i);
+    if (calc_shanten_tiles(tiles, total_len + 1, shanten - 1) < shanten) {
+      acceptables |= 1ull << i;
+    }
+    remove_tile(tiles, (MJTileId)i);
+  }
+  return acceptables;
+}
+
+ShantenCacheEntry *lookup_shanten_cache(ShantenCache *cache, const Tiles *tiles, uint64_t hash, int32_t total_len) {
+  ShantenCacheEntry *entry = &cache->entries[hash & (SHANTEN_CACHE_LEN - 1)];
+  if (entry->valid && entry->hash == hash) {
+    return entry;
+  }
+  entry->hash = hash;
+  entry->valid = true;
+  entry->shanten = calc_shanten_tiles(tiles, total_len, -1);
+  // 有効牌は全て求めると34回シャンテン数を計算するので, ツモった牌の分だけ後で求める
+  entry->acceptables = 0;
+  entry->checked = 0;
+  return entry;
+}
+
+bool is_shanten_cache_acceptable(ShantenCacheEntry *entry, Tiles *tiles, int32_t total_len, MJTileId tile_id) {
+  uint64_t bit = 1ull << tile_id;
+  if ((entry->checked & bit) == 0) {
+    entry->checked |= bit;
+    uint32_t kind = 0;
+    for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+      kind += tiles->tiles[i] != 0;
+    }
+    if (is_acceptable_candidate(tiles, total_len, kind, tile_id)) {
+      add_tile(tiles, tile_id);
+      if (calc_shanten_tiles(tiles, total_len + 1, entry->shanten - 1) < entry->shanten) {
+        entry->acceptables |= bit;
+      }
+      remove_tile(tiles, tile_id);
+    }
+  }
+  return (entry->acceptables & bit) != 0;
+}
+
 int32_t mj_ukeire_kokushi(const MJHands *hands, MJTiles *acceptables) {
   ShantenCtx ctx;
   int32_t ret = init_ctx(&ctx, hands);
   if (ret != MJ_OK) {
     return ret;
   }
-  gen_acceptable_kokushi(&ctx, acceptables);
+  Tiles _acceptables;
+  gen_acceptable_kokushi(&ctx, &_acceptables);
+  gen_mj_tiles_from_tiles(acceptables, &_acceptables);
   return MJ_OK;
 }
 
@@ -194,7 +272,9 @@ int32_t mj_ukeire_chiitoitsu(const MJHands *hands, MJTiles *acceptables) {
   if (ret != MJ_OK) {
     return ret;
   }
-  gen_acceptable_chiitoitsu(&ctx, acceptables);
+  Tiles _acceptables;
+  gen_acceptable_chiitoitsu(&ctx, &_acceptables);
+  gen_mj_tiles_from_tiles(acceptables, &_acceptables);
   return MJ_OK;
 }
 
@@ -205,6 +285,8 @@ int32_t mj_ukeire_normal(const MJHands *hands, MJTiles *acceptables) {
   if (ret != MJ_OK) {
     return ret;
   }
-  gen_acceptable_normal(&ctx, acceptables);
+  Tiles _acceptables;
+  gen_acceptable_normal(&ctx, &_acceptables);
+  gen_mj_tiles_from_tiles(acceptables, &_acceptables);
   return MJ_OK;
 }
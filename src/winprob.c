@@ -0,0 +1,272 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "winprob.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "element.h"
+#include "mahjong.h"
+#include "shanten.h"
+#include "tile.h"
+#include "ukeire.h"
+#include "zobrist.h"
+
+#define ENABLE_DEBUG (0)
+
+/* 1向聴の手牌の探索に使う情報. 有効牌ごとに, 聴牌に取れる打牌それぞれの待ちを持つ */
+typedef struct {
+  uint64_t hand_hash;
+  uint64_t acceptables;                  // 1向聴の有効牌
+  uint64_t relevants;                    // 有効牌と聴牌後の待ち牌. 山の状態で種類を区別する牌
+  uint64_t waits[MJ_DR + 1][MJ_DR + 1];  // [有効牌][i]: 有効牌をツモって聴牌に取ったときの待ち
+  uint32_t waits_len[MJ_DR + 1];
+  MJWinProbTable *table;
+} WinProbCtx;
+
+double calc_tenpai_win_rate(const WinProbPool *pool, uint64_t waits, uint32_t draws) {
+  uint32_t hits = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (waits & (1ull << i)) {
+      hits += pool->tiles.tiles[i];
+    }
+  }
+  if (draws > pool->total) {
+    draws = pool->total;
+  }
+  // 1 - (待ち牌を1枚も引かない確率)
+  double miss = 1.0;
+  for (uint32_t i = 0; i < draws; i++) {
+    if (pool->total - i <= hits) {
+      return 1.0;
+    }
+    miss *= (double)(pool->total - hits - i) / (double)(pool->total - i);
+  }
+  return 1.0 - miss;
+}
+
+static void remove_pool_tile(WinProbPool *pool, MJTileId tile_id) {
+  pool->tiles.tiles[tile_id]--;
+  pool->hash ^= get_zobrist_pool_key(tile_id, pool->tiles.tiles[tile_id]);
+  pool->total--;
+}
+
+static void add_pool_tile(WinProbPool *pool, MJTileId tile_id) {
+  pool->hash ^= get_zobrist_pool_key(tile_id, pool->tiles.tiles[tile_id]);
+  pool->tiles.tiles[tile_id]++;
+  pool->total++;
+}
+
+static double calc_iishanten_win_rate(WinProbCtx *ctx, WinProbPool *pool, uint32_t draws) {
+  if (draws < 2 || pool->total == 0) {  // 聴牌してからアガるまでに2回ツモが要る
+    return 0.0;
+  }
+  uint64_t key = ctx->hand_hash ^ pool->hash ^ get_zobrist_counter_key(((uint64_t)pool->total << 32) | draws);
+  key |= 1;  // 0は空きエントリ
+  MJWinProbEntry *entry = &ctx->table->entries[key & (MJ_WIN_PROB_TABLE_LEN - 1)];
+  if (entry->key == key) {
+    return entry->prob;
+  }
+
+  double prob = 0.0;
+  uint32_t total = pool->total;
+  uint32_t relevant = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    uint32_t count = pool->tiles.tiles[i];
+    if (count == 0) {
+      continue;
+    }
+    relevant += count;
+    remove_pool_tile(pool, (MJTileId)i);
+    double rate = 0.0;
+    if (ctx->acceptables & (1ull << i)) {
+      // 聴牌に取る打牌のうちアガリ確率が最大のもの
+      for (uint32_t j = 0; j < ctx->waits_len[i]; j++) {
+        double r = calc_tenpai_win_rate(pool, ctx->waits[i][j], draws - 1);
+        if (r > rate) {
+          rate = r;
+        }
+      }
+    } else {
+      rate = calc_iishanten_win_rate(ctx, pool, draws - 1);  // ツモ切り
+    }
+    add_pool_tile(pool, (MJTileId)i);
+    prob += rate * count / total;
+  }
+  if (total > relevant) {  // 関わらない牌はどれをツモってもツモ切りで同じ状態になる
+    pool->total--;
+    prob += calc_iishanten_win_rate(ctx, pool, draws - 1) * (total - relevant) / total;
+    pool->total++;
+  }
+
+  entry->key = key;
+  entry->prob = prob;
+  return prob;
+}
+
+/* 1向聴の tiles (total_len 枚) について有効牌ごとの聴牌の待ちを求める */
+static void init_win_prob_ctx(WinProbCtx *ctx, Tiles *tiles, int32_t total_len, uint64_t acceptables) {
+  ctx->acceptables = acceptables;
+  ctx->relevants = acceptables;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    ctx->waits_len[i] = 0;
+    if ((acceptables & (1ull << i)) == 0) {
+      continue;
+    }
+    add_tile(tiles, (MJTileId)i);
+    for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+      if (tiles->tiles[j] == 0) {
+        continue;
+      }
+      remove_tile(tiles, (MJTileId)j);
+      if (calc_shanten_tiles(tiles, total_len, 0) == 0) {
+        uint64_t waits = gen_acceptable_mask(tiles, total_len, 0);
+        bool found = false;
+        for (uint32_t k = 0; k < ctx->waits_len[i]; k++) {
+          found |= ctx->waits[i][k] == waits;
+        }
+        if (!found) {
+          ctx->waits[i][ctx->waits_len[i]++] = waits;
+          ctx->relevants |= waits;
+        }
+      }
+      add_tile(tiles, (MJTileId)j);
+    }
+    remove_tile(tiles, (MJTileId)i);
+  }
+}
+
+/* concealed (3n+1枚) と unseen からアガリ確率を求める. 2向聴以上で計算できない場合は false */
+static bool calc_win_rate(double *prob, int32_t *shanten, Tiles *concealed, int32_t total_len, const Tiles *unseen,
+                          uint32_t draws, MJWinProbTable *table) {
+  *shanten = calc_shanten_tiles(concealed, total_len, -1);
+  if (*shanten >= 2) {
+    *prob = 0.0;
+    return (uint32_t)*shanten + 1 > draws;  // 間に合わない
+  }
+  uint64_t acceptables = gen_acceptable_mask(concealed, total_len, *shanten);
+
+  WinProbCtx ctx;
+  uint64_t relevants = acceptables;
+  if (*shanten == 1) {
+    init_win_prob_ctx(&ctx, concealed, total_len, acceptables);
+    ctx.hand_hash = hash_tiles(concealed);
+    ctx.table = table;
+    relevants = ctx.relevants;
+  }
+  WinProbPool pool;
+  memset(&pool, 0, sizeof(pool));
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    pool.total += unseen->tiles[i];
+    if (relevants & (1ull << i)) {
+      for (uint32_t j = 0; j < unseen->tiles[i]; j++) {
+        pool.hash ^= get_zobrist_pool_key((MJTileId)i, j);
+      }
+      pool.tiles.tiles[i] = unseen->tiles[i];
+    }
+  }
+  if (*shanten == 0) {
+    *prob = calc_tenpai_win_rate(&pool, acceptables, draws);
+  } else {
+    *prob = calc_iishanten_win_rate(&ctx, &pool, draws);
+  }
+#if defined(ENABLE_DEBUG) && (ENABLE_DEBUG >= 1)
+  fprintf(stderr, "shanten %d, draws %u, total %u, prob %f\n", *shanten, draws, pool.total, *prob);
+#endif
+  return true;
+}
+
+static int32_t init_win_prob(Tiles *concealed, int32_t *total_len, Tiles *unseen, const MJHands *hands,
+                             const MJMelds *melds, const MJTiles *mj_unseen) {
+  MJPreparedHand hand;
+  int32_t ret = mj_init_hand(&hand, hands, melds);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  memcpy(concealed, &hand.concealed, sizeof(Tiles));
+  *total_len = (int32_t)count_tiles(concealed);
+
+  Tiles own;
+  gen_tiles_from_hands(&own, hands);  // mj_init_hand で検証済み
+  memset(unseen, 0, sizeof(Tiles));
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if ((uint32_t)mj_unseen->tiles[i] + own.tiles[i] > MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      return MJ_ERR_ILLEGAL_PARAM;
+    }
+    unseen->tiles[i] = (uint8_t)mj_unseen->tiles[i];
+  }
+  return MJ_OK;
+}
+
+void mj_init_win_prob_table(MJWinProbTable *table) { memset(table, 0, sizeof(MJWinProbTable)); }
+
+int32_t mj_win_probability(double *prob, const MJHands *hands, const MJMelds *melds, const MJTiles *unseen,
+                           uint32_t draws, MJWinProbTable *table) {
+  Tiles concealed;
+  Tiles _unseen;
+  int32_t total_len;
+  int32_t ret = init_win_prob(&concealed, &total_len, &_unseen, hands, melds, unseen);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  if (total_len % MJ_MIN_TILES_LEN_IN_ELEMENT != 1) {  // 打牌後の手牌
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  int32_t shanten;
+  if (!calc_win_rate(prob, &shanten, &concealed, total_len, &_unseen, draws, table)) {
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  return MJ_OK;
+}
+
+int32_t mj_win_probability_discards(MJWinProbResult *results, uint32_t *len, const MJHands *hands,
+                                    const MJMelds *melds, const MJTiles *unseen, uint32_t draws,
+                                    MJWinProbTable *table) {
+  Tiles concealed;
+  Tiles _unseen;
+  int32_t total_len;
+  int32_t ret = init_win_prob(&concealed, &total_len, &_unseen, hands, melds, unseen);
+  if (ret != MJ_OK) {
+    return ret;
+  }
+  if (total_len % MJ_MIN_TILES_LEN_IN_ELEMENT != 2) {  // ツモ後の手牌
+    return MJ_ERR_ILLEGAL_PARAM;
+  }
+  *len = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    if (concealed.tiles[i] == 0) {
+      continue;
+    }
+    MJWinProbResult *result = &results[(*len)++];
+    remove_tile(&concealed, (MJTileId)i);
+    result->discard = (MJTileId)i;
+    result->evaluated =
+        calc_win_rate(&result->win_rate, &result->shanten, &concealed, total_len - 1, &_unseen, draws, table);
+    add_tile(&concealed, (MJTileId)i);
+  }
+  return MJ_OK;
+}
@@ -53,6 +53,13 @@
  */
 int is_pinfu(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
              const ScoreConfig *cfg) {
+  Machi machi;
+  gen_machi(&machi, concealed_elems, pair_tile, cfg->win_tile);
+  return is_pinfu_with_machi(concealed_elems, melded_elems, pair_tile, cfg, &machi);
+}
+
+int is_pinfu_with_machi(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
+                        const ScoreConfig *cfg, const Machi *machi) {
   if (melded_elems->len) {
     return false;
   }
@@ -65,7 +72,7 @@ int is_pinfu(const Elements *concealed_elems, const Elements *melded_elems, MJTi
   if (count_elements_sequence(concealed_elems) != MJ_ELEMENTS_LEN) {
     return false;
   }
-  if (!is_ryanmen_machi(concealed_elems, cfg->win_tile)) {
+  if (!machi->ryanmen) {
     return false;
   }
   return true;
@@ -209,16 +216,22 @@ int is_toitoi(const Elements *concealed_elems, const Elements *melded_elems, MJT
 /* 三暗刻: 門前: 不要, 説明: 暗刻を3つ構成 */
 int is_sanankou(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
                 const ScoreConfig *cfg) {
+  Machi machi;
+  gen_machi(&machi, concealed_elems, pair_tile, cfg->win_tile);
+  return is_sanankou_with_machi(concealed_elems, melded_elems, pair_tile, cfg, &machi);
+}
+
+int is_sanankou_with_machi(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
+                           const ScoreConfig *cfg, const Machi *machi) {
   (void)pair_tile;
-  (void)cfg;
   uint32_t count = 0;
   count += count_elements_concealed_fours(melded_elems);
   count += count_elements_triplets(concealed_elems);
   if (count < 3) {
     return false;
   }
-  /* 刻子が3枚 && ロンアガリ && シャンポン待ち => 三暗刻不成立 */
-  if (count == 3 && cfg->ron && is_shanpon_machi(concealed_elems, cfg->win_tile)) {
+  /* 刻子が3枚 && ロンアガリ && シャンポン待ちとしか解釈できない => 三暗刻不成立 */
+  if (count == 3 && is_machi_ron_triplets(machi, cfg->ron)) {
     return false;
   }
   return true;
@@ -286,7 +299,7 @@ int is_shosangen(const Elements *concealed_elems, const Elements *melded_elems,
     return false;
   }
   /* もし刻子が白撥中のどれか2つでできていたら, 雀頭は刻子で構成された白撥中と別の牌で構成される */
-  if (pair_tile != MJ_DW && pair_tile != MJ_DG && pair_tile != MJ_DR) {
+  if (!is_tile_id_dragon(pair_tile)) {
     return false;
   }
   return true;
@@ -622,6 +635,13 @@ int is_kokushi(const Tiles *tiles) {
 /* 四暗刻: 門前: 必要, 説明: 面子を暗刻(暗槓含む)で構成. 注意: ロンアガリで面子が揃う場合は明刻扱い. */
 int is_suuankou(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
                 const ScoreConfig *cfg) {
+  Machi machi;
+  gen_machi(&machi, concealed_elems, pair_tile, cfg->win_tile);
+  return is_suuankou_with_machi(concealed_elems, melded_elems, pair_tile, cfg, &machi);
+}
+
+int is_suuankou_with_machi(const Elements *concealed_elems, const Elements *melded_elems, MJTileId pair_tile,
+                           const ScoreConfig *cfg, const Machi *machi) {
   (void)pair_tile;
   uint32_t count = 0;
   count += count_elements_concealed_fours(melded_elems);
@@ -629,8 +649,8 @@ int is_suuankou(const Elements *concealed_elems, const Elements *melded_elems, M
   if (count < 4) {
     return false;
   }
-  /* 刻子が4枚 && ロンアガリ && シャンポン待ち => 四暗刻不成立 */
-  if (count == 4 && cfg->ron && is_shanpon_machi(concealed_elems, cfg->win_tile)) {
+  /* 刻子が4枚 && ロンアガリ && シャンポン待ちとしか解釈できない => 四暗刻不成立 */
+  if (count == 4 && is_machi_ron_triplets(machi, cfg->ron)) {
     return false;
   }
   return true;
@@ -660,17 +680,11 @@ int is_ryuisou(const Elements *concealed_elems, const Elements *melded_elems, MJ
   for (uint32_t i = 0; i < merged_elems.len; i++) {
     const Element *elem = &merged_elems.meld[i];
     MJTileId tile_id = elem->tile_id[0];
-    if (is_element_sequence(elem) && tile_id != MJ_S2) {
+    if (is_element_sequence(elem) ? tile_id != MJ_S2 : !is_tile_id_green(tile_id)) {  // 順子は234だけ
       return false;
-    } else {
-      if (tile_id != MJ_S2 && tile_id != MJ_S3 && tile_id != MJ_S4 && tile_id != MJ_S6 && tile_id != MJ_S8 &&
-          tile_id != MJ_DG) {
-        return false;
-      }
     }
   }
-  if (pair_tile != MJ_S2 && pair_tile != MJ_S3 && pair_tile != MJ_S4 && pair_tile != MJ_S6 && pair_tile != MJ_S8 &&
-      pair_tile != MJ_DG) {
+  if (!is_tile_id_green(pair_tile)) {
     return false;
   }
   return true;
@@ -0,0 +1,76 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2023 otamajakusi
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "zobrist.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "element.h"
+#include "mahjong.h"
+#include "tile.h"
+
+uint64_t hash_tiles(const Tiles *tiles) {
+  uint64_t hash = 0;
+  for (uint32_t i = 0; i <= MJ_DR; i++) {
+    for (uint32_t copy = 0; copy < tiles->tiles[i]; copy++) {
+      hash ^= get_zobrist_tile_key((MJTileId)i, copy);
+    }
+  }
+  return hash;
+}
+
+static uint32_t count_same_elements(const Elements *elems, ElementCode code) {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < elems->len; i++) {
+    if (gen_element_code(&elems->meld[i]) == code) {
+      count++;
+    }
+  }
+  return count;
+}
+
+uint64_t hash_elements(const Elements *elems) {
+  uint64_t hash = 0;
+  Elements prev = {.len = 0};
+  for (uint32_t i = 0; i < elems->len; i++) {
+    hash = add_zobrist_element(hash, &prev, &elems->meld[i]);
+    prev.meld[prev.len++] = elems->meld[i];
+  }
+  return hash;
+}
+
+uint64_t add_zobrist_element(uint64_t hash, const Elements *elems, const Element *elem) {
+  ElementCode code = gen_element_code(elem);
+  return hash ^ get_zobrist_element_key(code, count_same_elements(elems, code));
+}
+
+uint64_t remove_zobrist_element(uint64_t hash, const Elements *elems, const Element *elem) {
+  ElementCode code = gen_element_code(elem);
+  uint32_t count = count_same_elements(elems, code);
+  assert(count > 0);
+  return hash ^ get_zobrist_element_key(code, count - 1);
+}
@@ -6,6 +6,7 @@
 
 bool test() {
   test_tile();
+  test_bitboard();
   test_meld();
   test_hand();
   test_element();
@@ -13,6 +14,20 @@ bool test() {
   test_agari();
   test_mahjong();
   test_shanten();
+  test_zobrist();
+  test_simulate();
+  test_winprob();
+  test_game();
+  test_scheduler();
+  test_ev();
+  test_enumerate();
+  test_mjlog();
+  test_record();
+  test_notation();
+  test_server();
+  test_ring();
+  test_stats();
+  test_query();
   return true;
 }
 
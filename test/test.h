@@ -1,10 +1,25 @@
 #pragma once
 #include "test_agari.h"
+#include "test_bitboard.h"
 #include "test_element.h"
+#include "test_enumerate.h"
+#include "test_ev.h"
+#include "test_game.h"
 #include "test_hand.h"
 #include "test_mahjong.h"
 #include "test_meld.h"
+#include "test_mjlog.h"
+#include "test_query.h"
+#include "test_notation.h"
+#include "test_record.h"
+#include "test_ring.h"
+#include "test_stats.h"
+#include "test_scheduler.h"
 #include "test_score.h"
+#include "test_server.h"
 #include "test_tile.h"
 #include "test_shanten.h"
+#include "test_simulate.h"
 #include "test_ukeire.h"
+#include "test_winprob.h"
+#include "test_zobrist.h"
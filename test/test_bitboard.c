@@ -0,0 +1,59 @@
+#include "test_bitboard.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "test_util.h"
+
+static void test_gen_bitboard_from_tiles() {
+  MJHands hands = {{m1, m2, m3, m3, p9, p9, p9, p9, s5, s6, wt, dr, dr, dr}, 14};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  Bitboard bb;
+  gen_bitboard_from_tiles(&bb, &tiles);
+  assert(bb.suit[BB_MAN] == 0x000000211ull);
+  assert(bb.suit[BB_PIN] == 0x400000000ull);
+  assert(bb.suit[BB_SOU] == 0x000110000ull);
+  assert(bb.suit[BB_HONORS] == 0x3000001ull);
+  assert(get_bb_tile_id(BB_HONORS, 6) == (MJTileId)dr);
+  assert(get_bb_suit(s5) == BB_SOU && get_bb_rank(s5) == 4);
+}
+
+static void test_find_bb() {
+  /* 1 22 3 444 5 . . . 9 (ランクごとの枚数は下位の4 bitから 1,2,1,3,1,0,0,0,1) */
+  uint64_t word = 0x100013121ull;
+  assert(get_bb_count(word, 0) == 1 && get_bb_count(word, 2) == 1 && get_bb_count(word, 3) == 3);
+  assert(find_bb_tiles(word) == 0x100011111ull);
+  assert(find_bb_pairs(word) == 0x000001010ull);
+  assert(find_bb_triplets(word) == 0x000001000ull);
+  assert(find_bb_sequences(word) == 0x000000111ull);
+  assert(find_bb_adjacents(word) == 0x000001111ull);
+  assert(find_bb_gaps(word) == 0x000000111ull);
+  assert(find_bb_triplets(0x4ull) == 0x1ull);  // 4枚
+  assert(find_bb_pairs(0x4ull) == 0x1ull);
+  assert(find_bb_sequences(0x111000000ull) == 0x001000000ull);  // 789
+  assert(find_bb_sequences(0x110000001ull) == 0);                // 1,89は順子にならない
+  assert(find_bb_adjacents(0x110000000ull) == 0x010000000ull);  // 89
+  assert(get_bb_lowest_rank(find_bb_tiles(0x10100000ull)) == 5);
+}
+
+static void test_remove_bb_block() {
+  uint64_t word = 0x000013121ull;
+  word = remove_bb_block(word, 0, BB_BLOCK_SEQUENCE);
+  assert(word == 0x000013010ull);
+  word = remove_bb_block(word, 3, BB_BLOCK_TRIPLETS);
+  assert(word == 0x000010010ull);
+  word = add_bb_block(word, 3, BB_BLOCK_TRIPLETS);
+  word = add_bb_block(word, 0, BB_BLOCK_SEQUENCE);
+  assert(word == 0x000013121ull);
+  assert(remove_bb_block(0x2ull, 0, BB_BLOCK_PAIR) == 0);
+  assert(remove_bb_block(0x101ull, 0, BB_BLOCK_GAP) == 0);
+  assert(remove_bb_block(0x110ull, 1, BB_BLOCK_ADJACENT) == 0);
+}
+
+bool test_bitboard() {
+  test_gen_bitboard_from_tiles();
+  test_find_bb();
+  test_remove_bb_block();
+  return true;
+}
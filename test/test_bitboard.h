@@ -0,0 +1,5 @@
+#pragma once
+
+#include "bitboard.h"
+
+bool test_bitboard();
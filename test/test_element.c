@@ -47,6 +47,36 @@ void test_gen_elements_from_melds() {
   assert(!gen_elements_from_melds(&act, &melds3));
 }
 
+void test_gen_elements_code() {
+  Element elem1 = {{wt, wt, wt, wt}, 4, true, ELEM_TYPE_FOURS};
+  ElementCode code = gen_element_code(&elem1);
+  assert(get_element_code_tile_id(code) == (MJTileId)wt);
+  assert(get_element_code_type(code) == ELEM_TYPE_FOURS);
+  assert(is_element_code_concealed(code));
+
+  MJMelds melds1 = {{
+                        {{p7, p8, p9}, 3, false, xx},
+                        {{m1, m2, m3}, 3, true, xx},
+                        {{dr, dr, dr}, 3, false, xx},
+                    },
+                    3};
+  MJMelds melds2 = {{
+                        {{dr, dr, dr}, 3, false, xx},
+                        {{m3, m1, m2}, 3, true, xx},
+                        {{p9, p8, p7}, 3, false, xx},
+                    },
+                    3};
+  Elements e1;
+  Elements e2;
+  assert(gen_elements_from_melds(&e1, &melds1));
+  assert(gen_elements_from_melds(&e2, &melds2));
+  ElementsCode code1 = gen_elements_code(&e1);
+  assert(code1 == gen_elements_code(&e2));
+  assert((code1 >> (3 * ELEM_CODE_BITS)) == 0);  // 空き
+  e2.meld[1].concealed = false;
+  assert(code1 != gen_elements_code(&e2));
+}
+
 /* single element */
 /* 2..8 */
 void test_is_element_chunchan() {
@@ -341,6 +371,29 @@ void test_is_tanki_machi() {
   assert(!is_tanki_machi(m2, m1));
 }
 
+void test_gen_machi() {
+  Elements elems = {{
+                        {{m1, m2, m3}, 3, true, ELEM_TYPE_SEQUENCE},
+                        {{m3, m4, m5}, 3, true, ELEM_TYPE_SEQUENCE},
+                        {{s7, s8, s9}, 3, true, ELEM_TYPE_SEQUENCE},
+                        {{p3, p3, p3}, 3, true, ELEM_TYPE_TRIPLETS},
+                    },
+                    4};
+  Machi machi;
+  gen_machi(&machi, &elems, wt, m3);
+  assert(machi.ryanmen && !machi.kanchan && machi.penchan && !machi.shanpon && !machi.tanki);
+  gen_machi(&machi, &elems, wt, m4);
+  assert(!machi.ryanmen && machi.kanchan && !machi.penchan && !machi.shanpon && !machi.tanki);
+  gen_machi(&machi, &elems, wt, s7);
+  assert(!machi.ryanmen && !machi.kanchan && machi.penchan && !machi.shanpon && !machi.tanki);
+  gen_machi(&machi, &elems, wt, s9);
+  assert(machi.ryanmen && !machi.kanchan && !machi.penchan && !machi.shanpon && !machi.tanki);
+  gen_machi(&machi, &elems, wt, p3);
+  assert(!machi.ryanmen && !machi.kanchan && !machi.penchan && machi.shanpon && !machi.tanki);
+  gen_machi(&machi, &elems, wt, wt);
+  assert(!machi.ryanmen && !machi.kanchan && !machi.penchan && !machi.shanpon && machi.tanki);
+}
+
 /*
  * counts same sequence element in elements
  * 123, 123, 123, 123 => 6
@@ -505,6 +558,7 @@ void test_merge_elements() {
 
 bool test_element() {
   test_gen_elements_from_melds();
+  test_gen_elements_code();
   test_is_element_chunchan();
   test_is_element_routou();
   test_has_element_routou();
@@ -527,6 +581,7 @@ bool test_element() {
   test_is_ryanmen_machi();
   test_is_shanpon_machi();
   test_is_tanki_machi();
+  test_gen_machi();
   test_count_elements_same_sequence();
   test_is_same_elements();
   test_has_elements_tile_id();
@@ -0,0 +1,168 @@
+#include "test_enumerate.h"
+
+#include <assert.h>
+#include <stdalign.h>
+
+#include "scheduler.h"
+#include "test_util.h"
+
+#define TEST_NORMAL_HANDS 11498658ull     // 通常形
+#define TEST_CHIITOITSU_HANDS 5374948ull  // 通常形に分解できない七対子
+#define TEST_KOKUSHI_HANDS 13ull
+#define TEST_RYUISOU_INDEX 10
+
+typedef struct {
+  struct {
+    alignas(SCHED_CACHE_LINE) uint64_t forms[ENUM_FORM_KOKUSHI + 1];
+    uint64_t green;  // 索子と發だけで 2, 3, 4, 6, 8 のアガリ形
+    uint64_t calls;
+  } shards[SCHED_MAX_WORKERS];
+} CountTest;
+
+static void count_enum_hand(void *arg, uint32_t worker, const Tiles *tiles, uint64_t weight, EnumForm form) {
+  CountTest *test = (CountTest *)arg;
+  uint32_t len = 0;
+  bool green = true;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    assert(tiles->tiles[i] <= MJ_MAX_TILES_LEN_IN_ELEMENT);
+    len += tiles->tiles[i];
+    if (tiles->tiles[i] && i != s2 && i != s3 && i != s4 && i != s6 && i != s8 && i != dg) {
+      green = false;
+    }
+  }
+  assert(len == MJ_MIN_HAND_LEN);
+  test->shards[worker].forms[form] += weight;
+  test->shards[worker].green += green ? weight : 0;
+  test->shards[worker].calls++;
+}
+
+static void count_enum_hands(CountTest *test, uint64_t *forms, uint64_t *green, uint64_t *calls, uint32_t threads,
+                             bool symmetry) {
+  memset(test, 0, sizeof(CountTest));
+  assert(enumerate_complete_hands(count_enum_hand, test, threads, symmetry) == MJ_OK);
+  memset(forms, 0, sizeof(uint64_t) * (ENUM_FORM_KOKUSHI + 1));
+  *green = 0;
+  *calls = 0;
+  for (uint32_t i = 0; i < SCHED_MAX_WORKERS; i++) {
+    for (uint32_t j = 0; j <= ENUM_FORM_KOKUSHI; j++) {
+      forms[j] += test->shards[i].forms[j];
+    }
+    *green += test->shards[i].green;
+    *calls += test->shards[i].calls;
+  }
+}
+
+static void test_get_enum_hands() {
+  const EnumSuit *suits = get_enum_suit_hands();
+  assert(suits[0].code == 0 && suits[0].elements == 0 && suits[0].pairs == 0);
+  for (uint32_t i = 1; i < ENUM_SUIT_HANDS_LEN; i++) {
+    uint32_t len = 0;
+    for (uint32_t j = 0; j < TILE_NUM_LEN; j++) {
+      len += suits[i].counts[j];
+    }
+    assert(len == (uint32_t)(suits[i].elements * MJ_MIN_TILES_LEN_IN_ELEMENT + suits[i].pairs * MJ_PAIR_LEN));
+    // (面子の数, 雀頭の数, code) の順
+    const EnumSuit *prev = &suits[i - 1];
+    assert(prev->elements < suits[i].elements ||
+           (prev->elements == suits[i].elements &&
+            (prev->pairs < suits[i].pairs || (prev->pairs == suits[i].pairs && prev->code < suits[i].code))));
+  }
+  // 1112345678999 + 1枚 (九蓮宝燈の形) は全て含まれる
+  const EnumSuit *last = &suits[ENUM_SUIT_HANDS_LEN - 1];
+  assert(last->elements == MJ_ELEMENTS_LEN && last->pairs == 1);
+
+  const EnumSuit *honors = get_enum_honor_hands();
+  for (uint32_t i = 0; i < ENUM_HONOR_HANDS_LEN; i++) {
+    for (uint32_t j = 0; j < ENUM_HONORS_LEN; j++) {
+      assert(honors[i].counts[j] == 0 || honors[i].counts[j] == 2 || honors[i].counts[j] == 3);
+    }
+  }
+}
+
+static void test_enumerate_complete_hands() {
+  static CountTest test;
+  uint64_t forms[ENUM_FORM_KOKUSHI + 1];
+  uint64_t green;
+  uint64_t calls;
+  count_enum_hands(&test, forms, &green, &calls, 1, false);
+  assert(forms[ENUM_FORM_NORMAL] == TEST_NORMAL_HANDS);
+  assert(forms[ENUM_FORM_CHIITOITSU] == TEST_CHIITOITSU_HANDS);
+  assert(forms[ENUM_FORM_KOKUSHI] == TEST_KOKUSHI_HANDS);
+  assert(calls == TEST_NORMAL_HANDS + TEST_CHIITOITSU_HANDS + TEST_KOKUSHI_HANDS);
+  uint64_t green_all = green;
+  assert(green_all > 0);
+
+  // 色の入れ替えで減らしても重みの合計は同じ. 緑一色の形も索子のまま数える
+  count_enum_hands(&test, forms, &green, &calls, 4, true);
+  assert(forms[ENUM_FORM_NORMAL] == TEST_NORMAL_HANDS);
+  assert(forms[ENUM_FORM_CHIITOITSU] == TEST_CHIITOITSU_HANDS);
+  assert(forms[ENUM_FORM_KOKUSHI] == TEST_KOKUSHI_HANDS);
+  assert(green == green_all);
+  assert(calls * 5 < TEST_NORMAL_HANDS + TEST_CHIITOITSU_HANDS);
+}
+
+static void set_test_tiles(Tiles *tiles, const uint32_t *tile_ids, uint32_t len) {
+  memset(tiles, 0, sizeof(Tiles));
+  for (uint32_t i = 0; i < len; i++) {
+    tiles->tiles[tile_ids[i]]++;
+  }
+}
+
+static void test_score_enum_hand() {
+  static MJEnumStats stats;
+  Tiles tiles;
+  // 緑一色. アガリ牌は6種類
+  const uint32_t ryuisou[] = {s2, s2, s3, s3, s4, s4, s6, s6, s6, s8, s8, s8, dg, dg};
+  memset(&stats, 0, sizeof(stats));
+  set_test_tiles(&tiles, ryuisou, MJ_MIN_HAND_LEN);
+  score_enum_hand(&stats, &tiles, 2, ENUM_FORM_NORMAL, MJ_WS, MJ_WT);
+  assert(stats.hands == 2 && stats.normal == 2);
+  assert(stats.tsumo.scored == 12 && stats.ron.scored == 12);
+  assert(stats.tsumo.yaku[TEST_RYUISOU_INDEX] == 12 && stats.ron.yaku[TEST_RYUISOU_INDEX] == 12);
+  assert(stats.tsumo.han[MJ_ENUM_HAN_LEN - 1] == 12 && stats.ron.limits[MJ_ENUM_LIMIT_LEN - 1] == 12);
+  assert(stats.ron.points == 32000ull * 12 && stats.tsumo.points == 32000ull * 12);
+
+  // 萬子なら緑一色ではなく清一色 (とその他の役)
+  const uint32_t chinitsu[] = {m2, m2, m3, m3, m4, m4, m6, m6, m6, m8, m8, m8, dg, dg};
+  memset(&stats, 0, sizeof(stats));
+  set_test_tiles(&tiles, chinitsu, MJ_MIN_HAND_LEN);
+  score_enum_hand(&stats, &tiles, 1, ENUM_FORM_NORMAL, MJ_WS, MJ_WT);
+  assert(stats.ron.yaku[TEST_RYUISOU_INDEX] == 0);
+  assert(strcmp(mj_enum_yaku_name(4), "honitsu") == 0 && stats.ron.yaku[4] == 6);
+
+  // 役なし: 234m 567p 345s 789s 11p のロンは嵌張, 辺張, 単騎の待ちでは役がない
+  const uint32_t no_yaku[] = {m2, m3, m4, p5, p6, p7, s3, s4, s5, s7, s8, s9, p1, p1};
+  memset(&stats, 0, sizeof(stats));
+  set_test_tiles(&tiles, no_yaku, MJ_MIN_HAND_LEN);
+  score_enum_hand(&stats, &tiles, 1, ENUM_FORM_NORMAL, MJ_WS, MJ_WT);
+  assert(stats.tsumo.no_yaku == 0);  // 門前ツモ
+  assert(stats.ron.scored == 13 && stats.ron.no_yaku > 0 && stats.ron.no_yaku < 13);
+
+  // 国士無双は親のツモで 16000 * 3
+  const uint32_t kokushi[] = {m1, m9, p1, p9, s1, s9, wt, wn, ws, wp, dw, dg, dr, dr};
+  memset(&stats, 0, sizeof(stats));
+  set_test_tiles(&tiles, kokushi, MJ_MIN_HAND_LEN);
+  score_enum_hand(&stats, &tiles, 1, ENUM_FORM_KOKUSHI, MJ_WT, MJ_WT);
+  assert(stats.kokushi == 1 && stats.tsumo.yaku[0] == 13);
+  assert(stats.tsumo.points >= 48000ull * 13);
+}
+
+static void test_mj_enumerate_complete_hands() {
+  MJEnumStats stats;
+  MJEnumConfig config = {MJ_WT, MJ_DW, 1, true};
+  assert(mj_enumerate_complete_hands(&stats, &config) == MJ_ERR_ILLEGAL_PARAM);
+  config.round_wind = MJ_WT;
+  config.threads = MJ_BATCH_MAX_THREADS + 1;
+  assert(mj_enumerate_complete_hands(&stats, &config) == MJ_ERR_ILLEGAL_PARAM);
+  assert(strcmp(mj_enum_yaku_name(0), "kokushi") == 0);
+  assert(strcmp(mj_enum_yaku_name(TEST_RYUISOU_INDEX), "ryuisou") == 0);
+  assert(mj_enum_yaku_name(MJ_ENUM_YAKU_LEN) == NULL);
+}
+
+bool test_enumerate() {
+  test_get_enum_hands();
+  test_enumerate_complete_hands();
+  test_score_enum_hand();
+  test_mj_enumerate_complete_hands();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "enumerate.h"
+
+bool test_enumerate();
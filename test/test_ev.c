@@ -0,0 +1,144 @@
+#include "test_ev.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "score.h"
+#include "test_util.h"
+#include "zobrist.h"
+
+static void test_lookup_ev_score() {
+  static EvScoreCache cache;
+  memset(&cache, 0, sizeof(cache));
+  EvScorer scorer;
+  memset(&scorer, 0, sizeof(scorer));
+  scorer.player_wind = wn;
+  scorer.round_wind = wt;
+
+  // 123m 123p 123s 123s 99s: 純チャン 三色 平和 一盃口 (7翻)
+  MJHands hands = {{m1, m2, m3, p1, p2, p3, s1, s2, s3, s1, s2, s3, s9, s9}, 14};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  const EvScoreEntry *entry = lookup_ev_score(&cache, &scorer, &tiles, hash_tiles(&tiles), p1);
+  assert(entry->ron == 12000);
+  assert(entry->tsumo == 16000);  // 門前ツモを加えて8翻. 4000/8000
+  scorer.dealer = true;
+  memset(&cache, 0, sizeof(cache));
+  entry = lookup_ev_score(&cache, &scorer, &tiles, hash_tiles(&tiles), p1);
+  assert(entry->ron == 18000);
+
+  // 123m 123p 東東東 234s 99s: 役なし. リーチとドラで点数がつく
+  MJHands yakunashi = {{m1, m2, m3, p1, p2, p3, wn, wn, wn, s2, s3, s4, s9, s9}, 14};
+  assert(gen_tiles_from_hands(&tiles, &yakunashi));
+  scorer.dealer = false;
+  scorer.player_wind = ws;
+  memset(&cache, 0, sizeof(cache));
+  entry = lookup_ev_score(&cache, &scorer, &tiles, hash_tiles(&tiles), p1);
+  assert(entry->ron == 0);
+  assert(entry->tsumo > 0);  // 門前ツモ
+  scorer.riichi = true;
+  memset(&cache, 0, sizeof(cache));
+  entry = lookup_ev_score(&cache, &scorer, &tiles, hash_tiles(&tiles), p1);
+  assert(entry->ron == 1300);  // 40符1翻
+  scorer.dora.tiles[s9] = 1;
+  memset(&cache, 0, sizeof(cache));
+  entry = lookup_ev_score(&cache, &scorer, &tiles, hash_tiles(&tiles), p1);
+  assert(entry->ron == 5200);  // 40符3翻
+
+  // アガリ形でなければ0点
+  remove_tile(&tiles, s9);
+  add_tile(&tiles, s8);
+  entry = lookup_ev_score(&cache, &scorer, &tiles, hash_tiles(&tiles), p1);
+  assert(entry->ron == 0 && entry->tsumo == 0);
+}
+
+/* ツモアガリの3人の支払いの合計 */
+static uint32_t get_tsumo_points(const MJHands *hands, MJTileId win_tile) {
+  MJMelds melds = {{}, 0};
+  MJBaseScore score;
+  assert(mj_get_score(&score, hands, &melds, win_tile, false, wn, wt) == MJ_OK);
+  uint32_t points;
+  uint32_t points_dealer;
+  get_score(score.fu, score.han, true, false, &points, &points_dealer);
+  return points * 2 + points_dealer;
+}
+
+static void test_mj_evaluate_discards() {
+  static MJWinProbTable table;
+  mj_init_win_prob_table(&table);
+  // 34567m 456p 789s 22s 東 -> 東を切れば 258m 待ち
+  MJHands hands = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2, wt}, 14};
+  MJMelds melds = {{}, 0};
+  MJEvConfig config;
+  memset(&config, 0, sizeof(config));
+  config.player_wind = wn;
+  config.round_wind = wt;
+  config.draws = 12;
+  config.seed = 12345;
+  config.samples = 200;
+  config.threads = 1;
+  MJEvResult results[MJ_DR + 1];
+  uint32_t len;
+  assert(mj_evaluate_discards(results, &len, &hands, &melds, NULL, &config, &table) == MJ_OK);
+  assert(len == 13);
+  assert(results[0].discard == (MJTileId)wt && results[0].shanten == 0 && results[0].exact);
+  for (uint32_t i = 1; i < len; i++) {
+    assert(results[i - 1].ev >= results[i].ev);
+    assert(results[i].ev == results[i].win_rate * results[i].win_score);
+  }
+
+  // テンパイの点数は待ち牌ごとのツモの点数を残り枚数で重み付けした平均
+  MJHands m2_win = {{m2, m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 14};
+  MJHands m5_win = {{m3, m4, m5, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 14};
+  MJHands m8_win = {{m3, m4, m5, m6, m7, m8, p4, p5, p6, s7, s8, s9, s2, s2}, 14};
+  double expected = (4.0 * get_tsumo_points(&m2_win, m2) + 3.0 * get_tsumo_points(&m5_win, m5) +
+                     4.0 * get_tsumo_points(&m8_win, m8)) /
+                    11.0;
+  assert(fabs(results[0].win_score - expected) < 1e-9);
+
+  // ドラの待ち牌で点数が上がり, アガリ率は変わらない
+  config.dora.tiles[m8] = 1;
+  MJEvResult dora_results[MJ_DR + 1];
+  assert(mj_evaluate_discards(dora_results, &len, &hands, &melds, NULL, &config, &table) == MJ_OK);
+  assert(dora_results[0].discard == (MJTileId)wt);
+  assert(dora_results[0].win_rate == results[0].win_rate);
+  assert(dora_results[0].win_score > results[0].win_score);
+  config.dora.tiles[m8] = 0;
+
+  // 2向聴以上はシミュレーションで, スレッド数によらず同じ結果
+  MJHands slow = {{m1, m4, m7, p2, p5, p8, s3, s4, s6, s7, wt, wt, dw, dr}, 14};
+  MJEvResult results1[MJ_DR + 1];
+  MJEvResult results4[MJ_DR + 1];
+  uint32_t len1;
+  uint32_t len4;
+  config.samples = 300;
+  config.threads = 1;
+  assert(mj_evaluate_discards(results1, &len1, &slow, &melds, NULL, &config, &table) == MJ_OK);
+  config.threads = 4;
+  assert(mj_evaluate_discards(results4, &len4, &slow, &melds, NULL, &config, &table) == MJ_OK);
+  assert(len1 == len4);
+  bool simulated = false;
+  for (uint32_t i = 0; i < len1; i++) {
+    // MJEvResult の詰め物は不定なので memcmp ではなくメンバごとに比べる
+    assert(results1[i].discard == results4[i].discard && results1[i].shanten == results4[i].shanten);
+    assert(results1[i].exact == results4[i].exact && results1[i].win_rate == results4[i].win_rate);
+    assert(results1[i].win_score == results4[i].win_score && results1[i].ev == results4[i].ev);
+    simulated |= !results1[i].exact;
+    assert(results1[i].exact || results1[i].shanten >= 2);
+    assert(results1[i].win_rate == 0.0 || results1[i].win_score > 0.0);
+  }
+  assert(simulated);
+
+  config.ron_rate = 1.5;
+  assert(mj_evaluate_discards(results, &len, &hands, &melds, NULL, &config, &table) == MJ_ERR_ILLEGAL_PARAM);
+  config.ron_rate = 0.0;
+  MJHands after = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 13};
+  assert(mj_evaluate_discards(results, &len, &after, &melds, NULL, &config, &table) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+bool test_ev() {
+  test_lookup_ev_score();
+  test_mj_evaluate_discards();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "ev.h"
+
+bool test_ev();
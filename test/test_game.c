@@ -0,0 +1,177 @@
+#include "test_game.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "test_util.h"
+
+static void test_get_dora_tile() {
+  assert(get_dora_tile(m1) == (MJTileId)m2);
+  assert(get_dora_tile(m9) == (MJTileId)m1);
+  assert(get_dora_tile(p9) == (MJTileId)p1);
+  assert(get_dora_tile(s8) == (MJTileId)s9);
+  assert(get_dora_tile(wp) == (MJTileId)wt);
+  assert(get_dora_tile(ws) == (MJTileId)wp);
+  assert(get_dora_tile(dr) == (MJTileId)dw);
+  assert(get_dora_tile(dw) == (MJTileId)dg);
+}
+
+static void init_test_game(MJGame *game) {
+  memset(game, 0, sizeof(MJGame));
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    game->players[i].points = 25000;
+  }
+  game->wall_end = GAME_DEAD_WALL_POS;
+  game->dora_len = 1;
+  game->dora_indicators[0] = wt;            // ドラ 南
+  game->wall[GAME_DEAD_WALL_POS + 1] = ws;  // 裏ドラ 北
+}
+
+static void test_score_game_win() {
+  MJGame game;
+  init_test_game(&game);
+  // 234m 567p 111s 78s 99s: 69s待ち, 役なし
+  MJHands hands = {{m2, m3, m4, p5, p6, p7, s1, s1, s1, s7, s8, s9, s9}, 13};
+  MJMelds melds = {{}, 0};
+  assert(mj_init_hand(&game.players[1].hand, &hands, &melds) == MJ_OK);
+  uint32_t han;
+  uint32_t fu;
+  assert(!score_game_win(&game, 1, s6, true, false, &han, &fu));
+
+  // リーチ: 40符1翻
+  game.players[1].riichi = true;
+  assert(score_game_win(&game, 1, s6, true, false, &han, &fu));
+  assert(han == 1 && fu == 40);
+  // 一発, ドラ(表示牌 1m), 裏ドラ(表示牌 8s)
+  game.players[1].ippatsu = true;
+  game.dora_indicators[0] = m1;
+  game.wall[GAME_DEAD_WALL_POS + 1] = s8;
+  assert(score_game_win(&game, 1, s6, true, false, &han, &fu));
+  assert(han == 1 + 1 + 1 + 2);
+  // 河底
+  game.players[1].riichi = false;
+  game.players[1].ippatsu = false;
+  game.wall_pos = game.wall_end;
+  assert(score_game_win(&game, 1, s6, true, false, &han, &fu));
+  assert(han == 1 + 1);
+  // ツモ(門前清自摸和)の嶺上牌は海底にならない
+  assert(mj_hand_draw(&game.players[1].hand, s9) == MJ_OK);
+  assert(score_game_win(&game, 1, s9, false, true, &han, &fu));
+  assert(han == 1 + 1);
+}
+
+static void test_settle_game() {
+  MJGame game;
+  init_test_game(&game);
+  game.honba = 1;
+  game.riichi_sticks = 1;
+  // 子の30符1翻ロン 1000 + 300, 供託 1000
+  settle_game_win(&game, 1, 2, 1, 30);
+  assert(game.players[1].points == 27300 && game.players[2].points == 23700);
+  assert(game.riichi_sticks == 0);
+  // 親の30符2翻ツモ 1000オール + 100
+  settle_game_win(&game, 0, 0, 2, 30);
+  assert(game.players[0].points == 28300);
+  assert(game.players[1].points == 26200 && game.players[2].points == 22600 && game.players[3].points == 23900);
+  // 子の満貫ツモ 2000/4000
+  game.honba = 0;
+  settle_game_win(&game, 3, 3, 5, 30);
+  assert(game.players[3].points == 31900 && game.players[0].points == 24300 && game.players[1].points == 24200);
+
+  init_test_game(&game);
+  bool tenpai[MJ_GAME_PLAYERS] = {true, false, false, false};
+  settle_game_exhaustive_draw(&game, tenpai);
+  assert(game.players[0].points == 28000 && game.players[1].points == 24000);
+  bool tenpai2[MJ_GAME_PLAYERS] = {true, false, true, false};
+  settle_game_exhaustive_draw(&game, tenpai2);
+  assert(game.players[0].points == 29500 && game.players[1].points == 22500 && game.players[2].points == 25500);
+}
+
+/* 鳴ける場合は必ず鳴き, それ以外は貪欲法. 候補の妥当性も確認する */
+static uint32_t decide_call(void *arg, const MJGame *game, uint32_t player, const MJAction *actions, uint32_t len) {
+  uint32_t *calls = (uint32_t *)arg;
+  assert(len > 0 && len <= MJ_GAME_MAX_ACTIONS);
+  for (uint32_t i = 0; i < len; i++) {
+    const MJAction *action = &actions[i];
+    if (action->type == MJ_ACTION_DISCARD || action->type == MJ_ACTION_RIICHI) {
+      assert(game->turn == player);
+      assert(game->players[player].hand.concealed.tiles[action->tile] > 0);
+    }
+    if (action->type == MJ_ACTION_PON || action->type == MJ_ACTION_CHI || action->type == MJ_ACTION_MINKAN ||
+        action->type == MJ_ACTION_ANKAN || action->type == MJ_ACTION_KAKAN) {
+      (*calls)++;
+      return i;
+    }
+  }
+  return mj_decide_greedy(NULL, game, player, actions, len);
+}
+
+static uint32_t decide_illegal(void *arg, const MJGame *game, uint32_t player, const MJAction *actions, uint32_t len) {
+  (void)arg;
+  (void)game;
+  (void)player;
+  (void)actions;
+  return len;
+}
+
+static void assert_game_result(const MJGameResult *result, const MJGameConfig *config) {
+  int32_t sum = 0;
+  uint32_t ranks = 0;
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    sum += result->points[i];
+    ranks |= 1u << result->ranks[i];
+  }
+  assert(sum == config->start_points * MJ_GAME_PLAYERS);
+  assert(ranks == (1u << MJ_GAME_PLAYERS) - 1);
+  assert(result->hands >= config->rounds);
+  assert(result->hands == result->wins + result->exhaustive_draws);
+}
+
+static void test_mj_play_game() {
+  MJGameConfig config = {12345, 8, 25000, {}};
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    config.players[i].decide = mj_decide_greedy;
+  }
+  MJGameResult result1;
+  MJGameResult result2;
+  uint32_t wins = 0;
+  for (uint64_t seed = 0; seed < 20; seed++) {
+    config.seed = seed;
+    assert(mj_play_game(&result1, &config) == MJ_OK);
+    assert_game_result(&result1, &config);
+    wins += result1.wins;
+    // 同じseedなら同じ対局
+    assert(mj_play_game(&result2, &config) == MJ_OK);
+    assert(memcmp(&result1, &result2, sizeof(MJGameResult)) == 0);
+  }
+  assert(wins > 0);
+
+  // 鳴きを含む対局
+  uint32_t calls = 0;
+  config.players[1].decide = decide_call;
+  config.players[1].arg = &calls;
+  config.players[3].decide = decide_call;
+  config.players[3].arg = &calls;
+  for (uint64_t seed = 0; seed < 20; seed++) {
+    config.seed = seed;
+    assert(mj_play_game(&result1, &config) == MJ_OK);
+    assert_game_result(&result1, &config);
+  }
+  assert(calls > 0);
+
+  config.players[2].decide = decide_illegal;
+  assert(mj_play_game(&result1, &config) == MJ_ERR_ILLEGAL_PARAM);
+  config.players[2].decide = NULL;
+  assert(mj_play_game(&result1, &config) == MJ_ERR_ILLEGAL_PARAM);
+  config.players[2].decide = mj_decide_greedy;
+  config.rounds = 0;
+  assert(mj_play_game(&result1, &config) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+bool test_game() {
+  test_get_dora_tile();
+  test_score_game_win();
+  test_settle_game();
+  test_mj_play_game();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "game.h"
+
+bool test_game();
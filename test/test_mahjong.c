@@ -51,7 +51,116 @@ void test_mj_get_score() {
   _test_mj_get_score(m1, m9, p1, p9, s1, s9, wt, wn, ws, wp, dw, dg, dr, m1, m1, 1, wt, wt, MJ_OK, 13, 0, "kokushi ");
 }
 
+void test_mj_score_prepared() {
+  MJHands hands = {{m2, m3, m4, p2, p2, p3, p3, p4, p4, p5, p5, s2, s3, s4}, 14};
+  MJMelds melds = {{}, 0};
+  MJPreparedHand prepared;
+  assert(mj_prepare_hand(&prepared, &hands, &melds) == MJ_OK);
+
+  const MJTileId win_tiles[] = {m2, p2, p3, p5, s4};
+  const MJTileId winds[] = {wt, wn, ws, wp};
+  for (uint32_t i = 0; i < sizeof(win_tiles) / sizeof(win_tiles[0]); i++) {
+    for (uint32_t j = 0; j < sizeof(winds) / sizeof(winds[0]); j++) {
+      for (uint32_t ron = 0; ron < 2; ron++) {
+        MJBaseScore exp;
+        MJBaseScore act;
+        assert(mj_get_score(&exp, &hands, &melds, win_tiles[i], ron, winds[j], wt) == MJ_OK);
+        assert(mj_score_prepared(&act, &prepared, win_tiles[i], ron, winds[j], wt) == MJ_OK);
+        assert(exp.han == act.han);
+        assert(exp.fu == act.fu);
+        assert(strcmp(exp.yaku_name, act.yaku_name) == 0);
+      }
+    }
+  }
+  MJBaseScore score;
+  assert(mj_score_prepared(&score, &prepared, m1, 1, wt, wt) == MJ_ERR_ILLEGAL_PARAM);  // not in hands
+
+  MJHands short_hands = {{m2, m3, m4, p2, p2, p3, p3, p4, p4, p5, p5, s2, s3}, 13};
+  assert(mj_prepare_hand(&prepared, &short_hands, &melds) == MJ_ERR_NUM_TILES_SHORT);
+}
+
+void test_mj_get_scores() {
+  MJHands hands = {{m1, m1, m1, m2, m3, m4, m5, m6, m7, m8, m9, m9, m9, m5}, 14};
+  MJMelds melds = {{}, 0};
+  const MJTileId winds[] = {wt, wn, ws, wp};
+  MJScoreConfig configs[16];
+  uint32_t len = 0;
+  for (uint32_t i = 0; i < sizeof(winds) / sizeof(winds[0]); i++) {
+    for (uint32_t ron = 0; ron < 2; ron++) {
+      configs[len++] = (MJScoreConfig){m5, ron, winds[i], wt};
+      configs[len++] = (MJScoreConfig){m9, ron, winds[i], wn};
+    }
+  }
+  MJBaseScore scores[16];
+  assert(mj_get_scores(scores, &hands, &melds, configs, len) == MJ_OK);
+  for (uint32_t i = 0; i < len; i++) {
+    MJBaseScore exp;
+    const MJScoreConfig *cfg = &configs[i];
+    assert(mj_get_score(&exp, &hands, &melds, cfg->win_tile, cfg->ron, cfg->player_wind, cfg->round_wind) == MJ_OK);
+    assert(exp.han == scores[i].han);
+    assert(exp.fu == scores[i].fu);
+    assert(strcmp(exp.yaku_name, scores[i].yaku_name) == 0);
+  }
+  configs[3].win_tile = dw;  // not in hands
+  assert(mj_get_scores(scores, &hands, &melds, configs, len) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+void test_mj_hand() {
+  MJHands hands = {{m1, m2, m3, p2, p2, p3, p4, s5, s5, s5, wt, wt, dr}, 13};
+  MJMelds melds = {{}, 0};
+  MJPreparedHand hand;
+  assert(mj_init_hand(&hand, &hands, &melds) == MJ_OK);
+  uint64_t hash;
+  assert(mj_hash_tiles(&hash, &hands, &melds) == MJ_OK);
+  assert(hash == hand.hash);
+
+  /* ツモ, 打牌 */
+  assert(mj_hand_draw(&hand, p5) == MJ_OK);
+  assert(mj_hand_discard(&hand, dr) == MJ_OK);
+  MJHands hands1 = {{m1, m2, m3, p2, p2, p3, p4, p5, s5, s5, s5, wt, wt}, 13};
+  assert(mj_hash_tiles(&hash, &hands1, &melds) == MJ_OK);
+  assert(hash == hand.hash);
+  assert(mj_hand_discard(&hand, dr) == MJ_ERR_ILLEGAL_PARAM);  // not in hands
+  assert(mj_hand_draw(&hand, (MJTileId)xx) == MJ_ERR_ILLEGAL_PARAM);
+
+  /* ポン, 加槓 */
+  MJMeld pon = {{wt, wt, wt}, 3, false, xx};
+  assert(mj_hand_call(&hand, &pon, wt) == MJ_OK);
+  MJHands hands2 = {{m1, m2, m3, p2, p2, p3, p4, p5, s5, s5, s5, wt, wt, wt}, 14};
+  MJMelds melds2 = {{{{wt, wt, wt}, 3, false, xx}}, 1};
+  assert(mj_hash_tiles(&hash, &hands2, &melds2) == MJ_OK);
+  assert(hash == hand.hash);
+  assert(mj_hand_discard(&hand, p2) == MJ_OK);
+  assert(mj_hand_draw(&hand, wt) == MJ_OK);
+  MJMeld kakan = {{wt, wt, wt, wt}, 4, false, xx};
+  assert(mj_hand_call(&hand, &kakan, wt) == MJ_OK);
+  MJHands hands3 = {{m1, m2, m3, p2, p3, p4, p5, s5, s5, s5, wt, wt, wt, wt}, 14};
+  MJMelds melds3 = {{{{wt, wt, wt, wt}, 4, false, xx}}, 1};
+  assert(mj_hash_tiles(&hash, &hands3, &melds3) == MJ_OK);
+  assert(hash == hand.hash);
+  assert(hand.melded.len == 1);
+
+  /* 暗槓 */
+  MJMeld ankan = {{s5, s5, s5, s5}, 4, true, xx};
+  assert(mj_hand_call(&hand, &ankan, xx) == MJ_ERR_ILLEGAL_PARAM);  // 3枚しかない
+  assert(mj_hand_draw(&hand, s5) == MJ_OK);
+  assert(mj_hand_call(&hand, &ankan, xx) == MJ_OK);
+  MJHands hands4 = {{m1, m2, m3, p2, p3, p4, p5, s5, s5, s5, s5, wt, wt, wt, wt}, 15};
+  MJMelds melds4 = {{{{wt, wt, wt, wt}, 4, false, xx}, {{s5, s5, s5, s5}, 4, true, xx}}, 2};
+  assert(mj_hash_tiles(&hash, &hands4, &melds4) == MJ_OK);
+  assert(hash == hand.hash);
+
+  /* チーは鳴いた牌以外を手牌から除く */
+  MJMeld chi = {{p4, p5, p6}, 3, false, xx};
+  assert(mj_hand_call(&hand, &chi, p5) == MJ_ERR_ILLEGAL_PARAM);  // p6がない
+  assert(mj_hand_call(&hand, &chi, p6) == MJ_OK);
+  assert(hand.concealed.tiles[p4] == 0 && hand.concealed.tiles[p5] == 0);
+}
+
 bool test_mahjong() {
   test_mj_get_score();
+  test_mj_score_prepared();
+  test_mj_get_scores();
+  test_mj_hand();
   return true;
 }
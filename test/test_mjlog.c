@@ -0,0 +1,216 @@
+#include "test_mjlog.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "test_util.h"
+
+/*
+ * 1局目: 親の門前ツモ (30符1翻).
+ * 2局目: 子が親の 2m をチーして, 断么九のロン (30符1翻).
+ * 3局目: 九種九牌の途中流局.
+ */
+static const char test_log[] =
+    "<mjloggm ver=\"2.3\"><SHUFFLE seed=\"mt19937ar-sha512-n288-base64,xxxx\" ref=\"\"/>"
+    "<GO type=\"169\" lobby=\"0\"/><UN n0=\"%41\" n1=\"%42\" n2=\"%43\" n3=\"%44\" dan=\"0,0,0,0\"/>"
+    "<TAIKYOKU oya=\"0\"/>\n"
+    "<INIT seed=\"0,0,0,1,2,3\" ten=\"250,250,250,250\" oya=\"0\" hai0=\"0,4,8,48,52,56,96,100,104,76,80,84,53\" "
+    "hai1=\"36,37,38,68,69,70,108,109,112,113,116,120,124\" hai2=\"16,20,24,28,32,72,73,88,92,97,128,132,133\" "
+    "hai3=\"6,10,13,17,21,25,29,33,40,44,49,93,98\"/>\n"
+    "<T54/><AGARI ba=\"0,0\" hai=\"0,4,8,48,52,53,54,56,76,80,84,96,100,104\" machi=\"54\" ten=\"30,1500,0\" "
+    "yaku=\"0,1,52,0\" doraHai=\"3\" who=\"0\" fromWho=\"0\" sc=\"250,15,250,-5,250,-5,250,-5\"/>\n"
+    "<INIT seed=\"0,1,0,1,2,3\" ten=\"265,245,245,245\" oya=\"0\" hai0=\"4,0,1,2,36,37,38,108,109,110,116,117,124\" "
+    "hai1=\"8,12,52,56,60,80,84,88,92,93,44,48,100\" hai2=\"16,20,24,28,32,72,73,96,97,128,129,132,133\" "
+    "hai3=\"41,68,69,70,112,113,114,120,121,122,125,126,18\"/>\n"
+    "<T130/><D4/><N who=\"1\" m=\"3079\" /><E100/><V134/><F134/><W40/><REACH who=\"3\" step=\"1\"/><G41/>"
+    "<AGARI ba=\"1,0\" hai=\"41,44,48,52,56,60,80,84,88,92,93\" m=\"3079\" machi=\"41\" ten=\"30,1000,0\" "
+    "yaku=\"8,1\" doraHai=\"3\" who=\"1\" fromWho=\"3\" sc=\"265,0,245,13,245,0,245,-13\"/>\n"
+    "<INIT seed=\"1,0,0,1,2,3\" ten=\"265,258,245,232\" oya=\"1\" hai0=\"4,0,1,2,36,37,38,108,109,110,116,117,124\" "
+    "hai1=\"8,12,52,56,60,80,84,88,92,93,44,48,100\" hai2=\"16,20,24,28,32,72,73,96,97,128,129,132,133\" "
+    "hai3=\"41,68,69,70,112,113,114,120,121,122,125,126,18\"/>\n"
+    "<RYUUKYOKU type=\"yao9\" ba=\"0,0\" sc=\"265,0,258,0,245,0,232,0\" "
+    "owari=\"265,6.5,258,-14.2,245,-25.5,232,-36.8\"/>"
+    "<!-- comment --></mjloggm>\n";
+
+typedef struct {
+  uint32_t events[MJ_LOG_EVENT_RYUUKYOKU + 1];
+  uint32_t tenpai_discards;
+  uint32_t wins[MJ_GAME_PLAYERS];
+} EventTest;
+
+static void count_mjlog_event(void *arg, uint32_t worker, const MJLogEvent *event) {
+  EventTest *test = (EventTest *)arg;
+  assert(worker == 0);
+  test->events[event->type]++;
+  if (event->type == MJ_LOG_EVENT_DISCARD && event->shanten.normal == 0) {
+    test->tenpai_discards++;
+  }
+  if (event->type == MJ_LOG_EVENT_WIN) {
+    assert(event->score_ret == MJ_OK && event->score->han == 1 && event->score->fu == 30);
+    test->wins[event->player]++;
+    if (event->player == 0) {
+      assert(event->player_wind == MJ_WT && event->tile == MJ_P5 && strcmp(event->score->yaku_name, "tsumo ") == 0);
+    } else {
+      assert(event->player_wind == MJ_WN && event->tile == MJ_P2 && strcmp(event->score->yaku_name, "tanyao ") == 0);
+    }
+  }
+}
+
+static void test_next_mjlog_tag() {
+  const char data[] = "<?xml version=\"1.0\"?><a/>text<B x=\"1\"  yy=\"\" />\n<!-- <C/> --></a><T12/>";
+  MjlogReader reader;
+  MjlogTag tag;
+  init_mjlog_reader_data(&reader, data, sizeof(data) - 1);
+  assert(next_mjlog_tag(&reader, &tag) && is_mjlog_tag(&tag, "a") && tag.attrs_len == 0);
+  assert(next_mjlog_tag(&reader, &tag) && is_mjlog_tag(&tag, "B") && tag.attrs_len == 2);
+  const MjlogAttr *attr = find_mjlog_attr(&tag, "x");
+  assert(attr && attr->value_len == 1 && attr->value[0] == '1');
+  attr = find_mjlog_attr(&tag, "yy");
+  assert(attr && attr->value_len == 0);
+  assert(find_mjlog_attr(&tag, "y") == NULL);
+  // コメントの中の '>' までを読み飛ばすので, "--" の後は文字列として扱う
+  assert(next_mjlog_tag(&reader, &tag) && is_mjlog_tag(&tag, "T12"));
+  assert(!next_mjlog_tag(&reader, &tag) && reader.error == MJ_OK);
+
+  int32_t values[4];
+  uint32_t len;
+  const char sc[] = "<AGARI sc=\"250,-15,0\" bad=\"1,,2\" long=\"1,2,3,4,5\"/>";
+  init_mjlog_reader_data(&reader, sc, sizeof(sc) - 1);
+  assert(next_mjlog_tag(&reader, &tag));
+  assert(parse_mjlog_values(&tag, "sc", values, &len, 4) && len == 3);
+  assert(values[0] == 250 && values[1] == -15 && values[2] == 0);
+  assert(parse_mjlog_values(&tag, "none", values, &len, 4) && len == 0);
+  assert(!parse_mjlog_values(&tag, "bad", values, &len, 4));
+  assert(!parse_mjlog_values(&tag, "long", values, &len, 4));
+
+  const char *illegals[] = {"<A x=1/>", "<A x=\"1/>", "<A", "< x=\"1\"/>"};
+  for (uint32_t i = 0; i < sizeof(illegals) / sizeof(illegals[0]); i++) {
+    init_mjlog_reader_data(&reader, illegals[i], strlen(illegals[i]));
+    assert(!next_mjlog_tag(&reader, &tag) && reader.error == MJ_ERR_ILLEGAL_LOG);
+  }
+}
+
+static void test_decode_mjlog_meld() {
+  MJMeld meld;
+  MJTileId called;
+  // 234m のチーで 2m を鳴いた
+  assert(decode_mjlog_meld(3079, &meld, &called));
+  assert(meld.len == 3 && meld.tile_id[0] == MJ_M2 && meld.tile_id[2] == MJ_M4 && !meld.concealed && called == MJ_M2);
+  // 678s のチーで 8s を鳴いた
+  assert(decode_mjlog_meld(((2 * 7 + 5) * 3 + 2) << 10 | 0x4 | 3, &meld, &called));
+  assert(meld.tile_id[0] == MJ_S6 && meld.tile_id[2] == MJ_S8 && called == MJ_S8);
+  // 5p のポン
+  assert(decode_mjlog_meld((p5 * 3 + 1) << 9 | 0x8 | 2, &meld, &called));
+  assert(meld.len == 3 && meld.tile_id[0] == MJ_P5 && meld.tile_id[2] == MJ_P5 && called == MJ_P5);
+  // 中の加槓
+  assert(decode_mjlog_meld((dr * 3) << 9 | 0x10 | 1, &meld, &called));
+  assert(meld.len == 4 && meld.tile_id[3] == MJ_DR && !meld.concealed);
+  // 東の暗槓と大明槓
+  assert(decode_mjlog_meld((wt * 4) << 8, &meld, &called));
+  assert(meld.len == 4 && meld.tile_id[0] == MJ_WT && meld.concealed);
+  assert(decode_mjlog_meld((wt * 4 + 3) << 8 | 1, &meld, &called));
+  assert(meld.len == 4 && meld.tile_id[0] == MJ_WT && !meld.concealed && called == MJ_WT);
+  // 抜きドラ, 範囲外
+  assert(!decode_mjlog_meld(0x20, &meld, &called));
+  assert(!decode_mjlog_meld(136 << 8, &meld, &called));
+  assert(!decode_mjlog_meld(21 * 3 << 10 | 0x4, &meld, &called));
+}
+
+static void check_test_log_stats(const MJLogStats *stats) {
+  assert(stats->games == 1 && stats->hands == 3);
+  assert(stats->draws == 4 && stats->discards == 4 && stats->calls == 1 && stats->riichi == 1);
+  assert(stats->wins == 2 && stats->exhaustive_draws == 0 && stats->abortive_draws == 1);
+  assert(stats->shanten[0] == 1);  // ツモアガリ
+  assert(stats->scored == 2 && stats->score_errors == 0);
+  assert(stats->hand_mismatches == 0 && stats->han_mismatches == 0 && stats->fu_mismatches == 0);
+  assert(stats->ukeire_kinds > 0 && stats->ukeire_tiles > stats->ukeire_kinds);
+}
+
+static void test_mj_replay_mjlog() {
+  MJLogStats stats;
+  EventTest test;
+  memset(&test, 0, sizeof(test));
+  MJLogConfig config = {1, count_mjlog_event, &test};
+  assert(mj_replay_mjlog(&stats, test_log, sizeof(test_log) - 1, &config) == MJ_OK);
+  check_test_log_stats(&stats);
+  assert(stats.files == 1 && stats.bytes == sizeof(test_log) - 1);
+  assert(test.events[MJ_LOG_EVENT_INIT] == 3 && test.events[MJ_LOG_EVENT_DRAW] == 4);
+  assert(test.events[MJ_LOG_EVENT_DISCARD] == 4 && test.events[MJ_LOG_EVENT_CALL] == 1);
+  assert(test.events[MJ_LOG_EVENT_WIN] == 2 && test.events[MJ_LOG_EVENT_RYUUKYOKU] == 1);
+  assert(test.wins[0] == 1 && test.wins[1] == 1);
+  assert(test.tenpai_discards >= 1);  // チーの後の 8s 切りでテンパイ
+
+  // 翻数が違えば数える (リーチとドラは比べない)
+  char log[sizeof(test_log)];
+  memcpy(log, test_log, sizeof(test_log));
+  memcpy(strstr(log, "yaku=\"8,1\""), "yaku=\"8,2\"", 10);
+  memcpy(strstr(log, "yaku=\"0,1,52,0\""), "yaku=\"1,1,52,3\"", 15);
+  config.func = NULL;
+  assert(mj_replay_mjlog(&stats, log, sizeof(log) - 1, &config) == MJ_OK);
+  assert(stats.scored == 2 && stats.han_mismatches == 2);
+
+  // 手牌にない牌は切れない
+  memcpy(log, test_log, sizeof(test_log));
+  memcpy(strstr(log, "<E100/>"), "<E104/>", 7);
+  assert(mj_replay_mjlog(&stats, log, sizeof(log) - 1, &config) == MJ_ERR_ILLEGAL_LOG);
+  assert(stats.hands == 2 && stats.wins == 1);  // 失敗した位置までは集計する
+}
+
+static void test_replay_mjlog_fd() {
+  char path[] = "/tmp/test_mjlog_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  assert(write(fd, test_log, sizeof(test_log) - 1) == (ssize_t)(sizeof(test_log) - 1));
+
+  // タグがバッファの境界をまたいでも同じ
+  MJLogConfig config = {1, NULL, NULL};
+  MJLogStats expected;
+  assert(mj_replay_mjlog(&expected, test_log, sizeof(test_log) - 1, &config) == MJ_OK);
+  const uint64_t buffer_lens[] = {256, 257, 1000, MJ_LOG_BUFFER_LEN};
+  static char buffer[MJ_LOG_BUFFER_LEN];
+  for (uint32_t i = 0; i < sizeof(buffer_lens) / sizeof(buffer_lens[0]); i++) {
+    MJLogStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.files = 1;
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    MjlogReader reader;
+    init_mjlog_reader_fd(&reader, fd, buffer, buffer_lens[i]);
+    MjlogReplay replay;
+    init_mjlog_replay(&replay, &stats, &config, 0, 0);
+    assert(replay_mjlog(&replay, &reader) == MJ_OK);
+    assert(memcmp(&stats, &expected, sizeof(MJLogStats)) == 0);
+  }
+
+  // AGARI がバッファに収まらない
+  MJLogStats stats;
+  memset(&stats, 0, sizeof(stats));
+  assert(lseek(fd, 0, SEEK_SET) == 0);
+  MjlogReader reader;
+  init_mjlog_reader_fd(&reader, fd, buffer, 128);
+  MjlogReplay replay;
+  init_mjlog_replay(&replay, &stats, &config, 0, 0);
+  assert(replay_mjlog(&replay, &reader) == MJ_ERR_ILLEGAL_LOG);
+  close(fd);
+
+  // ファイルごとに並列に再生する. 読めないファイルがあっても他のファイルは集計する
+  const char *paths[] = {path, path, "/nonexistent/mjlog", path};
+  config.threads = 3;
+  assert(mj_replay_mjlog_files(&stats, paths, 4, &config) == MJ_ERR_IO);
+  assert(stats.files == 4 && stats.hands == expected.hands * 3 && stats.wins == expected.wins * 3);
+  assert(stats.bytes == expected.bytes * 3);
+  assert(mj_replay_mjlog_files(&stats, paths, 2, &config) == MJ_OK);
+  assert(stats.draws == expected.draws * 2 && stats.ukeire_tiles == expected.ukeire_tiles * 2);
+  config.threads = MJ_BATCH_MAX_THREADS + 1;
+  assert(mj_replay_mjlog_files(&stats, paths, 2, &config) == MJ_ERR_ILLEGAL_PARAM);
+  unlink(path);
+}
+
+bool test_mjlog() {
+  test_next_mjlog_tag();
+  test_decode_mjlog_meld();
+  test_mj_replay_mjlog();
+  test_replay_mjlog_fd();
+  return true;
+}
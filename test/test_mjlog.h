@@ -0,0 +1,5 @@
+#pragma once
+
+#include "mjlog.h"
+
+bool test_mjlog();
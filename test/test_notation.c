@@ -0,0 +1,137 @@
+#include "test_notation.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "test_util.h"
+
+static int32_t parse(MJNotation *notation, const char *str) { return mj_parse_notation(notation, str, strlen(str)); }
+
+static void test_parse_notation_tile() {
+  MJTileId tile_id;
+  assert(parse_notation_tile(&tile_id, '1', 'm') && tile_id == MJ_M1);
+  assert(parse_notation_tile(&tile_id, '9', 'p') && tile_id == MJ_P9);
+  assert(parse_notation_tile(&tile_id, '5', 's') && tile_id == MJ_S5);
+  assert(parse_notation_tile(&tile_id, '1', 'z') && tile_id == MJ_WT);
+  assert(parse_notation_tile(&tile_id, '7', 'z') && tile_id == MJ_DR);
+  assert(!parse_notation_tile(&tile_id, '8', 'z'));
+  assert(!parse_notation_tile(&tile_id, '0', 'm'));
+  assert(!parse_notation_tile(&tile_id, '1', 'x'));
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    char suit = NOTATION_SUITS[get_notation_suit((MJTileId)i)];
+    assert(parse_notation_tile(&tile_id, get_notation_number((MJTileId)i), suit));
+    assert(tile_id == i);
+  }
+}
+
+static void test_mj_parse_notation() {
+  MJNotation notation;
+  assert(parse(&notation, "234m22334455p234s") == MJ_OK);
+  assert(!notation.has_win_tile && notation.melds.len == 0);
+  assert(notation.tiles.tiles[MJ_M2] == 1 && notation.tiles.tiles[MJ_P2] == 2 && notation.tiles.tiles[MJ_S4] == 1);
+
+  MJHands hands;
+  assert(mj_notation_to_hands(&hands, &notation) == MJ_OK);
+  MJHands expected = {{m2, m3, m4, p2, p2, p3, p3, p4, p4, p5, p5, s2, s3, s4}, 14};
+  assert(hands.len == expected.len && memcmp(hands.tile_id, expected.tile_id, sizeof(MJTileId) * hands.len) == 0);
+
+  // 副露, 暗槓, アガリ牌
+  assert(parse(&notation, "234m55p(678s)[1111z]66z+6z") == MJ_OK);
+  assert(notation.has_win_tile && notation.win_tile == MJ_DG);
+  assert(notation.melds.len == 2);
+  assert(notation.melds.meld[0].len == 3 && !notation.melds.meld[0].concealed);
+  assert(notation.melds.meld[0].tile_id[0] == MJ_S6 && notation.melds.meld[0].tile_id[2] == MJ_S8);
+  assert(notation.melds.meld[1].len == 4 && notation.melds.meld[1].concealed);
+  assert(notation.melds.meld[1].tile_id[3] == MJ_WT);
+  assert(notation.tiles.tiles[MJ_WT] == 4 && notation.tiles.tiles[MJ_DG] == 3);
+  assert(mj_notation_to_hands(&hands, &notation) == MJ_OK && hands.len == 15);
+
+  MJBaseScore score;
+  assert(mj_get_score(&score, &hands, &notation.melds, notation.win_tile, false, MJ_WT, MJ_WT) == MJ_OK);
+  assert(score.han == 3 && score.fu == 70);  // ダブ東, 發
+
+  // 順不同, 空文字列
+  assert(parse(&notation, "(312m)") == MJ_OK && notation.melds.meld[0].tile_id[0] == MJ_M3);
+  assert(parse(&notation, "") == MJ_OK && notation.melds.len == 0 && notation.tiles.tiles[MJ_M1] == 0);
+  // 長さで区切る. 後ろは読まない
+  assert(mj_parse_notation(&notation, "11m22m", 3) == MJ_OK && notation.tiles.tiles[MJ_M1] == 2);
+
+  const char *illegals[] = {
+      "123",    "123x",      "m",        "0m",       "8z",
+      "11111m", "(12m)",     "(12345m)", "(124m)",   "(123z)",
+      "(112m)", "[111m]",    "[1111m)",  "(111m",    "+",
+      "+5",     "123m+5p6p", "+5p123m",  "1111m+1m", "123m 456p",
+      "(111m)(222m)(333m)(444m)(555m)",
+  };
+  for (uint32_t i = 0; i < sizeof(illegals) / sizeof(illegals[0]); i++) {
+    assert(parse(&notation, illegals[i]) == MJ_ERR_ILLEGAL_PARAM);
+  }
+  assert(parse(&notation, "1111222233334444m55556666p") == MJ_ERR_NUM_TILES_LARGE);
+}
+
+static void test_mj_format_notation() {
+  const char *notations[] = {
+      "234m22334455p234s",
+      "234m55p66z(678s)[1111z]+6z",
+      "19m19p19s1234567z+1m",
+      "(999m)(1111z)[5555p](789s)",
+      "",
+  };
+  for (uint32_t i = 0; i < sizeof(notations) / sizeof(notations[0]); i++) {
+    MJNotation notation;
+    assert(parse(&notation, notations[i]) == MJ_OK);
+    char buf[MJ_NOTATION_MAX_LEN];
+    uint64_t written;
+    assert(mj_format_notation(buf, sizeof(buf), &written, &notation) == MJ_OK);
+    assert(strcmp(buf, notations[i]) == 0 && written == strlen(notations[i]));
+  }
+
+  // 門前の牌は並べ直す
+  MJNotation notation;
+  assert(parse(&notation, "11z9s5p1m+5m") == MJ_OK);
+  char buf[MJ_NOTATION_MAX_LEN];
+  assert(mj_format_notation(buf, sizeof(buf), NULL, &notation) == MJ_OK);
+  assert(strcmp(buf, "1m5p9s11z+5m") == 0);
+  assert(mj_format_notation(buf, 12, NULL, &notation) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_format_notation(buf, 13, NULL, &notation) == MJ_OK);
+
+  // 牌と副露が矛盾する
+  notation.win_tile = MJ_DR;
+  assert(mj_format_notation(buf, sizeof(buf), NULL, &notation) == MJ_ERR_ILLEGAL_PARAM);
+  assert(parse(&notation, "(123m)") == MJ_OK);
+  notation.tiles.tiles[MJ_M2] = 0;
+  assert(mj_format_notation(buf, sizeof(buf), NULL, &notation) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+static void test_notation_throughput() {
+  const char *notations[] = {
+      "234m22334455p234s",
+      "234m55p66z(678s)[1111z]+6z",
+      "19m19p19s1234567z+1m",
+  };
+  const uint32_t len = 300000;
+  uint64_t written = 0;
+  clock_t start = clock();
+  for (uint32_t i = 0; i < len; i++) {
+    const char *str = notations[i % 3];
+    MJNotation notation;
+    char buf[MJ_NOTATION_MAX_LEN];
+    uint64_t n;
+    assert(mj_parse_notation(&notation, str, strlen(str)) == MJ_OK);
+    assert(mj_format_notation(buf, sizeof(buf), &n, &notation) == MJ_OK);
+    written += n;
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  assert(written == (17 + 26 + 20) * (uint64_t)(len / 3));
+  fprintf(stderr, "notation: %.0f parse+format/s\n", seconds > 0.0 ? (double)len / seconds : 0.0);
+}
+
+bool test_notation() {
+  test_parse_notation_tile();
+  test_mj_parse_notation();
+  test_mj_format_notation();
+  test_notation_throughput();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "notation.h"
+
+bool test_notation();
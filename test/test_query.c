@@ -0,0 +1,249 @@
+#include "test_query.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "notation.h"
+#include "rng.h"
+#include "test_util.h"
+
+#define TEST_QUERY_HANDS 10000
+
+static const char *process(QueryOutput *output, const char *line) {
+  process_query(output, line, (uint32_t)strlen(line));
+  assert(output->len > 0 && output->len < sizeof(output->buf) && output->buf[output->len - 1] == '\n');
+  output->buf[output->len] = '\0';
+  return output->buf;
+}
+
+static void assert_process(const char *line, const char *expected) {
+  QueryOutput output;
+  const char *actual = process(&output, line);
+  if (strcmp(actual, expected) != 0) {
+    printf("%s -> %s", line, actual);
+  }
+  assert(strcmp(actual, expected) == 0);
+}
+
+/* 出力の JSON オブジェクトから key の値を探す. 出力を JSON として読み直せることも確かめる */
+static bool get_output_value(JsonValue *value, const QueryOutput *output, const char *key) {
+  const char *p = output->buf, *end = output->buf + output->len - 1;  // 改行を除く
+  assert(*p++ == '{' && end[-1] == '}');
+  end--;
+  bool found = false;
+  while (p < end) {
+    JsonValue k, v;
+    p = parse_json_value(&k, p, end);
+    assert(p && k.string && p[0] == ':' && p[1] == ' ');
+    p = parse_json_value(&v, p + 2, end);
+    assert(p);
+    if (k.len == strlen(key) && memcmp(k.str, key, k.len) == 0) {
+      *value = v;
+      found = true;
+    }
+    if (p < end) {
+      assert(p[0] == ',' && p[1] == ' ');
+      p += 2;
+    }
+  }
+  return found;
+}
+
+static int32_t get_output_int(const QueryOutput *output, const char *key) {
+  JsonValue value;
+  assert(get_output_value(&value, output, key) && !value.string);
+  return (int32_t)strtol(value.str, NULL, 10);
+}
+
+static void test_parse_json_value() {
+  const char *str = "\"a\\\"b\" 12, [1, {\"x\": \"]\"}] {\"y\": [2]}}";
+  const char *end = str + strlen(str);
+  JsonValue value;
+  const char *p = parse_json_value(&value, str, end);
+  assert(p && value.string && value.len == 4 && memcmp(value.str, "a\\\"b", 4) == 0);
+  p = parse_json_value(&value, p + 1, end);
+  assert(p && !value.string && value.len == 2 && *p == ',');
+  // 配列とオブジェクトは中の文字列の括弧も数えずに読み飛ばす
+  p = parse_json_value(&value, p + 2, end);
+  assert(p && !value.string && value.len == 15 && *p == ' ');
+  p = parse_json_value(&value, p + 1, end);
+  assert(p && value.len == 10 && *p == '}');
+
+  assert(!parse_json_value(&value, "\"abc", "\"abc" + 4));
+  assert(!parse_json_value(&value, "[1, 2", "[1, 2" + 5));
+  assert(!parse_json_value(&value, ",", "," + 1));
+  assert(!parse_json_value(&value, "", ""));
+}
+
+static void test_parse_query() {
+  Query query;
+  const char *line = "{\"id\": \"q1\", \"kind\": \"ukeire\", \"hand\": \"123m\", \"win_tile\": \"3m\", \"ron\": true,"
+                     " \"player_wind\": \"2z\", \"round_wind\": \"3z\", \"extra\": {\"hand\": \"9m\"}}";
+  assert(parse_query(&query, line, (uint32_t)strlen(line)) == NULL);
+  assert(query.kind == QUERY_UKEIRE && query.ron);
+  assert(query.id.string && query.id.len == 2 && memcmp(query.id.str, "q1", 2) == 0);
+  assert(query.hand.len == 4 && memcmp(query.hand.str, "123m", 4) == 0);
+  assert(query.win_tile.len == 2 && query.player_wind.len == 2 && query.round_wind.str[0] == '3');
+
+  line = "  {\"hand\":\"1m\",\"ron\":\"true\",\"id\":-3}";
+  assert(parse_query(&query, line, (uint32_t)strlen(line)) == NULL);
+  assert(query.kind == QUERY_SCORE && !query.ron && !query.id.string && query.id.len == 2);
+  assert(!query.win_tile.str && !query.player_wind.str);
+}
+
+static void test_process_query() {
+  assert_process("{\"id\": 1, \"hand\": \"234m2234455p234s+3p\", \"ron\": true}",
+                 "{\"id\": 1, \"ret\": 0, \"han\": 4, \"fu\": 40, "
+                 "\"yaku\": [\"sanshoku\", \"tanyao\", \"iipeiko\"]}\n");
+  assert_process("{\"hand\": \"234m2234455p234s3p\", \"win_tile\": \"3p\", \"player_wind\": \"2z\"}",
+                 "{\"ret\": 0, \"han\": 5, \"fu\": 30, "
+                 "\"yaku\": [\"sanshoku\", \"tanyao\", \"iipeiko\", \"tsumo\"]}\n");
+  assert_process("{\"id\": \"a\\\"b\", \"kind\": \"shanten\", \"hand\": \"123m456p789s11z23z\"}",
+                 "{\"id\": \"a\\\"b\", \"ret\": 0, \"shanten\": 1, \"normal\": 1, "
+                 "\"chiitoitsu\": 5, \"kokushi\": 7}\n");
+  // 副露を除いた手牌. 七対子と国士無双は出力しない
+  assert_process("{\"kind\": \"shanten\", \"hand\": \"123m(456p)789s11z23m\"}",
+                 "{\"ret\": 0, \"shanten\": 0, \"normal\": 0}\n");
+  assert_process("{\"kind\": \"ukeire\", \"hand\": \"123m456p789s11z23m\", \"extra\": [1, {\"a\": \"]\"}]}",
+                 "{\"ret\": 0, \"shanten\": 0, \"tiles\": \"14m\", \"count\": 7}\n");
+}
+
+static void test_process_query_malformed() {
+  assert_process("{", "{\"ret\": -1, \"error\": \"invalid json\"}\n");
+  assert_process("[1]", "{\"ret\": -1, \"error\": \"invalid json\"}\n");
+  assert_process("{\"hand\" \"1m\"}", "{\"ret\": -1, \"error\": \"invalid json\"}\n");
+  assert_process("{\"hand\": \"1m}", "{\"ret\": -1, \"error\": \"invalid json\"}\n");
+  assert_process("{\"hand\": }", "{\"ret\": -1, \"error\": \"invalid json\"}\n");
+  assert_process("{1: \"1m\"}", "{\"ret\": -1, \"error\": \"invalid json\"}\n");
+  // parse_query が失敗した行には id を出力しない
+  assert_process("{\"id\": 3}", "{\"ret\": -1, \"error\": \"hand is required\"}\n");
+  assert_process("{\"hand\": 1}", "{\"ret\": -1, \"error\": \"hand is required\"}\n");
+  assert_process("{\"id\": 3, \"hand\": \"1x\"}", "{\"id\": 3, \"ret\": -1, \"error\": \"invalid hand\"}\n");
+  assert_process("{\"kind\": \"foo\", \"hand\": \"1m\"}", "{\"ret\": -1, \"error\": \"unknown kind\"}\n");
+  assert_process("{\"hand\": \"234m2234455p234s3p\"}", "{\"ret\": -1, \"error\": \"invalid tile\"}\n");
+  assert_process("{\"hand\": \"234m2234455p234s3p\", \"win_tile\": \"33p\"}",
+                 "{\"ret\": -1, \"error\": \"invalid tile\"}\n");
+  assert_process("{\"hand\": \"234m2234455p234s+3p\", \"player_wind\": \"5z\"}",
+                 "{\"ret\": -1, \"error\": \"invalid tile\"}\n");
+  assert_process("{\"hand\": \"234m2234455p234s+3p\", \"round_wind\": 1}",
+                 "{\"ret\": -1, \"error\": \"invalid tile\"}\n");
+  assert_process("{\"id\": 4, \"hand\": \"11m+1m\"}", "{\"id\": 4, \"ret\": -2}\n");
+  assert_process("{\"kind\": \"shanten\", \"hand\": \"1111111m\"}", "{\"ret\": -1, \"error\": \"invalid hand\"}\n");
+
+  // 長すぎる行は中身を読まない
+  char line[QUERY_LINE_LEN + 1];
+  memset(line, ' ', sizeof(line));
+  memcpy(line, "{\"hand\": \"1m\"}", 14);
+  QueryOutput output;
+  process_query(&output, line, QUERY_LINE_LEN - 1);
+  const char *expected = "{\"ret\": -1, \"error\": \"invalid tile\"}\n";
+  assert(output.len == strlen(expected) && memcmp(output.buf, expected, output.len) == 0);
+  process_query(&output, line, QUERY_LINE_LEN);
+  expected = "{\"ret\": -1, \"error\": \"line too long\"}\n";
+  assert(output.len == strlen(expected) && memcmp(output.buf, expected, output.len) == 0);
+}
+
+/* 雀頭と4面子を並べたアガリ形. 同じ牌は4枚まで */
+static void gen_query_agari(MJHands *hands, Rng *rng) {
+  uint8_t counts[MJ_DR + 1] = {0};
+  hands->len = 0;
+  for (uint32_t i = 0; i < MJ_ELEMENTS_LEN + 1;) {
+    MJTileId t = (MJTileId)next_rng_bounded(rng, MJ_DR + 1);
+    bool chi = i > 0 && t < MJ_WT && get_notation_number(t) <= '7' && next_rng_bounded(rng, 2) == 0;
+    MJTileId element[3] = {t, chi ? t + 1 : t, chi ? t + 2 : t};
+    uint32_t len = i == 0 ? MJ_PAIR_LEN : 3;
+    bool ok = true;
+    for (uint32_t j = 0; j < len; j++) {
+      counts[element[j]]++;
+      ok = ok && counts[element[j]] <= MJ_MAX_TILES_LEN_IN_ELEMENT;
+    }
+    if (!ok) {
+      for (uint32_t j = 0; j < len; j++) {
+        counts[element[j]]--;
+      }
+      continue;
+    }
+    memcpy(&hands->tile_id[hands->len], element, sizeof(MJTileId) * len);
+    hands->len += len;
+    i++;
+  }
+}
+
+/* mj_format_notation の手牌を問い合わせ, 出力を読み直して mj_calc_shanten, mj_get_score と比べる */
+static void test_process_query_round_trip() {
+  MJTileId wall[136];
+  for (uint32_t i = 0; i < 136; i++) {
+    wall[i] = (MJTileId)(i / 4);
+  }
+  Rng rng;
+  seed_rng(&rng, 20261019);
+  const MJMelds melds = {0};
+  for (uint32_t n = 0; n < TEST_QUERY_HANDS; n++) {
+    MJHands hands;
+    if (n % 2 == 0) {
+      hands.len = 13;
+      for (uint32_t j = 0; j < hands.len; j++) {
+        uint32_t k = j + next_rng_bounded(&rng, (uint32_t)(sizeof(wall) / sizeof(wall[0])) - j);
+        MJTileId t = wall[j];
+        wall[j] = wall[k];
+        wall[k] = t;
+        hands.tile_id[j] = wall[j];
+      }
+    } else {
+      gen_query_agari(&hands, &rng);
+    }
+    MJNotation notation;
+    memset(&notation, 0, sizeof(notation));
+    for (uint32_t j = 0; j < hands.len; j++) {
+      notation.tiles.tiles[hands.tile_id[j]]++;
+    }
+    char hand[MJ_NOTATION_MAX_LEN];
+    assert(mj_format_notation(hand, sizeof(hand), NULL, &notation) == MJ_OK);
+
+    char line[QUERY_LINE_LEN];
+    QueryOutput output;
+    JsonValue value;
+    if (n % 2 == 0) {
+      snprintf(line, sizeof(line), "{\"id\": \"h%u\", \"kind\": \"shanten\", \"hand\": \"%s\"}", n, hand);
+      process(&output, line);
+      MJShanten shanten;
+      assert(mj_calc_shanten(&hands, &shanten) == MJ_OK);
+      assert(get_output_int(&output, "ret") == MJ_OK);
+      assert(get_output_int(&output, "normal") == shanten.normal);
+      assert(get_output_int(&output, "chiitoitsu") == shanten.chiitoitsu);
+      assert(get_output_int(&output, "kokushi") == shanten.kokushi);
+      char id[16];
+      snprintf(id, sizeof(id), "h%u", n);
+      assert(get_output_value(&value, &output, "id") && value.string);
+      assert(value.len == strlen(id) && memcmp(value.str, id, value.len) == 0);
+      continue;
+    }
+    const MJTileId win_tile = hands.tile_id[next_rng_bounded(&rng, hands.len)];
+    const MJTileId player_wind = (MJTileId)(MJ_WT + next_rng_bounded(&rng, 4));
+    const bool ron = next_rng_bounded(&rng, 2) == 0;
+    snprintf(line, sizeof(line),
+             "{\"id\": %u, \"hand\": \"%s\", \"win_tile\": \"%c%c\", \"ron\": %s, \"player_wind\": \"%cz\"}", n, hand,
+             get_notation_number(win_tile), NOTATION_SUITS[get_notation_suit(win_tile)], ron ? "true" : "false",
+             get_notation_number(player_wind));
+    process(&output, line);
+    MJBaseScore score;
+    int32_t ret = mj_get_score(&score, &hands, &melds, win_tile, ron, player_wind, MJ_WT);
+    assert(get_output_int(&output, "id") == (int32_t)n);
+    assert(get_output_int(&output, "ret") == ret);
+    if (ret == MJ_OK) {
+      assert(get_output_int(&output, "han") == (int32_t)score.han);
+      assert(get_output_int(&output, "fu") == (int32_t)score.fu);
+      assert(get_output_value(&value, &output, "yaku") && !value.string && value.str[0] == '[');
+    }
+  }
+}
+
+bool test_query() {
+  test_parse_json_value();
+  test_parse_query();
+  test_process_query();
+  test_process_query_malformed();
+  test_process_query_round_trip();
+  return true;
+}
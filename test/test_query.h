@@ -0,0 +1,5 @@
+#pragma once
+
+#include "query.h"
+
+bool test_query();
@@ -0,0 +1,232 @@
+#include "test_record.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "enumerate.h"
+#include "test_util.h"
+
+static void test_record_counts() {
+  Tiles tiles;
+  memset(&tiles, 0, sizeof(tiles));
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    tiles.tiles[i] = (uint8_t)(i % 5);
+  }
+  uint8_t counts[MJ_RECORD_COUNTS_LEN];
+  assert(encode_record_counts(counts, &tiles));
+  Tiles decoded;
+  decode_record_counts(&decoded, counts);
+  assert(memcmp(&tiles, &decoded, sizeof(tiles)) == 0);
+
+  tiles.tiles[MJ_DR] = 5;
+  assert(!encode_record_counts(counts, &tiles));
+}
+
+static void test_record_meld() {
+  const MJMeld melds[] = {
+      {{s7, s9, s8}, 3, false, xx},
+      {{dr, dr, dr}, 3, false, xx},
+      {{p5, p5, p5, p5}, 4, false, xx},
+      {{wn, wn, wn, wn}, 4, true, xx},
+  };
+  const RecordMeldType types[] = {RECORD_MELD_CHI, RECORD_MELD_PON, RECORD_MELD_MINKAN, RECORD_MELD_ANKAN};
+  for (uint32_t i = 0; i < sizeof(melds) / sizeof(melds[0]); i++) {
+    uint8_t code;
+    assert(encode_record_meld(&code, &melds[i]));
+    assert(code >> RECORD_MELD_TYPE_SHIFT == types[i]);
+    MJMeld meld;
+    assert(decode_record_meld(&meld, code));
+    assert(meld.len == melds[i].len && meld.concealed == melds[i].concealed);
+  }
+
+  uint8_t code;
+  const MJMeld illegal[] = {
+      {{s8, s9, wt}, 3, false, xx},  // 字牌をまたぐ
+      {{m1, m2, m4}, 3, false, xx},
+      {{m1, m1, m2}, 3, false, xx},
+      {{wt, wn, ws}, 3, false, xx},
+      {{m1, m1}, 2, false, xx},
+  };
+  for (uint32_t i = 0; i < sizeof(illegal) / sizeof(illegal[0]); i++) {
+    assert(!encode_record_meld(&code, &illegal[i]));
+  }
+  MJMeld meld;
+  assert(!decode_record_meld(&meld, (uint8_t)(RECORD_MELD_CHI << RECORD_MELD_TYPE_SHIFT | MJ_M8)));
+  assert(!decode_record_meld(&meld, (uint8_t)(RECORD_MELD_PON << RECORD_MELD_TYPE_SHIFT | RECORD_TILE_MASK)));
+}
+
+static void test_mj_hand_record() {
+  MJHands hands = {{m2, m3, m4, p5, p5, s6, s7, s8, wt, wt, wt, wt, dg, dg, dg}, 15};
+  MJMelds melds = {{{{s8, s6, s7}, 3, false, xx}, {{wt, wt, wt, wt}, 4, true, xx}}, 2};
+  MJScoreConfig config = {MJ_DG, true, MJ_WN, MJ_WT};
+  MJHandRecord record;
+  assert(mj_encode_hand_record(&record, &hands, &melds, &config) == MJ_OK);
+  assert(record.tag == 0 && record.meld_len == 2);
+
+  MJHands decoded_hands;
+  MJMelds decoded_melds;
+  MJScoreConfig decoded_config;
+  assert(mj_decode_hand_record(&decoded_hands, &decoded_melds, &decoded_config, &record) == MJ_OK);
+  assert(decoded_hands.len == hands.len && decoded_melds.len == melds.len);
+  assert(decoded_hands.tile_id[0] == MJ_M2 && decoded_hands.tile_id[14] == MJ_DG);
+  assert(decoded_melds.meld[0].tile_id[0] == MJ_S6 && !decoded_melds.meld[0].concealed);
+  assert(decoded_melds.meld[1].tile_id[0] == MJ_WT && decoded_melds.meld[1].concealed);
+  assert(decoded_config.win_tile == MJ_DG && decoded_config.ron);
+  assert(decoded_config.player_wind == MJ_WN && decoded_config.round_wind == MJ_WT);
+
+  MJBaseScore expected, score;
+  assert(mj_get_score(&expected, &hands, &melds, config.win_tile, config.ron, config.player_wind,
+                      config.round_wind) == MJ_OK);
+  assert(mj_get_score(&score, &decoded_hands, &decoded_melds, decoded_config.win_tile, decoded_config.ron,
+                      decoded_config.player_wind, decoded_config.round_wind) == MJ_OK);
+  assert(score.han == expected.han && score.fu == expected.fu && strcmp(score.yaku_name, expected.yaku_name) == 0);
+
+  MJHands five = {{m1, m1, m1, m1, m1}, 5};
+  assert(mj_encode_hand_record(&record, &five, &melds, &config) == MJ_ERR_ILLEGAL_PARAM);
+  MJHands invalid = {{m1, (MJTileId)xx}, 2};
+  assert(mj_encode_hand_record(&record, &invalid, &melds, &config) == MJ_ERR_ILLEGAL_PARAM);
+  MJScoreConfig dragon_wind = {MJ_DG, true, MJ_DW, MJ_WT};
+  assert(mj_encode_hand_record(&record, &hands, &melds, &dragon_wind) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+/* score_hand_record は mj_decode_hand_record と mj_get_score を通したときと同じ値を返す */
+static void assert_score_hand_record(const MJHandRecord *record) {
+  MJScoreRecord result;
+  score_hand_record(&result, record);
+  MJHands hands;
+  MJMelds melds;
+  MJScoreConfig config;
+  MJBaseScore score;
+  int32_t ret = mj_decode_hand_record(&hands, &melds, &config, record);
+  if (ret == MJ_OK) {
+    ret = mj_get_score(&score, &hands, &melds, config.win_tile, config.ron, config.player_wind, config.round_wind);
+  }
+  assert(result.tag == record->tag && result.ret == ret);
+  if (ret == MJ_OK) {
+    assert(result.han == score.han && result.fu == score.fu && result.yaku == get_enum_yaku_mask(score.yaku_name));
+  }
+}
+
+static void test_score_hand_record() {
+  const MJHands hands = {{m2, m3, m4, p5, p5, s6, s7, s8, wt, wt, wt, wt, dg, dg, dg}, 15};
+  const MJMelds melds = {{{{s8, s6, s7}, 3, false, xx}, {{wt, wt, wt, wt}, 4, true, xx}}, 2};
+  const MJScoreConfig config = {MJ_DG, true, MJ_WN, MJ_WT};
+  MJHandRecord valid;
+  assert(mj_encode_hand_record(&valid, &hands, &melds, &config) == MJ_OK);
+  valid.tag = 7;
+  assert_score_hand_record(&valid);
+
+  MJHandRecord record = valid;
+  Tiles tiles;
+  decode_record_counts(&tiles, record.counts);
+  tiles.tiles[MJ_DG] = 1;  // 13枚
+  assert(encode_record_counts(record.counts, &tiles));
+  assert_score_hand_record(&record);
+  tiles.tiles[MJ_DG] = 3;
+  tiles.tiles[MJ_M1] = 4;  // 19枚
+  assert(encode_record_counts(record.counts, &tiles));
+  assert_score_hand_record(&record);
+
+  // 1種類5枚. encode_record_counts は受け付けないので直接 3 bit を書く
+  record = valid;
+  record.counts[0] |= 5;
+  decode_record_counts(&tiles, record.counts);
+  assert(tiles.tiles[MJ_M1] == 5);
+  assert_score_hand_record(&record);
+
+  record = valid;
+  record.meld_len = MJ_ELEMENTS_LEN + 1;
+  assert_score_hand_record(&record);
+  record = valid;
+  MJMeld missing = {{p1, p2, p3}, 3, false, xx};  // 手牌にない副露
+  assert(encode_record_meld(&record.melds[0], &missing));
+  assert_score_hand_record(&record);
+  record = valid;
+  record.win_tile = (uint8_t)(MJ_DR + 1);
+  assert_score_hand_record(&record);
+  record = valid;
+  record.win_tile = MJ_P1 | RECORD_RON;  // 手牌にないアガリ牌
+  assert_score_hand_record(&record);
+}
+
+static void test_mj_score_records() {
+  const MJHands hands[] = {
+      {{m2, m3, m4, p2, p3, p4, s2, s3, s4, s6, s7, s8, p5, p5}, 14},
+      {{m1, m1, m1, m9, m9, m9, p1, p1, p1, s9, s9, s9, dr, dr}, 14},
+      {{m1, m2, m3, m4, m5, m6, m7, m8, m9, wt, wt, wt, dw, dw}, 14},
+      {{m1, m9, p1, p9, s1, s9, wt, wn, ws, wp, dw, dg, dr, m1}, 14},
+      {{m1, m2, m4, p2, p3, p4, s2, s3, s4, s6, s7, s8, p5, p5}, 14},  // 和了していない
+  };
+  const MJMelds melds[] = {
+      {{}, 0}, {{}, 0}, {{{{wt, wt, wt}, 3, false, xx}}, 1}, {{}, 0}, {{}, 0},
+  };
+  const MJScoreConfig configs[] = {
+      {MJ_P5, false, MJ_WT, MJ_WT}, {MJ_DR, true, MJ_WN, MJ_WT}, {MJ_M5, true, MJ_WT, MJ_WT},
+      {MJ_M1, false, MJ_WS, MJ_WN}, {MJ_P5, false, MJ_WT, MJ_WT},
+  };
+  const uint32_t len = sizeof(hands) / sizeof(hands[0]);
+
+  char path[] = "/tmp/test_record_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  close(fd);
+  MJRecordFile file;
+  assert(mj_create_record_file(&file, path, MJ_RECORD_HANDS, len) == MJ_OK);
+  assert(file.len == len && file.writable);
+  MJHandRecord *records = (MJHandRecord *)file.records;
+  for (uint32_t i = 0; i < len; i++) {
+    assert(mj_encode_hand_record(&records[i], &hands[i], &melds[i], &configs[i]) == MJ_OK);
+    records[i].tag = 100 + i;
+  }
+  assert(mj_close_record_file(&file) == MJ_OK);
+
+  assert(mj_open_record_file(&file, path, MJ_RECORD_SCORES) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_open_record_file(&file, "/nonexistent/record", MJ_RECORD_HANDS) == MJ_ERR_IO);
+  assert(mj_open_record_file(&file, path, MJ_RECORD_HANDS) == MJ_OK);
+  assert(file.len == len && !file.writable);
+
+  MJScoreRecord results[sizeof(hands) / sizeof(hands[0])];
+  for (uint32_t threads = 0; threads <= 3; threads++) {
+    memset(results, 0, sizeof(results));
+    assert(mj_score_records(results, (const MJHandRecord *)file.records, file.len, threads) == MJ_OK);
+    for (uint32_t i = 0; i < len; i++) {
+      MJBaseScore score;
+      int32_t ret = mj_get_score(&score, &hands[i], &melds[i], configs[i].win_tile, configs[i].ron,
+                                 configs[i].player_wind, configs[i].round_wind);
+      assert(results[i].tag == 100 + i && results[i].ret == ret);
+      if (ret == MJ_OK) {
+        assert(results[i].han == score.han && results[i].fu == score.fu);
+        assert(results[i].yaku == get_enum_yaku_mask(score.yaku_name) && results[i].yaku != 0);
+      }
+    }
+  }
+  assert(results[4].ret != MJ_OK);
+  assert(mj_score_records(results, (const MJHandRecord *)file.records, file.len, MJ_BATCH_MAX_THREADS + 1) ==
+         MJ_ERR_ILLEGAL_PARAM);
+
+  MJShantenRecord shantens[sizeof(hands) / sizeof(hands[0])];
+  assert(mj_calc_shanten_records(shantens, (const MJHandRecord *)file.records, file.len, 2) == MJ_OK);
+  for (uint32_t i = 0; i < len; i++) {
+    assert(shantens[i].tag == 100 + i && shantens[i].ret == MJ_OK);
+  }
+  assert(shantens[0].normal == -1 && shantens[3].kokushi == -1 && shantens[4].normal == 0);
+  assert(shantens[2].normal == -1 && shantens[2].chiitoitsu == MJ_RECORD_NO_SHANTEN);  // 副露を除いた 11 枚
+  assert(shantens[2].kokushi == MJ_RECORD_NO_SHANTEN);
+  assert(mj_close_record_file(&file) == MJ_OK);
+
+  // 短いファイルはヘッダの len を信用しない
+  assert(truncate(path, (off_t)(sizeof(MJRecordHeader) + sizeof(MJHandRecord))) == 0);
+  assert(mj_open_record_file(&file, path, MJ_RECORD_HANDS) == MJ_ERR_ILLEGAL_PARAM);
+  unlink(path);
+}
+
+bool test_record() {
+  test_record_counts();
+  test_record_meld();
+  test_mj_hand_record();
+  test_score_hand_record();
+  test_mj_score_records();
+  return true;
+}
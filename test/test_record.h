@@ -0,0 +1,5 @@
+#pragma once
+
+#include "record.h"
+
+bool test_record();
@@ -0,0 +1,231 @@
+#include "test_ring.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "test_util.h"
+
+#define TEST_RING_LEN 16
+#define TEST_RING_QUERIES 3000
+#define TEST_RING_PRODUCERS 3
+#define TEST_RING_WINDOW 8  // 1つの書き込み側が結果を待たずに書き込む数. 合計は TEST_RING_LEN より多くてもよい
+
+static MJQuery queries[TEST_RING_QUERIES];
+
+static void init_ring_queries() {
+  const char *hands[] = {"234m2234455p234s+3p", "123m456p789s1234z", "123m456p789s11z23s", "23m55p666z(678s)[1111z]"};
+  for (uint32_t i = 0; i < TEST_RING_QUERIES; i++) {
+    const char *str = hands[i % 4];
+    MJNotation notation;
+    assert(mj_parse_notation(&notation, str, strlen(str)) == MJ_OK);
+    MJHands hands_;
+    assert(mj_notation_to_hands(&hands_, &notation) == MJ_OK);
+    MJScoreConfig config = {notation.has_win_tile ? notation.win_tile : MJ_M1, i % 2 == 0, MJ_WT, MJ_WT};
+    memset(&queries[i], 0, sizeof(MJQuery));
+    assert(mj_encode_hand_record(&queries[i].hand, &hands_, &notation.melds, &config) == MJ_OK);
+    queries[i].hand.tag = i;
+    queries[i].kind = MJ_QUERY_SCORE + i % 4;
+  }
+}
+
+/* queries[first + k * step] を書き込み, 最大 TEST_RING_WINDOW 個を処理中にしながら結果を確かめる */
+static void produce_ring(MJRing *ring, uint32_t first, uint32_t step) {
+  uint32_t tickets[TEST_RING_WINDOW];
+  uint32_t indexes[TEST_RING_WINDOW];
+  uint32_t submitted = 0;
+  uint32_t waited = 0;
+  uint32_t i = first;
+  while (i < TEST_RING_QUERIES || waited < submitted) {
+    int32_t ret = MJ_ERR_BUSY;
+    if (i < TEST_RING_QUERIES && submitted - waited < TEST_RING_WINDOW) {
+      uint32_t k = submitted % TEST_RING_WINDOW;
+      ret = mj_submit_ring(ring, &tickets[k], &queries[i]);
+      assert(ret == MJ_OK || ret == MJ_ERR_BUSY);
+      if (ret == MJ_OK) {
+        indexes[k] = i;
+        submitted++;
+        i += step;
+        continue;
+      }
+    }
+    if (waited == submitted) {
+      sched_yield();  // 他の書き込み側が結果を読むまで空かない
+      continue;
+    }
+    uint32_t k = waited++ % TEST_RING_WINDOW;
+    MJQueryResult result, expected;
+    assert(mj_wait_ring(ring, &result, tickets[k]) == MJ_OK);
+    process_server_query(&expected, &queries[indexes[k]]);
+    assert(memcmp(&result, &expected, sizeof(MJQueryResult)) == 0);
+  }
+}
+
+typedef struct {
+  MJRing *ring;
+  uint32_t first;
+} TestRingProducer;
+
+static void *run_test_ring_producer(void *arg) {
+  TestRingProducer *producer = (TestRingProducer *)arg;
+  produce_ring(producer->ring, producer->first, TEST_RING_PRODUCERS);
+  return NULL;
+}
+
+static void *run_test_ring(void *arg) {
+  assert(mj_run_ring((MJRing *)arg, 2) == MJ_OK);
+  return NULL;
+}
+
+/* 別のプロセスが作ったファイルとして, len と mask だけを書いたヘッダを開く */
+static int32_t open_test_ring_header(uint32_t len, uint32_t mask, uint64_t slots) {
+  FILE *fp = tmpfile();
+  assert(fp);
+  RingHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, RING_MAGIC, sizeof(header.magic));
+  header.version = RING_VERSION;
+  header.len = len;
+  header.mask = mask;
+  int fd = dup(fileno(fp));
+  fclose(fp);
+  assert(ftruncate(fd, (off_t)(sizeof(RingHeader) + slots * sizeof(RingSlot))) == 0);
+  assert(pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header));
+  MJRing ring;
+  int32_t ret = mj_open_ring(&ring, fd);
+  if (ret == MJ_OK) {
+    mj_close_ring(&ring);
+  } else {
+    close(fd);
+  }
+  return ret;
+}
+
+static void test_mj_create_ring() {
+  MJRing ring;
+  assert(mj_create_ring(&ring, 0) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_create_ring(&ring, 2) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_create_ring(&ring, 3) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_create_ring(&ring, MJ_RING_MAX_LEN * 2) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_create_ring(&ring, TEST_RING_LEN) == MJ_OK);
+  assert(ring.len == TEST_RING_LEN && ring.fd >= 0);
+  assert(get_ring_slot(&ring, TEST_RING_LEN + 1) == get_ring_slot(&ring, 1));
+  assert(atomic_load(&get_ring_slot(&ring, 5)->seq) == 5);
+
+  // 同じ memfd を別に mmap しても同じリング
+  MJRing opened;
+  assert(mj_open_ring(&opened, dup(ring.fd)) == MJ_OK);
+  assert(opened.len == TEST_RING_LEN && opened.map != ring.map);
+  atomic_store(&get_ring_header(&ring)->tail, 3);
+  assert(atomic_load(&get_ring_header(&opened)->tail) == 3);
+  mj_close_ring(&opened);
+  mj_close_ring(&ring);
+  assert(ring.map == NULL && ring.fd == -1);
+
+  int fd = open("/dev/null", O_RDONLY);
+  assert(mj_open_ring(&opened, fd) == MJ_ERR_ILLEGAL_PARAM);
+  close(fd);
+
+  // mj_create_ring と同じ len の検査. 大きさと mask が合っていても開かない
+  assert(open_test_ring_header(TEST_RING_LEN, TEST_RING_LEN - 1, TEST_RING_LEN) == MJ_OK);
+  assert(open_test_ring_header(0, 0u - 1, 0) == MJ_ERR_ILLEGAL_PARAM);
+  assert(open_test_ring_header(1, 0, 1) == MJ_ERR_ILLEGAL_PARAM);
+  assert(open_test_ring_header(2, 1, 2) == MJ_ERR_ILLEGAL_PARAM);
+  assert(open_test_ring_header(3, 2, 3) == MJ_ERR_ILLEGAL_PARAM);
+  assert(open_test_ring_header(MJ_RING_MAX_LEN * 2, MJ_RING_MAX_LEN * 2 - 1, MJ_RING_MAX_LEN * 2) ==
+         MJ_ERR_ILLEGAL_PARAM);
+  assert(open_test_ring_header(TEST_RING_LEN, TEST_RING_LEN - 1, TEST_RING_LEN - 1) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+/* 全てのスロットに読まれていない結果があれば, 次の書き込みは前の周の結果を上書きしない */
+static void test_mj_submit_ring_full() {
+  MJRing ring;
+  assert(mj_create_ring(&ring, MJ_RING_MIN_LEN) == MJ_OK);
+  uint32_t tickets[MJ_RING_MIN_LEN];
+  for (uint32_t i = 0; i < MJ_RING_MIN_LEN; i++) {
+    assert(mj_submit_ring(&ring, &tickets[i], &queries[i]) == MJ_OK && tickets[i] == i);
+  }
+  uint32_t ticket;
+  assert(mj_submit_ring(&ring, &ticket, &queries[MJ_RING_MIN_LEN]) == MJ_ERR_BUSY);  // 計算していない
+  // stop してからワーカーを呼ぶと, 書き込まれた分を計算して返る
+  mj_stop_ring(&ring);
+  run_ring_worker(&ring);
+  assert(mj_submit_ring(&ring, &ticket, &queries[MJ_RING_MIN_LEN]) == MJ_ERR_BUSY);  // 結果を読んでいない
+
+  MJQueryResult result, expected;
+  assert(mj_wait_ring(&ring, &result, tickets[0]) == MJ_OK);
+  process_server_query(&expected, &queries[0]);
+  assert(memcmp(&result, &expected, sizeof(result)) == 0);
+  assert(mj_submit_ring(&ring, &ticket, &queries[MJ_RING_MIN_LEN]) == MJ_OK && ticket == MJ_RING_MIN_LEN);
+  assert(mj_submit_ring(&ring, &ticket, &queries[0]) == MJ_ERR_BUSY);
+  run_ring_worker(&ring);
+  for (uint32_t i = 1; i <= MJ_RING_MIN_LEN; i++) {
+    assert(mj_wait_ring(&ring, &result, i) == MJ_OK);
+    process_server_query(&expected, &queries[i]);
+    assert(memcmp(&result, &expected, sizeof(result)) == 0);
+  }
+  mj_close_ring(&ring);
+}
+
+static void test_mj_run_ring() {
+  MJRing ring;
+  assert(mj_create_ring(&ring, TEST_RING_LEN) == MJ_OK);
+  assert(mj_run_ring(&ring, MJ_BATCH_MAX_THREADS + 1) == MJ_ERR_ILLEGAL_PARAM);
+  pthread_t thread;
+  assert(pthread_create(&thread, NULL, run_test_ring, &ring) == 0);
+
+  clock_t start = clock();
+  pthread_t producers[TEST_RING_PRODUCERS];
+  TestRingProducer args[TEST_RING_PRODUCERS];
+  for (uint32_t i = 0; i < TEST_RING_PRODUCERS; i++) {
+    args[i] = (TestRingProducer){&ring, i};
+    assert(pthread_create(&producers[i], NULL, run_test_ring_producer, &args[i]) == 0);
+  }
+  for (uint32_t i = 0; i < TEST_RING_PRODUCERS; i++) {
+    assert(pthread_join(producers[i], NULL) == 0);
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  fprintf(stderr, "ring: %.0f queries/s\n", seconds > 0.0 ? TEST_RING_QUERIES / seconds : 0.0);
+  mj_stop_ring(&ring);
+  assert(pthread_join(thread, NULL) == 0);
+  const RingHeader *header = get_ring_header(&ring);
+  assert(atomic_load(&header->head) == TEST_RING_QUERIES && atomic_load(&header->tail) == TEST_RING_QUERIES);
+  mj_close_ring(&ring);
+}
+
+/* 計算する側は別のプロセス */
+static void test_ring_process() {
+  MJRing ring;
+  assert(mj_create_ring(&ring, 4) == MJ_OK);
+  pid_t pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    MJRing child;
+    int32_t ret = mj_open_ring(&child, ring.fd);
+    if (ret == MJ_OK) {
+      ret = mj_run_ring(&child, 1);
+    }
+    _exit(ret == MJ_OK ? 0 : 1);
+  }
+  produce_ring(&ring, 0, 1);
+  mj_stop_ring(&ring);
+  int status;
+  assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  mj_close_ring(&ring);
+}
+
+bool test_ring() {
+  init_ring_queries();
+  test_mj_create_ring();
+  test_mj_submit_ring_full();
+  test_mj_run_ring();
+  test_ring_process();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "ring.h"
+
+bool test_ring();
@@ -0,0 +1,175 @@
+#include "test_scheduler.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "test_util.h"
+
+#define TEST_TASKS_LEN 10007  // 素数. ワーカー数で割り切れない
+
+static void test_sched_deque() {
+  static SchedDeque deque;
+  atomic_init(&deque.top, 0);
+  atomic_init(&deque.bottom, 0);
+  uint64_t begin;
+  uint64_t end;
+  assert(!pop_sched_deque(&deque, &begin, &end));
+  assert(!steal_sched_deque(&deque, &begin, &end));
+  push_sched_deque(&deque, 0, 8);
+  push_sched_deque(&deque, 8, 12);
+  push_sched_deque(&deque, 12, 14);
+  // 持ち主は最後に積んだ区間から, 盗む側は最初に積んだ区間から取り出す
+  assert(pop_sched_deque(&deque, &begin, &end) && begin == 12 && end == 14);
+  assert(steal_sched_deque(&deque, &begin, &end) && begin == 0 && end == 8);
+  assert(pop_sched_deque(&deque, &begin, &end) && begin == 8 && end == 12);
+  assert(!pop_sched_deque(&deque, &begin, &end));
+  assert(!steal_sched_deque(&deque, &begin, &end));
+
+  // 一周しても同じように使える
+  for (uint64_t i = 0; i < SCHED_DEQUE_LEN * 3; i++) {
+    push_sched_deque(&deque, i, i + 1);
+    assert(steal_sched_deque(&deque, &begin, &end) && begin == i && end == i + 1);
+  }
+}
+
+static void test_next_scheduler_range() {
+  static Scheduler sched;
+  static uint8_t done[TEST_TASKS_LEN];
+  memset(done, 0, sizeof(done));
+  // ワーカー1のスレッドがない場合も, ワーカー0が全て盗んで実行する
+  init_scheduler(&sched, TEST_TASKS_LEN, 2, 16);
+  uint64_t begin;
+  uint64_t end;
+  while (next_scheduler_range(&sched, 0, &begin, &end)) {
+    assert(begin < end && end - begin <= 16 && end <= TEST_TASKS_LEN);
+    for (uint64_t i = begin; i < end; i++) {
+      done[i]++;
+    }
+    finish_scheduler_range(&sched, begin, end);
+  }
+  for (uint32_t i = 0; i < TEST_TASKS_LEN; i++) {
+    assert(done[i] == 1);
+  }
+}
+
+typedef struct {
+  atomic_uint counts[TEST_TASKS_LEN];
+  uint32_t threads;
+  struct {
+    alignas(SCHED_CACHE_LINE) uint64_t sum;
+  } shards[MJ_BATCH_MAX_THREADS];
+} ParallelForTest;
+
+static void count_task(void *arg, uint32_t worker, uint64_t index) {
+  ParallelForTest *test = (ParallelForTest *)arg;
+  assert(worker < test->threads);
+  assert(index < TEST_TASKS_LEN);
+  atomic_fetch_add(&test->counts[index], 1);
+  test->shards[worker].sum += index;
+}
+
+static void test_mj_parallel_for() {
+  static ParallelForTest test;
+  const uint32_t threads[] = {1, 3, 8, MJ_BATCH_MAX_THREADS};
+  const uint64_t grains[] = {0, 1, 100};
+  for (uint32_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    for (uint32_t j = 0; j < sizeof(grains) / sizeof(grains[0]); j++) {
+      memset(&test, 0, sizeof(test));
+      test.threads = threads[i];
+      assert(mj_parallel_for(TEST_TASKS_LEN, threads[i], grains[j], count_task, &test) == MJ_OK);
+      uint64_t sum = 0;
+      for (uint32_t k = 0; k < MJ_BATCH_MAX_THREADS; k++) {
+        sum += test.shards[k].sum;
+      }
+      assert(sum == (uint64_t)TEST_TASKS_LEN * (TEST_TASKS_LEN - 1) / 2);
+      for (uint32_t k = 0; k < TEST_TASKS_LEN; k++) {
+        assert(atomic_load(&test.counts[k]) == 1);
+      }
+    }
+  }
+  memset(&test, 0, sizeof(test));
+  test.threads = MJ_BATCH_MAX_THREADS;
+  assert(mj_parallel_for(0, 4, 0, count_task, &test) == MJ_OK);
+  assert(mj_parallel_for(3, 4, 0, count_task, &test) == MJ_OK);  // タスク数よりスレッドが多い
+  assert(mj_parallel_for(1, MJ_BATCH_MAX_THREADS + 1, 0, count_task, &test) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_parallel_for(1, 1, 0, NULL, &test) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+static void test_mj_get_scores_batch() {
+  static MJHands hands[3] = {
+      {{m1, m2, m3, p1, p2, p3, s1, s2, s3, s1, s2, s3, s9, s9}, 14},
+      {{m5, m5, p2, p3, p4, s4, s5, s6, s6, s7, dw, dw, dw, s5}, 14},
+      {{m1, m2, m3, p1, p2, p3, s1, s2, s3, s1, s2, s4, s9, s9}, 14},  // アガリ形でない
+  };
+  static MJMelds melds[3];
+  static MJScoreConfig configs[3] = {{p1, true, wt, wt}, {s5, false, wt, wt}, {p1, true, wt, wt}};
+  static MJBaseScore scores[3];
+  int32_t rets[3];
+  for (uint32_t threads = 1; threads <= 3; threads++) {
+    assert(mj_get_scores_batch(scores, rets, hands, melds, configs, 3, threads) == MJ_OK);
+    for (uint32_t i = 0; i < 3; i++) {
+      MJBaseScore score;
+      int32_t ret = mj_get_score(&score, &hands[i], &melds[i], configs[i].win_tile, configs[i].ron,
+                                 configs[i].player_wind, configs[i].round_wind);
+      assert(rets[i] == ret);
+      if (ret == MJ_OK) {
+        assert(scores[i].han == score.han && scores[i].fu == score.fu);
+        assert(strcmp(scores[i].yaku_name, score.yaku_name) == 0);
+      }
+    }
+  }
+  assert(rets[0] == MJ_OK && scores[0].han == 7);
+  assert(rets[2] != MJ_OK);
+}
+
+static void test_mj_play_games() {
+  MJGameConfig config = {2024, 4, 25000, {}};
+  for (uint32_t i = 0; i < MJ_GAME_PLAYERS; i++) {
+    config.players[i].decide = mj_decide_greedy;
+  }
+  static MJGameResult results1[12];
+  static MJGameResult results2[12];
+  MJGameStats stats1;
+  MJGameStats stats2;
+  assert(mj_play_games(results1, &stats1, 12, &config, 1) == MJ_OK);
+  // スレッド数によらず同じ結果になる
+  assert(mj_play_games(results2, &stats2, 12, &config, 4) == MJ_OK);
+  assert(memcmp(results1, results2, sizeof(results1)) == 0);
+  assert(memcmp(&stats1, &stats2, sizeof(MJGameStats)) == 0);
+  assert(mj_play_games(NULL, &stats2, 12, &config, 12) == MJ_OK);
+  assert(memcmp(&stats1, &stats2, sizeof(MJGameStats)) == 0);
+
+  // index 番目の対局は mj_batch_game_seed で再現できる
+  MJGameStats stats = {0};
+  for (uint32_t i = 0; i < 12; i++) {
+    MJGameConfig single = config;
+    single.seed = mj_batch_game_seed(config.seed, i);
+    MJGameResult result;
+    assert(mj_play_game(&result, &single) == MJ_OK);
+    assert(memcmp(&result, &results1[i], sizeof(MJGameResult)) == 0);
+    stats.hands += result.hands;
+    for (uint32_t j = 0; j < MJ_GAME_PLAYERS; j++) {
+      stats.points[j] += result.points[j];
+      stats.ranks[j][result.ranks[j]]++;
+    }
+  }
+  assert(stats1.games == 12);
+  assert(stats1.hands == stats.hands);
+  assert(stats1.wins + stats1.exhaustive_draws == stats1.hands);
+  assert(memcmp(stats1.points, stats.points, sizeof(stats.points)) == 0);
+  assert(memcmp(stats1.ranks, stats.ranks, sizeof(stats.ranks)) == 0);
+
+  assert(mj_play_games(NULL, NULL, 4, &config, MJ_BATCH_MAX_THREADS + 1) == MJ_ERR_ILLEGAL_PARAM);
+  config.rounds = 0;
+  assert(mj_play_games(results1, &stats1, 4, &config, 2) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+bool test_scheduler() {
+  test_sched_deque();
+  test_next_scheduler_range();
+  test_mj_parallel_for();
+  test_mj_get_scores_batch();
+  test_mj_play_games();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "scheduler.h"
+
+bool test_scheduler();
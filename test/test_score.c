@@ -165,6 +165,8 @@ void test_calc_score() {
                     "");  // 役なし(ペンチャン待ち)
   _test_calc_score0(m1, m2, m3, p2, p3, p4, s3, s4, s5, s7, s8, s9, m1, p3, 1, wt, wt, 0, 40,
                     "");  // 役なし(カンチャン待ち)
+  _test_calc_score0(m2, m2, m2, m2, m3, m4, ws, ws, ws, p2, p3, p4, p9, m2, 1, wt, wt, 0, 50,
+                    "");  // 役なし(シャンポン/両面待ち. 両面待ちを採用し222は暗刻)
   _test_calc_score0(m1, m2, m3, p2, p3, p4, s3, s4, s5, s7, s8, s9, m1, m3, 0, wt, wt, 1, 30, "tsumo ");   // 自摸
   _test_calc_score0(m2, m3, m4, p2, p3, p4, s3, s4, s5, s6, s7, s8, m2, p3, 1, wt, wt, 1, 40, "tanyao ");  // 断么九
   _test_calc_score0(m2, m3, m4, p2, p3, p4, p2, p3, p4, s6, s7, s8, m2, p4, 1, wt, wt, 3, 30,
@@ -187,6 +189,8 @@ void test_calc_score() {
   _test_calc_score0(m1, m1, m1, p7, p7, p7, s2, s2, s2, s4, s4, s4, s3, p7, 1, ws, wt, 4, 50,
                     "toitoi sanankou ");  // 対々和,三暗刻
   _test_calc_score0(m1, m1, m1, p7, p8, p9, s2, s2, s2, s4, s4, s4, s3, p7, 1, ws, wt, 2, 50, "sanankou ");  // 三暗刻
+  _test_calc_score0(m2, m2, m2, m2, m3, m4, p5, p5, p5, s7, s7, s7, s9, m2, 1, ws, wt, 2, 50,
+                    "sanankou ");  // 三暗刻(ロンのm2は234の両面待ちと解釈して222は暗刻)
   _test_calc_score0(m2, m2, m2, p7, p8, p9, s2, s2, s2, p2, p2, p2, s3, p2, 1, ws, wt, 2, 40,
                     "sanshoku_douko ");  // 三色同刻(p2が明刻扱いでちょうど40符)
                                          // (三槓子は_test_calc_score1でテストする)
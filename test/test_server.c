@@ -0,0 +1,202 @@
+#include "test_server.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "test_util.h"
+
+#define TEST_SERVER_CLIENTS 4
+#define TEST_SERVER_QUERIES 1500  // MJ_SERVER_BATCH_LEN より多い
+#define TEST_SERVER_STALLED_QUERIES 100000
+
+static void init_query(MJQuery *query, MJQueryKind kind, const char *str, bool ron) {
+  MJNotation notation;
+  assert(mj_parse_notation(&notation, str, strlen(str)) == MJ_OK);
+  MJHands hands;
+  assert(mj_notation_to_hands(&hands, &notation) == MJ_OK);
+  MJScoreConfig config = {notation.has_win_tile ? notation.win_tile : MJ_M1, ron, MJ_WT, MJ_WT};
+  memset(query, 0, sizeof(MJQuery));
+  assert(mj_encode_hand_record(&query->hand, &hands, &notation.melds, &config) == MJ_OK);
+  query->kind = kind;
+}
+
+static void test_process_server_query() {
+  MJQuery query;
+  MJQueryResult result;
+  init_query(&query, MJ_QUERY_SCORE, "234m2234455p234s+3p", true);
+  query.hand.tag = 7;
+  process_server_query(&result, &query);
+  assert(result.tag == 7 && result.kind == MJ_QUERY_SCORE && result.ret == MJ_OK);
+  assert(result.han == 4 && result.fu == 40 && result.value != 0);
+  MJScoreRecord score;
+  score_hand_record(&score, &query.hand);
+  assert(result.value == score.yaku);
+
+  init_query(&query, MJ_QUERY_SHANTEN, "123m456p789s1234z", false);
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_OK && result.normal == 2 && result.chiitoitsu == 6 && result.kokushi == 7);
+  assert(result.value == 0);
+
+  // 14s 待ち. 手牌の 2s, 3s は数えない
+  init_query(&query, MJ_QUERY_UKEIRE, "123m456p789s11z23s", false);
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_OK && result.normal == 0);
+  assert(result.value == ((1ull << MJ_S1) | (1ull << MJ_S4)) && result.count == 8);
+  query.kind = MJ_QUERY_WAIT;
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_OK && result.value == ((1ull << MJ_S1) | (1ull << MJ_S4)) && result.count == 8);
+
+  // 副露を除いた手牌. 副露の牌も数えない
+  init_query(&query, MJ_QUERY_WAIT, "23m55p666z(678s)[1111z]", false);
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_OK && result.normal == 0 && result.chiitoitsu == MJ_RECORD_NO_SHANTEN);
+  assert(result.value == ((1ull << MJ_M1) | (1ull << MJ_M4)) && result.count == 8);
+
+  // テンパイでなければ待ちはない
+  init_query(&query, MJ_QUERY_WAIT, "123m456p789s1234z", false);
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_OK && result.normal == 2 && result.value == 0 && result.count == 0);
+  query.kind = MJ_QUERY_UKEIRE;
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_OK && result.value != 0);
+
+  query.kind = 0;
+  process_server_query(&result, &query);
+  assert(result.ret == MJ_ERR_ILLEGAL_PARAM);
+}
+
+static MJServer server;
+
+typedef struct {
+  const char *path;
+  const MJQuery *queries;
+  uint32_t offset;
+} TestServerClient;
+
+static void *run_test_server(void *arg) {
+  (void)arg;
+  assert(mj_run_server(&server) == MJ_OK);
+  return NULL;
+}
+
+static void *run_test_server_client(void *arg) {
+  TestServerClient *client = (TestServerClient *)arg;
+  int32_t fd;
+  assert(mj_connect_server(&fd, client->path) == MJ_OK);
+  static MJQueryResult results[TEST_SERVER_CLIENTS][TEST_SERVER_QUERIES];
+  MJQueryResult *result = results[client->offset];
+  // 少しずつ送っても, まとめて送っても同じ
+  assert(mj_query_server(fd, result, client->queries, 3) == MJ_OK);
+  assert(mj_query_server(fd, &result[3], &client->queries[3], TEST_SERVER_QUERIES - 3) == MJ_OK);
+  for (uint32_t i = 0; i < TEST_SERVER_QUERIES; i++) {
+    MJQueryResult expected;
+    process_server_query(&expected, &client->queries[i]);
+    assert(memcmp(&result[i], &expected, sizeof(MJQueryResult)) == 0);
+  }
+  close(fd);
+  return NULL;
+}
+
+/* 結果を読まずに送れなくなるまで問い合わせを送る. 送れた問い合わせの数を返す */
+static uint32_t send_test_server_stalled(int32_t fd, const MJQuery *queries) {
+  uint32_t sent = 0;
+  while (sent < TEST_SERVER_STALLED_QUERIES) {
+    MJQuery query = queries[sent % TEST_SERVER_QUERIES];
+    query.hand.tag = sent;
+    ssize_t n = send(fd, &query, sizeof(query), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      if (poll(&pfd, 1, 100) == 0) {
+        break;  // サーバーが受信を止めた
+      }
+      continue;
+    }
+    assert(n == sizeof(query));
+    sent++;
+  }
+  return sent;
+}
+
+static void recv_test_server_stalled(int32_t fd, const MJQuery *queries, uint32_t sent) {
+  for (uint32_t i = 0; i < sent; i++) {
+    MJQueryResult result;
+    for (uint64_t len = 0; len < sizeof(result);) {
+      ssize_t n = recv(fd, (uint8_t *)&result + len, sizeof(result) - len, 0);
+      assert(n > 0);
+      len += (uint64_t)n;
+    }
+    MJQuery query = queries[i % TEST_SERVER_QUERIES];
+    query.hand.tag = i;
+    MJQueryResult expected;
+    process_server_query(&expected, &query);
+    assert(memcmp(&result, &expected, sizeof(MJQueryResult)) == 0);
+  }
+}
+
+static void test_mj_run_server() {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/test_server_%d.sock", (int)getpid());
+  const char *hands[] = {"234m2234455p234s+3p", "123m456p789s1234z", "123m456p789s11z23s", "23m55p666z(678s)[1111z]",
+                         "19m19p19s1234567z"};
+  static MJQuery queries[TEST_SERVER_QUERIES];
+  for (uint32_t i = 0; i < TEST_SERVER_QUERIES; i++) {
+    init_query(&queries[i], (MJQueryKind)(MJ_QUERY_SCORE + i % 4), hands[i % 5], i % 2 == 0);
+    queries[i].hand.tag = i;
+  }
+
+  assert(mj_open_server(&server, path, 2) == MJ_OK);
+  pthread_t thread;
+  assert(pthread_create(&thread, NULL, run_test_server, NULL) == 0);
+  // 結果を読まないクライアントがいても, 他のクライアントは待たされない
+  int32_t stalled;
+  assert(mj_connect_server(&stalled, path) == MJ_OK);
+  uint32_t sent = send_test_server_stalled(stalled, queries);
+  assert(sent > 0 && sent < TEST_SERVER_STALLED_QUERIES);
+  pthread_t clients[TEST_SERVER_CLIENTS];
+  TestServerClient args[TEST_SERVER_CLIENTS];
+  for (uint32_t i = 0; i < TEST_SERVER_CLIENTS; i++) {
+    args[i] = (TestServerClient){path, queries, i};
+    assert(pthread_create(&clients[i], NULL, run_test_server_client, &args[i]) == 0);
+  }
+  for (uint32_t i = 0; i < TEST_SERVER_CLIENTS; i++) {
+    assert(pthread_join(clients[i], NULL) == 0);
+  }
+  recv_test_server_stalled(stalled, queries, sent);
+  close(stalled);
+  mj_stop_server(&server);
+  assert(pthread_join(thread, NULL) == 0);
+
+  const MJServerStats *stats = &server.stats;
+  assert(stats->connections == TEST_SERVER_CLIENTS + 1);
+  assert(stats->queries == TEST_SERVER_CLIENTS * TEST_SERVER_QUERIES + sent);
+  assert(stats->batches > 0 && stats->batches <= stats->queries && stats->max_batch <= MJ_SERVER_BATCH_LEN);
+  uint32_t p50 = mj_server_latency_percentile(stats, 50.0);
+  uint32_t p99 = mj_server_latency_percentile(stats, 99.0);
+  assert(p50 <= p99 && p99 < MJ_SERVER_LATENCY_LEN);
+  fprintf(stderr, "server: %llu queries, %llu batches, p50 %uus, p99 %uus\n", (unsigned long long)stats->queries,
+          (unsigned long long)stats->batches, p50, p99);
+  mj_close_server(&server);
+  assert(access(path, F_OK) != 0);
+
+  int32_t fd;
+  assert(mj_connect_server(&fd, path) == MJ_ERR_IO);
+  char long_path[MJ_SERVER_PATH_LEN + 1];
+  memset(long_path, 'a', sizeof(long_path) - 1);
+  long_path[sizeof(long_path) - 1] = '\0';
+  assert(mj_open_server(&server, long_path, 1) == MJ_ERR_ILLEGAL_PARAM);
+  assert(mj_open_server(&server, path, MJ_BATCH_MAX_THREADS + 1) == MJ_ERR_ILLEGAL_PARAM);
+  mj_close_server(&server);
+  assert(mj_open_server(&server, "/nonexistent/test_server.sock", 1) == MJ_ERR_IO);
+}
+
+bool test_server() {
+  test_process_server_query();
+  test_mj_run_server();
+  return true;
+}
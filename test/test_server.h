@@ -0,0 +1,5 @@
+#pragma once
+
+#include "server.h"
+
+bool test_server();
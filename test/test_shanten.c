@@ -2,8 +2,13 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "bitboard.h"
+#include "rng.h"
+#include "shanten.h"
 #include "test_util.h"
+#include "tile.h"
 
 #define SHOW_PROGRESS 0
 
@@ -32,6 +37,17 @@ int32_t test_calc_shanten_14(MJTileId t1, MJTileId t2, MJTileId t3, MJTileId t4,
   return shanten.normal;
 }
 
+/* 副露して手牌が 3n+1 枚(n < 4)の場合 */
+static int32_t test_calc_shanten_melded(const MJTileId *tile_ids, uint32_t len) {
+  MJHands hands;
+  memcpy(hands.tile_id, tile_ids, sizeof(MJTileId) * len);
+  hands.len = len;
+  MJShanten shanten;
+  int ret = mj_calc_shanten(&hands, &shanten);
+  assert(ret == MJ_OK);
+  return shanten.normal;
+}
+
 void test_calc_shanten() {
   // テンパイ
   assert(test_calc_shanten_13(m1, m2, m3, m1, m2, m3, p1, p2, p3, s1, s2, s3, dw) == 0);
@@ -45,6 +61,231 @@ void test_calc_shanten() {
 
   /* 4 9 12 15 16 17 21 21 24 27 29 30 32 33 5 6 5 */
   assert(test_calc_shanten_14(4, 9, 12, 15, 16, 17, 21, 21, 24, 27, 29, 30, 32, 33) == 5);
+
+  // 副露あり: 搭子の数は残りの面子の数までしか数えない(以前は4まで数えて1少なく返していた)
+  assert(test_calc_shanten_melded((MJTileId[]){p2, p4, p7, p8}, 4) == 1);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m3, m5, m7}, 4) == 1);
+  assert(test_calc_shanten_melded((MJTileId[]){m2, m4, m7, m8}, 4) == 1);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m2, m3, m4}, 4) == 0);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m4, m7, s9}, 4) == 2);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m3, p4, p6, s7, s9, wt}, 7) == 2);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m2, m4, m5, m7, m8, p9}, 7) == 2);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m1, m2, m2, p3, p5, p7}, 7) == 1);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m1, m2, m2, p3, p3, p4, p4, s5, s7}, 10) == 2);
+  assert(test_calc_shanten_melded((MJTileId[]){m1, m3, m6, m8, p1, p3, p5, p7, s1, s3}, 10) == 3);
+}
+
+/*
+ * 手牌全体を1度に探索する以前の calc_shanten_normal. 種類ごとに分解する今の実装と比べる.
+ * 面子, 塔子は牌の小さい順にしか取り出さない.
+ */
+typedef struct {
+  Bitboard bb;
+  int32_t total_len;
+  int32_t elem_len;
+  int32_t pair_len;
+  int32_t partial_len;
+  int32_t shanten_min;
+  int32_t shanten;
+} RefShantenCtx;
+
+static bool ref_dig_partial(RefShantenCtx *ctx, MJTileId from);
+
+static bool ref_dig_partial_block(RefShantenCtx *ctx, uint32_t suit, uint32_t rank, uint64_t block) {
+  ctx->bb.suit[suit] = remove_bb_block(ctx->bb.suit[suit], rank, block);
+  ctx->partial_len++;
+  bool limit = ref_dig_partial(ctx, get_bb_tile_id(suit, rank));
+  ctx->partial_len--;
+  ctx->bb.suit[suit] = add_bb_block(ctx->bb.suit[suit], rank, block);
+  return limit;
+}
+
+static bool ref_dig_partial(RefShantenCtx *ctx, MJTileId from) {
+  if (ctx->elem_len + ctx->partial_len < ctx->total_len / MJ_MIN_TILES_LEN_IN_ELEMENT) {
+    for (uint32_t suit = get_bb_suit(from); suit < BB_LEN; suit++) {
+      uint64_t word = ctx->bb.suit[suit];
+      uint64_t pairs = find_bb_pairs(word);
+      uint64_t adjacents = suit == BB_HONORS ? 0 : find_bb_adjacents(word);
+      uint64_t gaps = suit == BB_HONORS ? 0 : find_bb_gaps(word);
+      uint64_t candidates = pairs | adjacents | gaps;
+      if (suit == get_bb_suit(from)) {
+        candidates &= ~(get_bb_rank_bit(get_bb_rank(from)) - 1);
+      }
+      while (candidates) {
+        uint32_t rank = get_bb_lowest_rank(candidates);
+        uint64_t bit = get_bb_rank_bit(rank);
+        candidates &= candidates - 1;
+        if ((pairs & bit) && ref_dig_partial_block(ctx, suit, rank, BB_BLOCK_PAIR)) {
+          return true;
+        }
+        if ((adjacents & bit) && ref_dig_partial_block(ctx, suit, rank, BB_BLOCK_ADJACENT)) {
+          return true;
+        }
+        if ((gaps & bit) && ref_dig_partial_block(ctx, suit, rank, BB_BLOCK_GAP)) {
+          return true;
+        }
+      }
+    }
+  }
+  int32_t shanten = ctx->total_len / MJ_MIN_TILES_LEN_IN_ELEMENT * 2 -
+                    (ctx->elem_len * 2 + ctx->pair_len + ctx->partial_len);
+  if (ctx->shanten > shanten) {
+    ctx->shanten = shanten;
+  }
+  return ctx->shanten <= ctx->shanten_min;
+}
+
+static bool ref_dig_element(RefShantenCtx *ctx, MJTileId from);
+
+static bool ref_dig_element_block(RefShantenCtx *ctx, uint32_t suit, uint32_t rank, uint64_t block) {
+  ctx->bb.suit[suit] = remove_bb_block(ctx->bb.suit[suit], rank, block);
+  ctx->elem_len++;
+  bool limit = ref_dig_element(ctx, get_bb_tile_id(suit, rank));
+  ctx->elem_len--;
+  ctx->bb.suit[suit] = add_bb_block(ctx->bb.suit[suit], rank, block);
+  return limit;
+}
+
+static bool ref_dig_element(RefShantenCtx *ctx, MJTileId from) {
+  for (uint32_t suit = get_bb_suit(from); suit < BB_LEN; suit++) {
+    uint64_t word = ctx->bb.suit[suit];
+    uint64_t triplets = find_bb_triplets(word);
+    uint64_t sequences = suit == BB_HONORS ? 0 : find_bb_sequences(word);
+    uint64_t candidates = triplets | sequences;
+    if (suit == get_bb_suit(from)) {
+      candidates &= ~(get_bb_rank_bit(get_bb_rank(from)) - 1);
+    }
+    while (candidates) {
+      uint32_t rank = get_bb_lowest_rank(candidates);
+      uint64_t bit = get_bb_rank_bit(rank);
+      candidates &= candidates - 1;
+      if ((triplets & bit) && ref_dig_element_block(ctx, suit, rank, BB_BLOCK_TRIPLETS)) {
+        return true;
+      }
+      if ((sequences & bit) && ref_dig_element_block(ctx, suit, rank, BB_BLOCK_SEQUENCE)) {
+        return true;
+      }
+    }
+  }
+  return ref_dig_partial(ctx, MJ_M1);
+}
+
+static int32_t ref_calc_shanten_normal(const Tiles *tiles, int32_t total_len) {
+  RefShantenCtx ctx;
+  memset(&ctx, 0, sizeof(ctx));
+  gen_bitboard_from_tiles(&ctx.bb, tiles);
+  ctx.total_len = total_len;
+  ctx.shanten_min = total_len % MJ_MIN_TILES_LEN_IN_ELEMENT == 2 ? -1 : 0;  // 和了 or テンパイ
+  ctx.shanten = total_len / MJ_MIN_TILES_LEN_IN_ELEMENT * 2;
+  for (uint32_t suit = 0; suit < BB_LEN; suit++) {
+    uint64_t pairs = find_bb_pairs(ctx.bb.suit[suit]);
+    while (pairs) {
+      uint32_t rank = get_bb_lowest_rank(pairs);
+      pairs &= pairs - 1;
+      ctx.bb.suit[suit] = remove_bb_block(ctx.bb.suit[suit], rank, BB_BLOCK_PAIR);
+      ctx.pair_len++;
+      bool limit = ref_dig_element(&ctx, MJ_M1);
+      ctx.pair_len--;
+      ctx.bb.suit[suit] = add_bb_block(ctx.bb.suit[suit], rank, BB_BLOCK_PAIR);
+      if (limit) {
+        return ctx.shanten;
+      }
+    }
+  }
+  ref_dig_element(&ctx, MJ_M1);
+  return ctx.shanten;
+}
+
+#define TEST_SHANTEN_DIFF_HANDS 300000
+#define TEST_SPLIT_SHANTEN_WALKS 400
+#define TEST_SPLIT_SHANTEN_STEPS 40  // 13 + 40 枚は山に収まる
+
+/* 山からランダムに配った 1, 4, 7, 10, 13, 14 枚の手牌で以前の探索と同じシャンテン数になる */
+static void test_calc_shanten_differential() {
+  static const uint32_t lens[] = {1, 4, 7, 10, 13, 13, 13, 14, 14, 14};
+  Rng rng;
+  seed_rng(&rng, 20261019);
+  for (uint32_t i = 0; i < TEST_SHANTEN_DIFF_HANDS; i++) {
+    uint8_t wall[(MJ_DR + 1) * MJ_MAX_TILES_LEN_IN_ELEMENT];
+    for (uint32_t j = 0; j < sizeof(wall); j++) {
+      wall[j] = (uint8_t)(j / MJ_MAX_TILES_LEN_IN_ELEMENT);
+    }
+    MJHands hands;
+    hands.len = lens[i % (sizeof(lens) / sizeof(lens[0]))];
+    for (uint32_t j = 0; j < hands.len; j++) {  // 部分的な Fisher-Yates
+      uint32_t k = j + next_rng_bounded(&rng, (uint32_t)sizeof(wall) - j);
+      uint8_t tile = wall[k];
+      wall[k] = wall[j];
+      wall[j] = tile;
+      hands.tile_id[j] = (MJTileId)tile;
+    }
+    Tiles tiles;
+    assert(gen_tiles_from_hands(&tiles, &hands));
+    MJShanten shanten;
+    assert(mj_calc_shanten(&hands, &shanten) == MJ_OK);
+    int32_t expected = ref_calc_shanten_normal(&tiles, (int32_t)hands.len);
+    if (shanten.normal != expected) {
+      for (uint32_t j = 0; j < hands.len; j++) {
+        fprintf(stderr, "%s ", tile_id_str(hands.tile_id[j]));
+      }
+      fprintf(stderr, "shanten %d, expected %d\n", shanten.normal, expected);
+    }
+    assert(shanten.normal == expected);
+  }
+}
+
+/* 1枚ずつ入れ替える手牌で, SplitShanten の差分の計算を calc_shanten_tiles と比べる */
+static void test_split_shanten() {
+  static const int32_t lens[] = {4, 7, 10, 13};
+  Rng rng;
+  seed_rng(&rng, 20261020);
+  for (uint32_t i = 0; i < TEST_SPLIT_SHANTEN_WALKS; i++) {
+    uint8_t wall[(MJ_DR + 1) * MJ_MAX_TILES_LEN_IN_ELEMENT];
+    for (uint32_t j = 0; j < sizeof(wall); j++) {
+      wall[j] = (uint8_t)(j / MJ_MAX_TILES_LEN_IN_ELEMENT);
+    }
+    for (uint32_t j = 0; j + 1 < sizeof(wall); j++) {
+      uint32_t k = j + next_rng_bounded(&rng, (uint32_t)sizeof(wall) - j);
+      uint8_t tile = wall[k];
+      wall[k] = wall[j];
+      wall[j] = tile;
+    }
+    int32_t total_len = lens[i % (sizeof(lens) / sizeof(lens[0]))];
+    Tiles tiles;
+    memset(&tiles, 0, sizeof(tiles));
+    uint32_t pos = 0;
+    for (; pos < (uint32_t)total_len; pos++) {
+      add_tile(&tiles, wall[pos]);
+    }
+    SplitShanten split;
+    split.valid = false;
+    for (uint32_t step = 0; step < TEST_SPLIT_SHANTEN_STEPS; step++) {
+      update_split_shanten(&split, &tiles, total_len);
+      assert(split.shanten == calc_shanten_tiles(&tiles, total_len, -1));
+      for (uint32_t t = MJ_M1; t <= MJ_DR; t++) {
+        if (tiles.tiles[t] < MJ_MAX_TILES_LEN_IN_ELEMENT) {
+          add_tile(&tiles, (MJTileId)t);
+          assert(calc_split_shanten(&split, (MJTileId)t, 1) == calc_shanten_tiles(&tiles, total_len + 1, -1));
+          remove_tile(&tiles, (MJTileId)t);
+        }
+        if (tiles.tiles[t] > 0) {
+          remove_tile(&tiles, (MJTileId)t);
+          assert(calc_split_shanten(&split, (MJTileId)t, -1) == calc_shanten_tiles(&tiles, total_len - 1, -1));
+          add_tile(&tiles, (MJTileId)t);
+        }
+      }
+      // ツモって, 手牌からランダムに1枚切る
+      add_tile(&tiles, wall[pos++]);
+      uint32_t discard = next_rng_bounded(&rng, (uint32_t)total_len + 1);
+      for (uint32_t t = MJ_M1; t <= MJ_DR; t++) {
+        if (discard < tiles.tiles[t]) {
+          remove_tile(&tiles, (MJTileId)t);
+          break;
+        }
+        discard -= tiles.tiles[t];
+      }
+    }
+  }
 }
 
 void test_file(const char *file) {
@@ -91,6 +332,8 @@ const char test_files[][32] = {"test/p_hon_10000.txt", "test/p_koku_10000.txt",
 
 bool test_shanten() {
   test_calc_shanten();
+  test_calc_shanten_differential();
+  test_split_shanten();
   for (uint32_t i = 0; i < sizeof(test_files) / sizeof(test_files[0]); i++) {
     test_file(test_files[i]);
   }
@@ -0,0 +1,83 @@
+#include "test_simulate.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "shanten.h"
+#include "test_util.h"
+#include "zobrist.h"
+
+static void test_select_sim_discard() {
+  // 12345m 456p 8p 789s 東東: 孤立した8pを切ればテンパイ
+  MJHands hands = {{m1, m2, m3, m4, m5, p4, p5, p6, p8, s7, s8, s9, wt, wt}, 14};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  MJTileId discard = select_sim_discard(&tiles, 14, 0);
+  assert(discard == (MJTileId)p8);
+  assert(tiles.tiles[p8] == 0);
+  assert(calc_shanten_tiles(&tiles, 13, -1) == 0);
+}
+
+static void test_mj_simulate_discards() {
+  // 34567m 456p 789s 22s 東 -> 東を切ればテンパイ
+  MJHands hands = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2, wt}, 14};
+  MJMelds melds = {{}, 0};
+  MJSimConfig config1 = {12345, 200, 12, 1};
+  MJSimConfig config4 = {12345, 200, 12, 4};
+  MJSimResult results1[MJ_DR + 1];
+  MJSimResult results4[MJ_DR + 1];
+  uint32_t len1;
+  uint32_t len4;
+  assert(mj_simulate_discards(results1, &len1, &hands, &melds, NULL, &config1) == MJ_OK);
+  assert(mj_simulate_discards(results4, &len4, &hands, &melds, NULL, &config4) == MJ_OK);
+  assert(len1 == 13 && len1 == len4);
+  for (uint32_t i = 0; i < len1; i++) {
+    // スレッド数によらず同じ結果
+    assert(results1[i].discard == results4[i].discard);
+    assert(results1[i].tenpai == results4[i].tenpai);
+    assert(results1[i].win == results4[i].win);
+    assert(results1[i].win <= results1[i].tenpai && results1[i].tenpai <= results1[i].samples);
+    if (results1[i].shanten <= 0) {
+      assert(results1[i].tenpai == results1[i].samples);
+    }
+  }
+  const MJSimResult *best = &results1[0];
+  for (uint32_t i = 1; i < len1; i++) {
+    if (results1[i].win > best->win) {
+      best = &results1[i];
+    }
+  }
+  assert(best->discard == (MJTileId)wt && best->shanten == 0);
+
+  MJTiles visible = {{0}};
+  visible.tiles[m1] = 5;
+  assert(mj_simulate_discards(results1, &len1, &hands, &melds, &visible, &config1) == MJ_ERR_ILLEGAL_PARAM);
+  MJHands short_hands = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 13};
+  assert(mj_simulate_discards(results1, &len1, &short_hands, &melds, NULL, &config1) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+static void test_lookup_shanten_cache() {
+  // 34567m 456p 789s 22s: 25m, 58m 待ち
+  MJHands hands = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 13};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  static ShantenCache cache;
+  memset(&cache, 0, sizeof(cache));
+  uint64_t hash = hash_tiles(&tiles);
+  ShantenCacheEntry *entry = lookup_shanten_cache(&cache, &tiles, hash, 13);
+  assert(entry->shanten == 0);
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    bool acceptable = i == m2 || i == m5 || i == m8;
+    assert(is_shanten_cache_acceptable(entry, &tiles, 13, (MJTileId)i) == acceptable);
+    assert(is_shanten_cache_acceptable(entry, &tiles, 13, (MJTileId)i) == acceptable);  // 記録した値
+  }
+  assert(entry->acceptables == ((1ull << m2) | (1ull << m5) | (1ull << m8)));
+  assert(lookup_shanten_cache(&cache, &tiles, hash, 13) == entry);
+}
+
+bool test_simulate() {
+  test_select_sim_discard();
+  test_lookup_shanten_cache();
+  test_mj_simulate_discards();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "simulate.h"
+
+bool test_simulate();
@@ -0,0 +1,98 @@
+#include "test_stats.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "test_util.h"
+
+static void parse_hands(MJHands *hands, MJMelds *melds, MJTileId *win_tile, const char *str) {
+  MJNotation notation;
+  assert(mj_parse_notation(&notation, str, strlen(str)) == MJ_OK);
+  assert(mj_notation_to_hands(hands, &notation) == MJ_OK);
+  *melds = notation.melds;
+  *win_tile = notation.win_tile;
+}
+
+static void *read_thread_stats(void *arg) {
+  assert(mj_get_stats((MJStats *)arg) == MJ_OK);
+  return NULL;
+}
+
+static void test_mj_get_stats() {
+  MJHands hands;
+  MJMelds melds;
+  MJTileId win_tile;
+  MJBaseScore score;
+  MJStats stats;
+  mj_reset_stats();
+#if defined(MJ_ENABLE_STATS)
+  assert(mj_get_stats(&stats) == MJ_OK);
+  assert(stats.shanten_calls == 0 && stats.agari_calls == 0 && stats.yaku_checks == 0);
+
+  // 111222333m は刻子3つと順子3つの2通りに分解できる
+  parse_hands(&hands, &melds, &win_tile, "111222333m456p9s+9s");
+  assert(mj_get_score(&score, &hands, &melds, win_tile, false, MJ_WT, MJ_WT) == MJ_OK);
+  assert(mj_get_stats(&stats) == MJ_OK);
+  assert(stats.agari_calls == 1);
+  assert(stats.agari_decompositions == 2);
+  assert(stats.scored_decompositions == 2);
+  assert(stats.yaku_checks > 2 * 9);
+  assert(stats.early_exits == 0);  // 七対子でないのは打ち切りではない
+  assert(stats.shanten_calls == 0);
+
+  // 役満は残りの役を判定しない
+  mj_reset_stats();
+  parse_hands(&hands, &melds, &win_tile, "111999m111p999s1z+1z");
+  assert(mj_get_score(&score, &hands, &melds, win_tile, false, MJ_WT, MJ_WT) == MJ_OK);
+  assert(mj_get_stats(&stats) == MJ_OK);
+  assert(stats.early_exits == 1 && stats.yaku_checks == 3 + 9);  // 国士無双, 字一色, 七対子と役満9つ
+
+  // 国士無双は七対子の役を判定しない
+  mj_reset_stats();
+  parse_hands(&hands, &melds, &win_tile, "19m19p19s1234567z+1z");
+  assert(mj_get_score(&score, &hands, &melds, win_tile, false, MJ_WT, MJ_WT) == MJ_OK);
+  assert(mj_get_stats(&stats) == MJ_OK);
+  assert(stats.early_exits == 1 && stats.yaku_checks == 2 && stats.scored_decompositions == 1);
+
+  // 面子が4つを超える探索は打ち切る. 15枚なら面子5つに分解できる
+  mj_reset_stats();
+  MJShanten shanten;
+  parse_hands(&hands, &melds, &win_tile, "111222333444555m");
+  assert(mj_calc_shanten(&hands, &shanten) == MJ_OK);
+  assert(mj_get_stats(&stats) == MJ_OK);
+  assert(stats.shanten_calls == 1 && stats.early_exits > 0);
+
+  // 清一色は探索の節が多い
+  mj_reset_stats();
+  parse_hands(&hands, &melds, &win_tile, "1112345678999m");
+  assert(mj_calc_shanten(&hands, &shanten) == MJ_OK);
+  MJStats chinitsu;
+  assert(mj_get_stats(&chinitsu) == MJ_OK);
+  mj_reset_stats();
+  parse_hands(&hands, &melds, &win_tile, "19m19p19s1234567z");
+  assert(mj_calc_shanten(&hands, &shanten) == MJ_OK);
+  assert(mj_get_stats(&stats) == MJ_OK);
+  assert(chinitsu.shanten_calls == 1 && stats.shanten_calls == 1);
+  assert(chinitsu.shanten_nodes > stats.shanten_nodes);
+
+  // スレッドごとに数える
+  MJStats other;
+  pthread_t thread;
+  assert(pthread_create(&thread, NULL, read_thread_stats, &other) == 0);
+  assert(pthread_join(thread, NULL) == 0);
+  assert(other.shanten_calls == 0 && other.shanten_nodes == 0);
+#else
+  // 数える処理はコンパイルされない
+  parse_hands(&hands, &melds, &win_tile, "111222333m456p9s+9s");
+  assert(mj_get_score(&score, &hands, &melds, win_tile, false, MJ_WT, MJ_WT) == MJ_OK);
+  assert(mj_get_stats(&stats) == MJ_ERR_NOT_SUPPORTED);
+  assert(stats.agari_calls == 0 && stats.scored_decompositions == 0);
+  (void)read_thread_stats;
+#endif  // defined(MJ_ENABLE_STATS)
+}
+
+bool test_stats() {
+  test_mj_get_stats();
+  return true;
+}
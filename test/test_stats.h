@@ -0,0 +1,5 @@
+#pragma once
+
+#include "stats.h"
+
+bool test_stats();
@@ -163,6 +163,42 @@ static void test_get_tile_number() {
   assert(get_tile_number(s3) == TILE_NUM_3);
   assert(get_tile_number(s7) == TILE_NUM_7);
   assert(get_tile_number(wt) == TILE_NUM_INVALID);
+  assert(get_tile_number(-1) == TILE_NUM_INVALID);
+}
+
+static void test_is_tile_id_green() {
+  assert(is_tile_id_green(s2));
+  assert(is_tile_id_green(s3));
+  assert(is_tile_id_green(s4));
+  assert(is_tile_id_green(s6));
+  assert(is_tile_id_green(s8));
+  assert(is_tile_id_green(dg));
+  assert(!is_tile_id_green(s1));
+  assert(!is_tile_id_green(s5));
+  assert(!is_tile_id_green(s7));
+  assert(!is_tile_id_green(s9));
+  assert(!is_tile_id_green(m2));
+  assert(!is_tile_id_green(p8));
+  assert(!is_tile_id_green(dw));
+  assert(!is_tile_id_green(-1));
+}
+
+/* 表が牌の番号から計算した性質と一致する */
+static void test_tile_properties() {
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    MJTileId tile_id = (MJTileId)i;
+    bool honors = i >= MJ_WT;
+    bool terminal = !honors && (i % 9 == 0 || i % 9 == 8);
+    assert(is_tile_id_honors(tile_id) == honors);
+    assert(is_tile_id_wind(tile_id) == (i >= MJ_WT && i <= MJ_WP));
+    assert(is_tile_id_dragon(tile_id) == (i >= MJ_DW));
+    assert(is_tile_id_routou(tile_id) == terminal);
+    assert(is_tile_id_yaochu(tile_id) == (honors || terminal));
+    assert(get_tile_number(tile_id) == (honors ? TILE_NUM_INVALID : i % 9));
+    assert(get_tile_type(tile_id) == (honors ? (i >= MJ_DW ? TILE_TYPE_DRAGON : TILE_TYPE_WIND) : 1u << (i / 9)));
+  }
+  assert(!is_tile_id_honors(dr + 1));
+  assert(!is_tile_id_yaochu(dr + 1));
 }
 
 __attribute__((unused)) static void dump(const uint8_t *p, size_t size) {
@@ -184,6 +220,45 @@ static void test_gen_tiles_from_hands() {
   assert(memcmp(&act, &exp, sizeof(Tiles)) == 0);
 }
 
+static void test_gen_mj_tiles_from_tiles() {
+  MJHands hands = {{m1, m2, m3, wt, wt, wt, p7, p8, p9, s4, s5, s6, dw, dw}, 14};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  MJTiles mj_tiles;
+  gen_mj_tiles_from_tiles(&mj_tiles, &tiles);
+  assert(mj_tiles.tiles[m1] == 1 && mj_tiles.tiles[wt] == 3 && mj_tiles.tiles[dw] == 2 && mj_tiles.tiles[dr] == 0);
+  Tiles act;
+  memset(&act, -1, sizeof(Tiles));
+  gen_tiles_from_mj_tiles(&act, &mj_tiles);
+  assert(memcmp(&act, &tiles, sizeof(Tiles)) == 0);
+}
+
+static void test_count_tiles() {
+  MJHands hands = {{m1, m2, m3, wt, wt, wt, p7, p8, p9, s4, s5, s6, dr, dr}, 14};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  assert(count_tiles(&tiles) == 14);
+  add_tile(&tiles, dr);
+  assert(count_tiles(&tiles) == 15);
+  remove_tile(&tiles, m1);
+  remove_tile(&tiles, m2);
+  assert(count_tiles(&tiles) == 13);
+  memset(&tiles, 0, sizeof(Tiles));
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    tiles.tiles[i] = 4;
+  }
+  assert(count_tiles(&tiles) == 136);
+}
+
+static void test_get_suit_tiles() {
+  MJHands hands = {{m1, m2, m3, wt, wt, wt, p7, p8, p9, p9, s4, s5, s6, dw}, 14};
+  Tiles tiles;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  assert(get_suit_tiles(&tiles, MJ_M1) == 0x000000111ull);
+  assert(get_suit_tiles(&tiles, MJ_P1) == 0x211000000ull);
+  assert(get_suit_tiles(&tiles, MJ_S1) == 0x000111000ull);
+}
+
 static void test_tile_id_str() {
   assert(strcmp(tile_id_str(m1), "m1") == 0);
   assert(strcmp(tile_id_str(m9), "m9") == 0);
@@ -209,7 +284,12 @@ bool test_tile() {
   test_is_tile_id_routou();
   test_get_tile_type();
   test_get_tile_number();
+  test_is_tile_id_green();
+  test_tile_properties();
   test_gen_tiles_from_hands();
+  test_gen_mj_tiles_from_tiles();
+  test_count_tiles();
+  test_get_suit_tiles();
   test_tile_id_str();
   return true;
 }
@@ -7,7 +7,7 @@
 #include "test_util.h"
 #include "tile.h"
 
-static void dump_tiles(const Tiles *tiles) {
+static void dump_tiles(const MJTiles *tiles) {
   bool found = false;
   for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
     if (tiles->tiles[i]) {
@@ -23,8 +23,8 @@ static void dump_tiles(const Tiles *tiles) {
 static int run_test(int32_t (*fn_ukeire)(const MJHands *, MJTiles *), MJTileId t1, MJTileId t2, MJTileId t3,
                     MJTileId t4, MJTileId t5, MJTileId t6, MJTileId t7, MJTileId t8, MJTileId t9, MJTileId t10,
                     MJTileId t11, MJTileId t12, MJTileId t13, int len, va_list args) {
-  Tiles expect;
-  memset(&expect, 0, sizeof(Tiles));
+  MJTiles expect;
+  memset(&expect, 0, sizeof(MJTiles));
   for (int i = 0; i < len; i++) {
     int value = va_arg(args, int);
     expect.tiles[value] = 1;
@@ -38,7 +38,7 @@ static int run_test(int32_t (*fn_ukeire)(const MJHands *, MJTiles *), MJTileId t
   int32_t ret = fn_ukeire(&hands, &acceptables);
   assert(ret == MJ_OK);
 
-  int n = memcmp(&acceptables, &expect, sizeof(Tiles));
+  int n = memcmp(&acceptables, &expect, sizeof(MJTiles));
   if (n != 0) {
     fprintf(stderr, "act\n");
     dump_tiles(&acceptables);
@@ -0,0 +1,145 @@
+#include "test_winprob.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "shanten.h"
+#include "test_util.h"
+
+static MJWinProbTable table;
+
+/* 山の全ての順番を数え上げて求めた確率. 有効牌では次のアガリ確率が最大になる牌を切り, それ以外はツモ切りする */
+static double calc_naive_win_rate(Tiles *tiles, int32_t total_len, Tiles *unseen, uint32_t total, uint32_t draws) {
+  if (draws == 0 || total == 0) {
+    return 0.0;
+  }
+  int32_t shanten = calc_shanten_tiles(tiles, total_len, -1);
+  double prob = 0.0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    uint32_t count = unseen->tiles[i];
+    if (count == 0) {
+      continue;
+    }
+    unseen->tiles[i]--;
+    add_tile(tiles, (MJTileId)i);
+    int32_t next = calc_shanten_tiles(tiles, total_len + 1, -1);
+    double rate = 0.0;
+    if (next < 0) {
+      rate = 1.0;
+    } else if (next < shanten) {
+      for (uint32_t j = MJ_M1; j <= MJ_DR; j++) {
+        if (tiles->tiles[j] == 0) {
+          continue;
+        }
+        remove_tile(tiles, (MJTileId)j);
+        if (calc_shanten_tiles(tiles, total_len, -1) == next) {
+          double r = calc_naive_win_rate(tiles, total_len, unseen, total - 1, draws - 1);
+          rate = r > rate ? r : rate;
+        }
+        add_tile(tiles, (MJTileId)j);
+      }
+    } else {
+      remove_tile(tiles, (MJTileId)i);
+      rate = calc_naive_win_rate(tiles, total_len, unseen, total - 1, draws - 1);
+      add_tile(tiles, (MJTileId)i);
+    }
+    remove_tile(tiles, (MJTileId)i);
+    unseen->tiles[i]++;
+    prob += rate * count / total;
+  }
+  return prob;
+}
+
+static void test_calc_tenpai_win_rate() {
+  WinProbPool pool;
+  memset(&pool, 0, sizeof(pool));
+  pool.tiles.tiles[m2] = 2;
+  pool.tiles.tiles[m5] = 1;
+  pool.total = 10;
+  // 1 - (7/10 * 6/9)
+  assert(fabs(calc_tenpai_win_rate(&pool, (1ull << m2) | (1ull << m5), 2) - (1.0 - 7.0 / 10 * 6.0 / 9)) < 1e-12);
+  assert(calc_tenpai_win_rate(&pool, (1ull << m2) | (1ull << m5), 8) == 1.0);
+  assert(calc_tenpai_win_rate(&pool, 1ull << m8, 5) == 0.0);
+}
+
+static void test_mj_win_probability() {
+  MJMelds melds = {{}, 0};
+  // 1向聴: 345m 67m 456p 789s 2s 東
+  MJHands hands = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, wt}, 13};
+  // 山を小さくして全ての順番を数え上げた結果と比べる
+  MJTiles unseen = {{0}};
+  unseen.tiles[m5] = 1;
+  unseen.tiles[m8] = 2;
+  unseen.tiles[s2] = 1;
+  unseen.tiles[wt] = 1;
+  unseen.tiles[p1] = 2;
+  unseen.tiles[dr] = 2;
+  unseen.tiles[s5] = 1;
+  Tiles tiles;
+  Tiles _unseen;
+  assert(gen_tiles_from_hands(&tiles, &hands));
+  gen_tiles_from_mj_tiles(&_unseen, &unseen);
+  mj_init_win_prob_table(&table);
+  for (uint32_t draws = 0; draws <= 5; draws++) {
+    double prob;
+    assert(mj_win_probability(&prob, &hands, &melds, &unseen, draws, &table) == MJ_OK);
+    double exp = calc_naive_win_rate(&tiles, 13, &_unseen, 10, draws);
+    assert(fabs(prob - exp) < 1e-12);
+  }
+
+  // テンパイ: 34567m 456p 789s 22s. 待ち 2m 5m 8m
+  MJHands tenpai = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 13};
+  double prob;
+  assert(mj_win_probability(&prob, &tenpai, &melds, &unseen, 2, &table) == MJ_OK);
+  assert(fabs(prob - (1.0 - 7.0 / 10 * 6.0 / 9)) < 1e-12);
+
+  // 2向聴以上は間に合わない場合のみ
+  MJHands ryanshanten = {{m1, m4, m7, p1, p4, p7, s1, s4, s7, wt, wn, ws, wp}, 13};
+  MJTiles all = {{0}};
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    all.tiles[i] = 3;
+  }
+  assert(mj_win_probability(&prob, &ryanshanten, &melds, &all, 3, &table) == MJ_OK);
+  assert(prob == 0.0);
+  assert(mj_win_probability(&prob, &ryanshanten, &melds, &all, 18, &table) == MJ_ERR_ILLEGAL_PARAM);
+  all.tiles[wt] = 4;  // 手牌と合わせて5枚
+  assert(mj_win_probability(&prob, &ryanshanten, &melds, &all, 3, &table) == MJ_ERR_ILLEGAL_PARAM);
+}
+
+static void test_mj_win_probability_discards() {
+  MJMelds melds = {{}, 0};
+  MJHands hands = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2, wt}, 14};
+  Tiles own;
+  assert(gen_tiles_from_hands(&own, &hands));
+  MJTiles unseen = {{0}};
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    unseen.tiles[i] = MJ_MAX_TILES_LEN_IN_ELEMENT - own.tiles[i];
+  }
+  unseen.tiles[m8] = 1;  // 見えている牌
+  MJWinProbResult results[MJ_DR + 1];
+  uint32_t len;
+  mj_init_win_prob_table(&table);
+  assert(mj_win_probability_discards(results, &len, &hands, &melds, &unseen, 6, &table) == MJ_OK);
+  assert(len == 13);
+  const MJWinProbResult *best = &results[0];
+  for (uint32_t i = 0; i < len; i++) {
+    assert(results[i].evaluated);
+    assert(results[i].win_rate >= 0.0 && results[i].win_rate <= 1.0);
+    if (results[i].win_rate > best->win_rate) {
+      best = &results[i];
+    }
+  }
+  assert(best->discard == (MJTileId)wt && best->shanten == 0);
+  MJHands after = {{m3, m4, m5, m6, m7, p4, p5, p6, s7, s8, s9, s2, s2}, 13};
+  double prob;
+  assert(mj_win_probability(&prob, &after, &melds, &unseen, 6, &table) == MJ_OK);
+  assert(prob == best->win_rate);
+}
+
+bool test_winprob() {
+  test_calc_tenpai_win_rate();
+  test_mj_win_probability();
+  test_mj_win_probability_discards();
+  return true;
+}
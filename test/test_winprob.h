@@ -0,0 +1,5 @@
+#pragma once
+
+#include "winprob.h"
+
+bool test_winprob();
@@ -0,0 +1,62 @@
+#include "test_zobrist.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "test_util.h"
+
+static void test_hash_tiles() {
+  MJHands hands1 = {{m1, m1, m2, p5, wt, wt, wt}, 7};
+  MJHands hands2 = {{wt, m2, wt, p5, m1, wt, m1}, 7};  // 並びが違うだけ
+  MJHands hands3 = {{m1, m2, m2, p5, wt, wt, wt}, 7};
+  Tiles t1, t2, t3;
+  assert(gen_tiles_from_hands(&t1, &hands1));
+  assert(gen_tiles_from_hands(&t2, &hands2));
+  assert(gen_tiles_from_hands(&t3, &hands3));
+  assert(hash_tiles(&t1) == hash_tiles(&t2));
+  assert(hash_tiles(&t1) != hash_tiles(&t3));
+
+  /* 1枚ずつの更新が作り直した場合と一致する */
+  uint64_t hash = hash_tiles(&t1);
+  hash = remove_zobrist_tile(hash, &t1, m1);
+  remove_tile(&t1, m1);
+  hash = add_zobrist_tile(hash, &t1, m2);
+  add_tile(&t1, m2);
+  assert(hash == hash_tiles(&t3));
+}
+
+static void test_hash_elements() {
+  MJMelds melds1 = {{
+                        {{m1, m2, m3}, 3, false, xx},
+                        {{m1, m2, m3}, 3, false, xx},
+                    },
+                    2};
+  MJMelds melds2 = {{
+                        {{m1, m2, m3}, 3, false, xx},
+                    },
+                    1};
+  MJMelds melds3 = {{
+                        {{dr, dr, dr, dr}, 4, true, xx},
+                    },
+                    1};
+  MJMelds melds4 = {{
+                        {{dr, dr, dr, dr}, 4, false, xx},
+                    },
+                    1};
+  Elements e1, e2, e3, e4;
+  assert(gen_elements_from_melds(&e1, &melds1));
+  assert(gen_elements_from_melds(&e2, &melds2));
+  assert(gen_elements_from_melds(&e3, &melds3));
+  assert(gen_elements_from_melds(&e4, &melds4));
+  assert(hash_elements(&e1) != 0);  // 同じ順子2つで打ち消し合わない
+  assert(hash_elements(&e1) != hash_elements(&e2));
+  assert(hash_elements(&e3) != hash_elements(&e4));  // 暗槓と明槓
+  assert(add_zobrist_element(hash_elements(&e2), &e2, &e2.meld[0]) == hash_elements(&e1));
+  assert(remove_zobrist_element(hash_elements(&e1), &e1, &e1.meld[1]) == hash_elements(&e2));
+}
+
+bool test_zobrist() {
+  test_hash_tiles();
+  test_hash_elements();
+  return true;
+}
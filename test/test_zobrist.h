@@ -0,0 +1,5 @@
+#pragma once
+
+#include "zobrist.h"
+
+bool test_zobrist();
@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "agari.h"
+#include "element.h"
+#include "mahjong.h"
+#include "rng.h"
+#include "tile.h"
+
+/*
+ * seed から作った手牌の集合で mj_calc_shanten, mj_ukeire_*, mj_get_score, find_agari を, 対局の集合で mj_play_game を
+ * 計測する.
+ * usage: mjbench.elf [-n ops] [-s seed] [-c corpus] [-o json]
+ *
+ * 手牌の集合 (BENCH_HANDS 個ずつ)
+ *   random13, random14: 山からランダムに 13, 14 枚
+ *   tenpai: アガリ形から1枚抜いた 13 枚
+ *   chinitsu13, chinitsu14: 1色だけのテンパイ, アガリ形. 分解の候補が最も多い
+ *   agari: アガリ形 14 枚
+ *   open: 1-3 個の副露があるアガリ形
+ *   east, hanchan: 4人とも mj_decide_greedy の東風戦, 半荘戦 (BENCH_GAMES 個). ops は BENCH_GAMES までにする
+ *   worst_shanten, worst_ukeire, worst_score: -c のファイル (mjworst.elf の出力) の手牌. 計算量が最も多い手牌
+ * 計測ごとに, 時刻を取らずに ops 回呼んだ時間から ns/op と ops/s を, 1回ずつ時刻を取って p50, p99, p99.9 を求める.
+ * checksum は結果の和で, 同じ seed なら版によらず同じになるはず.
+ */
+
+#define BENCH_HANDS 4096
+#define BENCH_MAX_OPS (1u << 22)
+#define BENCH_GAMES 256  // 対局は1回が手牌の計算の数千倍かかる
+
+typedef enum {
+  CORPUS_RANDOM13 = 0,
+  CORPUS_RANDOM14,
+  CORPUS_TENPAI,
+  CORPUS_CHINITSU13,
+  CORPUS_CHINITSU14,
+  CORPUS_AGARI,
+  CORPUS_OPEN,
+  CORPUS_EAST,
+  CORPUS_HANCHAN,
+  CORPUS_WORST_SHANTEN,  // 以降は -c で読む
+  CORPUS_WORST_UKEIRE,
+  CORPUS_WORST_SCORE,
+  CORPUS_LEN,
+} CorpusKind;
+
+static const char *corpus_names[CORPUS_LEN] = {
+    "random13", "random14", "tenpai", "chinitsu13", "chinitsu14", "agari", "open", "east", "hanchan",
+    "worst_shanten", "worst_ukeire", "worst_score"};
+
+typedef struct {
+  MJHands hands;      // 副露とアガリ牌を含む全ての牌
+  MJHands concealed;  // 副露を除いた牌
+  MJMelds melds;
+  MJTileId win_tile;
+  Tiles tiles;     // concealed. find_agari 用
+  Elements elems;  // melds. find_agari 用
+  uint64_t seed;   // east, hanchan の対局の seed
+} BenchHand;
+
+typedef uint64_t (*BenchFunc)(const BenchHand *hand);
+
+typedef struct {
+  const char *name;
+  CorpusKind corpus;
+  BenchFunc func;
+} Bench;
+
+static BenchHand corpora[CORPUS_LEN][BENCH_HANDS];
+static uint32_t corpus_lens[CORPUS_LEN];
+static uint64_t latencies[BENCH_MAX_OPS];
+
+static uint64_t get_nanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void gen_random_hand(BenchHand *hand, Rng *rng, uint32_t len) {
+  uint32_t wall[(MJ_DR + 1) * MJ_MAX_TILES_LEN_IN_ELEMENT];
+  for (uint32_t i = 0; i < sizeof(wall) / sizeof(wall[0]); i++) {
+    wall[i] = i / MJ_MAX_TILES_LEN_IN_ELEMENT;
+  }
+  hand->concealed.len = len;
+  for (uint32_t i = 0; i < len; i++) {
+    uint32_t j = i + next_rng_bounded(rng, (uint32_t)(sizeof(wall) / sizeof(wall[0])) - i);
+    uint32_t tmp = wall[i];
+    wall[i] = wall[j];
+    wall[j] = tmp;
+    hand->concealed.tile_id[i] = (MJTileId)wall[i];
+  }
+  hand->win_tile = hand->concealed.tile_id[len - 1];
+}
+
+/* suits 色 (1 なら萬子だけ, 4 なら字牌も) の範囲で 4 面子 1 雀頭を作る. 先頭の melds 個は副露にする */
+static void gen_complete_hand(BenchHand *hand, Rng *rng, uint32_t suits, uint32_t melds) {
+  uint32_t tiles = suits < 4 ? suits * 9 : MJ_DR + 1;
+  uint8_t counts[MJ_DR + 1];
+  for (;;) {
+    memset(counts, 0, sizeof(counts));
+    hand->melds.len = 0;
+    hand->concealed.len = 0;
+    bool valid = true;
+    for (uint32_t i = 0; i < MJ_ELEMENTS_LEN && valid; i++) {
+      MJMeld meld = {.len = MJ_MIN_TILES_LEN_IN_ELEMENT, .concealed = false, .type = 0};
+      uint32_t first = next_rng_bounded(rng, tiles);
+      bool sequence = first < MJ_WT && first % 9 < 7 && next_rng_bounded(rng, 3) > 0;
+      for (uint32_t j = 0; j < MJ_MIN_TILES_LEN_IN_ELEMENT; j++) {
+        meld.tile_id[j] = (MJTileId)(sequence ? first + j : first);
+        valid = valid && ++counts[meld.tile_id[j]] <= MJ_MAX_TILES_LEN_IN_ELEMENT;
+      }
+      if (i < melds) {
+        hand->melds.meld[hand->melds.len++] = meld;
+      } else {
+        memcpy(&hand->concealed.tile_id[hand->concealed.len], meld.tile_id, sizeof(MJTileId) * meld.len);
+        hand->concealed.len += meld.len;
+      }
+    }
+    uint32_t pair = next_rng_bounded(rng, tiles);
+    counts[pair] = (uint8_t)(counts[pair] + MJ_PAIR_LEN);
+    if (valid && counts[pair] <= MJ_MAX_TILES_LEN_IN_ELEMENT) {
+      hand->concealed.tile_id[hand->concealed.len++] = (MJTileId)pair;
+      hand->concealed.tile_id[hand->concealed.len++] = (MJTileId)pair;
+      break;
+    }
+  }
+  hand->win_tile = hand->concealed.tile_id[next_rng_bounded(rng, hand->concealed.len)];
+}
+
+/* アガリ牌を抜いてテンパイにする */
+static void remove_win_tile(BenchHand *hand) {
+  for (uint32_t i = 0; i < hand->concealed.len; i++) {
+    if (hand->concealed.tile_id[i] == hand->win_tile) {
+      hand->concealed.tile_id[i] = hand->concealed.tile_id[--hand->concealed.len];
+      return;
+    }
+  }
+}
+
+static void finish_bench_hand(BenchHand *hand) {
+  hand->hands = hand->concealed;
+  for (uint32_t i = 0; i < hand->melds.len; i++) {
+    const MJMeld *meld = &hand->melds.meld[i];
+    memcpy(&hand->hands.tile_id[hand->hands.len], meld->tile_id, sizeof(MJTileId) * meld->len);
+    hand->hands.len += meld->len;
+  }
+  gen_tiles_from_hands(&hand->tiles, &hand->concealed);
+  gen_elements_from_melds(&hand->elems, &hand->melds);
+}
+
+static void gen_corpora(uint64_t seed) {
+  memset(corpora, 0, sizeof(corpora));
+  for (uint32_t kind = 0; kind < CORPUS_WORST_SHANTEN; kind++) {
+    corpus_lens[kind] = kind == CORPUS_EAST || kind == CORPUS_HANCHAN ? BENCH_GAMES : BENCH_HANDS;
+    Rng rng;
+    uint64_t kind_seed = kind;
+    seed_rng(&rng, seed ^ next_splitmix64(&kind_seed));
+    for (uint32_t i = 0; i < corpus_lens[kind]; i++) {
+      BenchHand *hand = &corpora[kind][i];
+      switch ((CorpusKind)kind) {
+        case CORPUS_RANDOM13:
+        case CORPUS_RANDOM14:
+          gen_random_hand(hand, &rng, kind == CORPUS_RANDOM13 ? 13 : 14);
+          break;
+        case CORPUS_TENPAI:
+          gen_complete_hand(hand, &rng, 4, 0);
+          remove_win_tile(hand);
+          break;
+        case CORPUS_CHINITSU13:
+          gen_complete_hand(hand, &rng, 1, 0);
+          remove_win_tile(hand);
+          break;
+        case CORPUS_CHINITSU14:
+          gen_complete_hand(hand, &rng, 1, 0);
+          break;
+        case CORPUS_AGARI:
+          gen_complete_hand(hand, &rng, 4, 0);
+          break;
+        case CORPUS_OPEN:
+          gen_complete_hand(hand, &rng, 4, 1 + next_rng_bounded(&rng, 3));
+          break;
+        case CORPUS_EAST:
+        case CORPUS_HANCHAN:
+          hand->seed = next_rng(&rng);
+          continue;
+        default:
+          break;
+      }
+      finish_bench_hand(hand);
+    }
+  }
+}
+
+/* "kind hand ..." の行を kind ごとの worst_* に読む. 1つの kind は BENCH_HANDS 個まで */
+static bool load_corpus(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    perror(path);
+    return false;
+  }
+  const char *kinds[] = {"shanten", "ukeire", "score"};
+  char line[256];
+  uint32_t lineno = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineno++;
+    char kind[16], str[MJ_NOTATION_MAX_LEN];
+    if (line[0] == '#' || sscanf(line, "%15s %63s", kind, str) != 2) {
+      continue;
+    }
+    uint32_t corpus = CORPUS_LEN;
+    for (uint32_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+      corpus = strcmp(kind, kinds[i]) == 0 ? CORPUS_WORST_SHANTEN + i : corpus;
+    }
+    MJNotation notation;
+    if (corpus == CORPUS_LEN || mj_parse_notation(&notation, str, strlen(str)) != MJ_OK) {
+      fprintf(stderr, "%s:%u: illegal line\n", path, lineno);
+      fclose(fp);
+      return false;
+    }
+    if (corpus_lens[corpus] == BENCH_HANDS) {
+      continue;
+    }
+    BenchHand *hand = &corpora[corpus][corpus_lens[corpus]++];
+    memset(hand, 0, sizeof(BenchHand));
+    hand->melds = notation.melds;
+    hand->win_tile = notation.win_tile;
+    for (uint32_t i = 0; i < notation.melds.len; i++) {
+      for (uint32_t j = 0; j < notation.melds.meld[i].len; j++) {
+        notation.tiles.tiles[notation.melds.meld[i].tile_id[j]]--;
+      }
+    }
+    mj_notation_to_hands(&hand->concealed, &notation);
+    finish_bench_hand(hand);
+  }
+  fclose(fp);
+  return true;
+}
+
+static uint64_t bench_shanten(const BenchHand *hand) {
+  MJShanten shanten = {0, 0, 0};
+  mj_calc_shanten(&hand->concealed, &shanten);
+  return (uint64_t)(shanten.normal + shanten.chiitoitsu + shanten.kokushi + 3);
+}
+
+static uint64_t count_acceptables(const MJTiles *acceptables) {
+  uint64_t count = 0;
+  for (uint32_t i = MJ_M1; i <= MJ_DR; i++) {
+    count += acceptables->tiles[i] != 0;
+  }
+  return count;
+}
+
+static uint64_t bench_ukeire_normal(const BenchHand *hand) {
+  MJTiles acceptables;
+  return mj_ukeire_normal(&hand->concealed, &acceptables) == MJ_OK ? count_acceptables(&acceptables) : 0;
+}
+
+static uint64_t bench_ukeire_chiitoitsu(const BenchHand *hand) {
+  MJTiles acceptables;
+  return mj_ukeire_chiitoitsu(&hand->concealed, &acceptables) == MJ_OK ? count_acceptables(&acceptables) : 0;
+}
+
+static uint64_t bench_ukeire_kokushi(const BenchHand *hand) {
+  MJTiles acceptables;
+  return mj_ukeire_kokushi(&hand->concealed, &acceptables) == MJ_OK ? count_acceptables(&acceptables) : 0;
+}
+
+static uint64_t bench_score(const BenchHand *hand) {
+  MJBaseScore score;
+  if (mj_get_score(&score, &hand->hands, &hand->melds, hand->win_tile, false, MJ_WT, MJ_WT) != MJ_OK) {
+    return 0;
+  }
+  return score.han * 1000u + score.fu;
+}
+
+static bool count_agari_tiles(const Tiles *tiles, void *arg) {
+  (void)tiles;
+  (void)arg;
+  return false;
+}
+
+static bool count_agari_elements(const Elements *concealed, const Elements *melded, MJTileId pair, void *arg) {
+  (void)concealed;
+  (void)melded;
+  (void)pair;
+  (void)arg;
+  return true;
+}
+
+static uint64_t bench_find_agari(const BenchHand *hand) {
+  return find_agari(&hand->tiles, &hand->elems, count_agari_tiles, count_agari_elements, NULL);
+}
+
+static uint64_t play_bench_game(const BenchHand *hand, uint32_t rounds) {
+  MJGameConfig config = {hand->seed, rounds, 25000, {{mj_decide_greedy, NULL}}};
+  for (uint32_t i = 1; i < MJ_GAME_PLAYERS; i++) {
+    config.players[i] = config.players[0];
+  }
+  MJGameResult result;
+  if (mj_play_game(&result, &config) != MJ_OK) {
+    return 0;
+  }
+  return result.hands * 1000u + result.wins;
+}
+
+static uint64_t bench_game_east(const BenchHand *hand) { return play_bench_game(hand, 4); }
+
+static uint64_t bench_game_hanchan(const BenchHand *hand) { return play_bench_game(hand, 8); }
+
+static const Bench benches[] = {
+    {"shanten", CORPUS_RANDOM13, bench_shanten},
+    {"shanten", CORPUS_RANDOM14, bench_shanten},
+    {"shanten", CORPUS_TENPAI, bench_shanten},
+    {"shanten", CORPUS_CHINITSU13, bench_shanten},
+    {"shanten", CORPUS_CHINITSU14, bench_shanten},
+    {"ukeire_normal", CORPUS_RANDOM13, bench_ukeire_normal},
+    {"ukeire_normal", CORPUS_TENPAI, bench_ukeire_normal},
+    {"ukeire_normal", CORPUS_CHINITSU13, bench_ukeire_normal},
+    {"ukeire_chiitoitsu", CORPUS_RANDOM13, bench_ukeire_chiitoitsu},
+    {"ukeire_kokushi", CORPUS_RANDOM13, bench_ukeire_kokushi},
+    {"score", CORPUS_AGARI, bench_score},
+    {"score", CORPUS_CHINITSU14, bench_score},
+    {"score", CORPUS_OPEN, bench_score},
+    {"find_agari", CORPUS_AGARI, bench_find_agari},
+    {"find_agari", CORPUS_CHINITSU14, bench_find_agari},
+    {"find_agari", CORPUS_OPEN, bench_find_agari},
+    {"game", CORPUS_EAST, bench_game_east},
+    {"game", CORPUS_HANCHAN, bench_game_hanchan},
+    {"shanten", CORPUS_WORST_SHANTEN, bench_shanten},
+    {"ukeire_normal", CORPUS_WORST_UKEIRE, bench_ukeire_normal},
+    {"score", CORPUS_WORST_SCORE, bench_score},
+    {"find_agari", CORPUS_WORST_SCORE, bench_find_agari},
+};
+
+typedef struct {
+  double ns_per_op;
+  double ops_per_sec;
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t p999;
+  uint64_t checksum;
+} BenchResult;
+
+static int compare_latency(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* 小さい方から permille / 1000 の位置 */
+static uint64_t get_percentile(uint32_t ops, uint32_t permille) {
+  uint64_t index = ((uint64_t)ops * permille + 999) / 1000;
+  return latencies[index > 0 ? index - 1 : 0];
+}
+
+static void run_bench(BenchResult *result, const Bench *bench, uint32_t ops) {
+  const BenchHand *hands = corpora[bench->corpus];
+  uint32_t len = corpus_lens[bench->corpus];
+  uint64_t checksum = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    checksum += bench->func(&hands[i]);  // warm up. checksum は手牌の集合1周分
+  }
+  uint64_t start = get_nanoseconds();
+  for (uint32_t i = 0; i < ops; i++) {
+    bench->func(&hands[i % len]);
+  }
+  uint64_t elapsed = get_nanoseconds() - start;
+  for (uint32_t i = 0; i < ops; i++) {
+    uint64_t t = get_nanoseconds();
+    bench->func(&hands[i % len]);
+    latencies[i] = get_nanoseconds() - t;
+  }
+  qsort(latencies, ops, sizeof(uint64_t), compare_latency);
+  result->ns_per_op = (double)elapsed / ops;
+  result->ops_per_sec = result->ns_per_op > 0 ? 1e9 / result->ns_per_op : 0;
+  result->p50 = get_percentile(ops, 500);
+  result->p99 = get_percentile(ops, 990);
+  result->p999 = get_percentile(ops, 999);
+  result->checksum = checksum;
+}
+
+int main(int argc, char **argv) {
+  uint32_t ops = 100000;
+  uint64_t seed = 1;
+  const char *json_path = NULL;
+  const char *corpus_path = NULL;
+  int first = 1;
+  while (first + 1 < argc && argv[first][0] == '-') {
+    if (strcmp(argv[first], "-n") == 0) {
+      ops = (uint32_t)strtoul(argv[first + 1], NULL, 10);
+    } else if (strcmp(argv[first], "-s") == 0) {
+      seed = strtoull(argv[first + 1], NULL, 10);
+    } else if (strcmp(argv[first], "-c") == 0) {
+      corpus_path = argv[first + 1];
+    } else if (strcmp(argv[first], "-o") == 0) {
+      json_path = argv[first + 1];
+    } else {
+      break;
+    }
+    first += 2;
+  }
+  if (first != argc || ops == 0 || ops > BENCH_MAX_OPS) {
+    fprintf(stderr, "usage: %s [-n ops (1-%u)] [-s seed] [-c corpus] [-o json]\n", argv[0], BENCH_MAX_OPS);
+    return 1;
+  }
+
+  gen_corpora(seed);
+  if (corpus_path != NULL && !load_corpus(corpus_path)) {
+    return 1;
+  }
+  FILE *json = NULL;
+  if (json_path != NULL && (json = fopen(json_path, "w")) == NULL) {
+    perror(json_path);
+    return 1;
+  }
+  if (json != NULL) {
+    fprintf(json, "{\"seed\": %llu, \"ops\": %u, \"hands\": %u, \"results\": [", (unsigned long long)seed, ops,
+            BENCH_HANDS);
+  }
+  printf("%-18s %-13s %10s %12s %8s %8s %8s %16s\n", "bench", "corpus", "ns/op", "ops/s", "p50", "p99", "p99.9",
+         "checksum");
+  uint32_t written = 0;
+  for (uint32_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+    const Bench *bench = &benches[i];
+    if (corpus_lens[bench->corpus] == 0) {
+      continue;  // -c がない
+    }
+    BenchResult result;
+    run_bench(&result, bench, bench->corpus == CORPUS_EAST || bench->corpus == CORPUS_HANCHAN ? BENCH_GAMES : ops);
+    printf("%-18s %-13s %10.1f %12.0f %8llu %8llu %8llu %16llu\n", bench->name, corpus_names[bench->corpus],
+           result.ns_per_op, result.ops_per_sec, (unsigned long long)result.p50, (unsigned long long)result.p99,
+           (unsigned long long)result.p999, (unsigned long long)result.checksum);
+    fflush(stdout);
+    if (json != NULL) {
+      fprintf(json,
+              "%s\n  {\"name\": \"%s\", \"corpus\": \"%s\", \"ns_per_op\": %.1f, \"ops_per_sec\": %.0f, "
+              "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"checksum\": %llu}",
+              written++ > 0 ? "," : "", bench->name, corpus_names[bench->corpus], result.ns_per_op, result.ops_per_sec,
+              (unsigned long long)result.p50, (unsigned long long)result.p99, (unsigned long long)result.p999,
+              (unsigned long long)result.checksum);
+    }
+  }
+  if (json != NULL) {
+    fprintf(json, "\n]}\n");
+    fclose(json);
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mahjong.h"
+
+/*
+ * 門前14枚の全てのアガリ形を点数計算して集計する.
+ * usage: mjenum.elf [-t threads] [-p player_wind(1-4)] [-r round_wind(1-4)] [-n (no symmetry)]
+ */
+
+static void print_score_stats(const char *name, const MJEnumScoreStats *stats) {
+  const char *limits[MJ_ENUM_LIMIT_LEN] = {"under_mangan", "mangan", "haneman", "baiman", "sanbaiman", "yakuman"};
+  uint64_t scored = stats->scored - stats->no_yaku;
+  printf("[%s]\n", name);
+  printf("scored: %llu\n", (unsigned long long)stats->scored);
+  printf("no_yaku: %llu\n", (unsigned long long)stats->no_yaku);
+  printf("average_points: %.1f\n", scored ? (double)stats->points / (double)scored : 0.0);
+  for (uint32_t i = 0; i < MJ_ENUM_YAKU_LEN; i++) {
+    printf("yaku %s: %llu\n", mj_enum_yaku_name(i), (unsigned long long)stats->yaku[i]);
+  }
+  for (uint32_t i = 0; i < MJ_ENUM_HAN_LEN; i++) {
+    printf("han %u%s: %llu\n", i, i == MJ_ENUM_HAN_LEN - 1 ? "+" : "", (unsigned long long)stats->han[i]);
+  }
+  for (uint32_t i = 0; i < MJ_ENUM_FU_LEN; i++) {
+    if (stats->fu[i]) {
+      printf("fu %u%s: %llu\n", i * 5, i == MJ_ENUM_FU_LEN - 1 ? "+" : "", (unsigned long long)stats->fu[i]);
+    }
+  }
+  for (uint32_t i = 0; i < MJ_ENUM_LIMIT_LEN; i++) {
+    printf("limit %s: %llu\n", limits[i], (unsigned long long)stats->limits[i]);
+  }
+}
+
+int main(int argc, char **argv) {
+  MJEnumConfig config = {MJ_WT, MJ_WT, 1, true};
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0) {
+      config.symmetry = false;
+    } else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+      config.threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+      config.player_wind = (MJTileId)(MJ_WT + strtoul(argv[++i], NULL, 10) - 1);
+    } else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+      config.round_wind = (MJTileId)(MJ_WT + strtoul(argv[++i], NULL, 10) - 1);
+    } else {
+      fprintf(stderr, "usage: %s [-t threads] [-p player_wind(1-4)] [-r round_wind(1-4)] [-n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  MJEnumStats stats;
+  int32_t ret = mj_enumerate_complete_hands(&stats, &config);
+  if (ret != MJ_OK) {
+    fprintf(stderr, "error: %d\n", ret);
+    return 1;
+  }
+  printf("hands: %llu\n", (unsigned long long)stats.hands);
+  printf("normal: %llu\n", (unsigned long long)stats.normal);
+  printf("chiitoitsu: %llu\n", (unsigned long long)stats.chiitoitsu);
+  printf("kokushi: %llu\n", (unsigned long long)stats.kokushi);
+  print_score_stats("tsumo", &stats.tsumo);
+  print_score_stats("ron", &stats.ron);
+  return 0;
+}
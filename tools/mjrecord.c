@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mahjong.h"
+
+/*
+ * 手牌レコードファイル (MJ_RECORD_HANDS) を点数計算し, 結果のレコードファイルを書き出す.
+ * -s ならシャンテン数 (MJ_RECORD_SHANTENS) を書き出す.
+ * usage: mjrecord.elf [-t threads] [-s] hands results
+ */
+
+static double get_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  uint32_t threads = 1;
+  bool shanten = false;
+  int first = 1;
+  while (first < argc && argv[first][0] == '-') {
+    if (strcmp(argv[first], "-t") == 0 && first + 1 < argc) {
+      threads = (uint32_t)strtoul(argv[first + 1], NULL, 10);
+      first += 2;
+    } else if (strcmp(argv[first], "-s") == 0) {
+      shanten = true;
+      first++;
+    } else {
+      break;
+    }
+  }
+  if (first + 2 != argc) {
+    fprintf(stderr, "usage: %s [-t threads] [-s] hands results\n", argv[0]);
+    return 1;
+  }
+
+  MJRecordFile hands;
+  int32_t ret = mj_open_record_file(&hands, argv[first], MJ_RECORD_HANDS);
+  if (ret != MJ_OK) {
+    fprintf(stderr, "%s: error: %d\n", argv[first], ret);
+    return 1;
+  }
+  MJRecordFile results;
+  ret = mj_create_record_file(&results, argv[first + 1], shanten ? MJ_RECORD_SHANTENS : MJ_RECORD_SCORES, hands.len);
+  if (ret != MJ_OK) {
+    fprintf(stderr, "%s: error: %d\n", argv[first + 1], ret);
+    mj_close_record_file(&hands);
+    return 1;
+  }
+
+  double start = get_seconds();
+  const MJHandRecord *records = (const MJHandRecord *)hands.records;
+  ret = shanten ? mj_calc_shanten_records((MJShantenRecord *)results.records, records, hands.len, threads)
+                : mj_score_records((MJScoreRecord *)results.records, records, hands.len, threads);
+  double seconds = get_seconds() - start;
+  uint64_t errors = 0;
+  for (uint64_t i = 0; ret == MJ_OK && i < hands.len; i++) {
+    int8_t record_ret =
+        shanten ? ((MJShantenRecord *)results.records)[i].ret : ((MJScoreRecord *)results.records)[i].ret;
+    errors += record_ret != MJ_OK;
+  }
+  if (ret != MJ_OK) {
+    fprintf(stderr, "error: %d\n", ret);
+  }
+  printf("records: %llu\n", (unsigned long long)hands.len);
+  printf("errors: %llu\n", (unsigned long long)errors);
+  printf("seconds: %.3f\n", seconds);
+  printf("records_per_second: %.0f\n", seconds > 0.0 ? (double)hands.len / seconds : 0.0);
+  mj_close_record_file(&hands);
+  if (mj_close_record_file(&results) != MJ_OK && ret == MJ_OK) {
+    ret = MJ_ERR_IO;
+  }
+  return ret == MJ_OK ? 0 : 1;
+}
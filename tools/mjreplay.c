@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mahjong.h"
+
+/*
+ * 天鳳の牌譜 (mjlog の XML) を再生し, シャンテン数, 受け入れ, 点数を集計する.
+ * usage: mjreplay.elf [-t threads] file...
+ */
+
+static double get_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  MJLogConfig config = {1, NULL, NULL};
+  int first = 1;
+  if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+    config.threads = (uint32_t)strtoul(argv[2], NULL, 10);
+    first = 3;
+  }
+  if (first >= argc) {
+    fprintf(stderr, "usage: %s [-t threads] file...\n", argv[0]);
+    return 1;
+  }
+
+  MJLogStats stats;
+  double start = get_seconds();
+  int32_t ret = mj_replay_mjlog_files(&stats, (const char *const *)&argv[first], (uint64_t)(argc - first), &config);
+  double seconds = get_seconds() - start;
+  if (ret != MJ_OK) {
+    fprintf(stderr, "error: %d\n", ret);
+  }
+  printf("files: %llu\n", (unsigned long long)stats.files);
+  printf("bytes: %llu\n", (unsigned long long)stats.bytes);
+  printf("seconds: %.3f\n", seconds);
+  printf("mb_per_second: %.1f\n", seconds > 0.0 ? (double)stats.bytes / seconds / 1e6 : 0.0);
+  printf("games: %llu\n", (unsigned long long)stats.games);
+  printf("hands: %llu\n", (unsigned long long)stats.hands);
+  printf("draws: %llu\n", (unsigned long long)stats.draws);
+  printf("discards: %llu\n", (unsigned long long)stats.discards);
+  printf("calls: %llu\n", (unsigned long long)stats.calls);
+  printf("riichi: %llu\n", (unsigned long long)stats.riichi);
+  printf("wins: %llu\n", (unsigned long long)stats.wins);
+  printf("exhaustive_draws: %llu\n", (unsigned long long)stats.exhaustive_draws);
+  printf("abortive_draws: %llu\n", (unsigned long long)stats.abortive_draws);
+  for (uint32_t i = 0; i < MJ_LOG_SHANTEN_LEN; i++) {
+    printf("shanten %d%s: %llu\n", (int)i - 1, i == MJ_LOG_SHANTEN_LEN - 1 ? "+" : "",
+           (unsigned long long)stats.shanten[i]);
+  }
+  printf("average_ukeire_kinds: %.2f\n", stats.discards ? (double)stats.ukeire_kinds / (double)stats.discards : 0.0);
+  printf("average_ukeire_tiles: %.2f\n", stats.discards ? (double)stats.ukeire_tiles / (double)stats.discards : 0.0);
+  printf("scored: %llu\n", (unsigned long long)stats.scored);
+  printf("score_errors: %llu\n", (unsigned long long)stats.score_errors);
+  printf("hand_mismatches: %llu\n", (unsigned long long)stats.hand_mismatches);
+  printf("han_mismatches: %llu\n", (unsigned long long)stats.han_mismatches);
+  printf("fu_mismatches: %llu\n", (unsigned long long)stats.fu_mismatches);
+  return ret == MJ_OK ? 0 : 1;
+}
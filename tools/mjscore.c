@@ -0,0 +1,199 @@
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mahjong.h"
+#include "query.h"
+
+/*
+ * 1行に1つの JSON の問い合わせを読み, 点数, シャンテン数, 受け入れを計算して入力と同じ順に1行ずつ書き出す.
+ * usage: mjscore.elf [-t threads] [file...]   (file がなければ stdin)
+ * 入力と出力の形式は include/query.h を参照.
+ *
+ * 2つの batch を交互に使う. 読み込みのスレッドが一方に行を読む間, 書き出しのスレッドがもう一方を mj_parallel_for で
+ * 計算して順に書き出す. 読み込みは batch が一杯になるか, 読める入力がなくなったら (入力を待つ前に) 読んだ分を渡すので,
+ * パイプで1行ずつ問い合わせても応答が返る. バッファは2つの batch 分だけなので, 入力がどれだけ長くてもメモリは増えない.
+ */
+
+#define QUERY_BATCH_LEN 4096
+#define QUERY_READ_LEN 65536
+
+typedef struct {
+  char lines[QUERY_BATCH_LEN][QUERY_LINE_LEN];
+  uint32_t line_lens[QUERY_BATCH_LEN];  // QUERY_LINE_LEN 以上なら長すぎる行
+  QueryOutput outputs[QUERY_BATCH_LEN];
+  uint32_t len;
+  bool ready;  // 読み終わって書き出し待ち. 書き出したら false
+} QueryBatch;
+
+static QueryBatch batches[2];
+static uint32_t filling;  // 読み込み中の batches の添字
+static bool finished;     // もう batch は渡されない
+static int32_t write_ret = MJ_OK;
+static uint32_t threads = 1;
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t batch_cond = PTHREAD_COND_INITIALIZER;
+
+static char input[QUERY_READ_LEN];
+static uint32_t input_pos, input_len;
+static char line[QUERY_LINE_LEN];  // 読み途中の行
+static uint32_t line_len;          // QUERY_LINE_LEN 以上なら長すぎる行
+
+static void process_batch_query(void *arg, uint32_t worker, uint64_t index) {
+  (void)worker;
+  QueryBatch *batch = arg;
+  process_query(&batch->outputs[index], batch->lines[index], batch->line_lens[index]);
+}
+
+/* 渡された batch を順に計算して書き出す */
+static void *write_batches(void *arg) {
+  (void)arg;
+  uint32_t next = 0;
+  pthread_mutex_lock(&batch_mutex);
+  for (;;) {
+    while (!batches[next].ready && !finished) {
+      pthread_cond_wait(&batch_cond, &batch_mutex);
+    }
+    if (!batches[next].ready) {
+      break;
+    }
+    pthread_mutex_unlock(&batch_mutex);
+    QueryBatch *batch = &batches[next];
+    int32_t ret = mj_parallel_for(batch->len, threads, 0, process_batch_query, batch);
+    for (uint32_t i = 0; i < batch->len && ret == MJ_OK; i++) {
+      fwrite(batch->outputs[i].buf, 1, batch->outputs[i].len, stdout);
+    }
+    if (ret == MJ_OK && fflush(stdout) != 0) {
+      ret = MJ_ERR_IO;
+    }
+    pthread_mutex_lock(&batch_mutex);
+    write_ret = write_ret == MJ_OK ? ret : write_ret;
+    batch->len = 0;
+    batch->ready = false;
+    pthread_cond_broadcast(&batch_cond);
+    next ^= 1;
+  }
+  pthread_mutex_unlock(&batch_mutex);
+  return NULL;
+}
+
+/* 読み込み中の batch を書き出しのスレッドに渡し, もう一方の batch が空くのを待つ */
+static int32_t submit_batch() {
+  pthread_mutex_lock(&batch_mutex);
+  batches[filling].ready = true;
+  pthread_cond_broadcast(&batch_cond);
+  filling ^= 1;
+  while (batches[filling].ready) {
+    pthread_cond_wait(&batch_cond, &batch_mutex);
+  }
+  int32_t ret = write_ret;
+  pthread_mutex_unlock(&batch_mutex);
+  return ret;
+}
+
+/* 読み終わった行を batch に加える. 空行は読み飛ばす */
+static int32_t add_line() {
+  QueryBatch *batch = &batches[filling];
+  uint32_t len = line_len;
+  line_len = 0;
+  if (len == 0) {
+    return MJ_OK;
+  }
+  memcpy(batch->lines[batch->len], line, len < QUERY_LINE_LEN ? len : QUERY_LINE_LEN);
+  batch->line_lens[batch->len++] = len;
+  return batch->len == QUERY_BATCH_LEN ? submit_batch() : MJ_OK;
+}
+
+static bool is_readable(int fd) {
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  return poll(&pfd, 1, 0) > 0;
+}
+
+/* fd を1行ずつ読む. 入力を待つ前に読み終わった行を渡す */
+static int32_t score_file(int fd) {
+  input_pos = input_len = 0;
+  for (;;) {
+    if (input_pos == input_len) {
+      if (batches[filling].len > 0 && !is_readable(fd)) {
+        int32_t ret = submit_batch();
+        if (ret != MJ_OK) {
+          return ret;
+        }
+      }
+      ssize_t n = read(fd, input, sizeof(input));
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        int32_t ret = add_line();  // 改行で終わらない最後の行
+        return n < 0 ? MJ_ERR_IO : ret;
+      }
+      input_pos = 0;
+      input_len = (uint32_t)n;
+    }
+    const char *p = &input[input_pos];
+    const char *newline = memchr(p, '\n', input_len - input_pos);
+    uint32_t len = newline ? (uint32_t)(newline - p) : input_len - input_pos;
+    if (line_len < QUERY_LINE_LEN) {
+      uint32_t copy = len < QUERY_LINE_LEN - line_len ? len : QUERY_LINE_LEN - line_len;
+      memcpy(&line[line_len], p, copy);
+    }
+    line_len = line_len + len < QUERY_LINE_LEN ? line_len + len : QUERY_LINE_LEN;
+    input_pos += len + (newline ? 1 : 0);
+    if (newline) {
+      int32_t ret = add_line();
+      if (ret != MJ_OK) {
+        return ret;
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  int first = 1;
+  if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+    threads = (uint32_t)strtoul(argv[2], NULL, 10);
+    first = 3;
+  }
+  if (threads > MJ_BATCH_MAX_THREADS) {
+    fprintf(stderr, "usage: %s [-t threads(1-%u)] [file...]\n", argv[0], MJ_BATCH_MAX_THREADS);
+    return 1;
+  }
+  pthread_t writer;
+  if (pthread_create(&writer, NULL, write_batches, NULL) != 0) {
+    fprintf(stderr, "cannot create thread\n");
+    return 1;
+  }
+
+  int32_t ret = MJ_OK;
+  if (first >= argc) {
+    ret = score_file(STDIN_FILENO);
+  }
+  for (int i = first; i < argc && ret == MJ_OK; i++) {
+    FILE *fp = fopen(argv[i], "r");
+    if (!fp) {
+      fprintf(stderr, "%s: cannot open\n", argv[i]);
+      ret = MJ_ERR_IO;
+      break;
+    }
+    ret = score_file(fileno(fp));
+    fclose(fp);
+  }
+  if (ret == MJ_OK && batches[filling].len > 0) {
+    ret = submit_batch();
+  }
+  pthread_mutex_lock(&batch_mutex);
+  finished = true;
+  pthread_cond_broadcast(&batch_cond);
+  pthread_mutex_unlock(&batch_mutex);
+  pthread_join(writer, NULL);
+  ret = ret == MJ_OK ? write_ret : ret;
+  if (ret != MJ_OK) {
+    fprintf(stderr, "error: %d\n", ret);
+  }
+  return ret == MJ_OK ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mahjong.h"
+
+/*
+ * UNIX domain socket で点数, シャンテン数, 受け入れ, 待ちの問い合わせに答える.
+ * SIGINT, SIGTERM で終了し, 統計を出力する.
+ * usage: mjserver.elf [-t threads] path
+ *        mjserver.elf -b queries path   (path のサーバーに1件ずつ問い合わせ, 往復の時間を出力する)
+ */
+
+static MJServer server;
+
+static void stop_server(int sig) {
+  (void)sig;
+  mj_stop_server(&server);
+}
+
+static uint64_t get_nanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void print_latency(const MJServerStats *stats) {
+  const double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+  for (uint32_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+    uint32_t us = mj_server_latency_percentile(stats, percentiles[i]);
+    printf("latency p%g: %u%s us\n", percentiles[i], us, us == MJ_SERVER_LATENCY_LEN - 1 ? "+" : "");
+  }
+}
+
+/* 門前の平和, 断么九, 三色同順, 一盃口のロン. 1件ずつ送って結果を待つ */
+static int benchmark(const char *path, uint64_t len) {
+  int32_t fd;
+  if (mj_connect_server(&fd, path) != MJ_OK) {
+    fprintf(stderr, "%s: cannot connect\n", path);
+    return 1;
+  }
+  MJHands hands = {{MJ_M2, MJ_M3, MJ_M4, MJ_P2, MJ_P2, MJ_P3, MJ_P3, MJ_P4, MJ_P4, MJ_P5, MJ_P5, MJ_S2, MJ_S3, MJ_S4},
+                   14};
+  MJMelds melds = {{}, 0};
+  MJScoreConfig config = {MJ_P3, true, MJ_WT, MJ_WT};
+  MJQuery query;
+  memset(&query, 0, sizeof(query));
+  mj_encode_hand_record(&query.hand, &hands, &melds, &config);
+  query.kind = MJ_QUERY_SCORE;
+
+  static MJServerStats stats;
+  for (uint64_t i = 0; i < len; i++) {
+    MJQueryResult result;
+    uint64_t start = get_nanoseconds();
+    if (mj_query_server(fd, &result, &query, 1) != MJ_OK || result.ret != MJ_OK) {
+      fprintf(stderr, "query failed\n");
+      close(fd);
+      return 1;
+    }
+    uint64_t us = (get_nanoseconds() - start) / 1000;
+    stats.latency[us < MJ_SERVER_LATENCY_LEN ? us : MJ_SERVER_LATENCY_LEN - 1]++;
+  }
+  close(fd);
+  printf("queries: %llu\n", (unsigned long long)len);
+  print_latency(&stats);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  uint32_t threads = 1;
+  uint64_t bench = 0;
+  int i = 1;
+  for (; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-t") == 0) {
+      threads = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+    } else if (strcmp(argv[i], "-b") == 0) {
+      bench = strtoull(argv[i + 1], NULL, 10);
+    } else {
+      break;
+    }
+  }
+  if (i + 1 != argc) {
+    fprintf(stderr, "usage: %s [-t threads] path\n       %s -b queries path\n", argv[0], argv[0]);
+    return 1;
+  }
+  if (bench > 0) {
+    return benchmark(argv[i], bench);
+  }
+
+  int32_t ret = mj_open_server(&server, argv[i], threads);
+  if (ret != MJ_OK) {
+    fprintf(stderr, "%s: error: %d\n", argv[i], ret);
+    return 1;
+  }
+  signal(SIGINT, stop_server);
+  signal(SIGTERM, stop_server);
+  ret = mj_run_server(&server);
+  mj_close_server(&server);
+  if (ret != MJ_OK) {
+    fprintf(stderr, "error: %d\n", ret);
+  }
+  const MJServerStats *stats = &server.stats;
+  printf("connections: %llu\n", (unsigned long long)stats->connections);
+  printf("queries: %llu\n", (unsigned long long)stats->queries);
+  printf("batches: %llu\n", (unsigned long long)stats->batches);
+  printf("max_batch: %llu\n", (unsigned long long)stats->max_batch);
+  printf("average_batch: %.1f\n", stats->batches ? (double)stats->queries / (double)stats->batches : 0.0);
+  print_latency(stats);
+  return ret == MJ_OK ? 0 : 1;
+}
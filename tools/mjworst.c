@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mahjong.h"
+
+/*
+ * 1色だけの手牌 (萬子の 13 枚と 14 枚の全ての組み合わせ) から, シャンテン数, 受け入れ, 点数計算の計算量が最も多い
+ * 手牌を探し, mjbench.elf -c で読める形式で書き出す.
+ * usage: mjworst.elf [-k top] [-r repeats] [-o corpus]
+ *
+ * 計算量は mj_get_stats の探索の節, 分解, 役の判定の回数の和. make STATS=1 でビルドしていなければ時間で比べる.
+ * 全ての手牌を1回ずつ計測して候補を WORST_CANDIDATES 倍に絞り, 候補だけ repeats 回計測した最小の時間を使う.
+ *
+ * 出力: 1行に1つ "kind hand nodes ns". kind は shanten, ukeire, score. hand は mj_parse_notation の表記で,
+ * score はアガリ牌を "+" で付ける (ツモ). '#' から行末まではコメント.
+ */
+
+#define WORST_SUIT_LEN 9
+#define WORST_MAX_TOP 64
+#define WORST_CANDIDATES 4
+
+typedef enum {
+  WORST_SHANTEN = 0,
+  WORST_UKEIRE,
+  WORST_SCORE,
+  WORST_KIND_LEN,
+} WorstKind;
+
+static const char *kind_names[WORST_KIND_LEN] = {"shanten", "ukeire", "score"};
+
+typedef struct {
+  uint8_t counts[WORST_SUIT_LEN];  // 萬子の枚数
+  MJTileId win_tile;               // score だけ
+  uint64_t nodes;
+  uint64_t ns;
+} WorstHand;
+
+/* 計算量の大きい順に len 個まで */
+typedef struct {
+  WorstHand hands[WORST_MAX_TOP * WORST_CANDIDATES];
+  uint32_t len;
+  uint32_t cap;
+} WorstList;
+
+static bool use_stats;
+
+static uint64_t get_nanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool is_worse(const WorstHand *a, const WorstHand *b) {
+  if (use_stats && a->nodes != b->nodes) {
+    return a->nodes > b->nodes;
+  }
+  return a->ns > b->ns;
+}
+
+static void push_worst(WorstList *list, const WorstHand *hand) {
+  if (list->len == list->cap && !is_worse(hand, &list->hands[list->len - 1])) {
+    return;
+  }
+  uint32_t i = list->len < list->cap ? list->len++ : list->len - 1;
+  while (i > 0 && is_worse(hand, &list->hands[i - 1])) {
+    list->hands[i] = list->hands[i - 1];
+    i--;
+  }
+  list->hands[i] = *hand;
+}
+
+static void gen_worst_hands(MJHands *hands, const WorstHand *hand) {
+  hands->len = 0;
+  for (uint32_t i = 0; i < WORST_SUIT_LEN; i++) {
+    for (uint32_t j = 0; j < hand->counts[i]; j++) {
+      hands->tile_id[hands->len++] = (MJTileId)(MJ_M1 + i);
+    }
+  }
+}
+
+static uint64_t sum_stats(const MJStats *stats) {
+  return stats->shanten_nodes + stats->agari_decompositions + stats->scored_decompositions + stats->yaku_checks;
+}
+
+/* 1回計算して計算量を hand に書く. 点数計算でアガリ形がなければ false */
+static bool measure_worst(WorstHand *hand, WorstKind kind) {
+  MJHands hands;
+  gen_worst_hands(&hands, hand);
+  mj_reset_stats();
+  uint64_t start = get_nanoseconds();
+  int32_t ret = MJ_OK;
+  if (kind == WORST_SHANTEN) {
+    MJShanten shanten;
+    ret = mj_calc_shanten(&hands, &shanten);
+  } else if (kind == WORST_UKEIRE) {
+    MJTiles acceptables;
+    ret = mj_ukeire_normal(&hands, &acceptables);
+  } else {
+    MJBaseScore score;
+    MJMelds melds = {.len = 0};
+    ret = mj_get_score(&score, &hands, &melds, hand->win_tile, false, MJ_WT, MJ_WT);
+  }
+  hand->ns = get_nanoseconds() - start;
+  MJStats stats;
+  mj_get_stats(&stats);
+  hand->nodes = sum_stats(&stats);
+  return ret == MJ_OK;
+}
+
+static void search_counts(WorstList *lists, WorstHand *hand, uint32_t rank, uint32_t left) {
+  if (rank == WORST_SUIT_LEN) {
+    if (left != 0) {
+      return;
+    }
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < WORST_SUIT_LEN; i++) {
+      len += hand->counts[i];
+    }
+    if (len % 3 == 1) {
+      for (WorstKind kind = WORST_SHANTEN; kind <= WORST_UKEIRE; kind++) {
+        measure_worst(hand, kind);
+        push_worst(&lists[kind], hand);
+      }
+      return;
+    }
+    for (uint32_t i = 0; i < WORST_SUIT_LEN; i++) {
+      hand->win_tile = (MJTileId)(MJ_M1 + i);
+      if (hand->counts[i] > 0 && measure_worst(hand, WORST_SCORE)) {
+        push_worst(&lists[WORST_SCORE], hand);
+      }
+    }
+    return;
+  }
+  for (uint32_t count = 0; count <= MJ_MAX_TILES_LEN_IN_ELEMENT && count <= left; count++) {
+    hand->counts[rank] = (uint8_t)count;
+    search_counts(lists, hand, rank + 1, left - count);
+  }
+  hand->counts[rank] = 0;
+}
+
+/* 候補を repeats 回計測し直して最小の時間で並べ直す */
+static void remeasure_worst(WorstList *list, WorstKind kind, uint32_t repeats, uint32_t top) {
+  WorstList sorted = {.len = 0, .cap = top};
+  for (uint32_t i = 0; i < list->len; i++) {
+    WorstHand hand = list->hands[i];
+    uint64_t min = hand.ns;
+    for (uint32_t j = 0; j < repeats; j++) {
+      measure_worst(&hand, kind);
+      min = hand.ns < min ? hand.ns : min;
+    }
+    hand.ns = min;
+    push_worst(&sorted, &hand);
+  }
+  *list = sorted;
+}
+
+static void print_worst(FILE *fp, const WorstHand *hand, WorstKind kind) {
+  fprintf(fp, "%s ", kind_names[kind]);
+  for (uint32_t i = 0; i < WORST_SUIT_LEN; i++) {
+    uint32_t count = hand->counts[i];
+    if (kind == WORST_SCORE && hand->win_tile == MJ_M1 + i) {
+      count--;  // アガリ牌は "+" で書く
+    }
+    for (uint32_t j = 0; j < count; j++) {
+      fputc((int)('1' + i), fp);
+    }
+  }
+  fputc('m', fp);
+  if (kind == WORST_SCORE) {
+    fprintf(fp, "+%um", hand->win_tile - MJ_M1 + 1);
+  }
+  fprintf(fp, " %llu %llu\n", (unsigned long long)hand->nodes, (unsigned long long)hand->ns);
+}
+
+int main(int argc, char **argv) {
+  uint32_t top = 16;
+  uint32_t repeats = 10;
+  const char *path = NULL;
+  int first = 1;
+  while (first + 1 < argc && argv[first][0] == '-') {
+    if (strcmp(argv[first], "-k") == 0) {
+      top = (uint32_t)strtoul(argv[first + 1], NULL, 10);
+    } else if (strcmp(argv[first], "-r") == 0) {
+      repeats = (uint32_t)strtoul(argv[first + 1], NULL, 10);
+    } else if (strcmp(argv[first], "-o") == 0) {
+      path = argv[first + 1];
+    } else {
+      break;
+    }
+    first += 2;
+  }
+  if (first != argc || top == 0 || top > WORST_MAX_TOP) {
+    fprintf(stderr, "usage: %s [-k top (1-%u)] [-r repeats] [-o corpus]\n", argv[0], WORST_MAX_TOP);
+    return 1;
+  }
+  FILE *fp = path != NULL ? fopen(path, "w") : stdout;
+  if (fp == NULL) {
+    perror(path);
+    return 1;
+  }
+
+  MJStats stats;
+  use_stats = mj_get_stats(&stats) == MJ_OK;
+  static WorstList lists[WORST_KIND_LEN];
+  for (uint32_t kind = 0; kind < WORST_KIND_LEN; kind++) {
+    lists[kind].len = 0;
+    lists[kind].cap = top * WORST_CANDIDATES;
+  }
+  WorstHand hand;
+  memset(&hand, 0, sizeof(hand));
+  search_counts(lists, &hand, 0, 13);
+  search_counts(lists, &hand, 0, 14);
+
+  fprintf(fp, "# mjworst.elf -k %u -r %u: kind hand nodes ns (%s)\n", top, repeats,
+          use_stats ? "sorted by nodes" : "sorted by ns, nodes are not counted");
+  for (WorstKind kind = 0; kind < WORST_KIND_LEN; kind++) {
+    remeasure_worst(&lists[kind], kind, repeats, top);
+    for (uint32_t i = 0; i < lists[kind].len; i++) {
+      print_worst(fp, &lists[kind].hands[i], kind);
+    }
+  }
+  if (fp != stdout) {
+    fclose(fp);
+  }
+  return 0;
+}